@@ -1144,9 +1144,11 @@ integrationtest_ubuntu_cpu_dist_kvstore() {
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=gluon_type_cpu
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --no-multiprecision
+    MXNET_KVSTORE_SHM_TRANSPORT=1 ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=compressed_cpu
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=compressed_cpu --no-multiprecision
     ../../tools/launch.py -n 3 --launcher local python test_server_profiling.py
+    python dist_allreduce_kvstore.py -n 4
 }
 
 integrationtest_ubuntu_cpu_scala() {
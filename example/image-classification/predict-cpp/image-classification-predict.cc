@@ -307,19 +307,21 @@ int main(int argc, char* argv[]) {
 
     predict(pred_hnd, image_data, nd_hnd, synset_file, 0);
   } else {
-    // Create Predictor
+    // Create a pool of predictors sharing the parameters, one per thread,
+    // each running its operators on its own thread
     std::vector<PredictorHandle> pred_hnds(num_threads, nullptr);
-    MXPredCreateMultiThread(static_cast<const char*>(json_data.GetBuffer()),
-                            static_cast<const char*>(param_data.GetBuffer()),
-                            static_cast<int>(param_data.GetLength()),
-                            dev_type,
-                            dev_id,
-                            num_input_nodes,
-                            input_keys,
-                            input_shape_indptr,
-                            input_shape_data,
-                            pred_hnds.size(),
-                            pred_hnds.data());
+    MXPredCreatePool(static_cast<const char*>(json_data.GetBuffer()),
+                     static_cast<const char*>(param_data.GetBuffer()),
+                     static_cast<int>(param_data.GetLength()),
+                     dev_type,
+                     dev_id,
+                     num_input_nodes,
+                     input_keys,
+                     input_shape_indptr,
+                     input_shape_data,
+                     pred_hnds.size(),
+                     dev_type == 1,
+                     pred_hnds.data());
     for (auto hnd : pred_hnds)
       assert(hnd);
 
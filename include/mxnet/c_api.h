@@ -1747,6 +1747,35 @@ MXNET_DLL int MXSymbolInferTypePartial(SymbolHandle sym,
                                        const int **aux_type_data,
                                        int *complete);
 
+/*!
+ * \brief plan the memory of a symbol the way binding it would, without allocating.
+ *  The input shapes are passed by name and packed into a CSR matrix represented by
+ *  arg_ind_ptr and arg_shape_data, as in MXSymbolInferShapeEx.
+ *  The returned JSON object holds planned_bytes (executor memory pool), peak_live_bytes,
+ *  input_bytes, external_bytes, num_dynamic, the node names, the pool blocks with their
+ *  lifetime intervals in node ids ("storage") and the inplace decisions ("inplace").
+ *
+ * \param sym symbol handle
+ * \param num_args number of input arguments
+ * \param keys the names of the input arguments
+ * \param arg_ind_ptr the head pointer of the rows in CSR
+ * \param arg_shape_data the content of the CSR
+ * \param dev_type device type of the context to plan for
+ * \param dev_id device id of the context to plan for
+ * \param for_training whether to also plan the gradients of all arguments
+ * \param out_json the returned memory plan as a JSON string
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXSymbolPlanMemory(SymbolHandle sym,
+                                 mx_uint num_args,
+                                 const char** keys,
+                                 const mx_uint *arg_ind_ptr,
+                                 const int *arg_shape_data,
+                                 int dev_type,
+                                 int dev_id,
+                                 int for_training,
+                                 const char **out_json);
+
 /*!
  * \brief Convert a symbol into a quantized symbol where FP32 operators are replaced with INT8
  * \param sym_handle symbol to be converted
@@ -2242,6 +2271,29 @@ MXNET_DLL int MXDataIterNext(DataIterHandle handle,
  * \return 0 when success, -1 when failure happens
  */
 MXNET_DLL int MXDataIterBeforeFirst(DataIterHandle handle);
+/*!
+ * \brief Save the position of the iterator, with its shuffle order and random state,
+ *  so that an iterator created with the same parameters can continue after the last
+ *  batch returned. Fails for iterators that cannot save their state.
+ * \param handle the handle to iterator
+ * \param out_size size of the state
+ * \param out_buf the state, valid until the next API call on this thread
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXDataIterSaveState(DataIterHandle handle,
+                                  size_t *out_size,
+                                  const char **out_buf);
+/*!
+ * \brief Go to a position saved by MXDataIterSaveState, the next call to
+ *  MXDataIterNext returning the batch after it
+ * \param handle the handle to iterator
+ * \param size size of the state
+ * \param buf the state
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXDataIterLoadState(DataIterHandle handle,
+                                  size_t size,
+                                  const char *buf);
 
 /*!
  * \brief Get the handle to the NDArray of underlying data
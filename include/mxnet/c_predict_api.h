@@ -196,6 +196,46 @@ MXNET_DLL int MXPredCreateMultiThread(const char* symbol_json_str,
                                       int num_threads,
                                       PredictorHandle* out);
 
+/*!
+ * \brief create a pool of predictors sharing one read-only copy of the parameters.
+ *  Each predictor has its own input arrays and its own executor memory, so every
+ *  predictor can serve requests on its own thread. Unlike MXPredCreateMultiThread,
+ *  the pool works with any engine type.
+ * \param symbol_json_str The JSON string of the symbol.
+ * \param param_bytes The in-memory raw bytes of parameter ndarray file.
+ * \param param_size The size of parameter ndarray file.
+ * \param dev_type The device type, 1: cpu, 2:gpu
+ * \param dev_id The device id of the predictor.
+ * \param num_input_nodes Number of input nodes to the net,
+ *    For feedforward net, this is 1.
+ * \param input_keys The name of input argument.
+ *    For feedforward net, this is {"data"}
+ * \param input_shape_indptr Index pointer of shapes of each input node.
+ *    The length of this array = num_input_nodes + 1.
+ *    For feedforward net that takes 4 dimensional input, this is {0, 4}.
+ * \param input_shape_data A flattened data of shapes of each input node.
+ *    For feedforward net that takes 4 dimensional input, this is the shape data.
+ * \param num_predictors The number of predictors in the pool.
+ * \param inline_exec Whether MXPredForward runs the operators on the calling thread
+ *   instead of pushing them to the engine, as NaiveEngine does. Only CPU predictors
+ *   of synchronous operators support it.
+ * \param out An array of created predictor handles. The array has to be large
+ *   enough to keep `num_predictors` predictors. Each handle is freed by MXPredFree,
+ *   the parameters are released with the last predictor of the pool.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredCreatePool(const char* symbol_json_str,
+                               const void* param_bytes,
+                               int param_size,
+                               int dev_type, int dev_id,
+                               mx_uint num_input_nodes,
+                               const char** input_keys,
+                               const mx_uint* input_shape_indptr,
+                               const mx_uint* input_shape_data,
+                               int num_predictors,
+                               int inline_exec,
+                               PredictorHandle* out);
+
 /*!
  * \brief Change the input shape of an existing predictor.
  * \param num_input_nodes Number of input nodes to the net,
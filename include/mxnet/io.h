@@ -53,6 +53,24 @@ class IIterator : public dmlc::DataIter<DType> {
   virtual bool Next(void) = 0;
   /*! \brief get current data */
   virtual const DType &Value(void) const = 0;
+  /*!
+   * \brief save the position of the iterator in the current epoch, with its shuffle
+   *  order and random state, so that an iterator created with the same parameters
+   *  continues after the last item returned by Next once it loads the state
+   * \param fo the stream to write the state to
+   * \return false if the iterator cannot save its state, and fo is to be discarded
+   */
+  virtual bool SaveState(dmlc::Stream *fo) {
+    return false;
+  }
+  /*!
+   * \brief go to a position saved by SaveState, the next call to Next returning the
+   *  item after it
+   * \param fi the stream to read the state from
+   */
+  virtual void LoadState(dmlc::Stream *fi) {
+    LOG(FATAL) << "This iterator cannot load a saved state";
+  }
   /*! \brief constructor */
   virtual ~IIterator(void) {}
   /*! \brief store the name of each data, it could be used for making NDArrays */
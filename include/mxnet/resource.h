@@ -219,6 +219,19 @@ class ResourceManager {
    *       still hold by the manager singleton.
    */
   virtual Resource Request(Context ctx, const ResourceRequest &req) = 0;
+  /*!
+   * \brief Create a temporary space that is not shared with other requesters.
+   *  Unlike the round robin copies handed out by Request, an operator holding it
+   *  can run outside of the engine without racing with other operators.
+   * \param ctx the context of the space.
+   * \return the resource, release it with FreePrivateSpace.
+   */
+  virtual Resource RequestPrivateSpace(Context ctx) = 0;
+  /*!
+   * \brief Release a space created by RequestPrivateSpace.
+   * \param res the resource to release.
+   */
+  virtual void FreePrivateSpace(const Resource &res) = 0;
   /*!
    * \brief Seed all the allocated random number generators.
    * \param seed the seed to the random number generators on all devices.
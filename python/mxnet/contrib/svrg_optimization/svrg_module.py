@@ -169,7 +169,7 @@ class SVRGModule(Module):
         batch_size = self._exec_group.batch_size
 
         (kv_store, update_on_kvstore) = mx.model._create_kvstore(kvstore, self._ctx_len, self._arg_params)
-        if kv_store and 'dist' in kv_store.type and '_sync' in kv_store.type:
+        if kv_store and 'dist' in kv_store.type and '_async' not in kv_store.type:
             batch_size *= kv_store.num_workers
         rescale_grad = 1.0 / batch_size
 
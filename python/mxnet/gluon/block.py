@@ -35,6 +35,9 @@ from .. import name as _name
 from .parameter import Parameter, ParameterDict, DeferredInitializationError
 from .utils import _indent, _brief_print_list, HookHandle
 
+# subgraph backends whose operators only have CPU implementations
+_CPU_ONLY_BACKENDS = ('ELEMWISE_FUSION',)
+
 
 class _BlockScope(object):
     """Scope for collecting child `Block` s."""
@@ -523,6 +526,15 @@ class Block(object):
             Optimize for invariant input shapes between iterations. Must also
             set static_alloc to True. Change of input shapes is still allowed
             but slower.
+        frozen : bool, default False
+            Replay the recorded inference forward pass without creating arrays
+            or engine variables. Must also set static_shape to True. Outputs
+            are returned in the same arrays on every call and are overwritten
+            by the next call.
+        backend : str, default None
+            Name of a subgraph backend, e.g. 'ELEMWISE_FUSION', used to partition
+            the hybridized graph before it is executed. 'ELEMWISE_FUSION' only
+            runs on CPU.
         """
         for cld in self._children.values():
             cld.hybridize(active, **kwargs)
@@ -728,6 +740,7 @@ class HybridBlock(Block):
         self._in_format = None
         self._active = False
         self._flags = []
+        self._backend = None
 
     def __setattr__(self, name, value):
         """Registers parameters."""
@@ -755,6 +768,8 @@ class HybridBlock(Block):
 
     def _build_cache(self, *args):
         data, out = self._get_graph(*args)
+        if self._backend:
+            out = out.get_backend_symbol(self._backend)
         data_names = {data.name : i for i, data in enumerate(data)}
         params = self.collect_params()
         input_names = out.list_inputs()
@@ -801,6 +816,12 @@ class HybridBlock(Block):
             raise ValueError(error_msg)
 
     def _call_cached_op(self, *args):
+        if self._backend in _CPU_ONLY_BACKENDS:
+            for arg in _flatten(args, "input")[0]:
+                if isinstance(arg, NDArray) and arg.context.device_type == 'gpu':
+                    raise ValueError("Backend %s only runs on CPU, but %s was called with "
+                                     "inputs on %s. Hybridize it without the backend to "
+                                     "run it there."%(self._backend, self.name, arg.context))
         if self._cached_op is None:
             self._build_cache(*args)
 
@@ -837,14 +858,15 @@ class HybridBlock(Block):
         super(HybridBlock, self).register_child(block, name)
         self._clear_cached_op()
 
-    def hybridize(self, active=True, **kwargs):
+    def hybridize(self, active=True, backend=None, **kwargs):
         self._active = active
+        self._backend = backend
         self._flags = list(kwargs.items())
         self._clear_cached_op()
         if active and self._forward_hooks or self._forward_pre_hooks:
             warnings.warn('"{}" is being hybridized while still having forward hook/pre-hook. '
                           'If "{}" is a child of HybridBlock, the hooks will not take effect.')
-        super(HybridBlock, self).hybridize(active, **kwargs)
+        super(HybridBlock, self).hybridize(active, backend=backend, **kwargs)
 
     def cast(self, dtype):
         self._clear_cached_op()
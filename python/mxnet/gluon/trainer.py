@@ -355,11 +355,14 @@ class Trainer(object):
 
     def _allreduce_grads(self):
         if self._kvstore:
+            # push all gradients before pulling any, so that the kvstore can
+            # reduce small gradients together
             for i, param in enumerate(self._params):
                 if param.grad_req != 'null':
-
                     self._kvstore.push(i, param.list_grad(), priority=-i)
-                    if not self._update_on_kvstore:
+            if not self._update_on_kvstore:
+                for i, param in enumerate(self._params):
+                    if param.grad_req != 'null':
                         self._kvstore.pull(i, param.list_grad(), priority=-i,
                                            ignore_sparse=self._distributed)
 
@@ -198,6 +198,57 @@ def imdecode(buf, *args, **kwargs):
     return _internal._cvimdecode(buf, *args, **kwargs)
 
 
+def imdecode_batch(bufs, flag=1, to_rgb=True, size=None, interp=1):
+    """Decode a batch of images into a single NDArray, in parallel.
+
+    The images are decoded asynchronously on the engine's CPU threads, with
+    libjpeg-turbo when MXNet is built with it, so a single process can use all
+    cores to decode.
+
+    .. note:: `imdecode_batch` uses OpenCV (not the CV2 Python library).
+       MXNet must have been built with USE_OPENCV=1 for `imdecode_batch` to work.
+
+    Parameters
+    ----------
+    bufs : list of str/bytes/bytearray, numpy.ndarray or NDArray
+        Binary image data of every image.
+    flag : int, optional, default=1
+        1 for three channel color output. 0 for grayscale output.
+    to_rgb : bool, optional, default=True
+        True for RGB formatted output (MXNet default). False for BGR formatted output
+        (OpenCV default).
+    size : tuple of (width, height), optional
+        Size to resize every image to. By default the images keep their sizes and are
+        padded with zeros at the bottom and right to the largest one.
+    interp : int, optional, default=1
+        Interpolation method of the resize. See resize_short for details.
+
+    Returns
+    -------
+    tuple of (NDArray, NDArray)
+        The (N, H, W, C) uint8 batch of images, and the (N, 2) int32 (height, width)
+        of every image in it.
+
+    Example
+    -------
+    >>> bufs = [open(f, 'rb').read() for f in ["flower.jpg", "cat.jpg"]]
+    >>> data, sizes = mx.img.imdecode_batch(bufs, size=(224, 224))
+    >>> data
+    <NDArray 2x224x224x3 @cpu(0)>
+    """
+    arrays = []
+    for buf in bufs:
+        if not isinstance(buf, nd.NDArray):
+            if sys.version_info[0] == 3 and not isinstance(buf, (bytes, bytearray, np.ndarray)):
+                raise ValueError('buf must be of type bytes, bytearray or numpy.ndarray,'
+                                 'if you would like to input type str, please convert to bytes')
+            buf = nd.array(np.frombuffer(buf, dtype=np.uint8), dtype=np.uint8)
+        arrays.append(buf)
+    w, h = size if size is not None else (0, 0)
+    return _internal._cvimdecode_batch(*arrays, flag=flag, to_rgb=to_rgb, w=w, h=h,
+                                       interp=interp)
+
+
 def scale_down(src_size, size):
     """Scales down crop size if it's larger than image size.
 
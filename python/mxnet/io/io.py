@@ -31,7 +31,7 @@ from ..base import _LIB
 from ..base import c_str_array, mx_uint, py_str
 from ..base import DataIterHandle, NDArrayHandle
 from ..base import mx_real_t
-from ..base import check_call, build_param_doc as _build_param_doc
+from ..base import check_call, ctypes2buffer, build_param_doc as _build_param_doc
 from ..ndarray import NDArray
 from ..ndarray.sparse import CSRNDArray
 from ..ndarray import _ndarray_cls
@@ -845,6 +845,39 @@ class MXDataIter(DataIter):
         self.first_batch = None
         check_call(_LIB.MXDataIterBeforeFirst(self.handle))
 
+    def save_state(self):
+        """Saves the position of the iterator, with its shuffle order and random state.
+
+        An iterator created with the same parameters continues after the last batch
+        returned once it loads the state with `load_state`.
+
+        Returns
+        -------
+        bytearray
+            The state.
+        """
+        if self.first_batch is not None:
+            # the first batch was only read for the shapes, give it back
+            self.reset()
+        length = ctypes.c_size_t()
+        cptr = ctypes.POINTER(ctypes.c_char)()
+        check_call(_LIB.MXDataIterSaveState(self.handle, ctypes.byref(length),
+                                            ctypes.byref(cptr)))
+        return ctypes2buffer(cptr, length.value)
+
+    def load_state(self, state):
+        """Goes to a position saved by `save_state`, `next` returning the batch after it.
+
+        Parameters
+        ----------
+        state : bytes or bytearray
+            The state returned by `save_state`.
+        """
+        buf = bytearray(state)
+        ptr = (ctypes.c_char * len(buf)).from_buffer(buf)
+        check_call(_LIB.MXDataIterLoadState(self.handle, ctypes.c_size_t(len(buf)), ptr))
+        self.first_batch = None
+
     def next(self):
         if self._debug_skip_load and not self._debug_at_begin:
             return  DataBatch(data=[self.getdata()], label=[self.getlabel()], pad=self.getpad(),
@@ -407,6 +407,15 @@ class KVStore(object):
         original values is stored at the sender's end as residual and added to the
         gradient in the next iteration.
 
+        1bit Gradient Compression sends the sign of each value, and for each block of
+        1024 values the mean of their absolute values, which all values of the block
+        are then set to, with the sign they had. The difference is stored as residual.
+
+        topk Gradient Compression takes a float `ratio` in (0, 1], 0.01 by default, and
+        sends the value of largest magnitude out of each block of 1/ratio values, with its
+        position in the block. randk Gradient Compression sends a random value of each block
+        instead. The values not sent are stored as residual.
+
         When kvstore is 'local', gradient compression is used to reduce communication
         between multiple devices (gpus). Gradient is quantized on each GPU which
         computed the gradients, then sent to the GPU which merges the gradients. This
@@ -428,6 +437,8 @@ class KVStore(object):
         To completely specify the arguments for 2bit compression, we would need to pass
         a dictionary which includes `threshold` like:
         {'type': '2bit', 'threshold': 0.5}
+        The other types are specified the same way, like {'type': '1bit'} or
+        {'type': 'topk', 'ratio': 0.01}.
 
         Parameters
         ----------
@@ -435,7 +446,7 @@ class KVStore(object):
             A dictionary specifying the type and parameters for gradient compression.
             The key `type` in this dictionary is a
             required string argument and specifies the type of gradient compression.
-            Currently `type` can be only `2bit`
+            Currently `type` can be `2bit`, `1bit`, `topk` or `randk`
             Other keys in this dictionary are optional and specific to the type
             of gradient compression.
         """
@@ -454,6 +465,7 @@ class KVStore(object):
         If using multiple machines and this operation is invoked from a worker node,
         it will serialized the optimizer with pickle and send it to all servers.
         The function returns after all servers have been updated.
+        With ``dist_allreduce``, every worker updates its weights with its local optimizer.
 
         Parameters
         ----------
@@ -480,8 +492,8 @@ class KVStore(object):
         is_worker = ctypes.c_int()
         check_call(_LIB.MXKVStoreIsWorkerNode(ctypes.byref(is_worker)))
 
-        # pylint: disable=invalid-name
-        if 'dist' in self.type and is_worker.value: # pylint: disable=unsupported-membership-test
+        # pylint: disable=invalid-name,unsupported-membership-test
+        if 'dist' in self.type and 'allreduce' not in self.type and is_worker.value:
             # send the optimizer to server
             try:
                 # use ASCII protocol 0, might be slower, but not a big ideal
@@ -658,9 +670,17 @@ def create(name='local'):
     No two updates happen on the same weight at the same time. However, the order is not
     guaranteed.
 
+    ``dist_allreduce``: Behaves like ``dist_sync`` without servers. The gradients are
+    summed by allreduce between the workers, over TCP and over shared memory between
+    the workers of a machine, and every worker updates its own copy of the weights.
+    The workers are started with ``DMLC_NUM_WORKER``, ``DMLC_PS_ROOT_URI`` and
+    ``DMLC_PS_ROOT_PORT`` set, and no scheduler. ``dist_device_allreduce`` differs
+    from it as ``device`` from ``local``.
+
     Parameters
     ----------
-    name : {'local', 'device', 'nccl', 'dist_sync', 'dist_device_sync', 'dist_async'}
+    name : {'local', 'device', 'nccl', 'dist_sync', 'dist_device_sync', 'dist_async',
+            'dist_allreduce', 'dist_device_allreduce'}
         The type of KVStore.
     Returns
     -------
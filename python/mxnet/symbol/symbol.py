@@ -27,6 +27,7 @@ except ImportError:
 
 from array import array
 import ctypes
+import json
 import warnings
 from numbers import Number
 
@@ -1223,6 +1224,61 @@ class Symbol(SymbolBase):
             return (None, None, None)
         # pylint: enable=too-many-locals
 
+    def plan_memory(self, ctx=None, for_training=False, **kwargs):
+        """Plans the memory of the symbol the way binding it would, without allocating.
+
+        Example
+        -------
+        >>> data = mx.sym.var('data')
+        >>> out = mx.sym.relu(mx.sym.FullyConnected(data, num_hidden=128))
+        >>> plan = out.plan_memory(data=(64, 256))
+        >>> plan['planned_bytes']
+        32768
+
+        Parameters
+        ----------
+        ctx : Context, optional
+            The device context to plan for. Defaults to the current context.
+        for_training : bool, optional
+            Whether to also plan the gradients of all arguments.
+        **kwargs : dict of str to tuple
+            Shapes of the input arguments, by name.
+
+        Returns
+        -------
+        plan : dict
+            ``planned_bytes`` is the memory pool the executor allocates for internal
+            entries and ``peak_live_bytes`` the largest amount of it holding live data at
+            once. ``input_bytes`` and ``external_bytes`` count the arguments, auxiliary
+            states, head gradients and argument gradients. ``storage`` lists the pool
+            blocks with their ``lifetimes`` as ``[first, last]`` node ids indexing
+            ``nodes``, and ``inplace`` the outputs written into the storage of an input.
+        """
+        if ctx is None:
+            ctx = current_context()
+        sdata = []
+        indptr = [0]
+        str_keys = []
+        for k, v in kwargs.items():
+            if not isinstance(v, tuple):
+                raise TypeError("Arguments need to be shapes (tuple), "
+                                "but '%s' is %s." % (k, type(v)))
+            str_keys.append(k)
+            sdata.extend(v)
+            indptr.append(len(sdata))
+        out = ctypes.c_char_p()
+        check_call(_LIB.MXSymbolPlanMemory(
+            self.handle,
+            mx_uint(len(str_keys)),
+            c_str_array(str_keys),
+            c_array_buf(mx_uint, array('I', indptr)),
+            c_array_buf(mx_int, array('i', sdata)),
+            ctypes.c_int(ctx.device_typeid),
+            ctypes.c_int(ctx.device_id),
+            ctypes.c_int(int(for_training)),
+            ctypes.byref(out)))
+        return json.loads(py_str(out.value))
+
     def debug_str(self):
         """Gets a debug string of symbol.
 
@@ -815,6 +815,25 @@ int MXDataIterBeforeFirst(DataIterHandle handle) {
   API_END();
 }
 
+int MXDataIterSaveState(DataIterHandle handle, size_t *out_size, const char **out_buf) {
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  ret->ret_str.resize(0);
+  dmlc::MemoryStringStream strm(&ret->ret_str);
+  CHECK(static_cast<IIterator<DataBatch>* >(handle)->SaveState(&strm))
+      << "This iterator cannot save its state";
+  *out_size = ret->ret_str.length();
+  *out_buf = ret->ret_str.c_str();
+  API_END();
+}
+
+int MXDataIterLoadState(DataIterHandle handle, size_t size, const char *buf) {
+  API_BEGIN();
+  dmlc::MemoryFixedSizeStream strm((void*)buf, size);  // NOLINT(*)
+  static_cast<IIterator<DataBatch>* >(handle)->LoadState(&strm);
+  API_END();
+}
+
 int MXDataIterNext(DataIterHandle handle, int *out) {
   API_BEGIN();
   *out = static_cast<IIterator<DataBatch>* >(handle)->Next();
@@ -32,6 +32,8 @@
 #include "./c_api_common.h"
 #include "../operator/operator_common.h"
 #include "../executor/exec_pass.h"
+#include "../executor/graph_executor.h"
+#include "../common/exec_utils.h"
 #include "../operator/subgraph/subgraph_property.h"
 
 namespace mxnet {
@@ -774,6 +776,38 @@ int MXSymbolInferTypePartial(SymbolHandle sym,
                             &succ);
 }
 
+int MXSymbolPlanMemory(SymbolHandle sym,
+                       mx_uint num_args,
+                       const char** keys,
+                       const mx_uint *arg_ind_ptr,
+                       const int *arg_shape_data,
+                       int dev_type,
+                       int dev_id,
+                       int for_training,
+                       const char **out_json) {
+  nnvm::Symbol *s = static_cast<nnvm::Symbol*>(sym);
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  CHECK(keys != nullptr || num_args == 0) << "MXSymbolPlanMemory requires named input shapes";
+  std::unordered_map<std::string, mxnet::TShape> arg_shape_map;
+  for (mx_uint i = 0; i < num_args; ++i) {
+    mxnet::TShape shape = mxnet::ShapeTypeCast(arg_shape_data + arg_ind_ptr[i],
+                                               arg_shape_data + arg_ind_ptr[i+1]);
+    if (!Imperative::Get()->is_np_shape()) {
+      common::ConvertToNumpyShape(&shape);
+    }
+    arg_shape_map[keys[i]] = shape;
+  }
+  const Context ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  nnvm::Graph g = mxnet::exec::PlanGraphMemory(*s, ctx, arg_shape_map, for_training != 0);
+  std::ostringstream os;
+  dmlc::JSONWriter writer(&os);
+  mxnet::common::GetMemoryPlanInfo(g).Save(&writer);
+  ret->ret_str = os.str();
+  *out_json = ret->ret_str.c_str();
+  API_END();
+}
+
 int MXSymbolGrad(SymbolHandle sym, mx_uint num_wrt, const char** wrt, SymbolHandle* out) {
   API_BEGIN();
   LOG(FATAL) << "not implemented";
@@ -34,6 +34,7 @@
 #include "./c_api_common.h"
 #include "../operator/operator_common.h"
 #include "../executor/exec_pass.h"
+#include "../executor/graph_executor.h"
 
 using namespace mxnet;
 
@@ -60,6 +61,8 @@ struct MXAPIPredictor {
   nnvm::Symbol sym;
   // Context
   Context ctx;
+  // whether the executor runs the operators on the calling thread
+  bool inline_exec = false;
 };
 
 struct MXAPINDList {
@@ -83,6 +86,9 @@ inline void _CreateExecutor(PredictorHandle pred_hnd) {
     std::vector<OpReqType> grad_req(arg_arrays.size(), kNullOp);
     pred->exec.reset(Executor::Bind(sym, ctx, ctx_map, arg_arrays,
                                     grad_store, grad_req, aux_arrays));
+    if (pred->inline_exec) {
+      static_cast<exec::GraphExecutor*>(pred->exec.get())->EnableInlineExecution();
+    }
     pred->out_arrays = pred->exec->outputs();
   }
 }
@@ -100,6 +106,7 @@ int _CreatePartialOut(const char* symbol_json_str,
                       // This is used for parallel inference.
                       int num_threads,
                       bool lazy,
+                      bool inline_exec,
                       const mx_uint num_provided_arg_dtypes,
                       const char** provided_arg_dtype_names,
                       const int* provided_arg_dtypes,
@@ -289,15 +296,28 @@ int _CreatePartialOut(const char* symbol_json_str,
     ret->aux_arrays = aux_arrays;
     ret->out_shapes = out_shapes;
     ret->out_dtypes = result_out_types;
+    ret->inline_exec = inline_exec;
+    // the predictors share the parameters, but each one needs its own
+    // input arrays to run on its own thread
+    if (i > 0) {
+      for (size_t j = 0; j < arg_names.size(); ++j) {
+        if (arg_params.count(arg_names[j]) != 0) continue;
+        const NDArray& nd = arg_arrays[j];
+        ret->arg_arrays[j] = NDArray(nd.shape(), nd.ctx(), false, nd.dtype());
+      }
+    }
 
     if (!lazy) {
       std::map<std::string, Context> ctx_map;
       std::vector<NDArray> grad_store(arg_arrays.size());
       std::vector<OpReqType> grad_req(arg_arrays.size(), kNullOp);
       ret->exec.reset(Executor::Bind(sym, ctx, ctx_map,
-                                     arg_arrays,
+                                     ret->arg_arrays,
                                      grad_store, grad_req,
                                      aux_arrays));
+      if (inline_exec) {
+        static_cast<exec::GraphExecutor*>(ret->exec.get())->EnableInlineExecution();
+      }
       ret->out_arrays = ret->exec->outputs();
     }
     out[i] = ret.release();
@@ -329,6 +349,7 @@ int MXPredCreatePartialOut(const char* symbol_json_str,
       output_keys,
       1,
       false,
+      false,
       0,
       nullptr,
       nullptr,
@@ -358,6 +379,7 @@ int MXPredCreate(const char* symbol_json_str,
       nullptr,
       1,
       false,
+      false,
       0,
       nullptr,
       nullptr,
@@ -390,6 +412,7 @@ int MXPredCreateEx(const char* symbol_json_str,
       nullptr,
       1,
       false,
+      false,
       num_provided_arg_dtypes,
       provided_arg_dtype_names,
       provided_arg_dtypes,
@@ -428,6 +451,39 @@ int MXPredCreateMultiThread(const char* symbol_json_str,
       nullptr,
       num_threads,
       true,
+      false,
+      0,
+      nullptr,
+      nullptr,
+      out);
+}
+
+int MXPredCreatePool(const char* symbol_json_str,
+                     const void* param_bytes,
+                     int param_size,
+                     int dev_type, int dev_id,
+                     mx_uint num_input_nodes,
+                     const char** input_keys,
+                     const mx_uint* input_shape_indptr,
+                     const mx_uint* input_shape_data,
+                     int num_predictors,
+                     int inline_exec,
+                     PredictorHandle* out) {
+  return _CreatePartialOut(
+      symbol_json_str,
+      param_bytes,
+      param_size,
+      dev_type,
+      dev_id,
+      num_input_nodes,
+      input_keys,
+      input_shape_indptr,
+      input_shape_data,
+      0,
+      nullptr,
+      num_predictors,
+      false,
+      inline_exec != 0,
       0,
       nullptr,
       nullptr,
@@ -517,6 +573,10 @@ int MXPredReshape(mx_uint num_input_nodes,
                                    grad_store, grad_req,
                                    ret->aux_arrays,
                                    p->exec.get()));
+    if (p->inline_exec) {
+      static_cast<exec::GraphExecutor*>(ret->exec.get())->EnableInlineExecution();
+      ret->inline_exec = true;
+    }
     ret->out_shapes = out_shapes;
     ret->out_arrays = ret->exec->outputs();
     ret->out_dtypes = p->out_dtypes;
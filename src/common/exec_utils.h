@@ -24,8 +24,11 @@
 #ifndef MXNET_COMMON_EXEC_UTILS_H_
 #define MXNET_COMMON_EXEC_UTILS_H_
 
+#include <dmlc/json.h>
 #include <nnvm/graph.h>
+#include <nnvm/graph_attr_types.h>
 #include <nnvm/pass_functions.h>
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <string>
@@ -315,6 +318,170 @@ inline void LogMemoryPlan(const nnvm::Graph& g) {
   }
 }
 
+/*!
+ * \brief Summary of the static memory plan of a graph that went through MXPlanMemory.
+ *        Node ids index into nodes; a lifetime [first, last] is the range of node ids
+ *        during which a storage block holds data that is still going to be read.
+ */
+struct MemoryPlanInfo {
+  /*! \brief one block of the executor memory pool */
+  struct Storage {
+    int id;
+    size_t bytes;
+    /*! \brief offset inside the device arena, 0 unless planned by best_fit_offset */
+    size_t offset;
+    std::vector<std::vector<uint32_t> > lifetimes;
+    void Save(dmlc::JSONWriter* writer) const {
+      writer->BeginObject(false);
+      writer->WriteObjectKeyValue("id", id);
+      writer->WriteObjectKeyValue("bytes", bytes);
+      writer->WriteObjectKeyValue("offset", offset);
+      writer->WriteObjectKeyValue("lifetimes", lifetimes);
+      writer->EndObject();
+    }
+  };
+  /*! \brief an output written into the storage of one of its inputs */
+  struct Inplace {
+    uint32_t node_id;
+    uint32_t output;
+    uint32_t input;
+    int storage_id;
+    void Save(dmlc::JSONWriter* writer) const {
+      writer->BeginObject(false);
+      writer->WriteObjectKeyValue("node_id", node_id);
+      writer->WriteObjectKeyValue("output", output);
+      writer->WriteObjectKeyValue("input", input);
+      writer->WriteObjectKeyValue("storage_id", storage_id);
+      writer->EndObject();
+    }
+  };
+  /*! \brief bytes of the memory pool allocated by the executor for internal entries */
+  size_t planned_bytes = 0;
+  /*! \brief largest sum of pool blocks holding live data at the same time */
+  size_t peak_live_bytes = 0;
+  /*! \brief bytes of the variables: arguments, auxiliary states and head gradients */
+  size_t input_bytes = 0;
+  /*! \brief bytes of outputs bound to external arrays, e.g. argument gradients */
+  size_t external_bytes = 0;
+  /*! \brief number of entries allocated at runtime, e.g. sparse or unknown shapes */
+  size_t num_dynamic = 0;
+  std::vector<std::string> nodes;
+  std::vector<Storage> storage;
+  std::vector<Inplace> inplace;
+
+  void Save(dmlc::JSONWriter* writer) const {
+    writer->BeginObject();
+    writer->WriteObjectKeyValue("planned_bytes", planned_bytes);
+    writer->WriteObjectKeyValue("peak_live_bytes", peak_live_bytes);
+    writer->WriteObjectKeyValue("input_bytes", input_bytes);
+    writer->WriteObjectKeyValue("external_bytes", external_bytes);
+    writer->WriteObjectKeyValue("num_dynamic", num_dynamic);
+    writer->WriteObjectKeyValue("nodes", nodes);
+    writer->WriteObjectKeyValue("storage", storage);
+    writer->WriteObjectKeyValue("inplace", inplace);
+    writer->EndObject();
+  }
+};
+
+/*!
+ * \brief Collect the MemoryPlanInfo of a graph with "shape", "dtype", "storage_id"
+ *        and "storage_inplace_index" attributes. Pool blocks are sized the way
+ *        GraphExecutor sizes them: the largest entry mapped to them, in 4 byte words.
+ *        With a "storage_offset" plan the planned bytes are those of the device arenas.
+ */
+inline MemoryPlanInfo GetMemoryPlanInfo(const nnvm::Graph& g) {
+  const auto& idx = g.indexed_graph();
+  const auto& vshape = g.GetAttr<mxnet::ShapeVector>("shape");
+  const auto& vtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+  const auto& vstorage = g.GetAttr<nnvm::StorageVector>("storage_id");
+  const auto& vinplace = g.GetAttr<std::vector<int> >("storage_inplace_index");
+  const uint32_t num_nodes = idx.num_nodes();
+  auto entry_bytes = [&](uint32_t eid) -> size_t {
+    if (!shape_is_known(vshape[eid]) || vtype[eid] < 0) return 0;
+    return vshape[eid].Size() * mshadow::mshadow_sizeof(vtype[eid]);
+  };
+  // an entry is live from the node producing it to its last reader
+  std::vector<uint32_t> last_use(idx.num_node_entries(), 0);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+      last_use[idx.entry_id(nid, i)] = nid;
+    }
+    for (const auto& e : idx[nid].inputs) {
+      last_use[idx.entry_id(e)] = std::max(last_use[idx.entry_id(e)], nid);
+    }
+  }
+  for (const auto& e : idx.outputs()) {
+    last_use[idx.entry_id(e)] = num_nodes - 1;
+  }
+
+  MemoryPlanInfo info;
+  std::vector<std::vector<std::pair<uint32_t, uint32_t> > > intervals;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = idx[nid];
+    info.nodes.push_back(inode.source->attrs.name);
+    if (inode.source->is_variable()) {
+      info.input_bytes += entry_bytes(idx.entry_id(nid, 0));
+      continue;
+    }
+    for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+      const uint32_t eid = idx.entry_id(nid, i);
+      const int sid = vstorage[eid];
+      if (sid == exec::kExternalStorageID) {
+        info.external_bytes += entry_bytes(eid);
+      } else if (sid < 0) {
+        ++info.num_dynamic;
+      } else {
+        if (static_cast<size_t>(sid) >= info.storage.size()) {
+          info.storage.resize(sid + 1, MemoryPlanInfo::Storage{0, 0, 0, {}});
+          intervals.resize(sid + 1);
+        }
+        info.storage[sid].id = sid;
+        info.storage[sid].bytes = std::max(info.storage[sid].bytes,
+                                           (entry_bytes(eid) + 3) / 4 * 4);
+        intervals[sid].emplace_back(nid, last_use[eid]);
+      }
+      if (vinplace[eid] >= 0) {
+        info.inplace.push_back(MemoryPlanInfo::Inplace{
+            nid, i, static_cast<uint32_t>(vinplace[eid]), sid});
+      }
+    }
+  }
+  // merge the lifetimes of entries sharing a block through inplace reuse
+  const bool has_offset = g.attrs.count("storage_offset") != 0;
+  std::map<int, size_t> arena_bytes;
+  std::vector<int64_t> live_delta(num_nodes + 1, 0);
+  for (size_t sid = 0; sid < info.storage.size(); ++sid) {
+    MemoryPlanInfo::Storage& st = info.storage[sid];
+    if (has_offset) {
+      st.offset = g.GetAttr<std::vector<size_t> >("storage_offset").at(sid);
+      const int dev_id = g.attrs.count("device") && !intervals[sid].empty() ?
+          g.GetAttr<nnvm::DeviceVector>("device").at(intervals[sid].front().first) : 0;
+      arena_bytes[dev_id] = std::max(arena_bytes[dev_id], st.offset + st.bytes);
+    } else {
+      info.planned_bytes += st.bytes;
+    }
+    std::sort(intervals[sid].begin(), intervals[sid].end());
+    for (const auto& iv : intervals[sid]) {
+      if (!st.lifetimes.empty() && iv.first <= st.lifetimes.back()[1]) {
+        st.lifetimes.back()[1] = std::max(st.lifetimes.back()[1], iv.second);
+      } else {
+        st.lifetimes.push_back({iv.first, iv.second});
+      }
+    }
+    for (const auto& lt : st.lifetimes) {
+      live_delta[lt[0]] += st.bytes;
+      live_delta[lt[1] + 1] -= st.bytes;
+    }
+  }
+  for (const auto& kv : arena_bytes) info.planned_bytes += kv.second;
+  int64_t live = 0;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    live += live_delta[nid];
+    info.peak_live_bytes = std::max(info.peak_live_bytes, static_cast<size_t>(live));
+  }
+  return info;
+}
+
 /* log the static memory plan of the graph. Example:
     node 0 var
     node 1 _copy: fcompute
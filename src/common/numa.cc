@@ -0,0 +1,171 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file numa.cc
+ * \brief NUMA topology discovery, thread pinning and memory binding for CPU contexts.
+ */
+#include "./numa.h"
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif  // defined(__linux__)
+
+namespace mxnet {
+namespace common {
+namespace numa {
+
+namespace {
+
+/*! \brief NUMA topology of the machine, discovered once. */
+struct Topology {
+  bool enabled = false;
+  // operating system id and logical cpus of every node with cpus
+  std::vector<int> node_ids;
+  std::vector<std::vector<int>> node_cpus;
+
+  Topology() {
+#if defined(__linux__)
+    if (!dmlc::GetEnv("MXNET_CPU_NUMA", false)) return;
+    std::vector<int> nodes = ParseList(ReadFile("/sys/devices/system/node/online"));
+    for (int node : nodes) {
+      std::ostringstream path;
+      path << "/sys/devices/system/node/node" << node << "/cpulist";
+      std::vector<int> cpus = ParseList(ReadFile(path.str()));
+      // memory-only nodes cannot run workers
+      if (cpus.empty()) continue;
+      node_ids.push_back(node);
+      node_cpus.push_back(cpus);
+    }
+    if (node_cpus.empty()) {
+      LOG(WARNING) << "MXNET_CPU_NUMA is set but no NUMA topology was found, ignoring.";
+      return;
+    }
+    enabled = true;
+    LOG(INFO) << "NUMA mode enabled with " << node_cpus.size() << " node(s).";
+#endif  // defined(__linux__)
+  }
+
+  static std::string ReadFile(const std::string& path) {
+    std::ifstream is(path);
+    std::string content;
+    std::getline(is, content);
+    return content;
+  }
+
+  // parse a sysfs list such as "0-3,8-11,16"
+  static std::vector<int> ParseList(const std::string& str) {
+    std::vector<int> ret;
+    std::istringstream is(str);
+    std::string range;
+    while (std::getline(is, range, ',')) {
+      if (range.empty()) continue;
+      size_t dash = range.find('-');
+      int begin = std::stoi(range.substr(0, dash));
+      int end = dash == std::string::npos ? begin : std::stoi(range.substr(dash + 1));
+      for (int i = begin; i <= end; ++i) ret.push_back(i);
+    }
+    return ret;
+  }
+
+  static Topology* Get() {
+    static Topology inst;
+    return &inst;
+  }
+};
+
+}  // namespace
+
+bool Enabled() {
+  return Topology::Get()->enabled;
+}
+
+int NumNodes() {
+  const Topology* topo = Topology::Get();
+  return topo->enabled ? static_cast<int>(topo->node_cpus.size()) : 1;
+}
+
+int NodeOfDevice(int dev_id) {
+  return dev_id < 0 ? 0 : dev_id % NumNodes();
+}
+
+const std::vector<int>& NodeCPUs(int node) {
+  const Topology* topo = Topology::Get();
+  CHECK(topo->enabled) << "NUMA mode is not enabled";
+  CHECK_LT(node, static_cast<int>(topo->node_cpus.size()));
+  return topo->node_cpus[node];
+}
+
+bool BindCurrentThreadToNode(int node) {
+#if defined(__linux__)
+  if (!Enabled()) return false;
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (int cpu : NodeCPUs(node)) {
+    CPU_SET(cpu, &cpuset);
+  }
+  if (sched_setaffinity(0, sizeof(cpuset), &cpuset) != 0) {
+    LOG(WARNING) << "Failed to pin thread to NUMA node " << node;
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif  // defined(__linux__)
+}
+
+bool BindMemoryToNode(void* ptr, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  if (!Enabled() || size == 0) return false;
+  const int os_node = Topology::Get()->node_ids.at(node);
+  // MPOL_BIND from <numaif.h>, which is only shipped with libnuma
+  constexpr int kMPolBind = 2;
+  constexpr size_t kBitsPerWord = sizeof(unsigned long) * 8;  // NOLINT(runtime/int)
+  std::vector<unsigned long> mask(os_node / kBitsPerWord + 1, 0);  // NOLINT(runtime/int)
+  mask[os_node / kBitsPerWord] |= 1ul << (os_node % kBitsPerWord);
+  if (syscall(SYS_mbind, ptr, size, kMPolBind, mask.data(),
+              mask.size() * kBitsPerWord + 1, 0) != 0) {
+    LOG(WARNING) << "Failed to bind memory to NUMA node " << node;
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif  // defined(__linux__) && defined(SYS_mbind)
+}
+
+size_t PageSize() {
+#if defined(__linux__)
+  static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return page_size;
+#else
+  return 4096;
+#endif  // defined(__linux__)
+}
+
+}  // namespace numa
+}  // namespace common
+}  // namespace mxnet
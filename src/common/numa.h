@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file numa.h
+ * \brief NUMA topology discovery, thread pinning and memory binding for CPU contexts.
+ *
+ *  When MXNET_CPU_NUMA is enabled, CPU context `cpu(i)` is mapped to NUMA node
+ *  `i % num_nodes`. Engine workers of that context are pinned to the cores of the node
+ *  and large allocations of that context are bound to the memory of the node.
+ *  Only implemented on Linux, where the topology is read from sysfs. On other
+ *  platforms NUMA mode is silently disabled.
+ */
+#ifndef MXNET_COMMON_NUMA_H_
+#define MXNET_COMMON_NUMA_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace mxnet {
+namespace common {
+namespace numa {
+
+/*!
+ * \brief Whether NUMA mode is requested through MXNET_CPU_NUMA and the machine
+ *  exposes a NUMA topology.
+ */
+bool Enabled();
+/*! \brief Number of NUMA nodes, 1 if the topology is unknown. */
+int NumNodes();
+/*!
+ * \brief NUMA node of a CPU context device id.
+ * \param dev_id device id of a CPU context.
+ */
+int NodeOfDevice(int dev_id);
+/*!
+ * \brief Logical cpus belonging to a NUMA node.
+ * \param node NUMA node index.
+ */
+const std::vector<int>& NodeCPUs(int node);
+/*!
+ * \brief Pin the calling thread to the cores of a NUMA node.
+ *  Threads created afterwards by the calling thread, such as OpenMP workers,
+ *  inherit the affinity.
+ * \param node NUMA node index.
+ * \return whether the affinity was applied.
+ */
+bool BindCurrentThreadToNode(int node);
+/*!
+ * \brief Bind the pages of a memory range to a NUMA node.
+ *  The range must start on a page boundary.
+ * \param ptr start of the range.
+ * \param size size of the range in bytes.
+ * \param node NUMA node index.
+ * \return whether the policy was applied.
+ */
+bool BindMemoryToNode(void* ptr, size_t size, int node);
+/*! \brief System page size. */
+size_t PageSize();
+
+}  // namespace numa
+}  // namespace common
+}  // namespace mxnet
+
+#endif  // MXNET_COMMON_NUMA_H_
@@ -81,6 +81,8 @@ Engine *CreateNaiveEngine();
 Engine *CreateThreadedEnginePooled();
 /*! \return ThreadedEnginePerDevie instance */
 Engine *CreateThreadedEnginePerDevice();
+/*! \return ThreadedEnginePerDevice instance with work stealing cpu workers */
+Engine *CreateThreadedEnginePerDeviceWorkStealing();
 #endif
 }  // namespace engine
 }  // namespace mxnet
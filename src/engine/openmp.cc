@@ -19,6 +19,7 @@
 #include <dmlc/omp.h>
 #include <dmlc/base.h>
 #include <dmlc/parameter.h>
+#include <algorithm>
 #include <climits>
 #include "./openmp.h"
 
@@ -61,10 +62,18 @@ OpenMP::OpenMP()
 #endif
 }
 
-void OpenMP::on_start_worker_thread(bool use_omp) {
+void OpenMP::on_start_worker_thread(bool use_omp, int num_cpus) {
 #ifdef _OPENMP
   if (!omp_num_threads_set_in_environment_) {
-    omp_set_num_threads(use_omp ? GetRecommendedOMPThreadCount(true) : 1);
+    int thread_count = use_omp ? GetRecommendedOMPThreadCount(true) : 1;
+    if (num_cpus > 0) {
+#ifdef ARCH_IS_INTEL_X86
+      // same hyper-threading assumption as omp_thread_max_
+      num_cpus = std::max(num_cpus >> 1, 1);
+#endif
+      thread_count = std::min(thread_count, num_cpus);
+    }
+    omp_set_num_threads(thread_count);
   }
 #endif
 }
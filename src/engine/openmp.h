@@ -71,8 +71,10 @@ class OpenMP {
    * \brief Call at the beginning of a worker thread's life.  This will set the omp_num_threads
    *        for omp regions created by this thread
    * \param use_omp true if this thread plans to utilize parallel omp regions
+   * \param num_cpus if positive, number of logical cpus the thread is pinned to (e.g. the cores
+   *        of its NUMA node), which further caps the omp_num_threads of the thread
    */
-  void on_start_worker_thread(bool use_omp);
+  void on_start_worker_thread(bool use_omp, int num_cpus = 0);
 
   /*!
    * \brief Get the OpenMP object's singleton pointer
@@ -49,7 +49,7 @@ ThreadedVar::ThreadedVar(VersionedVarBlock* head) : head_{head} {
 }
 
 inline void ThreadedVar::AppendReadDependency(OprBlock* opr_block) {
-  std::lock_guard<std::mutex> lock{mutex_};
+  std::lock_guard<VarSpinLock> lock{mutex_};
   if (pending_write_ == nullptr) {
     // invariant: is_ready_to_read()
     CHECK_GE(num_pending_reads_, 0);
@@ -71,7 +71,7 @@ inline void ThreadedVar::AppendReadDependency(OprBlock* opr_block) {
 
 inline void ThreadedVar::AppendWriteDependency(OprBlock* opr_block) {
   auto&& new_var_block = VersionedVarBlock::New();
-  std::lock_guard<std::mutex> lock{mutex_};
+  std::lock_guard<VarSpinLock> lock{mutex_};
   // invariant.
   assert(head_->next == nullptr);
   assert(head_->trigger == nullptr);
@@ -102,7 +102,7 @@ inline void ThreadedVar::CompleteReadDependency(Dispatcher dispatcher) {
   OprBlock *trigger = nullptr;
   {
     // this is lock scope
-    std::lock_guard<std::mutex> lock{mutex_};
+    std::lock_guard<VarSpinLock> lock{mutex_};
     CHECK_GT(num_pending_reads_, 0);
 
     if (--num_pending_reads_ == 0) {
@@ -124,7 +124,7 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
   VersionedVarBlock *old_pending_write, *end_of_read_chain;
   OprBlock* trigger_write = nullptr;
   {
-    std::lock_guard<std::mutex> lock{mutex_};
+    std::lock_guard<VarSpinLock> lock{mutex_};
     // invariants
     assert(head_->next == nullptr);
     assert(pending_write_ != nullptr);
@@ -190,17 +190,17 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
 }
 
 inline void ThreadedVar::SetToDelete() {
-  std::lock_guard<std::mutex> lock{mutex_};
+  std::lock_guard<VarSpinLock> lock{mutex_};
   to_delete_ = true;
 }
 
 inline bool ThreadedVar::ready_to_read() {
-  std::lock_guard<std::mutex> lock{mutex_};
+  std::lock_guard<VarSpinLock> lock{mutex_};
   return this->is_ready_to_read();
 }
 
 inline size_t ThreadedVar::version() {
-  std::lock_guard<std::mutex> lock{mutex_};
+  std::lock_guard<VarSpinLock> lock{mutex_};
   return this->version_;
 }
 
@@ -301,6 +301,9 @@ void ThreadedEngine::Push(OprHandle op, Context exec_ctx, int priority, bool pro
   opr_block->ctx = exec_ctx;
   opr_block->priority = priority;
   opr_block->profiling = profiling;
+  if (profiling) {
+    opr_block->push_time = profiler::ProfileStat::NowInMicrosec();
+  }
   ++pending_;
   // Add read dependencies.
   for (auto&& i : threaded_opr->const_vars) {
@@ -311,6 +314,7 @@ void ThreadedEngine::Push(OprHandle op, Context exec_ctx, int priority, bool pro
     i->AppendWriteDependency(opr_block);
   }
   if (opr_block->decr_wait() == 0) {
+    opr_block->MarkReady(nullptr, nullptr);
     this->PushToExecute(opr_block, true);
   }
 }
@@ -443,7 +447,10 @@ inline void ThreadedEngine::OnComplete(ThreadedOpr* threaded_opr) {
   // Mark complete for read variables
   for (auto&& i : threaded_opr->const_vars) {
     i->CompleteReadDependency(
-        [this](OprBlock* opr) { this->PushToExecute(opr, false); });
+        [this, i, threaded_opr](OprBlock* opr) {
+          opr->MarkReady(i, threaded_opr->opr_name);
+          this->PushToExecute(opr, false);
+        });
   }
   // Mark complete for write variables.
   for (auto&& i : threaded_opr->mutable_vars) {
@@ -458,7 +465,8 @@ inline void ThreadedEngine::OnComplete(ThreadedOpr* threaded_opr) {
       LOG(INFO) << "Complete write dep for " << i;
     }
     const bool to_delete =
-        i->CompleteWriteDependency([this, debug_info](OprBlock* opr) {
+        i->CompleteWriteDependency([this, i, threaded_opr, debug_info](OprBlock* opr) {
+          opr->MarkReady(i, threaded_opr->opr_name);
           if (debug_info) {
             LOG(INFO) << "PushToExecute " << opr;
             debug_push_opr_ = opr;
@@ -83,6 +83,14 @@ struct OprBlock : public common::ObjectPoolAllocatable<OprBlock> {
   bool profiling{false};
   /*! \brief operator execution statistics */
   std::unique_ptr<profiler::ProfileOperator> opr_profile;
+  /*! \brief time the operator was pushed, only recorded when profiling */
+  uint64_t push_time{0};
+  /*! \brief time all dependencies were satisfied, only recorded when profiling */
+  uint64_t ready_time{0};
+  /*! \brief the var whose completion made the block ready, nullptr if ready when pushed */
+  const Var* ready_var{nullptr};
+  /*! \brief name of the operator that completed ready_var */
+  const char* ready_opr_name{nullptr};
   // define possible debug information
   DEFINE_ENGINE_DEBUG_INFO(OprBlock);
   /*!
@@ -95,6 +103,19 @@ struct OprBlock : public common::ObjectPoolAllocatable<OprBlock> {
     CHECK_GE(ret, 0);
     return ret;
   }
+  /*!
+   * \brief record when and by what the block became ready, if profiling.
+   *  Call this once the wait counter dropped to zero.
+   * \param var the var whose completion made the block ready, nullptr if ready when pushed.
+   * \param opr_name name of the operator that completed var.
+   */
+  inline void MarkReady(const Var* var, const char* opr_name) {
+    if (profiling) {
+      ready_time = profiler::ProfileStat::NowInMicrosec();
+      ready_var = var;
+      ready_opr_name = opr_name;
+    }
+  }
 };  // struct OprBlock
 
 /*!
@@ -113,6 +134,32 @@ struct VersionedVarBlock
   DEFINE_ENGINE_DEBUG_INFO(VersionedVarBlock);
 };  // struct VersionedVarBlock
 
+/*!
+ * \brief Test-and-test-and-set spin lock guarding the state of a ThreadedVar.
+ *  The critical sections only update a few fields of the var, so spinning is much
+ *  cheaper than parking the thread on a mutex. After kSpinCount failed spins the
+ *  waiting thread yields, so that a preempted owner does not make it burn a whole
+ *  time slice when there are more threads than cores.
+ */
+class VarSpinLock {
+ public:
+  inline void lock() {
+    int spin = 0;
+    while (locked_.exchange(true, std::memory_order_acquire)) {
+      do {
+        if (++spin > kSpinCount) std::this_thread::yield();
+      } while (locked_.load(std::memory_order_relaxed));
+    }
+  }
+  inline void unlock() {
+    locked_.store(false, std::memory_order_release);
+  }
+
+ private:
+  static constexpr int kSpinCount = 128;
+  std::atomic<bool> locked_{false};
+};  // class VarSpinLock
+
 /*!
  * \brief Variable implementation.
  *  Each ThreadedVar is a linked list(queue) of operations to be performed.
@@ -189,10 +236,9 @@ class ThreadedVar final
   ExceptionRef var_exception;
 
  private:
-  // TODO(hotpxl) change this to spinlock for faster runtime
   // TODO(hotpxl) consider rename head
-  /*! \brief internal mutex of the ThreadedVar */
-  std::mutex mutex_;
+  /*! \brief internal lock of the ThreadedVar */
+  VarSpinLock mutex_;
   /*!
    * \brief number of pending reads operation in the variable.
    *  will be marked as -1 when there is a already triggered pending write.
@@ -359,6 +405,9 @@ class ThreadedEngine : public Engine {
       const Context& ctx = opr_block->ctx;
       opr_block->opr_profile.reset(new profiler::ProfileOperator(threaded_opr->opr_name,
                                                                  attrs.release()));
+      opr_block->opr_profile->set_dependency_info(opr_block->push_time, opr_block->ready_time,
+                                                  opr_block->ready_var,
+                                                  opr_block->ready_opr_name);
       opr_block->opr_profile->start(ctx.dev_type, ctx.dev_id);
     }
     CallbackOnComplete callback =
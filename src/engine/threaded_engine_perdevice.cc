@@ -30,7 +30,9 @@
 #include <dmlc/thread_group.h>
 #include "./threaded_engine.h"
 #include "./thread_pool.h"
+#include "./work_stealing_queue.h"
 #include "../common/lazy_alloc_array.h"
+#include "../common/numa.h"
 #include "../common/utils.h"
 
 namespace mxnet {
@@ -51,7 +53,12 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   static auto constexpr kPriorityQueue = kPriority;
   static auto constexpr kWorkerQueue = kFIFO;
 
-  ThreadedEnginePerDevice() noexcept(false) {
+  /*!
+   * \param cpu_work_stealing whether CPU workers use per-worker lock-free deques with
+   *  work stealing instead of one blocking queue per device.
+   */
+  explicit ThreadedEnginePerDevice(bool cpu_work_stealing = false) noexcept(false)
+    : cpu_work_stealing_(cpu_work_stealing) {
     this->Start();
   }
   ~ThreadedEnginePerDevice() noexcept(false) {
@@ -64,6 +71,7 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     gpu_priority_workers_.Clear();
     gpu_copy_workers_.Clear();
     cpu_normal_workers_.Clear();
+    cpu_stealing_workers_.Clear();
     cpu_priority_worker_.reset(nullptr);
   }
 
@@ -105,6 +113,24 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
         // CPU execution.
         if (opr_block->opr->prop == FnProperty::kCPUPrioritized) {
           cpu_priority_worker_->task_queue.Push(opr_block, opr_block->priority);
+        } else if (cpu_work_stealing_) {
+          int nthread = cpu_worker_nthreads_;
+          auto ptr =
+          cpu_stealing_workers_.Get(ctx.dev_id, [this, ctx, nthread]() {
+              auto blk = new WorkStealingWorkerBlock(nthread);
+              blk->pool.reset(new ThreadPool(nthread,
+                  [this, ctx, blk](std::shared_ptr<dmlc::ManualEvent> ready_event) {
+                    this->CPUWorker(ctx, blk, ready_event, true);
+                  }, true));
+            return blk;
+          });
+          if (ptr) {
+            if (opr_block->opr->prop == FnProperty::kDeleteVar) {
+              ptr->task_queue.PushFront(opr_block, opr_block->priority);
+            } else {
+              ptr->task_queue.Push(opr_block, opr_block->priority);
+            }
+          }
         } else {
           int dev_id = ctx.dev_id;
           int nthread = cpu_worker_nthreads_;
@@ -113,7 +139,7 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
               auto blk = new ThreadWorkerBlock<kWorkerQueue>();
               blk->pool.reset(new ThreadPool(nthread,
                   [this, ctx, blk](std::shared_ptr<dmlc::ManualEvent> ready_event) {
-                    this->CPUWorker(ctx, blk, ready_event);
+                    this->CPUWorker(ctx, blk, ready_event, true);
                   }, true));
             return blk;
           });
@@ -211,9 +237,22 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     // destructor
     ~ThreadWorkerBlock() noexcept(false) {}
   };
+  // working unit of the cpu workers in work stealing mode.
+  struct WorkStealingWorkerBlock {
+    // task queue shared by the workers, with one deque per worker
+    WorkStealingQueue<OprBlock*> task_queue;
+    // thread pool that works on this task
+    std::unique_ptr<ThreadPool> pool;
+    // constructor
+    explicit WorkStealingWorkerBlock(int nthread) : task_queue(nthread) {}
+    // destructor
+    ~WorkStealingWorkerBlock() noexcept(false) {}
+  };
 
   /*! \brief whether this is a worker thread. */
   static MX_THREAD_LOCAL bool is_worker_;
+  /*! \brief whether cpu workers use work stealing queues */
+  const bool cpu_work_stealing_;
   /*! \brief number of concurrent thread cpu worker uses */
   size_t cpu_worker_nthreads_;
   /*! \brief number of concurrent thread each gpu worker uses */
@@ -222,6 +261,8 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   size_t gpu_copy_nthreads_;
   // cpu worker
   common::LazyAllocArray<ThreadWorkerBlock<kWorkerQueue> > cpu_normal_workers_;
+  // cpu worker in work stealing mode
+  common::LazyAllocArray<WorkStealingWorkerBlock> cpu_stealing_workers_;
   // cpu priority worker
   std::unique_ptr<ThreadWorkerBlock<kPriorityQueue> > cpu_priority_worker_;
   // workers doing normal works on GPU
@@ -280,11 +321,13 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   /*!
    * \brief CPU worker that performs operations on CPU.
    * \param block The task block of the worker.
+   * \param bind_numa whether to pin the worker to the NUMA node of ctx in NUMA mode.
    */
-  template<dmlc::ConcurrentQueueType type>
+  template<typename WorkerBlock>
   inline void CPUWorker(Context ctx,
-                        ThreadWorkerBlock<type> *block,
-                        const std::shared_ptr<dmlc::ManualEvent>& ready_event) {
+                        WorkerBlock *block,
+                        const std::shared_ptr<dmlc::ManualEvent>& ready_event,
+                        bool bind_numa = false) {
     this->is_worker_ = true;
     auto* task_queue = &(block->task_queue);
     RunContext run_ctx{ctx, nullptr, nullptr, false};
@@ -293,8 +336,18 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     OprBlock* opr_block;
     ready_event->signal();
 
+    // In NUMA mode, workers of a CPU context stay on the cores of its node. This is done
+    // before the first OMP region, so that the OMP threads of this worker inherit it.
+    int num_cpus = 0;
+    if (bind_numa && common::numa::Enabled()) {
+      const int node = common::numa::NodeOfDevice(ctx.dev_id);
+      if (common::numa::BindCurrentThreadToNode(node)) {
+        num_cpus = static_cast<int>(common::numa::NodeCPUs(node).size());
+      }
+    }
+
     // Set default number of threads for OMP parallel regions initiated by this thread
-    OpenMP::Get()->on_start_worker_thread(true);
+    OpenMP::Get()->on_start_worker_thread(true, num_cpus);
 
     while (task_queue->Pop(&opr_block)) {
       this->ExecuteOprBlock(run_ctx, opr_block);
@@ -336,6 +389,7 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     SignalQueueForKill(&gpu_normal_workers_);
     SignalQueueForKill(&gpu_copy_workers_);
     SignalQueueForKill(&cpu_normal_workers_);
+    SignalQueueForKill(&cpu_stealing_workers_);
     if (cpu_priority_worker_) {
       cpu_priority_worker_->task_queue.SignalForKill();
     }
@@ -346,6 +400,10 @@ Engine *CreateThreadedEnginePerDevice() {
   return new ThreadedEnginePerDevice();
 }
 
+Engine *CreateThreadedEnginePerDeviceWorkStealing() {
+  return new ThreadedEnginePerDevice(true);
+}
+
 MX_THREAD_LOCAL bool ThreadedEnginePerDevice::is_worker_ = false;
 
 }  // namespace engine
@@ -0,0 +1,372 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file work_stealing_queue.h
+ * \brief Task queue with per-worker lock-free deques and work stealing.
+ */
+#ifndef MXNET_ENGINE_WORK_STEALING_QUEUE_H_
+#define MXNET_ENGINE_WORK_STEALING_QUEUE_H_
+
+#include <dmlc/base.h>
+#include <dmlc/logging.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mxnet {
+namespace engine {
+
+/*!
+ * \brief Chase-Lev work stealing deque.
+ *
+ *  The owner thread pushes and pops at the bottom, other threads steal from the top.
+ *  Follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al., 2013).
+ *  Arrays replaced on growth are kept alive until destruction, since a concurrent
+ *  thief may still read from them.
+ * \tparam T trivially copyable element type, typically a pointer.
+ */
+template<typename T>
+class WorkStealingDeque {
+ public:
+  explicit WorkStealingDeque(int64_t log2_capacity = 8)
+      : top_(0), bottom_(0) {
+    arrays_.emplace_back(new Array(int64_t(1) << log2_capacity));
+    array_.store(arrays_.back().get(), std::memory_order_relaxed);
+  }
+  /*! \brief Push at the bottom, owner only. */
+  void Push(T value) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Array* a = array_.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1) {
+      a = Grow(a, t, b);
+    }
+    a->Put(b, value);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+  /*! \brief Pop from the bottom, owner only. */
+  bool Pop(T* value) {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Array* a = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      // empty
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    *value = a->Get(b);
+    if (t == b) {
+      // last element, race against thieves
+      bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+  /*! \brief Steal from the top, any thread. */
+  bool Steal(T* value) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return false;
+    Array* a = array_.load(std::memory_order_acquire);
+    T x = a->Get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return false;
+    }
+    *value = x;
+    return true;
+  }
+
+ private:
+  struct Array {
+    explicit Array(int64_t cap) : capacity(cap), mask(cap - 1), data(new std::atomic<T>[cap]) {}
+    T Get(int64_t i) const {
+      return data[i & mask].load(std::memory_order_relaxed);
+    }
+    void Put(int64_t i, T value) {
+      data[i & mask].store(value, std::memory_order_relaxed);
+    }
+    const int64_t capacity;
+    const int64_t mask;
+    std::unique_ptr<std::atomic<T>[]> data;
+  };
+
+  Array* Grow(Array* a, int64_t t, int64_t b) {
+    Array* grown = new Array(a->capacity * 2);
+    for (int64_t i = t; i < b; ++i) {
+      grown->Put(i, a->Get(i));
+    }
+    arrays_.emplace_back(grown);
+    array_.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+  alignas(64) std::atomic<int64_t> top_;
+  alignas(64) std::atomic<int64_t> bottom_;
+  std::atomic<Array*> array_;
+  // all arrays ever used, owner only
+  std::vector<std::unique_ptr<Array>> arrays_;
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
+/*!
+ * \brief Bounded lock-free multi-producer multi-consumer queue (D. Vyukov).
+ * \tparam T trivially copyable element type, typically a pointer.
+ */
+template<typename T>
+class MPMCBoundedQueue {
+ public:
+  /*!
+   * \param log2_capacity log2 of the queue capacity.
+   */
+  explicit MPMCBoundedQueue(int log2_capacity = 10)
+      : mask_((size_t(1) << log2_capacity) - 1),
+        cells_(new Cell[mask_ + 1]),
+        enqueue_pos_(0), dequeue_pos_(0) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+  /*! \return false if the queue is full. */
+  bool TryPush(T value) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = value;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+  /*! \return false if the queue is empty. */
+  bool TryPop(T* value) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    *value = cell->data;
+    cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T data;
+  };
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<size_t> enqueue_pos_;
+  alignas(64) std::atomic<size_t> dequeue_pos_;
+  DISALLOW_COPY_AND_ASSIGN(MPMCBoundedQueue);
+};
+
+/*!
+ * \brief Blocking task queue shared by a fixed set of worker threads, with the same
+ *  Push/PushFront/Pop/SignalForKill interface as dmlc::ConcurrentBlockingQueue.
+ *
+ *  Each worker owns a WorkStealingDeque. Tasks pushed by a worker of this queue (e.g. an
+ *  operator made ready by the completion of another one) go to the bottom of its own deque
+ *  and are popped LIFO by it, so that the pusher never takes a lock. Tasks pushed by other
+ *  threads go to lock-free injection queues: PushFront uses a separate injection queue
+ *  that is always drained first. Idle workers steal from the top of the other deques.
+ *  Only idle workers that run out of work take the mutex, to go to sleep.
+ *
+ *  Unlike the dmlc queue, priorities are ignored, which matches the FIFO worker queues.
+ * \tparam T trivially copyable element type, typically a pointer.
+ */
+template<typename T>
+class WorkStealingQueue {
+ public:
+  /*!
+   * \param num_workers number of worker threads that will call Pop.
+   */
+  explicit WorkStealingQueue(int num_workers)
+      : deques_(num_workers) {
+    CHECK_GT(num_workers, 0);
+    for (auto& deque : deques_) {
+      deque.reset(new WorkStealingDeque<T>());
+    }
+  }
+  /*! \brief Push a task at the back. */
+  void Push(T value, int priority = 0) {
+    if (tls_queue_ == this) {
+      deques_[tls_index_]->Push(value);
+    } else if (!inject_.TryPush(value)) {
+      PushOverflow(value, false);
+    }
+    Notify();
+  }
+  /*! \brief Push a task at the front, so that it is the next one to run. */
+  void PushFront(T value, int priority = 0) {
+    if (tls_queue_ == this) {
+      // the owner pops LIFO, so the bottom of its deque is the front
+      deques_[tls_index_]->Push(value);
+    } else if (!inject_front_.TryPush(value)) {
+      PushOverflow(value, true);
+    }
+    Notify();
+  }
+  /*!
+   * \brief Pop a task, blocking until one is available or the queue is killed.
+   *  Must only be called by the num_workers worker threads.
+   * \return false if the queue was killed.
+   */
+  bool Pop(T* value) {
+    if (tls_queue_ != this) {
+      tls_queue_ = this;
+      tls_index_ = next_index_++;
+      CHECK_LT(tls_index_, static_cast<int>(deques_.size()))
+        << "More workers than declared are popping from WorkStealingQueue";
+    }
+    for (;;) {
+      if (exit_now_.load(std::memory_order_acquire)) return false;
+      for (int spin = 0; spin < kSpinCount; ++spin) {
+        if (TryPop(value)) {
+          pending_.fetch_sub(1);
+          return true;
+        }
+        if (spin != 0) std::this_thread::yield();
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      ++num_sleepers_;
+      cv_.wait(lock, [this] {
+        return pending_.load() > 0 || exit_now_.load();
+      });
+      --num_sleepers_;
+    }
+  }
+  /*! \brief Wake up all workers and make Pop return false from now on. */
+  void SignalForKill() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_now_.store(true);
+    cv_.notify_all();
+  }
+
+ private:
+  static constexpr int kSpinCount = 16;
+
+  bool TryPop(T* value) {
+    const int self = tls_index_;
+    if (inject_front_.TryPop(value)) return true;
+    if (deques_[self]->Pop(value)) return true;
+    if (inject_.TryPop(value)) return true;
+    if (num_overflow_.load(std::memory_order_acquire) > 0 && PopOverflow(value)) return true;
+    const int n = static_cast<int>(deques_.size());
+    for (int i = 1; i < n; ++i) {
+      if (deques_[(self + i) % n]->Steal(value)) return true;
+    }
+    return false;
+  }
+
+  void Notify() {
+    // pairs with the increment of num_sleepers_ before the wait predicate is checked:
+    // either the sleeper sees the task or the pusher sees the sleeper.
+    pending_.fetch_add(1);
+    if (num_sleepers_.load() > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_one();
+    }
+  }
+
+  void PushOverflow(T value, bool front) {
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    if (front) {
+      overflow_.push_front(value);
+    } else {
+      overflow_.push_back(value);
+    }
+    num_overflow_.fetch_add(1, std::memory_order_release);
+  }
+
+  bool PopOverflow(T* value) {
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    if (overflow_.empty()) return false;
+    *value = overflow_.front();
+    overflow_.pop_front();
+    num_overflow_.fetch_sub(1, std::memory_order_release);
+    return true;
+  }
+
+  /*! \brief queue the calling thread works for, and its worker index */
+  static MX_THREAD_LOCAL WorkStealingQueue* tls_queue_;
+  static MX_THREAD_LOCAL int tls_index_;
+  /*! \brief per-worker deques */
+  std::vector<std::unique_ptr<WorkStealingDeque<T>>> deques_;
+  /*! \brief tasks pushed by other threads */
+  MPMCBoundedQueue<T> inject_;
+  /*! \brief tasks pushed to the front by other threads */
+  MPMCBoundedQueue<T> inject_front_;
+  /*! \brief fallback when an injection queue is full */
+  std::mutex overflow_mutex_;
+  std::deque<T> overflow_;
+  std::atomic<int> num_overflow_{0};
+  /*! \brief number of tasks pushed but not yet popped */
+  std::atomic<int64_t> pending_{0};
+  /*! \brief next worker index to assign */
+  std::atomic<int> next_index_{0};
+  /*! \brief sleeping workers */
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<int> num_sleepers_{0};
+  std::atomic<bool> exit_now_{false};
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingQueue);
+};
+
+template<typename T>
+MX_THREAD_LOCAL WorkStealingQueue<T>* WorkStealingQueue<T>::tls_queue_ = nullptr;
+template<typename T>
+MX_THREAD_LOCAL int WorkStealingQueue<T>::tls_index_ = 0;
+
+}  // namespace engine
+}  // namespace mxnet
+
+#endif  // MXNET_ENGINE_WORK_STEALING_QUEUE_H_
@@ -61,6 +61,9 @@ GraphExecutor::~GraphExecutor() {
       Engine::Get()->DeleteOperator(seg.opr);
     }
   }
+  for (const auto& space : private_spaces_) {
+    ResourceManager::Get()->FreePrivateSpace(space);
+  }
 }
 
 void GraphExecutor::Forward(bool is_train) {
@@ -176,6 +179,39 @@ void GraphExecutor::SetMonitorCallback(const MonitorCallback& callback, bool mon
   monitor_all_ = monitor_all;
 }
 
+void GraphExecutor::EnableInlineExecution() {
+  if (inline_exec_) return;
+  CHECK(!is_dynamic_) << "Inline execution needs the shapes of all entries to be known";
+  const auto& idx = graph_.indexed_graph();
+  for (size_t nid = 0; nid < num_forward_nodes_; ++nid) {
+    const OpNode& opnode = op_nodes_[nid];
+    if (idx[nid].source->is_variable() || opnode.skip_exec_node) continue;
+    CHECK_EQ(opnode.ctx.dev_mask(), Context::kCPU)
+        << "Inline execution only supports CPU operators, but " << opnode.opr_name
+        << " runs on " << opnode.ctx;
+    CHECK(opnode.exec->exec_type() == ExecType::kSync)
+        << "Inline execution only supports synchronous operators, but "
+        << opnode.opr_name << " is not";
+  }
+  // the setup of the operators has been pushed to the engine at initialization
+  Engine::Get()->WaitForAll();
+  for (size_t nid = 0; nid < num_forward_nodes_; ++nid) {
+    OpNode& opnode = op_nodes_[nid];
+    if (idx[nid].source->is_variable() || opnode.skip_exec_node) continue;
+    // operators run one at a time, so the k-th temporary space of every
+    // operator can be backed by the same private space
+    size_t num_spaces = 0;
+    for (auto& r : opnode.exec->op_ctx.requested) {
+      if (r.req.type != ResourceRequest::kTempSpace) continue;
+      if (num_spaces == private_spaces_.size()) {
+        private_spaces_.push_back(ResourceManager::Get()->RequestPrivateSpace(Context::CPU()));
+      }
+      r = private_spaces_[num_spaces++];
+    }
+  }
+  inline_exec_ = true;
+}
+
 const std::vector<NDArray>& GraphExecutor::outputs() const {
   if (this->is_dynamic_) {
     for (const NDArray &array : output_arrays_) {
@@ -209,6 +245,23 @@ static nnvm::NodeEntry AttrHint(nnvm::NodeEntry src, nnvm::NodeEntry like) {
   return nnvm::NodeEntry{n, 0, 0};
 }
 
+/*!
+ * \brief Select the planner used by MXPlanMemory: "match_range" shares pool blocks of
+ *        similar sizes, "best_fit_offset" packs all blocks of a device into one arena.
+ */
+static void SetMemoryPlanner(nnvm::Graph* g) {
+  std::string planner = dmlc::GetEnv("MXNET_EXEC_MEM_PLANNER", std::string("match_range"));
+#if MXNET_USE_MKLDNN == 1
+  // MKLDNN may grow an array to a padded layout, which needs an array owning its memory
+  if (planner == "best_fit_offset") {
+    LOG(WARNING) << "best_fit_offset memory planner is not supported with MKLDNN, "
+                 << "falling back to match_range";
+    planner = "match_range";
+  }
+#endif
+  g->attrs["mem_planner"] = std::make_shared<dmlc::any>(planner);
+}
+
 nnvm::NodeEntry AggregateGradient(std::vector<nnvm::NodeEntry>&& v) {
   using nnvm::Op;
   static size_t inplace_sum_cap = dmlc::GetEnv("MXNET_EXEC_INPLACE_GRAD_SUM_CAP", 8);
@@ -712,6 +765,7 @@ void GraphExecutor::FinishInitGraph(nnvm::Symbol symbol,
       if (vstorage_type[i] != kDefaultStorage) arg_storage_id[i] = kDynamicStorageID;
     }
     g.attrs["storage"] = std::make_shared<dmlc::any>(std::move(arg_storage_id));
+    SetMemoryPlanner(&g);
     g = nnvm::ApplyPass(g, "MXPlanMemory");
   }
   g = DetectInplaceAddTo(g);
@@ -720,6 +774,10 @@ void GraphExecutor::FinishInitGraph(nnvm::Symbol symbol,
   static bool mem_log_verbose = dmlc::GetEnv("MXNET_MEM_PLAN_VERBOSE_LOGGING", false);
   if (mem_log_verbose) {
     common::LogMemoryPlan(g);
+    const common::MemoryPlanInfo info = common::GetMemoryPlanInfo(g);
+    LOG(INFO) << "memory plan: " << info.storage.size() << " pool blocks, "
+              << info.planned_bytes / 1024 << " KB planned, "
+              << info.peak_live_bytes / 1024 << " KB peak live";
   }
 
   g = AttachOpExecs(g);
@@ -1080,6 +1138,32 @@ void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
       info.bytes = std::max(info.bytes, bytes);
     }
   }
+  // with an offset plan, the pool holds one arena per context and
+  // each storage block is placed at its planned offset inside the arena
+  const bool use_arena = graph_.attrs.count("storage_offset") != 0;
+  std::vector<PoolEntry> block_info;
+  std::vector<size_t> block_arena;
+  if (use_arena) {
+    const auto& voffset = graph_.GetAttr<std::vector<size_t> >("storage_offset");
+    std::vector<PoolEntry> arena_info;
+    block_arena.resize(pool_info.size(), 0);
+    for (size_t sid = 0; sid < pool_info.size(); ++sid) {
+      if (pool_info[sid].stype == kUndefinedStorage) continue;
+      size_t arena = 0;
+      while (arena < arena_info.size() && arena_info[arena].ctx != pool_info[sid].ctx) ++arena;
+      if (arena == arena_info.size()) {
+        arena_info.push_back(PoolEntry{pool_info[sid].ctx, size_t(0), kDefaultStorage});
+      }
+      arena_info[arena].bytes = std::max(arena_info[arena].bytes,
+                                         voffset.at(sid) + pool_info[sid].bytes);
+      block_arena[sid] = arena;
+    }
+    block_info = std::move(pool_info);
+    pool_info = std::move(arena_info);
+  }
+  // arenas are not shared between executors, since the engine would not order
+  // the blocks placed by different executors over the same memory
+  if (use_arena) shared_pool = nullptr;
   // construct the re-use pool, if needed
   std::multimap<size_t, NDArray> free_pool;
   if (shared_pool != nullptr) {
@@ -1133,6 +1217,38 @@ void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
     }
   }
   CHECK_EQ(data_pool_.size(), pool_info.size());
+  // the arena is allocated once, storage blocks are arrays over its memory
+  std::vector<NDArray> arena_blocks;
+  arena_aliases_.clear();
+  if (use_arena) {
+    const auto& voffset = graph_.GetAttr<std::vector<size_t> >("storage_offset");
+    arena_blocks.resize(block_info.size());
+    for (size_t sid = 0; sid < block_info.size(); ++sid) {
+      if (block_info[sid].stype == kUndefinedStorage) continue;
+      const Context& ctx = block_info[sid].ctx;
+      char* dptr = static_cast<char*>(data_pool_[block_arena[sid]].data().dptr_) + voffset[sid];
+      size_t nword = (block_info[sid].bytes + 3) / 4;
+      mxnet::TShape shape{static_cast<nnvm::dim_t>(nword)};
+      TBlob blob(reinterpret_cast<real_t*>(dptr), shape, ctx.dev_mask(), ctx.dev_id);
+      arena_blocks[sid] = NDArray(blob, ctx.dev_id);
+    }
+    // blocks placed over the same memory are ordered by the engine through their aliases
+    for (size_t sid = 0; sid < arena_blocks.size(); ++sid) {
+      if (arena_blocks[sid].is_none()) continue;
+      const size_t begin = voffset[sid];
+      const size_t end = begin + arena_blocks[sid].shape().Size() * 4;
+      auto& aliases = arena_aliases_[arena_blocks[sid].var()];
+      for (size_t other = 0; other < arena_blocks.size(); ++other) {
+        if (other == sid || arena_blocks[other].is_none() ||
+            block_arena[other] != block_arena[sid]) continue;
+        const size_t other_begin = voffset[other];
+        const size_t other_end = other_begin + arena_blocks[other].shape().Size() * 4;
+        if (other_begin < end && begin < other_end) {
+          aliases.push_back(arena_blocks[other].var());
+        }
+      }
+    }
+  }
   // assign the data entries
   for (size_t i = 0; i < data_entry_.size(); ++i) {
     // avoid pre-allocated arrays
@@ -1145,7 +1261,8 @@ void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
         data_entry_[i] = NDArray(data_context[i], vdtype[i]);
       } else {
         CHECK_GE(storage_id, 0) << "Do not support runtime shape op yet";
-        const NDArray& src = data_pool_.at(storage_id);
+        const NDArray& src =
+            use_arena ? arena_blocks.at(storage_id) : data_pool_.at(storage_id);
         data_entry_[i] = src.AsArray(vshape[i], vdtype[i]);
       }
     } else {
@@ -1232,6 +1349,13 @@ void GraphExecutor::InitCachedOps() {
     if (exec->var() != nullptr) {
       mutate_vars.push_back(exec->var());
     }
+    // writing an arena block must wait for every pending access to the
+    // blocks placed over the same memory earlier or later in the graph
+    for (const auto& nd : exec->out_array) {
+      auto it = arena_aliases_.find(nd.var());
+      if (it == arena_aliases_.end()) continue;
+      mutate_vars.insert(mutate_vars.end(), it->second.begin(), it->second.end());
+    }
     // dedup vars
     Engine::Get()->DeduplicateVarHandle(&use_vars, &mutate_vars);
     // all vars include both mutate vars and use vars
@@ -1380,7 +1504,32 @@ void GraphExecutor::ExecuteMonOutputCallback(size_t nid) {
   }
 }
 
+void GraphExecutor::RunOpsInline(bool is_train, size_t topo_start, size_t topo_end) {
+  const auto& idx = graph_.indexed_graph();
+  const RunContext rctx{Context::CPU(), nullptr, nullptr, false};
+  for (size_t nid = topo_start; nid < topo_end; ++nid) {
+    OpNode& opnode = op_nodes_[nid];
+    if (idx[nid].source->is_variable() || opnode.skip_exec_node) continue;
+    // arguments may still be written by operations pushed to the engine
+    for (const auto& e : idx[nid].inputs) {
+      if (idx[e.node_id].source->is_variable()) {
+        data_entry_[idx.entry_id(e)].WaitToRead();
+      }
+    }
+    opnode.exec->op_ctx.is_train = is_train;
+    opnode.exec->op_ctx.need_grad = need_grad_;
+    opnode.exec->Run(rctx, false);
+    if (monitor_callback_) {
+      ExecuteMonOutputCallback(nid);
+    }
+  }
+}
+
 void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end) {
+  if (inline_exec_) {
+    RunOpsInline(is_train, topo_start, topo_end);
+    return;
+  }
   static auto& finfer_shape = nnvm::Op::GetAttr<mxnet::FInferShape>("FInferShape");
   static auto& is_backward = Op::GetAttr<nnvm::TIsBackward>("TIsBackward");
   // Update context
@@ -1869,6 +2018,76 @@ static nnvm::Symbol BuildSubgraph(const nnvm::Symbol& src, const std::string& pr
   }
   return ret;
 }
+
+nnvm::Graph PlanGraphMemory(const nnvm::Symbol& symbol,
+                            const Context& ctx,
+                            const std::unordered_map<std::string, mxnet::TShape>& arg_shape_map,
+                            bool need_grad) {
+  nnvm::Graph g;
+  g.outputs = symbol.outputs;
+  const size_t num_forward_outputs = symbol.outputs.size();
+  const size_t num_forward_inputs = symbol.ListInputs(nnvm::Symbol::kAll).size();
+  if (need_grad) {
+    // same gradient graph as InitFullGraph with every argument requiring gradient
+    std::vector<nnvm::NodeEntry> head_grad_entry;
+    for (size_t i = 0; i < num_forward_outputs; ++i) {
+      nnvm::NodeEntry ngrad(nnvm::Node::Create(), 0, 0);
+      head_grad_entry.emplace_back(AttrHint(ngrad, g.outputs[i]));
+    }
+    std::vector<nnvm::NodeEntry> xs;
+    for (const auto& arg : symbol.ListInputs(nnvm::Symbol::kReadOnlyArgs)) {
+      xs.emplace_back(arg);
+    }
+    std::vector<const nnvm::Op*> zero_ops;
+    zero_ops.push_back(nnvm::Op::Get("zeros_like"));
+    zero_ops.push_back(nnvm::Op::Get("_zeros"));
+    nnvm::Graph g_grad = nnvm::pass::MXGradient(
+        g, symbol.outputs, xs, head_grad_entry,
+        AggregateGradient, nullptr, nullptr,
+        zero_ops, "_copy");
+    for (const auto &e : g_grad.outputs) {
+      g.outputs.push_back(e);
+    }
+  }
+  const auto& idx = g.indexed_graph();
+  g.attrs["context"] = std::make_shared<dmlc::any>(ContextVector(idx.num_nodes(), ctx));
+
+  // like simple_bind, inputs without a dtype attribute default to float32
+  mxnet::ShapeVector arg_shapes(idx.input_nodes().size(), mxnet::TShape());
+  nnvm::DTypeVector arg_dtypes(idx.input_nodes().size(), -1);
+  for (size_t i = 0; i < num_forward_inputs; ++i) {
+    const nnvm::Node* node = idx[idx.input_nodes()[i]].source;
+    auto it = arg_shape_map.find(node->attrs.name);
+    if (it != arg_shape_map.end()) arg_shapes[i] = it->second;
+    if (node->attrs.dict.count("__dtype__") == 0) arg_dtypes[i] = mshadow::kFloat32;
+  }
+  g = InferShape(std::move(g), std::move(arg_shapes), "__shape__");
+  if (g.GetAttr<size_t>("shape_num_unknown_nodes") != 0U) {
+    HandleInferShapeError(num_forward_inputs, idx, g.GetAttr<mxnet::ShapeVector>("shape"));
+  }
+  g = InferType(std::move(g), std::move(arg_dtypes), "__dtype__");
+  if (g.GetAttr<size_t>("dtype_num_unknown_nodes") != 0U) {
+    HandleInferTypeError(num_forward_inputs, idx, g.GetAttr<nnvm::DTypeVector>("dtype"));
+  }
+  g = InferStorageType(std::move(g), StorageTypeVector(), "__storage_type__");
+  if (g.GetAttr<size_t>("storage_type_num_unknown_nodes") != 0U) {
+    HandleInferStorageTypeError(num_forward_inputs, idx,
+                                g.GetAttr<StorageTypeVector>("storage_type"));
+  }
+
+  // same storage constraints as FinishInitGraph
+  const auto& vstorage_type = g.GetAttr<StorageTypeVector>("storage_type");
+  nnvm::StorageVector arg_storage_id(idx.num_node_entries(), kBadStorageID);
+  for (size_t j = num_forward_outputs; j < idx.outputs().size(); ++j) {
+    arg_storage_id[idx.entry_id(idx.outputs()[j])] = kExternalStorageID;
+  }
+  for (size_t i = 0; i < idx.num_node_entries(); i++) {
+    if (vstorage_type[i] != kDefaultStorage) arg_storage_id[i] = kDynamicStorageID;
+  }
+  g.attrs["storage"] = std::make_shared<dmlc::any>(std::move(arg_storage_id));
+  SetMemoryPlanner(&g);
+  return nnvm::ApplyPass(g, "MXPlanMemory");
+}
 }  // namespace exec
 
 Executor *Executor::SimpleBind(nnvm::Symbol symbol,
@@ -34,6 +34,7 @@
 #include <nnvm/op_attr_types.h>
 #include <nnvm/graph_attr_types.h>
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
 #include <string>
 #include <utility>
@@ -53,6 +54,21 @@ using nnvm::Graph;
 
 nnvm::NodeEntry AggregateGradient(std::vector<nnvm::NodeEntry>&& v);
 
+/*!
+ * \brief Run the passes GraphExecutor applies when binding symbol, up to and including
+ *        memory planning, without allocating any array.
+ * \param symbol the symbol to plan
+ * \param ctx the context of every node
+ * \param arg_shape_map shapes of the inputs, by name
+ * \param need_grad whether to plan the gradient graph of all arguments as well
+ * \return the graph with "shape", "dtype", "storage_type", "storage_id"
+ *         and "storage_inplace_index" attributes
+ */
+nnvm::Graph PlanGraphMemory(const nnvm::Symbol& symbol,
+                            const Context& ctx,
+                            const std::unordered_map<std::string, mxnet::TShape>& arg_shape_map,
+                            bool need_grad);
+
 // graph executors
 class GraphExecutor : public Executor {
  public:
@@ -70,6 +86,14 @@ class GraphExecutor : public Executor {
   void Print(std::ostream &os) const override; // NOLINT(*)
   nnvm::Symbol GetOptimizedSymbol();
   void SetMonitorCallback(const MonitorCallback& callback, bool monitor_all = false) override;
+  /*!
+   * \brief Run the operators inline on the thread calling Forward instead of pushing
+   *  them to the engine, like NaiveEngine does for the whole process. The temporary
+   *  space of the operators is replaced by space private to this executor, so several
+   *  executors sharing read-only arguments can run inline on different threads.
+   *  Only graphs of synchronous CPU operators can run inline.
+   */
+  void EnableInlineExecution();
   // Initialize the rest of attributes
   // after setting up arguments.
   void FinishInitGraph(nnvm::Symbol symbol, nnvm::Graph g,
@@ -202,6 +226,8 @@ class GraphExecutor : public Executor {
   void InitDataEntryMemory(std::vector<NDArray>* shared_pool);
   // run ops from topo order start to end
   void RunOps(bool is_train, size_t topo_start, size_t topo_end);
+  // run ops from topo order start to end on the calling thread
+  void RunOpsInline(bool is_train, size_t topo_start, size_t topo_end);
   /*!
    * \brief Try to create a cached operator to run segments between start and end
    * \param topo_start beginning of segment
@@ -229,6 +255,9 @@ class GraphExecutor : public Executor {
   // internal data pool of allocated entries.
   // these allocated entries can be used for static memory sharing between executors.
   std::vector<NDArray> data_pool_;
+  // with an offset memory plan, the variables of the storage blocks
+  // sharing memory with each block of the arena.
+  std::unordered_map<Engine::VarHandle, std::vector<Engine::VarHandle> > arena_aliases_;
   // output arrays
   std::vector<NDArray> output_arrays_;
   // input argument map, key is arg name, value is arg's NDArray
@@ -261,6 +290,10 @@ class GraphExecutor : public Executor {
   std::vector<CachedSegOpr> cached_seg_opr_;
   // cached segment operator name (needs a longer lifecycle than cached_seg_opr_)
   std::unordered_set<std::string> cached_seg_opr_names_;
+  // whether the operators run inline on the calling thread
+  bool inline_exec_{false};
+  // temporary spaces private to this executor, used by inline execution
+  std::vector<Resource> private_spaces_;
   // verbose logging
   bool log_verbose_ = false;
   // subgraph property name
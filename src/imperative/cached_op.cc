@@ -91,6 +91,15 @@ struct CachedOp::CachedOpState {
   std::vector<bool> dynamic_entries;
   std::multimap<size_t, NDArray> fwd_reuse_pool;
   std::multimap<size_t, NDArray> bwd_reuse_pool;
+
+  // recorded inference pass replayed by a frozen CachedOp
+  bool frozen = false;
+  mxnet::ShapeVector frozen_shapes;
+  std::vector<int> frozen_dtypes;
+  std::vector<int> frozen_stypes;
+  std::vector<uint32_t> frozen_data_indices;
+  std::vector<NDArray> frozen_inputs;
+  std::vector<NDArray> frozen_outputs;
 };
 
 CachedOp::CachedOp(
@@ -106,6 +115,9 @@ CachedOp::CachedOp(
   if (config_.static_shape) {
     CHECK(config_.static_alloc) << "static_alloc must be True when static_shape is True";
   }
+  if (config_.frozen) {
+    CHECK(config_.static_shape) << "static_shape must be True when frozen is True";
+  }
 
   // construct forward graph
   {
@@ -537,7 +549,10 @@ void CachedOp::StaticAllocMemory(
       keep_fwd ? state.info.fwd_graph.indexed_graph().num_node_entries() : 0;
   size_t end_eid = idx.num_node_entries();
 
-  if (!keep_fwd) state.fwd_alloc = false;
+  if (!keep_fwd) {
+    state.fwd_alloc = false;
+    state.frozen = false;
+  }
   state.bwd_alloc = false;
   for (size_t i = start_eid; i < state.buff.size(); ++i) {
     state.buff[i] = NDArray();
@@ -811,6 +826,114 @@ OpStatePtr CachedOp::StaticForward(
   return recording ? state_ptr : OpStatePtr();
 }
 
+/*!
+ * \brief Record the inference forward pass of a frozen CachedOp. Data inputs and
+ *        outputs are bound to arrays owned by the state, so that every node gets
+ *        an executor and the whole pass is pushed as cached engine operators.
+ */
+void CachedOp::FreezeForward(
+    const OpStatePtr& state_ptr,
+    const std::vector<NDArray*>& inputs) {
+  using namespace nnvm;
+  using namespace imperative;
+
+  auto& state = state_ptr.get_state<CachedOpState>();
+  const auto& default_ctx = state.context;
+  SetForwardGraph(&state.info, false, inputs);
+  StaticAllocMemory(state_ptr, false, false);
+
+  nnvm::Graph& g = state.info.fwd_graph;
+  const auto& idx = g.indexed_graph();
+  const auto& dtypes = g.GetAttr<DTypeVector>("dtype");
+  const auto& shapes = g.GetAttr<mxnet::ShapeVector>("shape");
+  const auto& stypes = g.GetAttr<StorageTypeVector>("storage_type");
+  auto new_array = [&](uint32_t eid) {
+    if (stypes[eid] == kDefaultStorage) {
+      return NDArray(shapes[eid], default_ctx, false, dtypes[eid]);
+    }
+    return NDArray(static_cast<NDArrayStorageType>(stypes[eid]),
+                   shapes[eid], default_ctx, true, dtypes[eid]);
+  };
+
+  // without indices, every input is treated as data
+  state.frozen_data_indices.clear();
+  if (config_.data_indices.ndim() || config_.param_indices.ndim()) {
+    for (auto i : config_.data_indices) state.frozen_data_indices.push_back(i);
+  } else {
+    for (uint32_t i = 0; i < num_inputs(); ++i) state.frozen_data_indices.push_back(i);
+  }
+  for (auto i : config_.param_indices) {
+    auto eid = idx.entry_id(idx.input_nodes()[i], 0);
+    state.buff[eid] = *inputs[i];
+    state.dynamic_entries[eid] = false;
+  }
+  state.frozen_inputs.clear();
+  for (auto i : state.frozen_data_indices) {
+    auto eid = idx.entry_id(idx.input_nodes()[i], 0);
+    state.buff[eid] = new_array(eid);
+    state.dynamic_entries[eid] = false;
+    state.frozen_inputs.push_back(state.buff[eid]);
+  }
+  state.frozen_outputs.clear();
+  for (size_t i = 0; i < idx.outputs().size(); ++i) {
+    auto eid = idx.entry_id(idx.outputs()[i]);
+    if (state.arrays[eid]->is_none()) *state.arrays[eid] = new_array(eid);
+    state.dynamic_entries[eid] = false;
+    state.frozen_outputs.push_back(state.arrays[eid]->Detach());
+  }
+
+  state.frozen_shapes.clear();
+  state.frozen_dtypes.clear();
+  state.frozen_stypes.clear();
+  for (auto input : inputs) {
+    state.frozen_shapes.push_back(input->shape());
+    state.frozen_dtypes.push_back(input->dtype());
+    state.frozen_stypes.push_back(input->storage_type());
+  }
+  StaticInitExec(state_ptr, false, false);
+  state.frozen = true;
+}
+
+OpStatePtr CachedOp::FrozenForward(
+    const Context& default_ctx,
+    const std::vector<NDArray*>& inputs,
+    const std::vector<NDArray*>& outputs) {
+  auto state_ptr = GetCachedOpState(default_ctx);
+  auto& state = state_ptr.get_state<CachedOpState>();
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  const nnvm::Graph& g = state.info.fwd_graph;
+  const auto& idx = g.indexed_graph();
+  bool match = state.frozen;
+  for (size_t i = 0; match && i < inputs.size(); ++i) {
+    match = inputs[i]->shape() == state.frozen_shapes[i] &&
+            inputs[i]->dtype() == state.frozen_dtypes[i] &&
+            inputs[i]->storage_type() == state.frozen_stypes[i];
+  }
+  for (size_t k = 0; match && k < config_.param_indices.ndim(); ++k) {
+    auto eid = idx.entry_id(idx.input_nodes()[config_.param_indices[k]], 0);
+    match = state.buff[eid].IsSame(*inputs[config_.param_indices[k]]);
+  }
+  if (!match) FreezeForward(state_ptr, inputs);
+
+  // replay: no array or engine variable is created from here on
+  for (size_t k = 0; k < state.frozen_data_indices.size(); ++k) {
+    const NDArray* input = inputs[state.frozen_data_indices[k]];
+    // an output fed back as input may already be the recorded array
+    if (!input->IsSame(state.frozen_inputs[k])) {
+      CopyFromTo(*input, state.frozen_inputs[k]);
+    }
+  }
+  StaticRunOps(default_ctx, g, state_ptr, state.arrays, 0, idx.num_nodes());
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    if (outputs[i]->is_none()) {
+      *outputs[i] = state.frozen_outputs[i];
+    } else {
+      CopyFromTo(state.frozen_outputs[i], *outputs[i]);
+    }
+  }
+  return OpStatePtr();
+}
 
 OpStatePtr CachedOp::DynamicForward(
     const Context& default_ctx,
@@ -928,7 +1051,10 @@ OpStatePtr CachedOp::Forward(
     if (config_.is_dynamic || CheckDynamicShapeExists(default_ctx, inputs, true)) {
       config_.is_dynamic = true;
       config_.static_alloc = false;
+      config_.frozen = false;
       op_state = DynamicForward(default_ctx, inputs, outputs, true);
+    } else if (config_.frozen && !Imperative::Get()->is_recording()) {
+      op_state = FrozenForward(default_ctx, inputs, outputs);
     } else if (config_.static_alloc) {
       op_state = StaticForward(default_ctx, inputs, outputs);
     } else {
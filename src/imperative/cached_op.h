@@ -35,6 +35,7 @@ struct CachedOpConfig : public dmlc::Parameter<CachedOpConfig> {
   uint32_t backward_bulk_size;
   bool static_alloc;
   bool static_shape;
+  bool frozen;
   bool is_dynamic;
   mxnet::Tuple<uint32_t> data_indices;
   mxnet::Tuple<uint32_t> param_indices;
@@ -49,6 +50,12 @@ struct CachedOpConfig : public dmlc::Parameter<CachedOpConfig> {
     .describe("Optimize for invariant input shapes between iterations. "
               "Must also set static_alloc to True. "
               "Change of input shapes is still allowed but slower.");
+    DMLC_DECLARE_FIELD(frozen)
+    .set_default(false)
+    .describe("Record the first inference forward pass and replay it on later calls "
+              "without creating arrays or engine variables. Must also set static_shape "
+              "to True. Outputs are returned in the same arrays on every call and are "
+              "overwritten by the next call.");
     DMLC_DECLARE_FIELD(inline_limit)
     .set_default(2)
     .describe("Maximum number of operators that can be inlined.");
@@ -180,6 +187,13 @@ class CachedOp {
       const Context& default_ctx,
       const std::vector<NDArray*>& inputs,
       const std::vector<NDArray*>& outputs);
+  void FreezeForward(
+      const OpStatePtr& state_ptr,
+      const std::vector<NDArray*>& inputs);
+  OpStatePtr FrozenForward(
+      const Context& default_ctx,
+      const std::vector<NDArray*>& inputs,
+      const std::vector<NDArray*>& outputs);
   void StaticBackward(
       const bool retain_graph,
       const OpStatePtr& state_ptr,
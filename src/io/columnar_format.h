@@ -0,0 +1,352 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file columnar_format.h
+ * \brief chunked columnar binary format of tabular data, its writer and its mapped reader
+ *
+ *  A file is a header, blocks of rows and a block table followed by a footer:
+ *
+ *    header | block 0 | block 1 | ... | block table | footer
+ *
+ *  Every block starts at a multiple of kColumnarAlign and holds its rows column by column.
+ *  The label columns come first, each one num_rows float32 values. Dense data follows as
+ *  num_columns columns of num_rows float32 values. CSR data follows, 8 byte aligned, as
+ *  the int64 row pointers of the block, starting at 0, then the nnz int64 column indices
+ *  and the nnz float32 values. Everything is stored in little endian.
+ */
+#ifndef MXNET_IO_COLUMNAR_FORMAT_H_
+#define MXNET_IO_COLUMNAR_FORMAT_H_
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // _WIN32
+#include <dmlc/base.h>
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <mxnet/base.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+
+/*! \brief magic number at both ends of a columnar file */
+const uint32_t kColumnarMagic = 0x4c4f4358;
+/*! \brief version of the format */
+const uint32_t kColumnarVersion = 1;
+/*! \brief alignment of the blocks in the file */
+const uint64_t kColumnarAlign = 64;
+
+/*! \brief storage of the data columns */
+enum ColumnarStorage {
+  kColumnarDense = 0,
+  kColumnarCSR = 1
+};
+
+/*! \brief start of a columnar file */
+struct ColumnarHeader {
+  uint32_t magic;
+  uint32_t version;
+  /*! \brief a ColumnarStorage */
+  uint32_t storage;
+  /*! \brief number of label columns */
+  uint32_t label_width;
+  /*! \brief number of data columns */
+  uint64_t num_columns;
+};
+
+/*! \brief location and size of a block */
+struct ColumnarBlock {
+  uint64_t offset;
+  uint64_t num_rows;
+  /*! \brief number of stored entries of CSR data, 0 for dense data */
+  uint64_t nnz;
+};
+
+/*! \brief end of a columnar file */
+struct ColumnarFooter {
+  uint64_t num_rows;
+  uint64_t num_blocks;
+  /*! \brief offset of the table of num_blocks ColumnarBlock */
+  uint64_t block_table;
+  uint32_t version;
+  uint32_t magic;
+};
+
+inline uint64_t ColumnarRoundUp(uint64_t x, uint64_t align) {
+  return (x + align - 1) / align * align;
+}
+
+/*! \brief offset of the CSR row pointers of a block from the start of the block */
+inline uint64_t ColumnarIndPtrOffset(const ColumnarHeader& header, uint64_t num_rows) {
+  return ColumnarRoundUp(header.label_width * num_rows * sizeof(real_t), sizeof(int64_t));
+}
+
+/*!
+ * \brief Writes rows into a columnar file, buffering a block of rows at a time and
+ *  transposing it into columns when the block is full.
+ */
+class ColumnarWriter {
+ public:
+  /*!
+   * \param out stream to write to, only written sequentially
+   * \param storage a ColumnarStorage
+   * \param num_columns number of data columns
+   * \param label_width number of label columns
+   * \param rows_per_block number of rows of a full block
+   */
+  ColumnarWriter(dmlc::Stream *out, int storage, uint64_t num_columns, uint32_t label_width,
+                 size_t rows_per_block)
+      : out_(out), rows_per_block_(rows_per_block) {
+    CHECK(storage == kColumnarDense || storage == kColumnarCSR) << "Unknown storage " << storage;
+    CHECK_GT(num_columns, 0U) << "There must be at least one data column";
+    CHECK_GT(rows_per_block, 0U) << "A block must hold at least one row";
+    header_.magic = kColumnarMagic;
+    header_.version = kColumnarVersion;
+    header_.storage = storage;
+    header_.label_width = label_width;
+    header_.num_columns = num_columns;
+    this->Write(&header_, sizeof(header_));
+    indptr_.push_back(0);
+  }
+
+  /*! \brief add a dense row of num_columns values */
+  void WriteDenseRow(const real_t *label, const real_t *value) {
+    CHECK(header_.storage == kColumnarDense) << "Dense row written into a CSR file";
+    labels_.insert(labels_.end(), label, label + header_.label_width);
+    values_.insert(values_.end(), value, value + header_.num_columns);
+    if (++num_buffered_ == rows_per_block_) FlushBlock();
+  }
+
+  /*! \brief add a sparse row of nnz entries, with indices ascending */
+  void WriteSparseRow(const real_t *label, const int64_t *index, const real_t *value,
+                      size_t nnz) {
+    CHECK(header_.storage == kColumnarCSR) << "Sparse row written into a dense file";
+    labels_.insert(labels_.end(), label, label + header_.label_width);
+    for (size_t i = 0; i < nnz; ++i) {
+      CHECK(index[i] >= 0 && static_cast<uint64_t>(index[i]) < header_.num_columns)
+          << "Column index " << index[i] << " out of range [0, " << header_.num_columns << ")";
+    }
+    index_.insert(index_.end(), index, index + nnz);
+    values_.insert(values_.end(), value, value + nnz);
+    indptr_.push_back(index_.size());
+    if (++num_buffered_ == rows_per_block_) FlushBlock();
+  }
+
+  /*! \brief write the last block, the block table and the footer */
+  void Finish() {
+    if (num_buffered_ != 0) FlushBlock();
+    this->Pad(sizeof(uint64_t));
+    ColumnarFooter footer;
+    footer.num_rows = num_rows_;
+    footer.num_blocks = blocks_.size();
+    footer.block_table = pos_;
+    footer.version = kColumnarVersion;
+    footer.magic = kColumnarMagic;
+    if (!blocks_.empty()) this->Write(blocks_.data(), blocks_.size() * sizeof(ColumnarBlock));
+    this->Write(&footer, sizeof(footer));
+  }
+
+  /*! \return number of rows written */
+  uint64_t NumRows() const {
+    return num_rows_ + num_buffered_;
+  }
+
+ private:
+  void Write(const void *ptr, size_t size) {
+    out_->Write(ptr, size);
+    pos_ += size;
+  }
+
+  void Pad(uint64_t align) {
+    static const char zeros[kColumnarAlign] = {0};
+    const uint64_t padding = ColumnarRoundUp(pos_, align) - pos_;
+    if (padding != 0) this->Write(zeros, padding);
+  }
+
+  void WriteColumns(const real_t *rows, size_t width) {
+    for (size_t c = 0; c < width; ++c) {
+      for (size_t r = 0; r < num_buffered_; ++r) {
+        column_[r] = rows[r * width + c];
+      }
+      this->Write(column_.data(), num_buffered_ * sizeof(real_t));
+    }
+  }
+
+  void FlushBlock() {
+    this->Pad(kColumnarAlign);
+    ColumnarBlock block;
+    block.offset = pos_;
+    block.num_rows = num_buffered_;
+    block.nnz = header_.storage == kColumnarCSR ? index_.size() : 0;
+    column_.resize(num_buffered_);
+    WriteColumns(labels_.data(), header_.label_width);
+    if (header_.storage == kColumnarDense) {
+      WriteColumns(values_.data(), header_.num_columns);
+    } else {
+      this->Pad(sizeof(int64_t));
+      CHECK_EQ(pos_ - block.offset, ColumnarIndPtrOffset(header_, block.num_rows));
+      this->Write(indptr_.data(), indptr_.size() * sizeof(int64_t));
+      if (!index_.empty()) {
+        this->Write(index_.data(), index_.size() * sizeof(int64_t));
+        this->Write(values_.data(), values_.size() * sizeof(real_t));
+      }
+    }
+    blocks_.push_back(block);
+    num_rows_ += num_buffered_;
+    num_buffered_ = 0;
+    labels_.clear();
+    values_.clear();
+    index_.clear();
+    indptr_.assign(1, 0);
+  }
+
+  /*! \brief the output */
+  dmlc::Stream *out_;
+  /*! \brief bytes written so far */
+  uint64_t pos_{0};
+  ColumnarHeader header_;
+  /*! \brief number of rows of a full block */
+  size_t rows_per_block_;
+  /*! \brief blocks written so far */
+  std::vector<ColumnarBlock> blocks_;
+  /*! \brief rows in written blocks, and rows buffered for the next one */
+  uint64_t num_rows_{0};
+  size_t num_buffered_{0};
+  /*! \brief buffered rows: labels, dense values or CSR values, indices and row pointers */
+  std::vector<real_t> labels_, values_;
+  std::vector<int64_t> index_, indptr_;
+  /*! \brief a column being transposed */
+  std::vector<real_t> column_;
+};
+
+/*!
+ * \brief Maps a columnar file into memory and serves its columns as pointers into the
+ *  mapping, so reading a block costs no parsing, and no I/O once its pages are cached.
+ */
+class ColumnarReader {
+ public:
+  explicit ColumnarReader(const std::string& path) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    CHECK_GE(fd, 0) << "Failed to open " << path << " for mapping: " << strerror(errno)
+                    << ". Only local files can be mapped.";
+    struct stat st;
+    CHECK_EQ(fstat(fd, &st), 0) << "Failed to stat " << path << ": " << strerror(errno);
+    size_ = static_cast<size_t>(st.st_size);
+    CHECK_GE(size_, sizeof(ColumnarHeader) + sizeof(ColumnarFooter))
+        << path << " is too small to be a columnar file";
+    void *ptr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    CHECK_NE(ptr, MAP_FAILED) << "Failed to map " << path << ": " << strerror(errno);
+    data_ = static_cast<const char*>(ptr);
+#else
+    LOG(FATAL) << "Columnar files are not supported on Windows";
+#endif  // _WIN32
+    std::memcpy(&header_, data_, sizeof(header_));
+    std::memcpy(&footer_, data_ + size_ - sizeof(footer_), sizeof(footer_));
+    const uint32_t magic = kColumnarMagic, version = kColumnarVersion;
+    CHECK(header_.magic == magic && footer_.magic == magic)
+        << path << " is not a columnar file";
+    CHECK_EQ(header_.version, version) << "Unsupported columnar format version";
+    CHECK_EQ(footer_.block_table + footer_.num_blocks * sizeof(ColumnarBlock),
+             size_ - sizeof(footer_)) << path << " is truncated";
+    blocks_ = reinterpret_cast<const ColumnarBlock*>(data_ + footer_.block_table);
+  }
+
+  ~ColumnarReader() {
+#ifndef _WIN32
+    if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+#endif  // _WIN32
+  }
+
+  bool IsSparse() const {
+    return header_.storage == kColumnarCSR;
+  }
+  uint64_t NumColumns() const {
+    return header_.num_columns;
+  }
+  uint32_t LabelWidth() const {
+    return header_.label_width;
+  }
+  uint64_t NumRows() const {
+    return footer_.num_rows;
+  }
+  uint64_t NumBlocks() const {
+    return footer_.num_blocks;
+  }
+  const ColumnarBlock &Block(size_t i) const {
+    return blocks_[i];
+  }
+
+  /*! \brief column c of the labels of block i */
+  const real_t *Label(size_t i, size_t c) const {
+    return reinterpret_cast<const real_t*>(data_ + blocks_[i].offset) + c * blocks_[i].num_rows;
+  }
+  /*! \brief column c of the dense data of block i */
+  const real_t *Column(size_t i, size_t c) const {
+    return Label(i, header_.label_width) + c * blocks_[i].num_rows;
+  }
+  /*! \brief row pointers of the CSR data of block i */
+  const int64_t *IndPtr(size_t i) const {
+    return reinterpret_cast<const int64_t*>(
+        data_ + blocks_[i].offset + ColumnarIndPtrOffset(header_, blocks_[i].num_rows));
+  }
+  /*! \brief column indices of the CSR data of block i */
+  const int64_t *Index(size_t i) const {
+    return IndPtr(i) + blocks_[i].num_rows + 1;
+  }
+  /*! \brief values of the CSR data of block i */
+  const real_t *Value(size_t i) const {
+    return reinterpret_cast<const real_t*>(Index(i) + blocks_[i].nnz);
+  }
+
+  /*! \brief ask the kernel to read blocks [begin, end) ahead of their use */
+  void WillNeed(size_t begin, size_t end) const {
+#ifndef _WIN32
+    if (begin >= end) return;
+    const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    const uint64_t first = blocks_[begin].offset / page * page;
+    const uint64_t last = end < NumBlocks() ? blocks_[end].offset : footer_.block_table;
+    madvise(const_cast<char*>(data_) + first, last - first, MADV_WILLNEED);
+#endif  // _WIN32
+  }
+
+ private:
+  /*! \brief the mapped file */
+  const char *data_{nullptr};
+  /*! \brief size of the mapped file */
+  size_t size_{0};
+  ColumnarHeader header_;
+  ColumnarFooter footer_;
+  /*! \brief the block table, inside the mapping */
+  const ColumnarBlock *blocks_{nullptr};
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_COLUMNAR_FORMAT_H_
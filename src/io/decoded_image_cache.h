@@ -0,0 +1,209 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file decoded_image_cache.h
+ * \brief cache of decoded images kept in memory or spilled to a local file
+ */
+#ifndef MXNET_IO_DECODED_IMAGE_CACHE_H_
+#define MXNET_IO_DECODED_IMAGE_CACHE_H_
+
+#if MXNET_USE_OPENCV
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // _WIN32
+#include <dmlc/base.h>
+#include <dmlc/logging.h>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace mxnet {
+namespace io {
+
+/*!
+ * \brief Scale an image down so that its shorter edge is edge pixels long, computing
+ *  the size like the resize of the default augmenter, which then leaves it unchanged.
+ * \param interpolation the OpenCV interpolation flag the augmenter resizes with
+ * \return the image itself if its shorter edge is not longer than edge
+ */
+inline cv::Mat ShrinkShorterEdge(const cv::Mat& src, int edge, int interpolation) {
+  if (edge <= 0 || std::min(src.rows, src.cols) <= edge) return src;
+  int new_height, new_width;
+  if (src.rows > src.cols) {
+    new_height = edge * src.rows / src.cols;
+    new_width = edge;
+  } else {
+    new_height = edge;
+    new_width = edge * src.cols / src.rows;
+  }
+  cv::Mat res;
+  cv::resize(src, res, cv::Size(new_width, new_height), 0, 0, interpolation);
+  return res;
+}
+
+/*!
+ * \brief Thread safe cache of decoded 8 bit images keyed by record index. Images are
+ *  kept in memory up to a byte budget, and the ones beyond it are appended to a spill
+ *  file on local disk when one is given, or not cached at all otherwise. Nothing is
+ *  evicted: a dataset whose decoded form fits is decoded once, in its first epoch.
+ *
+ *  Images are handed out as copies, since augmenters may modify them in place.
+ */
+class DecodedImageCache {
+ public:
+  /*!
+   * \param memory_bytes bytes of pixels to keep in memory
+   * \param spill_path local file to write the images beyond the budget to, created and
+   *  truncated here and removed with the cache, or empty to not spill
+   */
+  DecodedImageCache(size_t memory_bytes, const std::string& spill_path)
+      : memory_budget_(memory_bytes), spill_path_(spill_path) {
+    if (spill_path_.empty()) return;
+#ifndef _WIN32
+    spill_fd_ = open(spill_path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    CHECK_GE(spill_fd_, 0) << "Failed to create the decoded image cache file "
+                           << spill_path_ << ": " << strerror(errno);
+#else
+    LOG(FATAL) << "Spilling decoded images to a file is not supported on Windows";
+#endif  // _WIN32
+  }
+
+  ~DecodedImageCache() {
+#ifndef _WIN32
+    if (spill_fd_ >= 0) {
+      close(spill_fd_);
+      std::remove(spill_path_.c_str());
+    }
+#endif  // _WIN32
+  }
+
+  /*!
+   * \brief look an image up
+   * \param key the record index
+   * \param out set to a copy of the image when it is cached
+   * \return whether the image is cached
+   */
+  bool Get(uint64_t key, cv::Mat *out) {
+    Entry entry;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(key);
+      if (it == entries_.end()) return false;
+      entry = it->second;
+    }
+    if (entry.offset < 0) {
+      *out = entry.image.clone();
+      return true;
+    }
+    out->create(entry.rows, entry.cols, entry.type);
+    ReadSpill(entry.offset, out->data, out->total() * out->elemSize());
+    return true;
+  }
+
+  /*!
+   * \brief cache an image, if it still fits
+   * \param key the record index
+   * \param image the decoded image, which is copied
+   */
+  void Put(uint64_t key, const cv::Mat& image) {
+    CHECK_EQ(image.depth(), CV_8U) << "Only 8 bit images can be cached";
+    const size_t bytes = image.total() * image.elemSize();
+    Entry entry;
+    entry.rows = image.rows;
+    entry.cols = image.cols;
+    entry.type = image.type();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (entries_.count(key) != 0) return;
+      if (memory_used_ + bytes <= memory_budget_) {
+        memory_used_ += bytes;
+        entry.image = image.clone();
+        entries_.emplace(key, entry);
+        return;
+      }
+      if (spill_fd_ < 0) return;
+      // reserve the range now and publish the entry once it is written
+      entry.offset = static_cast<int64_t>(spill_used_);
+      spill_used_ += bytes;
+    }
+    const cv::Mat continuous = image.isContinuous() ? image : image.clone();
+    WriteSpill(entry.offset, continuous.data, bytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.emplace(key, entry);
+  }
+
+ private:
+  /*! \brief a cached image, in memory when offset is negative */
+  struct Entry {
+    int rows{0}, cols{0}, type{0};
+    cv::Mat image;
+    int64_t offset{-1};
+  };
+
+  void WriteSpill(int64_t offset, const uint8_t *data, size_t bytes) {
+#ifndef _WIN32
+    while (bytes != 0) {
+      const ssize_t n = pwrite(spill_fd_, data, bytes, offset);
+      CHECK_GT(n, 0) << "Failed to write the decoded image cache file " << spill_path_
+                     << ": " << strerror(errno);
+      data += n;
+      offset += n;
+      bytes -= n;
+    }
+#endif  // _WIN32
+  }
+
+  void ReadSpill(int64_t offset, uint8_t *data, size_t bytes) {
+#ifndef _WIN32
+    while (bytes != 0) {
+      const ssize_t n = pread(spill_fd_, data, bytes, offset);
+      CHECK_GT(n, 0) << "Failed to read the decoded image cache file " << spill_path_
+                     << ": " << strerror(errno);
+      data += n;
+      offset += n;
+      bytes -= n;
+    }
+#endif  // _WIN32
+  }
+
+  /*! \brief bytes of pixels allowed, and used, in memory */
+  const size_t memory_budget_;
+  size_t memory_used_{0};
+  /*! \brief spill file, its descriptor or -1, and the bytes written to it */
+  const std::string spill_path_;
+  int spill_fd_{-1};
+  size_t spill_used_{0};
+  /*! \brief cached images by record index */
+  std::unordered_map<uint64_t, Entry> entries_;
+  std::mutex mutex_;
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_USE_OPENCV
+#endif  // MXNET_IO_DECODED_IMAGE_CACHE_H_
@@ -243,6 +243,17 @@ class DefaultImageAugmenter : public ImageAugmenter {
       return inter_method;
     }
   }
+  int MinShorterEdge() const override {
+    // everything after the resize works on the resized image
+    return param_.resize;
+  }
+  int ShrinkInterMethod() const override {
+    // auto picks area when both edges shrink, which they do when scaling down to resize
+    if (param_.inter_method == 9) return 3;
+    if (param_.inter_method == 10) return -1;
+    return param_.inter_method;
+  }
+
   cv::Mat Process(const cv::Mat &src, std::vector<float> *label,
                   common::RANDOM_ENGINE *prnd) override {
     using mshadow::index_t;
@@ -59,6 +59,23 @@ class ImageAugmenter {
    */
   virtual cv::Mat Process(const cv::Mat &src, std::vector<float> *label,
                           common::RANDOM_ENGINE *prnd) = 0;
+  /*!
+   * \brief the length the shorter edge of the source image can be scaled down to
+   *  before Process without changing the result beyond resampling, which lets
+   *  the decoder skip decoding pixels that would be thrown away.
+   * \return the length, or -1 if Process needs the image at its original size.
+   */
+  virtual int MinShorterEdge() const {
+    return -1;
+  }
+  /*!
+   * \brief the interpolation Process scales the image down to MinShorterEdge with,
+   *  so that an image scaled down beforehand with it comes out of Process the same.
+   * \return the OpenCV interpolation flag, or -1 if it is chosen at random.
+   */
+  virtual int ShrinkInterMethod() const {
+    return -1;
+  }
   // virtual destructor
   virtual ~ImageAugmenter() {}
   /*!
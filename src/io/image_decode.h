@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file image_decode.h
+ * \brief JPEG decoding with libjpeg-turbo, falling back to OpenCV
+ */
+#ifndef MXNET_IO_IMAGE_DECODE_H_
+#define MXNET_IO_IMAGE_DECODE_H_
+
+#if MXNET_USE_OPENCV && MXNET_USE_LIBJPEG_TURBO
+#include <opencv2/opencv.hpp>
+#include <turbojpeg.h>
+#include <algorithm>
+
+namespace mxnet {
+namespace io {
+
+inline bool is_jpeg(unsigned char * file) {
+  if ((file[0] == 255) && (file[1] == 216)) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+/*!
+ * \brief decode an encoded image into BGR or grayscale pixels, with libjpeg-turbo when
+ *  it is a JPEG and with OpenCV otherwise
+ * \param image the encoded bytes
+ * \param color 1 to decode to BGR, 0 to grayscale
+ * \param min_decode_edge when positive, JPEGs are decoded at the smallest of 1/8, 1/4 and
+ *  1/2 of their size whose shorter edge is still at least this long
+ */
+inline cv::Mat TJimdecode(cv::Mat image, int color, int min_decode_edge = -1) {
+  unsigned char* jpeg = image.ptr();
+  size_t jpeg_size = image.rows * image.cols;
+
+  if (!is_jpeg(jpeg)) {
+    // If it is not JPEG then fall back to OpenCV
+    return cv::imdecode(image, color);
+  }
+
+  tjhandle handle = tjInitDecompress();
+  int h, w, subsamp;
+  int err = tjDecompressHeader2(handle,
+                                jpeg,
+                                jpeg_size,
+                                &w, &h, &subsamp);
+  if (err != 0) {
+    // If it is a malformed JPEG then fall back to OpenCV
+    tjDestroy(handle);
+    return cv::imdecode(image, color);
+  }
+  if (min_decode_edge > 0) {
+    // scale in the DCT domain by the largest factor keeping the shorter edge long enough
+    for (int denom : {8, 4, 2}) {
+      const tjscalingfactor factor = {1, denom};
+      const int scaled_w = TJSCALED(w, factor);
+      const int scaled_h = TJSCALED(h, factor);
+      if (std::min(scaled_w, scaled_h) >= min_decode_edge) {
+        w = scaled_w;
+        h = scaled_h;
+        break;
+      }
+    }
+  }
+  cv::Mat ret = cv::Mat(h, w, color ? CV_8UC3 : CV_8UC1);
+  err = tjDecompress2(handle,
+                      jpeg,
+                      jpeg_size,
+                      ret.ptr(),
+                      w,
+                      0,
+                      h,
+                      color ? TJPF_BGR : TJPF_GRAY,
+                      0);
+  tjDestroy(handle);
+  if (err != 0) {
+    // If it is a malformed JPEG then fall back to OpenCV
+    return cv::imdecode(image, color);
+  }
+  return ret;
+}
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_USE_OPENCV && MXNET_USE_LIBJPEG_TURBO
+#endif  // MXNET_IO_IMAGE_DECODE_H_
@@ -33,14 +33,21 @@
 #include <nnvm/op.h>
 #include <nnvm/op_attr_types.h>
 
+#include <dmlc/common.h>
+#include <dmlc/omp.h>
+
+#include <algorithm>
 #include <fstream>
 #include <cstring>
+#include <vector>
 
+#include "../engine/openmp.h"
 #include "../operator/elemwise_op_common.h"
 #include "../operator/image/resize-inl.h"
 
 #if MXNET_USE_OPENCV
   #include <opencv2/opencv.hpp>
+  #include "./image_decode.h"
   #include "./opencv_compatibility.h"
 #endif  // MXNET_USE_OPENCV
 
@@ -116,6 +123,43 @@ struct ImdecodeParam : public dmlc::Parameter<ImdecodeParam> {
 
 DMLC_REGISTER_PARAMETER(ImdecodeParam);
 
+struct ImdecodeBatchParam : public dmlc::Parameter<ImdecodeBatchParam> {
+  int num_args;
+  int flag;
+  bool to_rgb;
+  int w;
+  int h;
+  int interp;
+  DMLC_DECLARE_PARAMETER(ImdecodeBatchParam) {
+    DMLC_DECLARE_FIELD(num_args)
+    .set_lower_bound(1)
+    .describe("Number of encoded images.");
+    DMLC_DECLARE_FIELD(flag)
+    .set_range(0, 1)
+    .set_default(1)
+    .describe("Convert decoded images to grayscale (0) or color (1).");
+    DMLC_DECLARE_FIELD(to_rgb)
+    .set_default(true)
+    .describe("Whether to convert decoded images to mxnet's default RGB format "
+              "(instead of opencv's default BGR).");
+    DMLC_DECLARE_FIELD(w)
+    .set_lower_bound(0)
+    .set_default(0)
+    .describe("Width to resize every image to. 0 keeps the decoded sizes and pads "
+              "the images to the largest one.");
+    DMLC_DECLARE_FIELD(h)
+    .set_lower_bound(0)
+    .set_default(0)
+    .describe("Height to resize every image to. 0 keeps the decoded sizes and pads "
+              "the images to the largest one.");
+    DMLC_DECLARE_FIELD(interp)
+    .set_default(1)
+    .describe("Interpolation method of the resize (default=cv2.INTER_LINEAR).");
+  }
+};
+
+DMLC_REGISTER_PARAMETER(ImdecodeBatchParam);
+
 struct ImreadParam : public dmlc::Parameter<ImreadParam> {
   std::string filename;
   int flag;
@@ -212,6 +256,129 @@ void Imdecode(const nnvm::NodeAttrs& attrs,
 #endif  // MXNET_USE_OPENCV
 }
 
+#if MXNET_USE_OPENCV
+cv::Mat ImdecodeBatchDecode(const NDArray& buf, int flag) {
+  cv::Mat src(1, buf.shape().Size(), CV_8U, buf.data().dptr_);
+#if MXNET_USE_LIBJPEG_TURBO
+  cv::Mat res = TJimdecode(src, flag);
+#else
+  cv::Mat res = cv::imdecode(src, flag);
+#endif
+  CHECK(!res.empty()) << "Decoding failed. Invalid image file.";
+  return res;
+}
+
+/*! \brief run fn(i) for every image of a batch on the OpenMP threads of the engine */
+template<typename Fn>
+void ImdecodeBatchParallel(size_t num_images, Fn fn) {
+  const int nthread = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  dmlc::OMPException omp_exc;
+  #pragma omp parallel for num_threads(nthread) schedule(dynamic)
+  for (int i = 0; i < static_cast<int>(num_images); ++i) {
+    omp_exc.Run([&] {
+      fn(i);
+    });
+  }
+  omp_exc.Rethrow();
+}
+
+/*!
+ * \brief decode the images of a batch, unless already decoded, into their slots of out,
+ *  resized to it or padded with zeros at the bottom and right
+ */
+void ImdecodeBatchImpl(const ImdecodeBatchParam& param, const std::vector<NDArray>& bufs,
+                       std::vector<cv::Mat>* decoded, const NDArray& out) {
+  const mxnet::TShape& shape = out.shape();
+  const size_t slot_size = shape[1] * shape[2] * shape[3];
+  uint8_t *dptr = out.data().dptr<uint8_t>();
+  ImdecodeBatchParallel(bufs.size(), [&](size_t i) {
+    cv::Mat img = (*decoded)[i];
+    if (img.empty()) img = ImdecodeBatchDecode(bufs[i], param.flag);
+    cv::Mat slot(shape[1], shape[2], param.flag == 0 ? CV_8U : CV_8UC3, dptr + i * slot_size);
+    cv::Mat dst;
+    if (param.w > 0) {
+      cv::resize(img, slot, slot.size(), 0, 0, param.interp);
+      dst = slot;
+    } else {
+      CHECK(img.rows <= slot.rows && img.cols <= slot.cols)
+          << "Image " << i << " decoded to " << img.rows << "x" << img.cols
+          << ", larger than its header says";
+      slot.setTo(cv::Scalar::all(0));
+      dst = slot(cv::Rect(0, 0, img.cols, img.rows));
+      img.copyTo(dst);
+    }
+    CHECK_EQ(static_cast<void*>(slot.ptr()), dptr + i * slot_size);
+    if (param.to_rgb && param.flag != 0) {
+      cv::cvtColor(dst, dst, CV_BGR2RGB);
+    }
+  });
+}
+#endif  // MXNET_USE_OPENCV
+
+void ImdecodeBatch(const nnvm::NodeAttrs& attrs,
+                   const std::vector<NDArray>& inputs,
+                   std::vector<NDArray>* outputs) {
+#if MXNET_USE_OPENCV
+  const auto& param = nnvm::get<ImdecodeBatchParam>(attrs.parsed);
+  CHECK_EQ(param.w > 0, param.h > 0) << "Set both w and h to resize, or neither";
+  const size_t num_images = inputs.size();
+  std::vector<int64_t> heights(num_images, param.h), widths(num_images, param.w);
+  bool sizes_known = true;
+  for (size_t i = 0; i < num_images; ++i) {
+    CHECK_EQ(inputs[i].ctx().dev_mask(), Context::kCPU) << "Only supports cpu input";
+    CHECK_EQ(inputs[i].dtype(), mshadow::kUint8) << "Input needs to be uint8 buffer";
+    CHECK(inputs[i].shape().Size() > 0) << "Input cannot be an empty buffer";
+    if (param.w > 0) continue;
+    inputs[i].WaitToRead();
+    const uint8_t* str_img = inputs[i].data().dptr<uint8_t>();
+    const size_t len = inputs[i].shape().Size();
+    if (!get_jpeg_size(str_img, len, &widths[i], &heights[i]) &&
+        !get_png_size(str_img, len, &widths[i], &heights[i])) {
+      sizes_known = false;
+    }
+  }
+  std::vector<cv::Mat> decoded(num_images);
+  if (!sizes_known) {
+    // decode right away to learn the size of the batch
+    ImdecodeBatchParallel(num_images, [&](size_t i) {
+      decoded[i] = ImdecodeBatchDecode(inputs[i], param.flag);
+      heights[i] = decoded[i].rows;
+      widths[i] = decoded[i].cols;
+    });
+  }
+
+  std::vector<int32_t> sizes;
+  for (size_t i = 0; i < num_images; ++i) {
+    sizes.push_back(heights[i]);
+    sizes.push_back(widths[i]);
+  }
+  (*outputs)[1] = NDArray(mshadow::Shape2(num_images, 2), Context::CPU(), false,
+                          mshadow::kInt32);
+  (*outputs)[1].SyncCopyFromCPU(sizes.data(), sizes.size());
+
+  const mxnet::TShape oshape = mshadow::Shape4(
+      num_images, *std::max_element(heights.begin(), heights.end()),
+      *std::max_element(widths.begin(), widths.end()), param.flag == 0 ? 1 : 3);
+  if (!sizes_known) {
+    (*outputs)[0] = NDArray(oshape, Context::CPU(), false, mshadow::kUint8);
+    ImdecodeBatchImpl(param, inputs, &decoded, (*outputs)[0]);
+    return;
+  }
+  const std::vector<NDArray> ndin = inputs;
+  NDArray& ndout = (*outputs)[0];
+  ndout = NDArray(oshape, Context::CPU(), true, mshadow::kUint8);
+  std::vector<Engine::VarHandle> const_vars;
+  for (const auto& nd : ndin) const_vars.push_back(nd.var());
+  Engine::Get()->PushSync([ndin, ndout, param](RunContext ctx){
+      std::vector<cv::Mat> decoded(ndin.size());
+      ImdecodeBatchImpl(param, ndin, &decoded, ndout);
+    }, ndout.ctx(), const_vars, {ndout.var()},
+    FnProperty::kNormal, 0, "ImdecodeBatch");
+#else
+  LOG(FATAL) << "Build with USE_OPENCV=1 for image io.";
+#endif  // MXNET_USE_OPENCV
+}
+
 void Imread(const nnvm::NodeAttrs& attrs,
             const std::vector<NDArray>& inputs,
             std::vector<NDArray>* outputs) {
@@ -367,6 +534,24 @@ NNVM_REGISTER_OP(_cvimdecode)
 .add_argument("buf", "NDArray", "Buffer containing binary encoded image")
 .add_arguments(ImdecodeParam::__FIELDS__());
 
+NNVM_REGISTER_OP(_cvimdecode_batch)
+.describe("Decode a batch of images with OpenCV, or libjpeg-turbo when available, "
+          "in parallel on the engine's CPU threads. \n"
+          "Returns the images in a single (N, H, W, C) array, either all resized to "
+          "(h, w) or padded with zeros to the largest one, and the (height, width) "
+          "of every image in an (N, 2) int32 array. \n"
+          "Note: return images in RGB by default, "
+          "instead of OpenCV's default BGR.")
+.set_num_inputs([](const nnvm::NodeAttrs& attrs) {
+  return static_cast<uint32_t>(nnvm::get<ImdecodeBatchParam>(attrs.parsed).num_args);
+})
+.set_num_outputs(2)
+.set_attr_parser(op::ParamParser<ImdecodeBatchParam>)
+.set_attr<FNDArrayFunction>("FNDArrayFunction", ImdecodeBatch)
+.set_attr<std::string>("key_var_num_args", "num_args")
+.add_argument("bufs", "NDArray-or-Symbol[]", "Buffers containing binary encoded images")
+.add_arguments(ImdecodeBatchParam::__FIELDS__());
+
 NNVM_REGISTER_OP(_cvimread)
 .describe("Read and decode image with OpenCV. \n"
           "Note: return image in RGB by default, "
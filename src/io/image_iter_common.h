@@ -135,6 +135,14 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
   int shuffle_chunk_seed;
   /*! \brief random seed for augmentations */
   dmlc::optional<int> seed_aug;
+  /*! \brief whether to decode JPEG images at a reduced size when possible */
+  bool jpeg_scaled_decode;
+  /*! \brief whether to map the record file into memory */
+  bool mmap_recordio;
+  /*! \brief memory budget of the decoded image cache in MB */
+  size_t decoded_cache_size;
+  /*! \brief local file the decoded image cache spills to */
+  std::string decoded_cache_file;
 
   // declare parameters
   DMLC_DECLARE_PARAMETER(ImageRecParserParam) {
@@ -169,13 +177,35 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
         .describe("The device id used to create context for internal NDArray. "\
                   "Setting device_id to -1 will create Context::CPU(0). Setting "
                   "device_id to valid positive device id will create "
-                  "Context::CPUPinned(device_id). Default is 0.");
+                  "Context::CPUPinned(device_id). Default is 0. A ``batch_memory`` "
+                  "of ``pinned`` or ``shared`` takes precedence.");
     DMLC_DECLARE_FIELD(shuffle_chunk_size).set_default(0)
         .describe("The data shuffle buffer size in MB. Only valid if shuffle is true.");
     DMLC_DECLARE_FIELD(shuffle_chunk_seed).set_default(0)
         .describe("The random seed for shuffling");
     DMLC_DECLARE_FIELD(seed_aug).set_default(dmlc::optional<int>())
         .describe("Random seed for augmentations.");
+    DMLC_DECLARE_FIELD(jpeg_scaled_decode).set_default(false)
+        .describe("Decode JPEG images directly at 1/2, 1/4 or 1/8 of their size when the "
+                  "shorter edge still covers ``resize``. Decoding in the DCT domain skips "
+                  "most of the decode work for images much larger than the network input, "
+                  "at the cost of slightly different resampling. "
+                  "Requires MXNet built with libjpeg-turbo.");
+    DMLC_DECLARE_FIELD(mmap_recordio).set_default(false)
+        .describe("Map the local ``path_imgrec`` file into memory and decode the records "
+                  "in place instead of copying them out of file chunks. Requires "
+                  "``path_imgidx``. With ``shuffle``, every epoch visits all records of "
+                  "the part in a new random order; ``shuffle_chunk_size`` is ignored.");
+    DMLC_DECLARE_FIELD(decoded_cache_size).set_default(0)
+        .describe("Keep up to this many MB of decoded images in memory, keyed by record "
+                  "index, so later epochs run the augmenters on cached pixels instead of "
+                  "decoding again. Images are shrunk to the ``resize`` shorter edge before "
+                  "being cached. Record indices must be unique, as tools/im2rec.py writes "
+                  "them.");
+    DMLC_DECLARE_FIELD(decoded_cache_file).set_default("")
+        .describe("Local file the decoded images beyond ``decoded_cache_size`` are "
+                  "written to and read back from in later epochs. It is created when the "
+                  "iterator starts and removed when it is destroyed.");
   }
 };
 
@@ -347,9 +377,16 @@ struct ImageDetNormalizeParam :  public dmlc::Parameter<ImageDetNormalizeParam>
 // Define prefetcher parameters
 struct PrefetcherParam : public dmlc::Parameter<PrefetcherParam> {
   enum CtxType { kGPU = 0, kCPU};
+  enum MemoryType { kCPUMemory = 0, kPinnedMemory, kSharedMemory };
   /*! \brief number of prefetched batches */
   size_t prefetch_buffer;
 
+  /*! \brief maximum number of batches produced ahead of the consumer */
+  size_t prefetch_queue_size;
+
+  /*! \brief memory the batches are allocated in */
+  int batch_memory;
+
   /*! \brief Context data loader optimized for */
   int ctx;
 
@@ -360,6 +397,16 @@ struct PrefetcherParam : public dmlc::Parameter<PrefetcherParam> {
   DMLC_DECLARE_PARAMETER(PrefetcherParam) {
     DMLC_DECLARE_FIELD(prefetch_buffer).set_default(4)
         .describe("Maximum number of batches to prefetch.");
+    DMLC_DECLARE_FIELD(prefetch_queue_size).set_default(16).set_lower_bound(1)
+        .describe("Maximum number of batches the background thread loads ahead of "
+                  "the consumer.");
+    DMLC_DECLARE_FIELD(batch_memory).set_default(kCPUMemory)
+        .add_enum("cpu", kCPUMemory)
+        .add_enum("pinned", kPinnedMemory)
+        .add_enum("shared", kSharedMemory)
+        .describe("Memory the prefetched batches are allocated in. ``pinned`` is "
+                  "page-locked memory that is copied to GPU faster, ``shared`` is shared "
+                  "memory that can be passed to other processes without a copy.");
     DMLC_DECLARE_FIELD(ctx).set_default(kGPU)
         .add_enum("cpu", kCPU)
         .add_enum("gpu", kGPU)
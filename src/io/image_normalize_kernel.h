@@ -0,0 +1,321 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file image_normalize_kernel.h
+ * \brief fused mirror, normalization, type conversion and HWC to CHW transpose of an image
+ */
+#ifndef MXNET_IO_IMAGE_NORMALIZE_KERNEL_H_
+#define MXNET_IO_IMAGE_NORMALIZE_KERNEL_H_
+
+#if defined(__GNUC__) && defined(__x86_64__)
+// the vector kernels are compiled for their instruction sets whatever the build's -m flags,
+// and picked at runtime by what the CPU supports
+#define MXNET_IO_NORMALIZE_DISPATCH 1
+#include <immintrin.h>
+#endif
+#include <dmlc/base.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace mxnet {
+namespace io {
+
+/*! \brief per channel parameters of NormalizeImage, indexed by output channel */
+struct NormalizeKernelParam {
+  /*! \brief the interleaved source channel of every output channel */
+  int source_channel[4];
+  /*! \brief mean, used when there is no mean image */
+  float mean[4];
+  /*! \brief scale and offset applied after subtracting the mean, for floating point outputs */
+  float mult[4];
+  float bias[4];
+  /*! \brief CHW mean image of the size of the output with row stride mean_stride, or nullptr */
+  const float *mean_img;
+  size_t mean_stride;
+  /*! \brief whether to flip the image horizontally */
+  bool mirror;
+};
+
+#ifdef MXNET_IO_NORMALIZE_DISPATCH
+/*! \brief the instruction sets of the vector kernels this CPU supports */
+struct NormalizeCpuFeatures {
+  bool ssse3;
+  bool avx2;
+  bool avx512f;
+
+  NormalizeCpuFeatures() {
+    __builtin_cpu_init();
+    ssse3 = __builtin_cpu_supports("ssse3");
+    avx2 = __builtin_cpu_supports("avx2");
+    avx512f = __builtin_cpu_supports("avx512f");
+  }
+
+  static const NormalizeCpuFeatures &Get() {
+    static NormalizeCpuFeatures inst;
+    return inst;
+  }
+};
+
+/*!
+ * \brief Byte shuffles picking one channel of kWidth interleaved pixels of n_channels bytes
+ *  out of the fewest 16 byte loads covering them.
+ */
+template<int n_channels, int kWidth>
+struct ChannelShuffle {
+  static const int kBytes = n_channels * kWidth;
+  static const int kLoads = (kBytes + 15) / 16;
+  /*! \brief offset of every load from the first pixel */
+  int offset[kLoads];
+  /*! \brief shuffle of every load for every channel, 0x80 zeroing the bytes of other loads */
+  __m128i mask[n_channels][kLoads];
+
+  ChannelShuffle() {
+    for (int l = 0; l < kLoads; ++l) {
+      offset[l] = std::max(0, std::min(16 * l, kBytes - 16));
+    }
+    for (int c = 0; c < n_channels; ++c) {
+      alignas(16) uint8_t bytes[kLoads][16];
+      std::fill(&bytes[0][0], &bytes[0][0] + kLoads * 16, 0x80);
+      for (int i = 0; i < kWidth; ++i) {
+        const int b = n_channels * i + c;
+        for (int l = 0; l < kLoads; ++l) {
+          if (b >= offset[l] && b < offset[l] + 16) {
+            bytes[l][i] = static_cast<uint8_t>(b - offset[l]);
+            break;
+          }
+        }
+      }
+      for (int l = 0; l < kLoads; ++l) {
+        mask[c][l] = _mm_load_si128(reinterpret_cast<const __m128i*>(bytes[l]));
+      }
+    }
+  }
+
+  static const ChannelShuffle &Get() {
+    static ChannelShuffle inst;
+    return inst;
+  }
+
+  /*! \brief load the kBytes bytes of the pixels at src */
+  __attribute__((target("ssse3")))
+  void Load(const uint8_t *src, __m128i *v) const {
+    for (int l = 0; l < kLoads; ++l) {
+      v[l] = kBytes >= 16 ?
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + offset[l])) :
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+    }
+  }
+
+  /*! \brief the kWidth bytes of channel c of the loaded pixels, in the low bytes */
+  __attribute__((target("ssse3")))
+  __m128i Channel(const __m128i *v, int c) const {
+    __m128i out = _mm_shuffle_epi8(v[0], mask[c][0]);
+    for (int l = 1; l < kLoads; ++l) {
+      out = _mm_or_si128(out, _mm_shuffle_epi8(v[l], mask[c][l]));
+    }
+    return out;
+  }
+};
+#endif  // MXNET_IO_NORMALIZE_DISPATCH
+
+/*!
+ * \brief Normalize one row of the image and write it into the CHW output, pixels
+ *  [begin, cols) with scalar code.
+ */
+template<int n_channels, typename DType>
+inline void NormalizeImageRowScalar(const uint8_t *src, int row, int rows, int cols, int begin,
+                                    const NormalizeKernelParam &param, DType *dst) {
+  const size_t plane = static_cast<size_t>(rows) * cols;
+  for (int k = 0; k < n_channels; ++k) {
+    const uint8_t *s = src + param.source_channel[k];
+    DType *d = dst + k * plane + static_cast<size_t>(row) * cols;
+    const float *mean_row = param.mean_img == nullptr ? nullptr :
+        param.mean_img + (static_cast<size_t>(k) * rows + row) * param.mean_stride;
+    for (int j = begin; j < cols; ++j) {
+      const float x = s[j * n_channels];
+      const float mean = mean_row != nullptr ? mean_row[j] : param.mean[k];
+      DType out;
+      if (std::is_same<DType, uint8_t>::value) {
+        out = static_cast<DType>(s[j * n_channels]);
+      } else if (std::is_same<DType, int8_t>::value) {
+        const int v = s[j * n_channels] - static_cast<int16_t>(std::round(mean));
+        out = static_cast<DType>(std::min(127, std::max(-128, v)));
+      } else {
+        out = static_cast<DType>((x - mean) * param.mult[k] + param.bias[k]);
+      }
+      d[param.mirror ? cols - j - 1 : j] = out;
+    }
+  }
+}
+
+#ifdef MXNET_IO_NORMALIZE_DISPATCH
+/*!
+ * \brief Normalize pixels [begin, cols) of a row of the image into float outputs 16 at a
+ *  time with AVX-512.
+ * \return the first pixel left for the caller
+ */
+template<int n_channels>
+__attribute__((target("avx512f")))
+inline int NormalizeImageRowAVX512(const uint8_t *s, int i, int rows, int cols, int begin,
+                                   const NormalizeKernelParam &param, float *dst) {
+  const size_t plane = static_cast<size_t>(rows) * cols;
+  float *d = dst + static_cast<size_t>(i) * cols;
+  const ChannelShuffle<n_channels, 16> &shuffle = ChannelShuffle<n_channels, 16>::Get();
+  const __m512i reverse = _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8,
+                                            7, 6, 5, 4, 3, 2, 1, 0);
+  const __mmask16 kAll = 0xFFFF;
+  __m128i v[ChannelShuffle<n_channels, 16>::kLoads];
+  int j = begin;
+  for (; j + 16 <= cols; j += 16) {
+    shuffle.Load(s + j * n_channels, v);
+    for (int k = 0; k < n_channels; ++k) {
+      const __m128i bytes = shuffle.Channel(v, param.source_channel[k]);
+      // the zero masked forms, since the plain ones trip -Wmaybe-uninitialized in target
+      // attributed functions with GCC 12
+      __m512 x = _mm512_maskz_cvtepi32_ps(kAll, _mm512_maskz_cvtepu8_epi32(kAll, bytes));
+      const __m512 mean = param.mean_img == nullptr ? _mm512_set1_ps(param.mean[k]) :
+          _mm512_loadu_ps(param.mean_img + (static_cast<size_t>(k) * rows + i) *
+                          param.mean_stride + j);
+      x = _mm512_add_ps(_mm512_mul_ps(_mm512_sub_ps(x, mean), _mm512_set1_ps(param.mult[k])),
+                        _mm512_set1_ps(param.bias[k]));
+      if (param.mirror) {
+        _mm512_storeu_ps(d + k * plane + cols - j - 16,
+                         _mm512_maskz_permutexvar_ps(kAll, reverse, x));
+      } else {
+        _mm512_storeu_ps(d + k * plane + j, x);
+      }
+    }
+  }
+  return j;
+}
+
+/*!
+ * \brief Normalize pixels [begin, cols) of a row of the image into float outputs 8 at a
+ *  time with AVX2.
+ * \return the first pixel left for the caller
+ */
+template<int n_channels>
+__attribute__((target("avx2")))
+inline int NormalizeImageRowAVX2(const uint8_t *s, int i, int rows, int cols, int begin,
+                                 const NormalizeKernelParam &param, float *dst) {
+  const size_t plane = static_cast<size_t>(rows) * cols;
+  float *d = dst + static_cast<size_t>(i) * cols;
+  const ChannelShuffle<n_channels, 8> &shuffle = ChannelShuffle<n_channels, 8>::Get();
+  const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+  __m128i v[ChannelShuffle<n_channels, 8>::kLoads];
+  int j = begin;
+  for (; j + 8 <= cols; j += 8) {
+    shuffle.Load(s + j * n_channels, v);
+    for (int k = 0; k < n_channels; ++k) {
+      const __m128i bytes = shuffle.Channel(v, param.source_channel[k]);
+      __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+      const __m256 mean = param.mean_img == nullptr ? _mm256_set1_ps(param.mean[k]) :
+          _mm256_loadu_ps(param.mean_img + (static_cast<size_t>(k) * rows + i) *
+                          param.mean_stride + j);
+      x = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(x, mean), _mm256_set1_ps(param.mult[k])),
+                        _mm256_set1_ps(param.bias[k]));
+      if (param.mirror) {
+        _mm256_storeu_ps(d + k * plane + cols - j - 8, _mm256_permutevar8x32_ps(x, reverse));
+      } else {
+        _mm256_storeu_ps(d + k * plane + j, x);
+      }
+    }
+  }
+  return j;
+}
+
+/*!
+ * \brief Copy the channels of pixels [begin, cols) of a row of the image into uint8
+ *  outputs 16 at a time with SSSE3.
+ * \return the first pixel left for the caller
+ */
+template<int n_channels>
+__attribute__((target("ssse3")))
+inline int NormalizeImageRowSSSE3(const uint8_t *s, int i, int rows, int cols, int begin,
+                                  const NormalizeKernelParam &param, uint8_t *dst) {
+  const size_t plane = static_cast<size_t>(rows) * cols;
+  uint8_t *d = dst + static_cast<size_t>(i) * cols;
+  const ChannelShuffle<n_channels, 16> &shuffle = ChannelShuffle<n_channels, 16>::Get();
+  const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  __m128i v[ChannelShuffle<n_channels, 16>::kLoads];
+  int j = begin;
+  for (; j + 16 <= cols; j += 16) {
+    shuffle.Load(s + j * n_channels, v);
+    for (int k = 0; k < n_channels; ++k) {
+      const __m128i bytes = shuffle.Channel(v, param.source_channel[k]);
+      if (param.mirror) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k * plane + cols - j - 16),
+                         _mm_shuffle_epi8(bytes, reverse));
+      } else {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k * plane + j), bytes);
+      }
+    }
+  }
+  return j;
+}
+#endif  // MXNET_IO_NORMALIZE_DISPATCH
+
+/*!
+ * \brief Turn an interleaved 8 bit image, as decoded by OpenCV, into the planar batch
+ *  slot in a single pass. Every output channel k is read from source channel
+ *  param.source_channel[k], mirrored when asked, and converted to DType: uint8 outputs
+ *  are copied, int8 outputs have the rounded mean subtracted with saturation, and
+ *  floating point outputs become (x - mean) * mult + bias.
+ *
+ *  On x86-64 with GCC or Clang, float outputs are processed 16 pixels at a time with
+ *  AVX-512 and 8 at a time with AVX2, and uint8 outputs 16 at a time with SSSE3,
+ *  whichever the CPU supports, and the remaining pixels with scalar code.
+ * \param src the first row of the image, which may be a view into a larger one
+ * \param src_step bytes between the rows of src
+ * \param rows number of rows
+ * \param cols number of pixels of a row
+ * \param param normalization parameters
+ * \param dst n_channels planes of rows * cols values
+ */
+template<int n_channels, typename DType>
+inline void NormalizeImage(const uint8_t *src, size_t src_step, int rows, int cols,
+                           const NormalizeKernelParam &param, DType *dst) {
+#ifdef MXNET_IO_NORMALIZE_DISPATCH
+  const NormalizeCpuFeatures &cpu = NormalizeCpuFeatures::Get();
+#endif
+  for (int i = 0; i < rows; ++i) {
+    const uint8_t *s = src + i * src_step;
+    int j = 0;
+#ifdef MXNET_IO_NORMALIZE_DISPATCH
+    if (std::is_same<DType, float>::value) {
+      float *d = reinterpret_cast<float*>(dst);
+      if (cpu.avx512f) j = NormalizeImageRowAVX512<n_channels>(s, i, rows, cols, j, param, d);
+      if (cpu.avx2) j = NormalizeImageRowAVX2<n_channels>(s, i, rows, cols, j, param, d);
+    } else if (std::is_same<DType, uint8_t>::value && cpu.ssse3) {
+      j = NormalizeImageRowSSSE3<n_channels>(s, i, rows, cols, j, param,
+                                             reinterpret_cast<uint8_t*>(dst));
+    }
+#endif  // MXNET_IO_NORMALIZE_DISPATCH
+    NormalizeImageRowScalar<n_channels>(s, i, rows, cols, j, param, dst);
+  }
+}
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_IMAGE_NORMALIZE_KERNEL_H_
@@ -86,15 +86,7 @@ class BatchLoader : public IIterator<TBlobBatch> {
       if (data_.size() == 0) {
         this->InitData(d);
       }
-      for (size_t i = 0; i < d.data.size(); ++i) {
-        CHECK_EQ(unit_size_[i], d.data[i].Size());
-        MSHADOW_TYPE_SWITCH(data_[i].type_flag_, DType, {
-            mshadow::Copy(
-              data_[i].get<cpu, 1, DType>().Slice(top * unit_size_[i],
-                                                  (top + 1) * unit_size_[i]),
-              d.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(unit_size_[i])));
-          });
-      }
+      this->CopyInst(top, d);
       if (++top >= param_.batch_size) {
         return true;
       }
@@ -107,16 +99,7 @@ class BatchLoader : public IIterator<TBlobBatch> {
           CHECK(base_->Next()) << "number of input must be bigger than batch size";
           const DataInst& d = base_->Value();
           out_.inst_index[top] = d.index;
-          // copy data
-          for (size_t i = 0; i < d.data.size(); ++i) {
-            CHECK_EQ(unit_size_[i], d.data[i].Size());
-            MSHADOW_TYPE_SWITCH(data_[i].type_flag_, DType, {
-                mshadow::Copy(
-                  data_[i].get<cpu, 1, DType>().Slice(top * unit_size_[i],
-                                                      (top + 1) * unit_size_[i]),
-                  d.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(unit_size_[i])));
-              });
-          }
+          this->CopyInst(top, d);
         }
         out_.num_batch_padd = num_overflow_;
       } else {
@@ -130,6 +113,37 @@ class BatchLoader : public IIterator<TBlobBatch> {
     return out_;
   }
 
+  virtual bool SaveState(dmlc::Stream *fo) {
+    if (!base_->SaveState(fo)) return false;
+    fo->Write(head_);
+    fo->Write(num_overflow_);
+    return true;
+  }
+
+  virtual void LoadState(dmlc::Stream *fi) {
+    base_->LoadState(fi);
+    CHECK(fi->Read(&head_) && fi->Read(&num_overflow_)) << "Invalid batch loader state";
+  }
+  /*!
+   * \brief write the next batches into the given blobs instead of the internal buffers,
+   *  so the caller does not have to copy Value() out. Only valid once a batch was loaded.
+   * \param out blobs with the shapes and types of Value().data, or empty to go back
+   *  to the internal buffers
+   */
+  inline void SetOutput(const std::vector<TBlob>& out) {
+    CHECK(out.empty() || out.size() == data_.size())
+        << "SetOutput needs one blob per data of the batch";
+    for (size_t i = 0; i < data_.size(); ++i) {
+      void *dptr = data_[i].dptr_;
+      if (!out.empty()) {
+        CHECK_EQ(out[i].shape_, shape_[i]);
+        CHECK_EQ(out[i].type_flag_, data_[i].type_flag_);
+        dptr = out[i].dptr_;
+      }
+      out_.data[i] = TBlob(dptr, shape_[i], cpu::kDevMask, data_[i].type_flag_, 0);
+    }
+  }
+
  protected:
   /*! \brief batch parameters */
   BatchParam param_;
@@ -149,6 +163,18 @@ class BatchLoader : public IIterator<TBlobBatch> {
   mxnet::ShapeVector shape_;
   /*! \brief unit size */
   std::vector<size_t> unit_size_;
+  // copy an instance into row top of the output batch
+  inline void CopyInst(size_t top, const DataInst& d) {
+    for (size_t i = 0; i < d.data.size(); ++i) {
+      CHECK_EQ(unit_size_[i], d.data[i].Size());
+      MSHADOW_TYPE_SWITCH(out_.data[i].type_flag_, DType, {
+          mshadow::Copy(
+            out_.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(shape_[i].Size()))
+              .Slice(top * unit_size_[i], (top + 1) * unit_size_[i]),
+            d.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(unit_size_[i])));
+        });
+    }
+  }
   // initialize the data holder by using from the first batch.
   inline void InitData(const DataInst& first_batch) {
     shape_.resize(first_batch.data.size());
@@ -0,0 +1,301 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file iter_columnar.cc
+ * \brief define an iterator reading batches out of a memory mapped columnar file
+ */
+#include <mxnet/io.h>
+#include <dmlc/base.h>
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./columnar_format.h"
+#include "./iter_sparse_prefetcher.h"
+#include "./iter_sparse.h"
+
+namespace mxnet {
+namespace io {
+// Columnar parameters
+struct ColumnarIterParam : public dmlc::Parameter<ColumnarIterParam> {
+  /*! \brief path to the columnar file */
+  std::string data_columnar;
+  /*! \brief partition the data into multiple parts */
+  int num_parts;
+  /*! \brief the index of the part will read */
+  int part_index;
+  /*! \brief whether to shuffle the rows */
+  bool shuffle;
+  /*! \brief random seed of the shuffle */
+  int seed;
+  // declare parameters
+  DMLC_DECLARE_PARAMETER(ColumnarIterParam) {
+    DMLC_DECLARE_FIELD(data_columnar)
+        .describe("The input columnar file, as written by tools/text2col.");
+    DMLC_DECLARE_FIELD(num_parts).set_default(1)
+        .describe("partition the data into multiple parts");
+    DMLC_DECLARE_FIELD(part_index).set_default(0)
+        .describe("the index of the part will read");
+    DMLC_DECLARE_FIELD(shuffle).set_default(false)
+        .describe("Whether to visit the blocks, and the rows of every block, "
+                  "in a random order every epoch.");
+    DMLC_DECLARE_FIELD(seed).set_default(0)
+        .describe("The random seed of the shuffle.");
+  }
+};
+
+/*!
+ * \brief Reads batches out of a columnar file. The columns of the blocks are gathered
+ *  straight into the batch buffers, dense rows row-major and sparse rows as CSR.
+ */
+class ColumnarIter : public SparseIIterator<TBlobBatch> {
+ public:
+  ColumnarIter() {}
+  virtual ~ColumnarIter() {}
+
+  virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
+    param_.InitAllowUnknown(kwargs);
+    batch_param_.InitAllowUnknown(kwargs);
+    CHECK_GT(param_.num_parts, 0) << "number of parts should be positive";
+    CHECK(param_.part_index >= 0 && param_.part_index < param_.num_parts)
+        << "part index should be in [0, num_parts)";
+    reader_.reset(new ColumnarReader(param_.data_columnar));
+    const size_t num_blocks = reader_->NumBlocks();
+    block_begin_ = num_blocks * param_.part_index / param_.num_parts;
+    block_end_ = num_blocks * (param_.part_index + 1) / param_.num_parts;
+    CHECK_LT(block_begin_, block_end_)
+        << "Part " << param_.part_index << " of " << param_.data_columnar
+        << " has no block, the file has " << num_blocks << " blocks";
+    first_row_.resize(num_blocks + 1, 0);
+    for (size_t i = 0; i < num_blocks; ++i) {
+      first_row_[i + 1] = first_row_[i] + reader_->Block(i).num_rows;
+    }
+    block_order_.resize(block_end_ - block_begin_);
+    std::iota(block_order_.begin(), block_order_.end(), block_begin_);
+    rnd_.seed(kRandMagic + param_.seed);
+    reader_->WillNeed(block_begin_, block_end_);
+
+    const size_t batch_size = batch_param_.batch_size;
+    out_.batch_size = batch_size;
+    out_.inst_index = new unsigned[batch_size];
+    label_width_ = std::max<size_t>(reader_->LabelWidth(), 1);
+    label_.assign(batch_size * label_width_, 0.0f);
+    if (!reader_->IsSparse()) {
+      dense_.resize(batch_size * reader_->NumColumns());
+    }
+    this->BeforeFirst();
+  }
+
+  virtual void BeforeFirst() {
+    if (param_.shuffle) {
+      std::shuffle(block_order_.begin(), block_order_.end(), rnd_);
+    }
+    block_cursor_ = 0;
+    row_cursor_ = 0;
+    row_order_.clear();
+  }
+
+  virtual bool Next() {
+    const size_t batch_size = batch_param_.batch_size;
+    rows_.clear();
+    std::pair<size_t, size_t> pos;
+    while (rows_.size() < batch_size && NextRow(&pos)) rows_.push_back(pos);
+    if (rows_.empty()) return false;
+    out_.num_batch_padd = batch_size - rows_.size();
+    // pad with the first rows of the part
+    for (size_t b = block_begin_; rows_.size() < batch_size;
+         b = b + 1 == block_end_ ? block_begin_ : b + 1) {
+      for (size_t r = 0; r < reader_->Block(b).num_rows && rows_.size() < batch_size; ++r) {
+        rows_.emplace_back(b, r);
+      }
+    }
+    for (size_t i = 0; i < batch_size; ++i) {
+      out_.inst_index[i] = static_cast<unsigned>(first_row_[rows_[i].first] + rows_[i].second);
+    }
+    if (reader_->IsSparse()) {
+      GatherSparse();
+    } else {
+      GatherDense();
+    }
+    return true;
+  }
+
+  virtual const TBlobBatch &Value(void) const {
+    return out_;
+  }
+
+  virtual const NDArrayStorageType GetStorageType(bool is_data) const {
+    return is_data && reader_->IsSparse() ? kCSRStorage : kDefaultStorage;
+  }
+
+  virtual const mxnet::TShape GetShape(bool is_data) const {
+    const index_t batch_size = batch_param_.batch_size;
+    if (is_data) return mshadow::Shape2(batch_size, reader_->NumColumns());
+    if (label_width_ == 1) return mshadow::Shape1(batch_size);
+    return mshadow::Shape2(batch_size, label_width_);
+  }
+
+ private:
+  /*! \brief magic number to seed the shuffle */
+  static const int kRandMagic = 111;
+
+  /*! \brief position of the next row of the epoch, as (block, row in block) */
+  bool NextRow(std::pair<size_t, size_t> *pos) {
+    while (row_cursor_ >= row_order_.size()) {
+      if (block_cursor_ == block_order_.size()) return false;
+      current_block_ = block_order_[block_cursor_++];
+      row_order_.resize(reader_->Block(current_block_).num_rows);
+      std::iota(row_order_.begin(), row_order_.end(), 0);
+      if (param_.shuffle) {
+        std::shuffle(row_order_.begin(), row_order_.end(), rnd_);
+      }
+      row_cursor_ = 0;
+    }
+    *pos = std::make_pair(current_block_, row_order_[row_cursor_++]);
+    return true;
+  }
+
+  /*! \brief gather the labels of rows [begin, end) of the batch, all in block b */
+  void GatherLabels(size_t b, size_t begin, size_t end) {
+    for (size_t c = 0; c < reader_->LabelWidth(); ++c) {
+      const real_t *column = reader_->Label(b, c);
+      for (size_t i = begin; i < end; ++i) {
+        label_[i * label_width_ + c] = column[rows_[i].second];
+      }
+    }
+  }
+
+  void GatherDense() {
+    const size_t num_columns = reader_->NumColumns();
+    for (size_t begin = 0, end; begin < rows_.size(); begin = end) {
+      const size_t b = rows_[begin].first;
+      for (end = begin + 1; end < rows_.size() && rows_[end].first == b; ++end) {}
+      for (size_t c = 0; c < num_columns; ++c) {
+        const real_t *column = reader_->Column(b, c);
+        for (size_t i = begin; i < end; ++i) {
+          dense_[i * num_columns + c] = column[rows_[i].second];
+        }
+      }
+      GatherLabels(b, begin, end);
+    }
+    out_.data.resize(2);
+    out_.data[0] = TBlob(dense_.data(), GetShape(true), cpu::kDevMask);
+    out_.data[1] = TBlob(label_.data(), GetShape(false), cpu::kDevMask);
+  }
+
+  void GatherSparse() {
+    value_.clear();
+    index_.clear();
+    indptr_.assign(1, 0);
+    for (size_t i = 0; i < rows_.size(); ++i) {
+      const size_t b = rows_[i].first, r = rows_[i].second;
+      const int64_t *indptr = reader_->IndPtr(b);
+      const int64_t *index = reader_->Index(b);
+      const real_t *value = reader_->Value(b);
+      index_.insert(index_.end(), index + indptr[r], index + indptr[r + 1]);
+      value_.insert(value_.end(), value + indptr[r], value + indptr[r + 1]);
+      indptr_.push_back(index_.size());
+      GatherLabels(b, i, i + 1);
+    }
+    out_.data.resize(4);
+    out_.data[0] = TBlob(value_.data(), mshadow::Shape1(value_.size()), cpu::kDevMask);
+    out_.data[1] = TBlob(index_.data(), mshadow::Shape1(index_.size()), cpu::kDevMask);
+    out_.data[2] = TBlob(indptr_.data(), mshadow::Shape1(indptr_.size()), cpu::kDevMask);
+    out_.data[3] = TBlob(label_.data(), GetShape(false), cpu::kDevMask);
+  }
+
+  ColumnarIterParam param_;
+  BatchParam batch_param_;
+  /*! \brief the mapped file */
+  std::unique_ptr<ColumnarReader> reader_;
+  /*! \brief blocks [block_begin_, block_end_) make up this part */
+  size_t block_begin_{0}, block_end_{0};
+  /*! \brief index of the first row of every block in the file */
+  std::vector<uint64_t> first_row_;
+  /*! \brief order of the blocks in this epoch, and the position of the next one */
+  std::vector<size_t> block_order_;
+  size_t block_cursor_{0};
+  /*! \brief the block being read, the order of its rows and the position of the next one */
+  size_t current_block_{0};
+  std::vector<size_t> row_order_;
+  size_t row_cursor_{0};
+  /*! \brief rows of the batch being gathered */
+  std::vector<std::pair<size_t, size_t> > rows_;
+  /*! \brief number of label values of a row */
+  size_t label_width_{1};
+  /*! \brief batch buffers */
+  std::vector<real_t> label_, dense_, value_;
+  std::vector<int64_t> index_, indptr_;
+  /*! \brief output batch */
+  TBlobBatch out_;
+  /*! \brief random engine of the shuffle */
+  std::mt19937 rnd_;
+};
+
+DMLC_REGISTER_PARAMETER(ColumnarIterParam);
+
+MXNET_REGISTER_IO_ITER(ColumnarIter)
+.describe(R"code(Returns the iterator over a columnar file, a binary format of tabular data
+written by ``tools/text2col`` from CSV or LibSVM files.
+
+The file holds its rows in blocks, each block column by column, with the data either dense
+or in CSR layout. The data is returned in `default` or `csr` storage type accordingly,
+with shape (batch_size, num_columns). The label is a dense array of shape (batch_size,)
+or (batch_size, label_width).
+
+The file is memory mapped and read without parsing, so once its pages are cached,
+epochs after the first neither parse nor read from disk.
+
+When `num_parts` and `part_index` are provided, the blocks are split into `num_parts`
+partitions and the iterator only reads the `part_index`-th partition.
+
+When `shuffle` is set, the blocks are visited in a random order every epoch, and the
+rows of every block in a random order as well.
+
+The last batch of an epoch is padded with the first rows of the partition,
+``num_batch_padd`` tells how many.
+
+Example::
+
+  # Convert a CSV file of 1 label column followed by 16 data columns
+  $ text2col data.csv data.col format=csv num_columns=16 label_width=1
+
+  >>> data_iter = mx.io.ColumnarIter(data_columnar='data.col', batch_size=128)
+  >>> batch = data_iter.next()
+  >>> batch.data[0].shape
+  (128L, 16L)
+
+)code" ADD_FILELINE)
+.add_arguments(ColumnarIterParam::__FIELDS__())
+.add_arguments(BatchParam::__FIELDS__())
+.add_arguments(PrefetcherParam::__FIELDS__())
+.set_body([]() {
+    return new SparsePrefetcherIter(
+        new ColumnarIter());
+  });
+
+}  // namespace io
+}  // namespace mxnet
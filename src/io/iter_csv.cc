@@ -26,9 +26,9 @@
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
-#include <dmlc/data.h>
 #include "./iter_prefetcher.h"
 #include "./iter_batchloader.h"
+#include "./text_parser.h"
 
 namespace mxnet {
 namespace io {
@@ -42,6 +42,8 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
   std::string label_csv;
   /*! \brief label shape */
   mxnet::TShape label_shape;
+  /*! \brief number of threads parsing the text */
+  int preprocess_threads;
   // declare parameters
   DMLC_DECLARE_PARAMETER(CSVIterParam) {
     DMLC_DECLARE_FIELD(data_csv)
@@ -54,6 +56,8 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
     index_t shape1[] = {1};
     DMLC_DECLARE_FIELD(label_shape).set_default(mxnet::TShape(shape1, shape1 + 1))
         .describe("The shape of one label.");
+    DMLC_DECLARE_FIELD(preprocess_threads).set_lower_bound(1).set_default(4)
+        .describe("The number of threads parsing the CSV files.");
   }
 };
 
@@ -97,10 +101,11 @@ class CSVIterTyped: public CSVIterBase {
   // intialize iterator loads data in
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
     param_.InitAllowUnknown(kwargs);
-    data_parser_.reset(dmlc::Parser<uint32_t, DType>::Create(param_.data_csv.c_str(), 0, 1, "csv"));
+    data_parser_.reset(new CSVTextParser<DType>(param_.data_csv, param_.data_shape,
+                                                param_.preprocess_threads));
     if (param_.label_csv != "NULL") {
-      label_parser_.reset(
-        dmlc::Parser<uint32_t, DType>::Create(param_.label_csv.c_str(), 0, 1, "csv"));
+      label_parser_.reset(new CSVTextParser<DType>(param_.label_csv, param_.label_shape,
+                                                   param_.preprocess_threads));
     } else {
       dummy_label.set_pad(false);
       dummy_label.Resize(mshadow::Shape1(1));
@@ -126,39 +131,60 @@ class CSVIterTyped: public CSVIterBase {
         end_ = true; return false;
       }
       data_ptr_ = 0;
-      data_size_ = data_parser_->Value().size;
+      data_size_ = data_parser_->Value().Size();
     }
     out_.index = inst_counter_++;
     CHECK_LT(data_ptr_, data_size_);
-    out_.data[0] = AsTBlob(data_parser_->Value()[data_ptr_++], param_.data_shape);
+    out_.data[0] = AsTBlob(data_parser_->Value().Row(data_ptr_++), param_.data_shape);
 
     if (label_parser_.get() != nullptr) {
       while (label_ptr_ >= label_size_) {
         CHECK(label_parser_->Next())
             << "Data CSV's row is smaller than the number of rows in label_csv";
         label_ptr_ = 0;
-        label_size_ = label_parser_->Value().size;
+        label_size_ = label_parser_->Value().Size();
       }
       CHECK_LT(label_ptr_, label_size_);
-      out_.data[1] = AsTBlob(label_parser_->Value()[label_ptr_++], param_.label_shape);
+      out_.data[1] = AsTBlob(label_parser_->Value().Row(label_ptr_++), param_.label_shape);
     } else {
       out_.data[1] = dummy_label;
     }
     return true;
   }
 
+  virtual bool SaveState(dmlc::Stream *fo) {
+    data_parser_->SaveState(fo);
+    if (label_parser_.get() != nullptr) {
+      label_parser_->SaveState(fo);
+    }
+    fo->Write(data_ptr_);
+    fo->Write(data_size_);
+    fo->Write(label_ptr_);
+    fo->Write(label_size_);
+    fo->Write(inst_counter_);
+    fo->Write(end_);
+    return true;
+  }
+
+  virtual void LoadState(dmlc::Stream *fi) {
+    data_parser_->LoadState(fi);
+    if (label_parser_.get() != nullptr) {
+      label_parser_->LoadState(fi);
+    }
+    CHECK(fi->Read(&data_ptr_) && fi->Read(&data_size_) &&
+          fi->Read(&label_ptr_) && fi->Read(&label_size_) &&
+          fi->Read(&inst_counter_) && fi->Read(&end_)) << "Invalid CSVIter state";
+  }
+
  private:
-  inline TBlob AsTBlob(const dmlc::Row<uint32_t, DType>& row, const mxnet::TShape& shape) {
-    CHECK_EQ(row.length, shape.Size())
-        << "The data size in CSV do not match size of shape: "
-        << "specified shape=" << shape << ", the csv row-length=" << row.length;
-    const DType* ptr = row.value;
-    return TBlob((DType*)ptr, shape, cpu::kDevMask, 0);  // NOLINT(*)
+  // the parser already checked the length of the row
+  inline TBlob AsTBlob(const DType* row, const mxnet::TShape& shape) {
+    return TBlob((DType*)row, shape, cpu::kDevMask, 0);  // NOLINT(*)
   }
   // dummy label
   mshadow::TensorContainer<cpu, 1, DType> dummy_label;
-  std::unique_ptr<dmlc::Parser<uint32_t, DType> > label_parser_;
-  std::unique_ptr<dmlc::Parser<uint32_t, DType> > data_parser_;
+  std::unique_ptr<CSVTextParser<DType> > label_parser_;
+  std::unique_ptr<CSVTextParser<DType> > data_parser_;
 };
 
 class CSVIter: public IIterator<DataInst> {
@@ -207,6 +233,14 @@ class CSVIter: public IIterator<DataInst> {
     return iterator_->Value();
   }
 
+  virtual bool SaveState(dmlc::Stream *fo) {
+    return iterator_->SaveState(fo);
+  }
+
+  virtual void LoadState(dmlc::Stream *fi) {
+    iterator_->LoadState(fi);
+  }
+
  private:
   CSVIterParam param_;
   std::unique_ptr<CSVIterBase> iterator_;
@@ -234,6 +268,9 @@ If ``data_csv = 'data/'`` is set, then all the files in this directory will be r
 
 ``reset()`` is expected to be called only after a complete pass of data.
 
+The files are parsed by `preprocess_threads` threads, each one taking a share of the lines
+of every chunk read.
+
 By default, the CSVIter parses all entries in the data file as float32 data type,
 if `dtype` argument is set to be 'int32' or 'int64' then CSVIter will parse all entries in the file
 as int32 or int64 data type accordingly.
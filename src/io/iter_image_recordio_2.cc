@@ -33,14 +33,19 @@
 #include <dmlc/omp.h>
 #include <dmlc/common.h>
 #include <dmlc/timer.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
 #include <type_traits>
-#if MXNET_USE_LIBJPEG_TURBO
-#include <turbojpeg.h>
-#endif
+#include "./decoded_image_cache.h"
 #include "./image_recordio.h"
+#include "./mmap_recordio.h"
 #include "./image_augmenter.h"
+#include "./image_decode.h"
 #include "./image_iter_common.h"
+#include "./image_normalize_kernel.h"
 #include "./inst_vector.h"
+#include "./iter_state.h"
 #include "../common/utils.h"
 
 namespace mxnet {
@@ -57,7 +62,7 @@ class ImageRecordIOParser2 {
   inline void BeforeFirst(void) {
     if (batch_param_.round_batch == 0 || !overflow) {
       n_parsed_ = 0;
-      return source_->BeforeFirst();
+      return SourceBeforeFirst();
     } else {
       overflow = false;
     }
@@ -65,6 +70,10 @@ class ImageRecordIOParser2 {
   // parse next set of records, return an array of
   // instance vector to the user
   inline bool ParseNext(DataBatch *out);
+  // save the position and the random states, only the mapped records can be seeked to
+  inline bool SaveState(dmlc::Stream *fo) const;
+  // go to a saved position
+  inline void LoadState(dmlc::Stream *fi);
 
  private:
 #if MXNET_USE_OPENCV
@@ -72,12 +81,18 @@ class ImageRecordIOParser2 {
   void ProcessImage(const cv::Mat& res,
     mshadow::Tensor<cpu, 3, DType>* data_ptr, const bool is_mirrored, const float contrast_scaled,
     const float illumination_scaled);
-#if MXNET_USE_LIBJPEG_TURBO
-  cv::Mat TJimdecode(cv::Mat buf, int color);
-#endif
 #endif
   inline size_t ParseChunk(DType* data_dptr, real_t* label_dptr, const size_t current_size,
     dmlc::InputSplit::Blob * chunk);
+  // select the records of the next batch, the mapped records are not read into chunk
+  inline bool SourceNextBatch(dmlc::InputSplit::Blob *chunk) {
+    if (mmap_source_ != nullptr) return mmap_source_->NextBatch(batch_param_.batch_size);
+    return source_->NextBatch(chunk, batch_param_.batch_size);
+  }
+  inline void SourceBeforeFirst(void) {
+    if (mmap_source_ != nullptr) return mmap_source_->BeforeFirst();
+    return source_->BeforeFirst();
+  }
   inline void CreateMeanImg(void);
 
   // magic number to seed prng
@@ -98,6 +113,8 @@ class ImageRecordIOParser2 {
   common::RANDOM_ENGINE rnd_;
   /*! \brief data source */
   std::unique_ptr<dmlc::InputSplit> source_;
+  /*! \brief data source serving records in place, replaces source_ when set */
+  std::unique_ptr<MMapRecordIOReader> mmap_source_;
   /*! \brief label information, if any */
   std::unique_ptr<ImageLabelMap> label_map_;
   /*! \brief temporary results */
@@ -107,6 +124,11 @@ class ImageRecordIOParser2 {
   /*! \brief internal instance order */
   std::vector<std::pair<size_t, size_t> > inst_order_;
   size_t inst_index_;
+  /*!
+   * \brief with mmap_source_, the random state of the thread augmenting each image of
+   *  inst_order_ before it did, which a state saved before the image resumes from
+   */
+  std::vector<common::RANDOM_ENGINE> inst_rnds_;
   /*! \brief internal counter tracking number of already parsed entries */
   size_t n_parsed_;
   /*! \brief overflow marker */
@@ -120,6 +142,18 @@ class ImageRecordIOParser2 {
   bool legacy_shuffle_;
   // whether mean image is ready.
   bool meanfile_ready_;
+  // length the shorter edge of JPEG images can be decoded at, -1 to decode at full size
+  int min_decode_edge_;
+#if MXNET_USE_OPENCV
+  /*! \brief decoded images of earlier epochs, if caching */
+  std::unique_ptr<DecodedImageCache> decoded_cache_;
+#endif
+  // length the shorter edge of cached images is shrunk to, -1 to cache them at full size
+  int cache_edge_;
+  // interpolation the cached images are shrunk with, the one of the first augmenter
+  int cache_inter_method_;
+  /*! \brief memory the batches are allocated in, a PrefetcherParam::MemoryType */
+  int batch_memory_;
   /*! \brief OMPException obj to store and rethrow exceptions from omp blocks*/
   dmlc::OMPException omp_exc_;
 };
@@ -136,7 +170,9 @@ inline void ImageRecordIOParser2<DType>::Init(
   normalize_param_.InitAllowUnknown(kwargs);
   PrefetcherParam prefetch_param;
   prefetch_param.InitAllowUnknown(kwargs);
+  batch_memory_ = prefetch_param.batch_memory;
   n_parsed_ = 0;
+  inst_index_ = 0;
   overflow = false;
   rnd_.seed(kRandMagic + record_param_.seed);
   int maxthread, threadget;
@@ -167,6 +203,26 @@ inline void ImageRecordIOParser2<DType>::Init(
     }
     prnds_.emplace_back(new common::RANDOM_ENGINE((i + 1) * kRandMagic));
   }
+  min_decode_edge_ = -1;
+  if (param_.jpeg_scaled_decode && !augmenters_[0].empty()) {
+    // only the first augmenter sees the decoded image
+    min_decode_edge_ = augmenters_[0][0]->MinShorterEdge();
+#if !MXNET_USE_LIBJPEG_TURBO
+    LOG(WARNING) << "jpeg_scaled_decode requires MXNet built with libjpeg-turbo, "
+                 << "images are decoded at full size";
+#endif
+  }
+  cache_edge_ = -1;
+  cache_inter_method_ = -1;
+  if (param_.decoded_cache_size > 0 || param_.decoded_cache_file.length() != 0) {
+    decoded_cache_.reset(new DecodedImageCache(param_.decoded_cache_size << 20UL,
+                                               param_.decoded_cache_file));
+    if (!augmenters_[0].empty()) {
+      // images are scaled down once for all epochs, which needs a fixed interpolation
+      cache_inter_method_ = augmenters_[0][0]->ShrinkInterMethod();
+      if (cache_inter_method_ >= 0) cache_edge_ = augmenters_[0][0]->MinShorterEdge();
+    }
+  }
   if (param_.path_imglist.length() != 0) {
     label_map_.reset(new ImageLabelMap(param_.path_imglist.c_str(),
       param_.label_width, !param_.verbose));
@@ -179,7 +235,14 @@ inline void ImageRecordIOParser2<DType>::Init(
               << ", use " << threadget << " threads for decoding..";
   }
   legacy_shuffle_ = false;
-  if (param_.path_imgidx.length() != 0) {
+  if (param_.mmap_recordio) {
+    CHECK(param_.path_imgidx.length() != 0)
+        << "ImageRecordIter2: mmap_recordio requires path_imgidx";
+    mmap_source_.reset(new MMapRecordIOReader(
+        param_.path_imgrec, param_.path_imgidx,
+        param_.part_index, param_.num_parts,
+        record_param_.shuffle, record_param_.seed));
+  } else if (param_.path_imgidx.length() != 0) {
     source_.reset(dmlc::InputSplit::Create(
         param_.path_imgrec.c_str(),
         param_.path_imgidx.c_str(),
@@ -266,7 +329,7 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
   if (overflow) {
     return false;
   }
-  CHECK(source_ != nullptr);
+  CHECK(source_ != nullptr || mmap_source_ != nullptr);
   dmlc::InputSplit::Blob chunk;
   size_t current_size = 0;
   out->index.resize(batch_param_.batch_size);
@@ -293,7 +356,11 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
 
     auto ctx = Context::CPU(0);
     auto dev_id = param_.device_id;
-    if (dev_id != -1) {
+    if (batch_memory_ == PrefetcherParam::kSharedMemory) {
+      ctx = Context::CPUShared(0);
+    } else if (batch_memory_ == PrefetcherParam::kPinnedMemory) {
+      ctx = Context::CPUPinned(std::max(dev_id, 0));
+    } else if (dev_id != -1) {
       ctx = Context::CPUPinned(dev_id);
     }
     out->data.at(0) = NDArray(data_shape, ctx, false,
@@ -308,8 +375,9 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
     // int n_to_copy;
     size_t n_to_out = 0;
     if (n_parsed_ == 0) {
-      if (source_->NextBatch(&chunk, batch_param_.batch_size)) {
+      if (SourceNextBatch(&chunk)) {
         inst_order_.clear();
+        inst_rnds_.clear();
         inst_index_ = 0;
         DType* data_dptr = static_cast<DType*>(out->data[0].data().dptr_);
         real_t* label_dptr = static_cast<real_t*>(out->data[1].data().dptr_);
@@ -331,7 +399,7 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
         CHECK(!overflow) << "number of input images must be bigger than the batch size";
         if (batch_param_.round_batch != 0) {
           overflow = true;
-          source_->BeforeFirst();
+          SourceBeforeFirst();
         } else {
           current_size = batch_param_.batch_size;
         }
@@ -369,6 +437,47 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
   return true;
 }
 
+template<typename DType>
+inline bool ImageRecordIOParser2<DType>::SaveState(dmlc::Stream *fo) const {
+  if (mmap_source_ == nullptr) return false;
+  // the images parsed beyond the last batch are parsed again after loading the state
+  mmap_source_->SaveState(fo, n_parsed_);
+  fo->Write(overflow);
+  // and with the random states the threads had before augmenting the first of them
+  std::vector<std::string> rnds;
+  for (size_t t = 0; t < prnds_.size(); ++t) {
+    const common::RANDOM_ENGINE *prnd = prnds_[t].get();
+    for (size_t i = inst_index_; i < inst_index_ + n_parsed_; ++i) {
+      if (inst_order_[i].first == t) {
+        prnd = &inst_rnds_[i];
+        break;
+      }
+    }
+    std::ostringstream os;
+    os << *prnd;
+    rnds.push_back(os.str());
+  }
+  fo->Write(rnds);
+  return true;
+}
+
+template<typename DType>
+inline void ImageRecordIOParser2<DType>::LoadState(dmlc::Stream *fi) {
+  CHECK(mmap_source_ != nullptr)
+      << "ImageRecordIter2: loading a state requires mmap_recordio";
+  mmap_source_->LoadState(fi);
+  std::vector<std::string> rnds;
+  CHECK(fi->Read(&overflow) && fi->Read(&rnds)) << "Invalid ImageRecordIter2 state";
+  CHECK_EQ(rnds.size(), prnds_.size())
+      << "ImageRecordIter2: the state was saved with another number of preprocess_threads";
+  for (size_t i = 0; i < rnds.size(); ++i) {
+    std::istringstream is(rnds[i]);
+    is >> *prnds_[i];
+    CHECK(!is.fail()) << "Invalid ImageRecordIter2 state";
+  }
+  n_parsed_ = 0;
+}
+
 #if MXNET_USE_OPENCV
 template<typename DType>
 template<int n_channels>
@@ -378,7 +487,6 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
   float RGBA_MULT[4] = { 0 };
   float RGBA_BIAS[4] = { 0 };
   float RGBA_MEAN[4] = { 0 };
-  int16_t RGBA_MEAN_INT[4] = {0};
   mshadow::Tensor<cpu, 3, DType>& data = (*data_ptr);
   if (!std::is_same<DType, uint8_t>::value) {
     RGBA_MULT[0] = contrast_scaled / normalize_param_.std_r;
@@ -394,120 +502,27 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
       RGBA_MEAN[1] = normalize_param_.mean_g;
       RGBA_MEAN[2] = normalize_param_.mean_b;
       RGBA_MEAN[3] = normalize_param_.mean_a;
-      RGBA_MEAN_INT[0] = std::round(normalize_param_.mean_r);
-      RGBA_MEAN_INT[1] = std::round(normalize_param_.mean_g);
-      RGBA_MEAN_INT[2] = std::round(normalize_param_.mean_b);
-      RGBA_MEAN_INT[3] = std::round(normalize_param_.mean_a);
     }
   }
 
-  int swap_indices[n_channels]; // NOLINT(*)
-  if (n_channels == 1) {
-    swap_indices[0] = 0;
-  } else if (n_channels == 3) {
-    swap_indices[0] = 2;
-    swap_indices[1] = 1;
-    swap_indices[2] = 0;
-  } else if (n_channels == 4) {
-    swap_indices[0] = 2;
-    swap_indices[1] = 1;
-    swap_indices[2] = 0;
-    swap_indices[3] = 3;
-  }
-
-  DType RGBA[n_channels] = {};
-  for (int i = 0; i < res.rows; ++i) {
-    const uchar* im_data = res.ptr<uchar>(i);
-    for (int j = 0; j < res.cols; ++j) {
-      if (std::is_same<DType, int8_t>::value) {
-        if (meanfile_ready_) {
-          for (int k = 0; k < n_channels; ++k) {
-            RGBA[k] = cv::saturate_cast<int8_t>(im_data[swap_indices[k]] -
-                                    static_cast<int16_t>(std::round(meanimg_[k][i][j])));
-          }
-        } else {
-          for (int k = 0; k < n_channels; ++k) {
-            RGBA[k] = cv::saturate_cast<int8_t>(im_data[swap_indices[k]] - RGBA_MEAN_INT[k]);
-          }
-        }
-      } else {
-        for (int k = 0; k < n_channels; ++k) {
-          RGBA[k] = im_data[swap_indices[k]];
-        }
-        if (!std::is_same<DType, uint8_t>::value) {
-          // normalize/mirror here to avoid memory copies
-          // logic from iter_normalize.h, function SetOutImg
-          for (int k = 0; k < n_channels; ++k) {
-            if (meanfile_ready_) {
-              RGBA[k] = (RGBA[k] - meanimg_[k][i][j]) * RGBA_MULT[k] + RGBA_BIAS[k];
-            } else {
-              RGBA[k] = (RGBA[k] - RGBA_MEAN[k]) * RGBA_MULT[k] + RGBA_BIAS[k];
-            }
-          }
-        }
-      }
-      for (int k = 0; k < n_channels; ++k) {
-        // mirror here to avoid memory copies
-        // logic from iter_normalize.h, function SetOutImg
-        if (is_mirrored) {
-          data[k][i][res.cols - j - 1] = RGBA[k];
-        } else {
-          data[k][i][j] = RGBA[k];
-        }
-      }
-      im_data += n_channels;
-    }
-  }
-}
-
-#if MXNET_USE_LIBJPEG_TURBO
-
-bool is_jpeg(unsigned char * file) {
-  if ((file[0] == 255) && (file[1] == 216)) {
-    return true;
-  } else {
-    return false;
+  // OpenCV stores BGR (or BGRA) and we want RGB (or RGBA)
+  const int swap_indices[4] = {n_channels == 1 ? 0 : 2, 1, 0, 3};
+  NormalizeKernelParam param;
+  for (int k = 0; k < 4; ++k) {
+    param.source_channel[k] = swap_indices[k];
+    param.mean[k] = RGBA_MEAN[k];
+    param.mult[k] = RGBA_MULT[k];
+    param.bias[k] = RGBA_BIAS[k];
   }
+  param.mean_img = meanfile_ready_ ? meanimg_.dptr_ : nullptr;
+  param.mean_stride = meanimg_.stride_;
+  param.mirror = is_mirrored;
+  // mirror, normalize and transpose in a single pass straight into the batch
+  // logic from iter_normalize.h, function SetOutImg
+  NormalizeImage<n_channels>(res.ptr<uchar>(0), res.step, res.rows, res.cols, param,
+                             data.dptr_);
 }
 
-template<typename DType>
-cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color) {
-  unsigned char* jpeg = image.ptr();
-  size_t jpeg_size = image.rows * image.cols;
-
-  if (!is_jpeg(jpeg)) {
-    // If it is not JPEG then fall back to OpenCV
-    return cv::imdecode(image, color);
-  }
-
-  tjhandle handle = tjInitDecompress();
-  int h, w, subsamp;
-  int err = tjDecompressHeader2(handle,
-                                jpeg,
-                                jpeg_size,
-                                &w, &h, &subsamp);
-  if (err != 0) {
-    // If it is a malformed JPEG then fall back to OpenCV
-    return cv::imdecode(image, color);
-  }
-  cv::Mat ret = cv::Mat(h, w, color ? CV_8UC3 : CV_8UC1);
-  err = tjDecompress2(handle,
-                      jpeg,
-                      jpeg_size,
-                      ret.ptr(),
-                      w,
-                      0,
-                      h,
-                      color ? TJPF_BGR : TJPF_GRAY,
-                      0);
-  if (err != 0) {
-    // If it is a malformed JPEG then fall back to OpenCV
-    return cv::imdecode(image, color);
-  }
-  tjDestroy(handle);
-  return ret;
-}
-#endif
 #endif
 
 // Returns the number of images that are put into output
@@ -517,7 +532,10 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
   temp_.resize(param_.preprocess_threads);
 #if MXNET_USE_OPENCV
   // save opencv out
-  dmlc::RecordIOChunkReader reader(*chunk, 0, 1);
+  std::unique_ptr<dmlc::RecordIOChunkReader> reader;
+  if (mmap_source_ == nullptr) {
+    reader.reset(new dmlc::RecordIOChunkReader(*chunk, 0, 1));
+  }
   size_t gl_idx = current_size;
   #pragma omp parallel num_threads(param_.preprocess_threads)
   {
@@ -535,11 +553,13 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
       size_t idx;
       #pragma omp critical
       {
-        reader_has_data = reader.NextRecord(&blob);
+        reader_has_data = reader != nullptr ? reader->NextRecord(&blob)
+                                            : mmap_source_->NextRecord(&blob);
         if (reader_has_data) {
           idx = gl_idx++;
           if (idx >= batch_param_.batch_size) {
             inst_order_.push_back(std::make_pair(tid, out_tmp.Size()));
+            if (mmap_source_ != nullptr) inst_rnds_.push_back(*prnds_[tid]);
           }
         }
       }
@@ -555,30 +575,36 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
         prnds_[tid]->seed(idx + param_.seed_aug.value() + kRandMagic);
       }
 
-      switch (param_.data_shape[0]) {
-       case 1:
+      if (decoded_cache_ == nullptr || !decoded_cache_->Get(rec.image_index(), &res)) {
+        switch (param_.data_shape[0]) {
+         case 1:
 #if MXNET_USE_LIBJPEG_TURBO
-        res = TJimdecode(buf, 0);
+          res = TJimdecode(buf, 0, min_decode_edge_);
 #else
-        res = cv::imdecode(buf, 0);
+          res = cv::imdecode(buf, 0);
 #endif
-        break;
-       case 3:
+          break;
+         case 3:
 #if MXNET_USE_LIBJPEG_TURBO
-        res = TJimdecode(buf, 1);
+          res = TJimdecode(buf, 1, min_decode_edge_);
 #else
-        res = cv::imdecode(buf, 1);
+          res = cv::imdecode(buf, 1);
 #endif
-        break;
-       case 4:
-        // -1 to keep the number of channel of the encoded image, and not force gray or color.
-        res = cv::imdecode(buf, -1);
-        CHECK_EQ(res.channels(), 4)
-          << "Invalid image with index " << rec.image_index()
-          << ". Expected 4 channels, got " << res.channels();
-        break;
-       default:
-        LOG(FATAL) << "Invalid output shape " << param_.data_shape;
+          break;
+         case 4:
+          // -1 to keep the number of channel of the encoded image, and not force gray or color.
+          res = cv::imdecode(buf, -1);
+          CHECK_EQ(res.channels(), 4)
+            << "Invalid image with index " << rec.image_index()
+            << ". Expected 4 channels, got " << res.channels();
+          break;
+         default:
+          LOG(FATAL) << "Invalid output shape " << param_.data_shape;
+        }
+        if (decoded_cache_ != nullptr) {
+          res = ShrinkShorterEdge(res, cache_edge_, cache_inter_method_);
+          decoded_cache_->Put(rec.image_index(), res);
+        }
       }
       const int n_channels = res.channels();
       // load label before augmentations
@@ -666,8 +692,9 @@ inline void ImageRecordIOParser2<DType>::CreateMeanImg(void) {
     double start = dmlc::GetTime();
     dmlc::InputSplit::Blob chunk;
     size_t imcnt = 0;  // NOLINT(*)
-    while (source_->NextChunk(&chunk)) {
+    while (mmap_source_ != nullptr ? SourceNextBatch(&chunk) : source_->NextChunk(&chunk)) {
       inst_order_.clear();
+      inst_rnds_.clear();
       // Parse chunk w/o putting anything in out
       ParseChunk(nullptr, nullptr, batch_param_.batch_size, &chunk);
       for (size_t i = 0; i < inst_order_.size(); ++i) {
@@ -716,18 +743,22 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
     virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
       prefetch_param_.InitAllowUnknown(kwargs);
       parser_.Init(kwargs);
-      // maximum prefetch threaded iter internal size
-      const int kMaxPrefetchBuffer = 16;
       // init thread iter
-      iter_.set_max_capacity(kMaxPrefetchBuffer);
+      iter_.set_max_capacity(prefetch_param_.prefetch_queue_size);
+      state_.Init(&parser_);
       // init thread iter
       iter_.Init([this](DataBatch **dptr) {
           if (*dptr == nullptr) {
             *dptr = new DataBatch();
           }
-          return parser_.ParseNext(*dptr);
+          if (!parser_.ParseNext(*dptr)) return false;
+          state_.Produced(&parser_, *dptr);
+          return true;
           },
-          [this]() { parser_.BeforeFirst(); });
+          [this]() {
+            parser_.BeforeFirst();
+            state_.Reset(&parser_);
+          });
     }
 
     virtual void BeforeFirst(void) {
@@ -749,13 +780,24 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
         recycle_queue_.pop();
         iter_.Recycle(&old_batch);
       }
-      return iter_.Next(&out_);
+      if (!iter_.Next(&out_)) return false;
+      state_.Consumed(out_);
+      return true;
     }
 
     virtual const DataBatch &Value(void) const {
       return *out_;
     }
 
+    virtual bool SaveState(dmlc::Stream *fo) {
+      return state_.Save(fo);
+    }
+
+    virtual void LoadState(dmlc::Stream *fi) {
+      state_.Load(fi);
+      iter_.BeforeFirst();
+    }
+
  private:
     /*! \brief Backend thread */
     dmlc::ThreadedIter<DataBatch> iter_;
@@ -767,6 +809,8 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
     std::queue<DataBatch*> recycle_queue_;
     /* \brief parser */
     ImageRecordIOParser2<DType> parser_;
+    /*! \brief state of the parser after the batch last returned */
+    PrefetchState<DataBatch> state_;
 };
 
 template<typename DType = real_t>
@@ -803,6 +847,13 @@ class ImageRecordIter2CPU : public IIterator<DataBatch> {
 
   virtual const DataBatch& Value(void) const { return *out_; }
 
+  virtual bool SaveState(dmlc::Stream *fo) { return parser_.SaveState(fo); }
+
+  virtual void LoadState(dmlc::Stream *fi) {
+    parser_.BeforeFirst();
+    parser_.LoadState(fi);
+  }
+
  private:
   /*! \brief Backend thread */
   dmlc::ThreadedIter<DataBatch> iter_;
@@ -873,6 +924,14 @@ class ImageRecordIter2Wrapper : public IIterator<DataBatch> {
       return record_iter_->Value();
     }
 
+    bool SaveState(dmlc::Stream *fo) override {
+      return record_iter_->SaveState(fo);
+    }
+
+    void LoadState(dmlc::Stream *fi) override {
+      record_iter_->LoadState(fi);
+    }
+
  private:
   IIterator<DataBatch>* record_iter_ = nullptr;
 };
@@ -25,9 +25,9 @@
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
-#include <dmlc/data.h>
 #include "./iter_sparse_prefetcher.h"
 #include "./iter_sparse_batchloader.h"
+#include "./text_parser.h"
 
 namespace mxnet {
 namespace io {
@@ -45,6 +45,8 @@ struct LibSVMIterParam : public dmlc::Parameter<LibSVMIterParam> {
   int num_parts;
   /*! \brief the index of the part will read*/
   int part_index;
+  /*! \brief number of threads parsing the text */
+  int preprocess_threads;
   // declare parameters
   DMLC_DECLARE_PARAMETER(LibSVMIterParam) {
     DMLC_DECLARE_FIELD(data_libsvm)
@@ -61,6 +63,8 @@ struct LibSVMIterParam : public dmlc::Parameter<LibSVMIterParam> {
         .describe("partition the data into multiple parts");
     DMLC_DECLARE_FIELD(part_index).set_default(0)
         .describe("the index of the part will read");
+    DMLC_DECLARE_FIELD(preprocess_threads).set_lower_bound(1).set_default(4)
+        .describe("The number of threads parsing the LibSVM files.");
   }
 };
 
@@ -75,13 +79,11 @@ class LibSVMIter: public SparseIIterator<DataInst> {
     CHECK_EQ(param_.data_shape.ndim(), 1) << "dimension of data_shape is expected to be 1";
     CHECK_GT(param_.num_parts, 0) << "number of parts should be positive";
     CHECK_GE(param_.part_index, 0) << "part index should be non-negative";
-    data_parser_.reset(dmlc::Parser<uint64_t>::Create(param_.data_libsvm.c_str(),
-                                                      param_.part_index,
-                                                      param_.num_parts, "libsvm"));
+    data_parser_.reset(new LibSVMTextParser(param_.data_libsvm, param_.part_index,
+                                            param_.num_parts, param_.preprocess_threads));
     if (param_.label_libsvm != "NULL") {
-      label_parser_.reset(dmlc::Parser<uint64_t>::Create(param_.label_libsvm.c_str(),
-                                                         param_.part_index,
-                                                         param_.num_parts, "libsvm"));
+      label_parser_.reset(new LibSVMTextParser(param_.label_libsvm, param_.part_index,
+                                               param_.num_parts, param_.preprocess_threads));
       CHECK_GT(param_.label_shape.Size(), 1)
         << "label_shape is not expected to be (1,) when param_.label_libsvm is set.";
     } else {
@@ -115,31 +117,33 @@ class LibSVMIter: public SparseIIterator<DataInst> {
         end_ = true; return false;
       }
       data_ptr_ = 0;
-      data_size_ = data_parser_->Value().size;
+      data_size_ = data_parser_->Value().Size();
     }
     out_.index = inst_counter_++;
     CHECK_LT(data_ptr_, data_size_);
-    const auto data_row = data_parser_->Value()[data_ptr_++];
+    const SparseTextBlock& data_block = data_parser_->Value();
+    const size_t data_row = data_ptr_++;
     // data, indices and indptr
-    out_.data[0] = AsDataBlob(data_row);
-    out_.data[1] = AsIdxBlob(data_row);
-    out_.data[2] = AsIndPtrPlaceholder(data_row);
+    out_.data[0] = AsDataBlob(data_block, data_row);
+    out_.data[1] = AsIdxBlob(data_block, data_row);
+    out_.data[2] = AsIndPtrPlaceholder();
 
     if (label_parser_.get() != nullptr) {
       while (label_ptr_ >= label_size_) {
         CHECK(label_parser_->Next())
             << "Data LibSVM's row is smaller than the number of rows in label_libsvm";
         label_ptr_ = 0;
-        label_size_ = label_parser_->Value().size;
+        label_size_ = label_parser_->Value().Size();
       }
       CHECK_LT(label_ptr_, label_size_);
-      const auto label_row = label_parser_->Value()[label_ptr_++];
+      const SparseTextBlock& label_block = label_parser_->Value();
+      const size_t label_row = label_ptr_++;
       // data, indices and indptr
-      out_.data[3] = AsDataBlob(label_row);
-      out_.data[4] = AsIdxBlob(label_row);
-      out_.data[5] = AsIndPtrPlaceholder(label_row);
+      out_.data[3] = AsDataBlob(label_block, label_row);
+      out_.data[4] = AsIdxBlob(label_block, label_row);
+      out_.data[5] = AsIndPtrPlaceholder();
     } else {
-      out_.data[3] = AsScalarLabelBlob(data_row);
+      out_.data[3] = AsScalarLabelBlob(data_block, data_row);
     }
     return true;
   }
@@ -148,6 +152,30 @@ class LibSVMIter: public SparseIIterator<DataInst> {
     return out_;
   }
 
+  virtual bool SaveState(dmlc::Stream *fo) {
+    data_parser_->SaveState(fo);
+    if (label_parser_.get() != nullptr) {
+      label_parser_->SaveState(fo);
+    }
+    fo->Write(data_ptr_);
+    fo->Write(data_size_);
+    fo->Write(label_ptr_);
+    fo->Write(label_size_);
+    fo->Write(inst_counter_);
+    fo->Write(end_);
+    return true;
+  }
+
+  virtual void LoadState(dmlc::Stream *fi) {
+    data_parser_->LoadState(fi);
+    if (label_parser_.get() != nullptr) {
+      label_parser_->LoadState(fi);
+    }
+    CHECK(fi->Read(&data_ptr_) && fi->Read(&data_size_) &&
+          fi->Read(&label_ptr_) && fi->Read(&label_size_) &&
+          fi->Read(&inst_counter_) && fi->Read(&end_)) << "Invalid LibSVMIter state";
+  }
+
   virtual const NDArrayStorageType GetStorageType(bool is_data) const {
     if (is_data) return kCSRStorage;
     return param_.label_shape.Size() > 1 ? kCSRStorage : kDefaultStorage;
@@ -159,24 +187,24 @@ class LibSVMIter: public SparseIIterator<DataInst> {
   }
 
  private:
-  inline TBlob AsDataBlob(const dmlc::Row<uint64_t>& row) {
-    const real_t* ptr = row.value;
-    mxnet::TShape shape(mshadow::Shape1(row.length));
+  inline TBlob AsDataBlob(const SparseTextBlock& block, size_t row) {
+    const real_t* ptr = block.value.data() + block.offset[row];
+    mxnet::TShape shape(mshadow::Shape1(block.offset[row + 1] - block.offset[row]));
     return TBlob((real_t*) ptr, shape, cpu::kDevMask);  // NOLINT(*)
   }
 
-  inline TBlob AsIdxBlob(const dmlc::Row<uint64_t>& row) {
-    const uint64_t* ptr = row.index;
-    mxnet::TShape shape(mshadow::Shape1(row.length));
+  inline TBlob AsIdxBlob(const SparseTextBlock& block, size_t row) {
+    const uint64_t* ptr = block.index.data() + block.offset[row];
+    mxnet::TShape shape(mshadow::Shape1(block.offset[row + 1] - block.offset[row]));
     return TBlob((int64_t*) ptr, shape, cpu::kDevMask, mshadow::kInt64);  // NOLINT(*)
   }
 
-  inline TBlob AsIndPtrPlaceholder(const dmlc::Row<uint64_t>& row) {
+  inline TBlob AsIndPtrPlaceholder() {
     return TBlob(nullptr, mshadow::Shape1(0), cpu::kDevMask, mshadow::kInt64);
   }
 
-  inline TBlob AsScalarLabelBlob(const dmlc::Row<uint64_t>& row) {
-    const real_t* ptr = row.label;
+  inline TBlob AsScalarLabelBlob(const SparseTextBlock& block, size_t row) {
+    const real_t* ptr = block.label.data() + row;
     return TBlob((real_t*) ptr, mshadow::Shape1(1), cpu::kDevMask);  // NOLINT(*)
   }
 
@@ -190,8 +218,8 @@ class LibSVMIter: public SparseIIterator<DataInst> {
   // label parser
   size_t label_ptr_{0}, label_size_{0};
   size_t data_ptr_{0}, data_size_{0};
-  std::unique_ptr<dmlc::Parser<uint64_t> > label_parser_;
-  std::unique_ptr<dmlc::Parser<uint64_t> > data_parser_;
+  std::unique_ptr<LibSVMTextParser> label_parser_;
+  std::unique_ptr<LibSVMTextParser> data_parser_;
 };
 
 
@@ -224,6 +252,9 @@ When `num_parts` and `part_index` are provided, the data is split into `num_part
 and the iterator only reads the `part_index`-th partition. However, the partitions are not
 guaranteed to be even.
 
+The files are parsed by `preprocess_threads` threads, each one taking a share of the lines
+of every chunk read.
+
 ``reset()`` is expected to be called only after a complete pass of data.
 
 Example::
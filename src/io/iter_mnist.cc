@@ -138,6 +138,15 @@ class MNISTIter: public IIterator<TBlobBatch> {
   virtual const TBlobBatch &Value(void) const {
     return out_;
   }
+  virtual bool SaveState(dmlc::Stream *fo) {
+    // the shuffle only depends on the seed
+    fo->Write(loc_);
+    return true;
+  }
+  virtual void LoadState(dmlc::Stream *fi) {
+    CHECK(fi->Read(&loc_)) << "Invalid MNISTIter state";
+    CHECK_LE(loc_, img_.size(0)) << "The MNISTIter state was saved on more images";
+  }
 
  private:
   inline void GetPart(int count, int* start, int *end) {
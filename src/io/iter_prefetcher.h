@@ -40,6 +40,8 @@
 #include <algorithm>
 #include "./inst_vector.h"
 #include "./image_iter_common.h"
+#include "./iter_batchloader.h"
+#include "./iter_state.h"
 
 namespace mxnet {
 namespace io {
@@ -63,17 +65,36 @@ class PrefetcherIter : public IIterator<DataBatch> {
     std::vector<std::pair<std::string, std::string> > kwargs_left;
     // init image rec param
     kwargs_left = param_.InitAllowUnknown(kwargs);
-    // maximum prefetch threaded iter internal size
-    const int kMaxPrefetchBuffer = 16;
     // init thread iter
-    iter.set_max_capacity(kMaxPrefetchBuffer);
+    iter.set_max_capacity(param_.prefetch_queue_size);
+  }
+
+  /*! \return the context the prefetched batches are allocated in */
+  Context BatchContext() const {
+    switch (param_.batch_memory) {
+      case PrefetcherParam::kPinnedMemory: return Context::CPUPinned(0);
+      case PrefetcherParam::kSharedMemory: return Context::CPUShared(0);
+      default: return Context::CPU();
+    }
   }
 
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
     InitParams(kwargs);
     // use the kwarg to init batch loader
     loader_->Init(kwargs);
-    iter.Init([this](DataBatch **dptr) {
+    // a batch loader can write straight into the recycled batches, unless they
+    // are converted to another type
+    BatchLoader *direct_loader = param_.dtype ? nullptr
+                                              : dynamic_cast<BatchLoader*>(loader_.get());
+    state_.Init(loader_.get());
+    iter.Init([this, direct_loader](DataBatch **dptr) {
+        if (direct_loader != nullptr) {
+          std::vector<TBlob> out;
+          if (*dptr != nullptr) {
+            for (const NDArray& arr : (*dptr)->data) out.push_back(arr.data());
+          }
+          direct_loader->SetOutput(out);
+        }
         if (!loader_->Next()) return false;
         const TBlobBatch& batch = loader_->Value();
         if (*dptr == nullptr) {
@@ -87,28 +108,33 @@ class PrefetcherIter : public IIterator<DataBatch> {
                              ? param_.dtype.value()
                              : batch.data[i].type_flag_;
             (*dptr)->data.at(i) = NDArray(batch.data[i].shape_,
-                                          Context::CPU(), false,
+                                          BatchContext(), false,
                                           dtype);
           }
         }
         CHECK(batch.data.size() == (*dptr)->data.size());
-        // copy data over
+        // copy data over, unless the loader wrote it in place
         for (size_t i = 0; i < batch.data.size(); ++i) {
           CHECK_EQ((*dptr)->data.at(i).shape(), batch.data[i].shape_);
+          (*dptr)->num_batch_padd = batch.num_batch_padd;
+          if ((*dptr)->data[i].data().dptr_ == batch.data[i].dptr_) continue;
           MSHADOW_TYPE_SWITCH(batch.data[i].type_flag_, DType, {
               mshadow::Copy(((*dptr)->data)[i].data().FlatTo2D<cpu, DType>(),
                         batch.data[i].FlatTo2D<cpu, DType>());
           });
-          (*dptr)->num_batch_padd = batch.num_batch_padd;
         }
         if (batch.inst_index) {
           std::copy(batch.inst_index,
                     batch.inst_index + batch.batch_size,
                     (*dptr)->index.begin());
         }
+        state_.Produced(loader_.get(), *dptr);
        return true;
       },
-      [this]() { loader_->BeforeFirst(); });
+      [this]() {
+        loader_->BeforeFirst();
+        state_.Reset(loader_.get());
+      });
   }
 
   virtual void BeforeFirst(void) {
@@ -129,12 +155,23 @@ class PrefetcherIter : public IIterator<DataBatch> {
       recycle_queue_.pop();
       iter.Recycle(&old_batch);
     }
-    return iter.Next(&out_);
+    if (!iter.Next(&out_)) return false;
+    state_.Consumed(out_);
+    return true;
   }
   virtual const DataBatch &Value(void) const {
     return *out_;
   }
 
+  virtual bool SaveState(dmlc::Stream *fo) {
+    return state_.Save(fo);
+  }
+
+  virtual void LoadState(dmlc::Stream *fi) {
+    state_.Load(fi);
+    iter.BeforeFirst();
+  }
+
  protected:
   /*! \brief prefetcher parameters */
   PrefetcherParam param_;
@@ -142,6 +179,8 @@ class PrefetcherIter : public IIterator<DataBatch> {
   dmlc::ThreadedIter<DataBatch> iter;
   /*! \brief internal batch loader */
   std::unique_ptr<IIterator<TBlobBatch> > loader_;
+  /*! \brief state of the loader after the batch last returned */
+  PrefetchState<DataBatch> state_;
 
  private:
   /*! \brief output data */
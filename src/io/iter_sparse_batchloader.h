@@ -104,6 +104,14 @@ class SparseBatchLoader : public BatchLoader, public SparseIIterator<TBlobBatch>
     return BatchLoader::Value();
   }
 
+  virtual bool SaveState(dmlc::Stream *fo) {
+    return BatchLoader::SaveState(fo);
+  }
+
+  virtual void LoadState(dmlc::Stream *fi) {
+    BatchLoader::LoadState(fi);
+  }
+
   virtual const NDArrayStorageType GetStorageType(bool is_data) const {
     return sparse_base_->GetStorageType(is_data);
   }
@@ -56,6 +56,7 @@ class SparsePrefetcherIter : public PrefetcherIter {
     PrefetcherIter::InitParams(kwargs);
     // use the kwarg to init batch loader
     sparse_loader_->Init(kwargs);
+    state_.Init(loader_.get());
     iter.Init([this](DataBatch **dptr) {
         if (!sparse_loader_->Next()) return false;
         const TBlobBatch& batch = sparse_loader_->Value();
@@ -114,9 +115,13 @@ class SparsePrefetcherIter : public PrefetcherIter {
                     batch.inst_index + batch.batch_size,
                     (*dptr)->index.begin());
         }
+        state_.Produced(loader_.get(), *dptr);
        return true;
       },
-      [this]() { sparse_loader_->BeforeFirst(); });
+      [this]() {
+        sparse_loader_->BeforeFirst();
+        state_.Reset(loader_.get());
+      });
   }
 
   virtual void BeforeFirst(void) {
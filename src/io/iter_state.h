@@ -0,0 +1,131 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file iter_state.h
+ * \brief saved states of iterators read ahead by a prefetch thread
+ */
+#ifndef MXNET_IO_ITER_STATE_H_
+#define MXNET_IO_ITER_STATE_H_
+
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/memory_io.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace mxnet {
+namespace io {
+
+/*!
+ * \brief Tracks the state to save for an iterator whose batches are produced ahead
+ *  by a prefetch thread, where the state of the source is that of the last batch
+ *  queued rather than of the last one returned. The producer takes the state of the
+ *  source after every batch, and the consumer keeps the one of the batch it got.
+ *
+ *  A state to load is applied by the producer when it goes back to the first batch,
+ *  so the batches queued from the old position are dropped.
+ * \tparam Batch the type of the prefetched batches
+ */
+template<typename Batch>
+class PrefetchState {
+ public:
+  /*!
+   * \brief take the initial state of the source, before the producer starts
+   * \tparam Source a type with the SaveState and LoadState of IIterator
+   */
+  template<typename Source>
+  void Init(Source *source) {
+    supported_ = Take(source, &current_);
+  }
+
+  /*! \brief called by the producer once source filled batch */
+  template<typename Source>
+  void Produced(Source *source, const Batch *batch) {
+    if (!supported_) return;
+    std::string state;
+    CHECK(Take(source, &state)) << "The iterator stopped saving its state";
+    std::lock_guard<std::mutex> lock(mutex_);
+    produced_[batch].swap(state);
+  }
+
+  /*! \brief called by the consumer when it got batch */
+  void Consumed(const Batch *batch) {
+    if (!supported_) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = produced_.find(batch);
+    if (it != produced_.end()) current_ = it->second;
+  }
+
+  /*! \brief called by the producer once source went back to the first batch */
+  template<typename Source>
+  void Reset(Source *source) {
+    if (!supported_) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (has_pending_) {
+      dmlc::MemoryStringStream fi(&pending_);
+      has_pending_ = false;
+      source->LoadState(&fi);
+    }
+    Take(source, &current_);
+  }
+
+  /*! \brief save the state of the last batch the consumer got */
+  bool Save(dmlc::Stream *fo) {
+    if (!supported_) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    fo->Write(current_);
+    return true;
+  }
+
+  /*! \brief read a state to apply at the next Reset, which the consumer has to request */
+  void Load(dmlc::Stream *fi) {
+    CHECK(supported_) << "This iterator cannot load a saved state";
+    std::string state;
+    CHECK(fi->Read(&state)) << "Invalid iterator state";
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.swap(state);
+    has_pending_ = true;
+  }
+
+ private:
+  template<typename Source>
+  static bool Take(Source *source, std::string *state) {
+    state->clear();
+    dmlc::MemoryStringStream fo(state);
+    return source->SaveState(&fo);
+  }
+
+  /*! \brief whether the source saves its state */
+  bool supported_{false};
+  /*! \brief state after the last batch the consumer got */
+  std::string current_;
+  /*! \brief state after each batch produced, by batch */
+  std::unordered_map<const Batch*, std::string> produced_;
+  /*! \brief state to load at the next Reset */
+  std::string pending_;
+  bool has_pending_{false};
+  std::mutex mutex_;
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_ITER_STATE_H_
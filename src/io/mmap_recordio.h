@@ -0,0 +1,254 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file mmap_recordio.h
+ * \brief RecordIO reader serving the records of an indexed file as views into its mapping
+ */
+#ifndef MXNET_IO_MMAP_RECORDIO_H_
+#define MXNET_IO_MMAP_RECORDIO_H_
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // _WIN32
+#include <dmlc/base.h>
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/recordio.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+
+/*!
+ * \brief Maps a RecordIO file into memory and serves the records listed in its
+ *  index as views into the mapping, so records resident in the page cache reach
+ *  the decoders without being copied. Every epoch visits the records of this
+ *  part in a fresh global permutation when shuffling.
+ *
+ *  Records the writer split because their payload contains the RecordIO magic
+ *  number cannot be viewed in place; they are reassembled into buffers owned by
+ *  the reader, which live until the next call to NextBatch.
+ */
+class MMapRecordIOReader {
+ public:
+  /*!
+   * \brief map a RecordIO file
+   * \param rec_path path of the local .rec file
+   * \param idx_path path of its index, lines of "key offset"
+   * \param part_index the part of the records to read
+   * \param num_parts the number of parts the records are split into
+   * \param shuffle whether to visit the records in a random order
+   * \param seed the seed of the shuffle
+   */
+  MMapRecordIOReader(const std::string& rec_path, const std::string& idx_path,
+                     unsigned part_index, unsigned num_parts, bool shuffle, int seed)
+      : shuffle_(shuffle), rnd_(kRandMagic + seed) {
+    CHECK_LT(part_index, num_parts) << "part_index must be smaller than num_parts";
+    LoadIndex(idx_path);
+    const size_t begin = offsets_.size() * part_index / num_parts;
+    const size_t end = offsets_.size() * (part_index + 1) / num_parts;
+    offsets_ = std::vector<size_t>(offsets_.begin() + begin, offsets_.begin() + end);
+    Map(rec_path);
+    order_ = offsets_;
+    this->BeforeFirst();
+  }
+
+  ~MMapRecordIOReader() {
+#ifndef _WIN32
+    if (data_ != nullptr) munmap(data_, size_);
+#endif  // _WIN32
+  }
+
+  /*! \brief start a new epoch, in a new order when shuffling */
+  void BeforeFirst() {
+    if (shuffle_) {
+      // shuffle the file order, so that the order of an epoch follows from epoch_rnd_
+      epoch_rnd_ = rnd_;
+      order_ = offsets_;
+      std::shuffle(order_.begin(), order_.end(), rnd_);
+    }
+    batch_end_ = 0;
+    cursor_ = 0;
+    owned_.clear();
+  }
+
+  /*!
+   * \brief select the next batch of records, to be read with NextRecord
+   * \param batch_size the number of records in the batch
+   * \return false at the end of the epoch
+   */
+  bool NextBatch(size_t batch_size) {
+    cursor_ = batch_end_;
+    if (cursor_ >= order_.size()) return false;
+    batch_end_ = std::min(cursor_ + batch_size, order_.size());
+    owned_.clear();
+    return true;
+  }
+
+  /*!
+   * \brief get the next record of the selected batch, not thread safe
+   * \param out_rec the record, valid until the next call to NextBatch
+   * \return false when the batch has been read
+   */
+  bool NextRecord(dmlc::InputSplit::Blob *out_rec) {
+    if (cursor_ >= batch_end_) return false;
+    const size_t offset = order_[cursor_++];
+    uint32_t cflag, len;
+    const char *payload = ReadHeader(offset, &cflag, &len);
+    if (cflag == 0U) {
+      out_rec->dptr = const_cast<char*>(payload);
+      out_rec->size = len;
+      return true;
+    }
+    CHECK_EQ(cflag, 1U) << "Index offset " << offset << " is not the start of a record";
+    owned_.emplace_back();
+    std::string &rec = owned_.back();
+    size_t next = offset;
+    while (true) {
+      rec.append(payload, len);
+      if (cflag == 3U) break;
+      const uint32_t magic = dmlc::RecordIOWriter::kMagic;
+      rec.append(reinterpret_cast<const char*>(&magic), sizeof(magic));
+      next += 2 * sizeof(uint32_t) + ((len + 3U) & ~3U);
+      payload = ReadHeader(next, &cflag, &len);
+      CHECK(cflag == 2U || cflag == 3U) << "Invalid RecordIO continuation at " << next;
+    }
+    out_rec->dptr = &rec[0];
+    out_rec->size = rec.size();
+    return true;
+  }
+
+  /*!
+   * \brief save the position in the epoch, to be loaded by a reader of the same file,
+   *  part and seed
+   * \param pending the number of records of the selected batches that were not used,
+   *  which are served again after loading the state
+   */
+  void SaveState(dmlc::Stream *fo, size_t pending) const {
+    CHECK_LE(pending, batch_end_);
+    std::ostringstream rnd;
+    rnd << epoch_rnd_;
+    fo->Write(rnd.str());
+    fo->Write(batch_end_ - pending);
+  }
+
+  /*!
+   * \brief go to a position saved by SaveState, replaying the shuffle of its epoch
+   *  and seeking straight to the next record
+   */
+  void LoadState(dmlc::Stream *fi) {
+    std::string rnd;
+    size_t position;
+    CHECK(fi->Read(&rnd) && fi->Read(&position)) << "Invalid RecordIO reader state";
+    std::istringstream is(rnd);
+    is >> rnd_;
+    CHECK(!is.fail()) << "Invalid RecordIO reader state";
+    this->BeforeFirst();
+    CHECK_LE(position, order_.size()) << "The RecordIO reader state was saved on more records";
+    batch_end_ = cursor_ = position;
+  }
+
+  /*! \return the number of records of this part */
+  size_t NumRecords() const {
+    return offsets_.size();
+  }
+
+ private:
+  /*! \brief magic number to seed the shuffle */
+  static const int kRandMagic = 111;
+
+  void LoadIndex(const std::string& idx_path) {
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(idx_path.c_str(), "r"));
+    dmlc::istream is(fi.get());
+    size_t key, offset;
+    while (is >> key >> offset) {
+      offsets_.push_back(offset);
+    }
+    CHECK(!offsets_.empty()) << "No record found in index " << idx_path;
+    std::sort(offsets_.begin(), offsets_.end());
+  }
+
+  void Map(const std::string& rec_path) {
+#ifndef _WIN32
+    int fd = open(rec_path.c_str(), O_RDONLY);
+    CHECK_GE(fd, 0) << "Failed to open " << rec_path << " for mapping: " << strerror(errno)
+                    << ". Only local files can be mapped.";
+    struct stat st;
+    CHECK_EQ(fstat(fd, &st), 0) << "Failed to stat " << rec_path << ": " << strerror(errno);
+    size_ = static_cast<size_t>(st.st_size);
+    CHECK_GT(size_, 0U) << rec_path << " is empty";
+    void *ptr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    CHECK_NE(ptr, MAP_FAILED) << "Failed to map " << rec_path << ": " << strerror(errno);
+    data_ = static_cast<char*>(ptr);
+    madvise(ptr, size_, shuffle_ ? MADV_RANDOM : MADV_SEQUENTIAL);
+#else
+    LOG(FATAL) << "Memory mapped RecordIO is not supported on Windows";
+#endif  // _WIN32
+  }
+
+  const char *ReadHeader(size_t offset, uint32_t *cflag, uint32_t *len) const {
+    CHECK_LE(offset + 2 * sizeof(uint32_t), size_) << "Truncated record at " << offset;
+    uint32_t header[2];
+    std::memcpy(header, data_ + offset, sizeof(header));
+    const uint32_t magic = dmlc::RecordIOWriter::kMagic;
+    CHECK_EQ(header[0], magic) << "Invalid RecordIO record at " << offset;
+    *cflag = dmlc::RecordIOWriter::DecodeFlag(header[1]);
+    *len = dmlc::RecordIOWriter::DecodeLength(header[1]);
+    CHECK_LE(offset + sizeof(header) + *len, size_) << "Truncated record at " << offset;
+    return data_ + offset + sizeof(header);
+  }
+
+  /*! \brief the mapped file */
+  char *data_{nullptr};
+  /*! \brief size of the mapped file */
+  size_t size_{0};
+  /*! \brief offsets of the records of this part, in file order */
+  std::vector<size_t> offsets_;
+  /*! \brief offsets of the records in the order of the current epoch */
+  std::vector<size_t> order_;
+  /*! \brief position of the next record and the end of the current batch in order_ */
+  size_t cursor_{0}, batch_end_{0};
+  /*! \brief reassembled split records of the current batch */
+  std::deque<std::string> owned_;
+  /*! \brief whether to shuffle every epoch */
+  bool shuffle_;
+  /*! \brief random engine of the shuffle */
+  std::mt19937 rnd_;
+  /*! \brief random engine of the shuffle when the current epoch started */
+  std::mt19937 epoch_rnd_;
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_MMAP_RECORDIO_H_
@@ -0,0 +1,529 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file text_parser.h
+ * \brief multi-threaded parsers of the CSV and LibSVM text formats
+ */
+#ifndef MXNET_IO_TEXT_PARSER_H_
+#define MXNET_IO_TEXT_PARSER_H_
+
+#include <dmlc/base.h>
+#include <dmlc/endian.h>
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <mxnet/base.h>
+#include <mxnet/tuple.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+
+/*! \brief the most decimal digits accumulated into the mantissa of a number */
+const int kTextMaxDigits = 19;
+
+inline bool IsTextDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline bool IsTextBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+/*! \brief whether the 8 bytes of val, first character lowest, are all decimal digits */
+inline bool IsEightDigits(uint64_t val) {
+  return ((val & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((val + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+         0x3333333333333333ULL;
+}
+
+/*! \brief value of the 8 decimal digits of val, first character lowest, with 3 multiplies */
+inline uint64_t EightDigitsValue(uint64_t val) {
+  val -= 0x3030303030303030ULL;
+  val = val * 10 + (val >> 8);
+  return ((val & 0x000000FF000000FFULL) * 0x000F424000000064ULL +
+          ((val >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL) >> 32;
+}
+
+/*!
+ * \brief accumulate the decimal digits at p into mantissa, eight at a time while they last
+ * \param significant digits of the mantissa so far, at most kTextMaxDigits
+ * \param taken incremented by the number of digits accumulated into the mantissa
+ * \param dropped incremented by the number of digits beyond the precision of the mantissa
+ * \return the end of the digits
+ */
+inline const char *AccumulateDigits(const char *p, const char *end, uint64_t *mantissa,
+                                    int *significant, int *taken, int *dropped) {
+#if DMLC_LITTLE_ENDIAN
+  while (end - p >= 8 && *significant + 8 <= kTextMaxDigits) {
+    uint64_t chunk;
+    std::memcpy(&chunk, p, sizeof(chunk));
+    if (!IsEightDigits(chunk)) break;
+    const uint64_t value = EightDigitsValue(chunk);
+    if (*mantissa != 0) {
+      *significant += 8;
+    } else {
+      // only the digits after the leading zeros of the chunk are significant
+      for (uint64_t v = value; v != 0; v /= 10) ++*significant;
+    }
+    *mantissa = *mantissa * 100000000ULL + value;
+    *taken += 8;
+    p += 8;
+  }
+#endif  // DMLC_LITTLE_ENDIAN
+  for (; p != end && IsTextDigit(*p); ++p) {
+    if (*significant < kTextMaxDigits) {
+      *mantissa = *mantissa * 10 + static_cast<uint64_t>(*p - '0');
+      if (*mantissa != 0) ++*significant;
+      ++*taken;
+    } else {
+      ++*dropped;
+    }
+  }
+  return p;
+}
+
+/*! \brief parse what strtod accepts beyond plain decimals, like nan, inf and hex floats */
+template<typename DType>
+inline const char *ParseRealFallback(const char *p, const char *end, DType *out) {
+  char buf[64];
+  const size_t len = std::min<size_t>(end - p, sizeof(buf) - 1);
+  std::memcpy(buf, p, len);
+  buf[len] = '\0';
+  char *endptr;
+  *out = static_cast<DType>(std::strtod(buf, &endptr));
+  return p + (endptr - buf);
+}
+
+/*!
+ * \brief parse a decimal floating point number
+ * \return the end of the number, p when there is none and out is set to 0
+ */
+template<typename DType>
+inline const char *ParseReal(const char *p, const char *end, DType *out) {
+  static const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char *begin = p;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  // hex floats start with the digit 0, so they are told apart before the decimal digits
+  if (end - p >= 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+    return ParseRealFallback(begin, end, out);
+  }
+  uint64_t mantissa = 0;
+  int significant = 0, taken = 0, dropped = 0;
+  const char *q = AccumulateDigits(p, end, &mantissa, &significant, &taken, &dropped);
+  bool has_digits = q != p;
+  int exp10 = dropped;
+  p = q;
+  if (p != end && *p == '.') {
+    ++p;
+    taken = dropped = 0;
+    q = AccumulateDigits(p, end, &mantissa, &significant, &taken, &dropped);
+    has_digits = has_digits || q != p;
+    exp10 -= taken;
+    p = q;
+  }
+  if (!has_digits) return ParseRealFallback(begin, end, out);
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    const char *e = p + 1;
+    bool negative_exp = false;
+    if (e != end && (*e == '-' || *e == '+')) {
+      negative_exp = *e == '-';
+      ++e;
+    }
+    if (e != end && IsTextDigit(*e)) {
+      int x = 0;
+      for (; e != end && IsTextDigit(*e); ++e) {
+        if (x < 100000) x = x * 10 + (*e - '0');
+      }
+      exp10 += negative_exp ? -x : x;
+      p = e;
+    }
+  }
+  double v = static_cast<double>(mantissa);
+  if (mantissa != 0 && exp10 != 0) {
+    if (exp10 > 0) {
+      v = exp10 <= 22 ? v * kPow10[exp10] : v * std::pow(10.0, exp10);
+    } else {
+      v = exp10 >= -22 ? v / kPow10[-exp10] : v * std::pow(10.0, exp10);
+    }
+  }
+  *out = static_cast<DType>(negative ? -v : v);
+  return p;
+}
+
+/*!
+ * \brief parse a decimal integer
+ * \return the end of the number, p when there is none and out is set to 0
+ */
+template<typename DType>
+inline const char *ParseInteger(const char *p, const char *end, DType *out) {
+  const char *begin = p;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  int significant = 0, taken = 0, dropped = 0;
+  const char *q = AccumulateDigits(p, end, &mantissa, &significant, &taken, &dropped);
+  if (q == p) {
+    *out = 0;
+    return begin;
+  }
+  const int64_t v = static_cast<int64_t>(mantissa);
+  *out = static_cast<DType>(negative ? -v : v);
+  return q;
+}
+
+/*!
+ * \brief parse a number of type DType from the text in [p, end)
+ * \return the end of the number, p when there is none and out is set to 0
+ */
+template<typename DType>
+inline const char *ParseNumber(const char *p, const char *end, DType *out) {
+  return std::is_integral<DType>::value ? ParseInteger(p, end, out) : ParseReal(p, end, out);
+}
+
+/*!
+ * \brief Reads a text file chunk by chunk and parses every chunk on several threads,
+ *  each one taking the lines of an equal share of the chunk into a block of its own.
+ *  Blocks are handed out in file order and live until the next chunk is parsed.
+ * \tparam Block the parsed lines, with Size() rows and Clear()
+ */
+template<typename Block>
+class ParallelTextParser {
+ public:
+  /*!
+   * \param uri the file or directory to read
+   * \param part_index the part of the data to read
+   * \param num_parts the number of parts the data is split into
+   * \param nthread the number of threads parsing a chunk
+   */
+  ParallelTextParser(const std::string& uri, unsigned part_index, unsigned num_parts,
+                     int nthread)
+      : nthread_(std::max(nthread, 1)) {
+    source_.reset(dmlc::InputSplit::Create(uri.c_str(), part_index, num_parts, "text"));
+    source_->HintChunkSize(nthread_ * kChunkBytesPerThread);
+  }
+  virtual ~ParallelTextParser() {}
+
+  /*! \brief go back to the start of the data */
+  void BeforeFirst() {
+    source_->BeforeFirst();
+    num_chunks_ = num_blocks_ = cursor_ = 0;
+  }
+
+  /*!
+   * \brief save the position in the data, to be loaded by a parser of the same data
+   *  with the same number of threads, which splits it into the same chunks
+   */
+  void SaveState(dmlc::Stream *fo) const {
+    fo->Write(nthread_);
+    fo->Write(num_chunks_);
+    fo->Write(cursor_);
+    fo->Write(bytes_read_);
+  }
+
+  /*!
+   * \brief go to a position saved by SaveState. Text splits cannot seek, so the chunks
+   *  before the current one are read again, but skipped without being parsed.
+   */
+  void LoadState(dmlc::Stream *fi) {
+    int nthread;
+    size_t num_chunks, cursor, bytes_read;
+    CHECK(fi->Read(&nthread) && fi->Read(&num_chunks) && fi->Read(&cursor) &&
+          fi->Read(&bytes_read)) << "Invalid text parser state";
+    CHECK_EQ(nthread, nthread_) << "The text parser state was saved with another number "
+                                << "of threads, which splits the data into other chunks";
+    BeforeFirst();
+    dmlc::InputSplit::Blob chunk;
+    for (size_t i = 1; i < num_chunks; ++i) {
+      CHECK(source_->NextChunk(&chunk)) << "The data is shorter than when its state was saved";
+    }
+    if (num_chunks != 0) {
+      CHECK(ParseChunk()) << "The data is shorter than when its state was saved";
+      CHECK_LE(cursor, num_blocks_) << "Invalid text parser state";
+      num_chunks_ = num_chunks;
+      cursor_ = cursor;
+    }
+    bytes_read_ = bytes_read;
+  }
+
+  /*! \brief move to the next non-empty block, false at the end of the data */
+  bool Next() {
+    while (true) {
+      while (cursor_ < num_blocks_) {
+        if (blocks_[cursor_++].Size() != 0) return true;
+      }
+      if (!ParseChunk()) return false;
+    }
+  }
+
+  /*! \brief the current block */
+  const Block &Value() const {
+    return blocks_[cursor_ - 1];
+  }
+
+  /*! \brief number of bytes of text parsed so far */
+  size_t BytesRead() const {
+    return bytes_read_;
+  }
+
+ protected:
+  /*! \brief parse the whole lines in [begin, end) into out, called concurrently */
+  virtual void ParseLines(const char *begin, const char *end, Block *out) const = 0;
+
+ private:
+  /*! \brief bytes of a chunk for each thread */
+  static const size_t kChunkBytesPerThread = 4UL << 20;
+  /*! \brief smallest share of a chunk worth a thread of its own */
+  static const size_t kMinBytesPerThread = 64UL << 10;
+
+  /*! \brief the first line starting at or after p */
+  static const char *LineStart(const char *head, const char *tail, const char *p) {
+    if (p == head) return head;
+    while (p != tail && p[-1] != '\n') ++p;
+    return p;
+  }
+
+  bool ParseChunk() {
+    dmlc::InputSplit::Blob chunk;
+    if (!source_->NextChunk(&chunk)) return false;
+    const char *head = static_cast<const char*>(chunk.dptr);
+    const char *tail = head + chunk.size;
+    const int nthread = static_cast<int>(
+        std::min<size_t>(nthread_, chunk.size / kMinBytesPerThread + 1));
+    if (blocks_.size() < static_cast<size_t>(nthread)) blocks_.resize(nthread);
+    std::vector<std::exception_ptr> errors(nthread);
+    #pragma omp parallel for num_threads(nthread)
+    for (int i = 0; i < nthread; ++i) {
+      try {
+        const char *begin = LineStart(head, tail, head + chunk.size * i / nthread);
+        const char *end = LineStart(head, tail, head + chunk.size * (i + 1) / nthread);
+        blocks_[i].Clear();
+        this->ParseLines(begin, end, &blocks_[i]);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+    for (const auto& error : errors) {
+      if (error) std::rethrow_exception(error);
+    }
+    num_blocks_ = nthread;
+    cursor_ = 0;
+    ++num_chunks_;
+    bytes_read_ += chunk.size;
+    return true;
+  }
+
+  /*! \brief number of threads parsing a chunk */
+  int nthread_;
+  /*! \brief the text being read */
+  std::unique_ptr<dmlc::InputSplit> source_;
+  /*! \brief blocks of the current chunk, kept across chunks to reuse their memory */
+  std::vector<Block> blocks_;
+  /*! \brief number of chunks parsed since the start of the data */
+  size_t num_chunks_{0};
+  /*! \brief number of blocks of the current chunk and the position after the current one */
+  size_t num_blocks_{0}, cursor_{0};
+  /*! \brief total size of the chunks parsed */
+  size_t bytes_read_{0};
+};
+
+/*! \brief dense rows of the same length, back to back */
+template<typename DType>
+struct DenseTextBlock {
+  /*! \brief values of the rows */
+  std::vector<DType> value;
+  /*! \brief number of values of a row */
+  size_t row_length{1};
+
+  size_t Size() const {
+    return value.size() / row_length;
+  }
+  const DType *Row(size_t i) const {
+    return value.data() + i * row_length;
+  }
+  void Clear() {
+    value.clear();
+  }
+};
+
+/*!
+ * \brief Parses CSV rows of a fixed number of values straight into dense blocks,
+ *  so a row can be used as is without going through a sparse row block.
+ */
+template<typename DType>
+class CSVTextParser : public ParallelTextParser<DenseTextBlock<DType> > {
+ public:
+  /*!
+   * \param uri the file or directory to read
+   * \param shape the shape of a row, whose size every row must have
+   * \param nthread the number of threads parsing a chunk
+   */
+  CSVTextParser(const std::string& uri, const mxnet::TShape& shape, int nthread)
+      : ParallelTextParser<DenseTextBlock<DType> >(uri, 0, 1, nthread),
+        shape_(shape), row_length_(shape.Size()) {
+    CHECK_GT(row_length_, 0U) << "The shape of a CSV row must not be empty";
+  }
+
+ protected:
+  void ParseLines(const char *begin, const char *end, DenseTextBlock<DType> *out) const override {
+    out->row_length = row_length_;
+    const char *p = begin;
+    while (p != end) {
+      const char *lend = static_cast<const char*>(std::memchr(p, '\n', end - p));
+      const char *next = lend == nullptr ? end : lend + 1;
+      if (lend == nullptr) lend = end;
+      while (lend != p && IsTextBlank(lend[-1])) --lend;
+      while (p != lend && IsTextBlank(*p)) ++p;
+      if (p != lend) ParseRow(p, lend, out);
+      p = next;
+    }
+  }
+
+ private:
+  void ParseRow(const char *p, const char *lend, DenseTextBlock<DType> *out) const {
+    const size_t base = out->value.size();
+    out->value.resize(base + row_length_);
+    DType *row = out->value.data() + base;
+    size_t n = 0;
+    while (true) {
+      while (p != lend && IsTextBlank(*p)) ++p;
+      DType v;
+      p = ParseNumber(p, lend, &v);
+      if (n < row_length_) row[n] = v;
+      ++n;
+      while (p != lend && *p != ',') ++p;
+      if (p == lend) break;
+      ++p;
+    }
+    CHECK_EQ(n, row_length_)
+        << "The data size in CSV do not match size of shape: "
+        << "specified shape=" << shape_ << ", the csv row-length=" << n;
+  }
+
+  /*! \brief shape of a row */
+  mxnet::TShape shape_;
+  /*! \brief number of values of a row */
+  size_t row_length_;
+};
+
+/*! \brief sparse rows with a label, in CSR layout */
+struct SparseTextBlock {
+  /*! \brief label of each row */
+  std::vector<real_t> label;
+  /*! \brief position of the first entry of each row, and the end of the last one */
+  std::vector<size_t> offset{0};
+  /*! \brief column index of each entry */
+  std::vector<uint64_t> index;
+  /*! \brief value of each entry */
+  std::vector<real_t> value;
+
+  size_t Size() const {
+    return label.size();
+  }
+  void Clear() {
+    label.clear();
+    offset.assign(1, 0);
+    index.clear();
+    value.clear();
+  }
+};
+
+/*!
+ * \brief Parses LibSVM lines of the form "label[:weight] [qid:n] index:value ...".
+ *  Weights and query ids are skipped, an entry without a value counts as 1.
+ */
+class LibSVMTextParser : public ParallelTextParser<SparseTextBlock> {
+ public:
+  /*!
+   * \param uri the file or directory to read
+   * \param part_index the part of the data to read
+   * \param num_parts the number of parts the data is split into
+   * \param nthread the number of threads parsing a chunk
+   */
+  LibSVMTextParser(const std::string& uri, unsigned part_index, unsigned num_parts,
+                   int nthread)
+      : ParallelTextParser<SparseTextBlock>(uri, part_index, num_parts, nthread) {}
+
+ protected:
+  void ParseLines(const char *begin, const char *end, SparseTextBlock *out) const override {
+    const char *p = begin;
+    while (p != end) {
+      const char *lend = static_cast<const char*>(std::memchr(p, '\n', end - p));
+      const char *next = lend == nullptr ? end : lend + 1;
+      if (lend == nullptr) lend = end;
+      while (p != lend && IsTextBlank(*p)) ++p;
+      if (p != lend) ParseRow(p, lend, out);
+      p = next;
+    }
+  }
+
+ private:
+  static void ParseRow(const char *p, const char *lend, SparseTextBlock *out) {
+    real_t label;
+    const char *q = ParseNumber(p, lend, &label);
+    CHECK(q != p) << "Invalid LibSVM label: " << std::string(p, lend);
+    p = q;
+    if (p != lend && *p == ':') {
+      real_t weight;
+      p = ParseNumber(p + 1, lend, &weight);
+    }
+    while (true) {
+      while (p != lend && IsTextBlank(*p)) ++p;
+      if (p == lend) break;
+      if (lend - p > 4 && std::strncmp(p, "qid:", 4) == 0) {
+        while (p != lend && !IsTextBlank(*p)) ++p;
+        continue;
+      }
+      uint64_t index;
+      q = ParseNumber(p, lend, &index);
+      CHECK(q != p) << "Invalid LibSVM entry: " << std::string(p, lend);
+      real_t value = 1.0f;
+      if (q != lend && *q == ':') q = ParseNumber(q + 1, lend, &value);
+      out->index.push_back(index);
+      out->value.push_back(value);
+      p = q;
+      while (p != lend && !IsTextBlank(*p)) ++p;
+    }
+    out->label.push_back(label);
+    out->offset.push_back(out->index.size());
+  }
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_TEXT_PARSER_H_
@@ -0,0 +1,694 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file collective.h
+ * \brief allreduce, broadcast and barrier between processes, over TCP sockets and over
+ *  shared memory between the processes of a host
+ */
+#ifndef MXNET_KVSTORE_COLLECTIVE_H_
+#define MXNET_KVSTORE_COLLECTIVE_H_
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dmlc/logging.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace kvstore {
+
+/*!
+ * \brief the header of a ring buffer in shared memory, written by one process and read
+ *  by another, followed by the bytes of the ring
+ */
+struct ShmRingHeader {
+  /*! \brief the nonce of rank 0, which the writer checks to tell the ring of its group */
+  uint64_t nonce{0};
+  /*! \brief the bytes written so far, by the writer */
+  alignas(64) std::atomic<uint64_t> head{0};
+  /*! \brief the bytes read so far, by the reader */
+  alignas(64) std::atomic<uint64_t> tail{0};
+};
+
+/*!
+ * \brief a connection to another process, which moves bytes without blocking through a
+ *  socket, or through two ring buffers in shared memory when both run on the same host.
+ *  The socket is then only watched to notice that the other process exited.
+ */
+class CollectiveChannel {
+ public:
+  CollectiveChannel(int peer, int fd) : peer_(peer), fd_(fd) {}
+
+  ~CollectiveChannel() {
+    if (send_ != nullptr) munmap(send_, sizeof(ShmRingHeader) + capacity_);
+    if (recv_ != nullptr) munmap(recv_, sizeof(ShmRingHeader) + capacity_);
+    close(fd_);
+  }
+
+  /*! \brief move the bytes through the given mapped rings from now on */
+  void UseShm(void *send, void *recv, size_t capacity) {
+    send_ = static_cast<ShmRingHeader*>(send);
+    recv_ = static_cast<ShmRingHeader*>(recv);
+    capacity_ = capacity;
+  }
+
+  bool is_shm() const {
+    return send_ != nullptr;
+  }
+
+  int fd() const {
+    return fd_;
+  }
+
+  /*! \return the number of the first size bytes of data sent */
+  size_t TrySend(const char *data, size_t size) {
+    if (is_shm()) {
+      const uint64_t head = send_->head.load(std::memory_order_relaxed);
+      const uint64_t tail = send_->tail.load(std::memory_order_acquire);
+      const size_t n = std::min(size, capacity_ - static_cast<size_t>(head - tail));
+      if (n == 0) return 0;
+      char *ring = reinterpret_cast<char*>(send_ + 1);
+      const size_t pos = head % capacity_;
+      const size_t first = std::min(n, capacity_ - pos);
+      std::memcpy(ring + pos, data, first);
+      std::memcpy(ring, data + first, n - first);
+      send_->head.store(head + n, std::memory_order_release);
+      return n;
+    }
+    const ssize_t n = send(fd_, data, size, MSG_NOSIGNAL);
+    if (n >= 0) return n;
+    CHECK(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        << "Failed to send to rank " << peer_ << ": " << strerror(errno);
+    return 0;
+  }
+
+  /*! \return the number of the first size bytes of data received */
+  size_t TryRecv(char *data, size_t size) {
+    if (is_shm()) {
+      const uint64_t tail = recv_->tail.load(std::memory_order_relaxed);
+      const uint64_t head = recv_->head.load(std::memory_order_acquire);
+      const size_t n = std::min(size, static_cast<size_t>(head - tail));
+      if (n == 0) return 0;
+      const char *ring = reinterpret_cast<const char*>(recv_ + 1);
+      const size_t pos = tail % capacity_;
+      const size_t first = std::min(n, capacity_ - pos);
+      std::memcpy(data, ring + pos, first);
+      std::memcpy(data + first, ring, n - first);
+      recv_->tail.store(tail + n, std::memory_order_release);
+      return n;
+    }
+    const ssize_t n = recv(fd_, data, size, 0);
+    CHECK(n != 0 || size == 0) << "Rank " << peer_ << " closed its connection";
+    if (n > 0) return n;
+    CHECK(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        << "Failed to receive from rank " << peer_ << ": " << strerror(errno);
+    return 0;
+  }
+
+  /*! \brief fail if the other process closed the socket of a shared memory channel */
+  void CheckAlive() const {
+    pollfd pfd = {fd_, POLLIN, 0};
+    if (poll(&pfd, 1, 0) <= 0) return;
+    char c;
+    CHECK_NE(recv(fd_, &c, 1, MSG_PEEK | MSG_DONTWAIT), 0)
+        << "Rank " << peer_ << " closed its connection";
+  }
+
+ private:
+  int peer_;
+  int fd_;
+  ShmRingHeader *send_{nullptr};
+  ShmRingHeader *recv_{nullptr};
+  size_t capacity_{0};
+};
+
+/*!
+ * \brief Collective operations between a group of processes, each called by all of them
+ *  in the same order.
+ *
+ *  The processes meet at a root address: the first one to listen there is rank 0, and the
+ *  others connect to it and are ranked in the order they do. Every pair of processes is
+ *  then connected, through shared memory when they run on the same host.
+ */
+class Collective {
+ public:
+  /*!
+   * \param root_uri the address to meet at, of a host running one of the processes
+   * \param root_port the port to meet at
+   * \param size the number of processes
+   * \param use_shm whether the processes of a host exchange bytes through shared memory,
+   *  as decided by rank 0
+   * \param shm_size the bytes of each ring buffer in shared memory, for each direction of
+   *  each pair of processes of a host
+   * \param ring_bound arrays of at least this many bytes are summed around a ring, and
+   *  the smaller ones by recursive halving and doubling
+   */
+  Collective(const std::string& root_uri, int root_port, int size, bool use_shm,
+             size_t shm_size, size_t ring_bound)
+      : size_(size), ring_bound_(ring_bound) {
+    CHECK_GT(size, 0) << "Invalid number of processes " << size;
+    if (size_ == 1) return;
+    Connect(root_uri, root_port, use_shm, shm_size);
+  }
+
+  int rank() const {
+    return rank_;
+  }
+
+  int size() const {
+    return size_;
+  }
+
+  /*!
+   * \brief sum data over all the processes, every process getting the same result
+   * \param reduce reduce(dst, src, n) adds the n values of src to those of dst
+   */
+  template<typename DType, typename Reduce>
+  void Allreduce(DType *data, size_t count, const Reduce& reduce) {
+    if (size_ == 1) return;
+    if (count * sizeof(DType) >= ring_bound_) {
+      RingAllreduce(data, count, reduce);
+    } else {
+      HalvingAllreduce(data, count, reduce);
+    }
+  }
+
+  /*! \brief copy the size bytes of data of the process root to all the others */
+  void Broadcast(char *data, size_t size, int root) {
+    // binomial tree, rooted at root
+    const int vrank = (rank_ - root + size_) % size_;
+    for (int mask = 1; mask < size_; mask <<= 1) {
+      if (vrank < mask) {
+        if (vrank + mask < size_) Exchange((vrank + mask + root) % size_, data, size);
+      } else if (vrank < 2 * mask) {
+        Exchange<char>(-1, nullptr, 0, (vrank - mask + root) % size_, data, size);
+      }
+    }
+  }
+
+  /*! \brief return once all the processes called Barrier */
+  void Barrier() {
+    // dissemination barrier
+    char send = 0, recv = 0;
+    for (int dist = 1; dist < size_; dist <<= 1) {
+      Exchange((rank_ + dist) % size_, &send, 1, (rank_ - dist + size_) % size_, &recv, 1);
+    }
+  }
+
+ private:
+  /*!
+   * \brief reduce-scatter then allgather around a ring of the ranks, each sending and
+   *  receiving about 2 * count values in all
+   */
+  template<typename DType, typename Reduce>
+  void RingAllreduce(DType *data, size_t count, const Reduce& reduce) {
+    const int next = (rank_ + 1) % size_;
+    const int prev = (rank_ + size_ - 1) % size_;
+    // the range of values of the i-th chunk
+    auto chunk = [this, count](int i) {
+      i = (i % size_ + size_) % size_;
+      return std::make_pair(count * i / size_, count * (i + 1) / size_);
+    };
+    DType *tmp = Temp<DType>((count + size_ - 1) / size_);
+    // after step s, rank r holds the sum of ranks r - s - 1 to r for chunk r - s - 1
+    for (int s = 0; s < size_ - 1; ++s) {
+      const auto send = chunk(rank_ - s);
+      const auto recv = chunk(rank_ - s - 1);
+      Exchange(next, data + send.first, send.second - send.first,
+               prev, tmp, recv.second - recv.first);
+      reduce(data + recv.first, tmp, recv.second - recv.first);
+    }
+    // rank r holds the sum for chunk r + 1, which goes around the ring
+    for (int s = 0; s < size_ - 1; ++s) {
+      const auto send = chunk(rank_ + 1 - s);
+      const auto recv = chunk(rank_ - s);
+      Exchange(next, data + send.first, send.second - send.first,
+               prev, data + recv.first, recv.second - recv.first);
+    }
+  }
+
+  /*!
+   * \brief reduce-scatter by recursive halving, then allgather by recursive doubling,
+   *  in 2 * log2(size) steps. With a size that is not a power of two, the ranks past the
+   *  largest power of two first add their values to those of a lower rank, and get the
+   *  result from it at the end.
+   */
+  template<typename DType, typename Reduce>
+  void HalvingAllreduce(DType *data, size_t count, const Reduce& reduce) {
+    int pof2 = 1;
+    while (pof2 * 2 <= size_) pof2 *= 2;
+    if (rank_ >= pof2) {
+      Exchange(rank_ - pof2, data, count);
+      Exchange<DType>(-1, nullptr, 0, rank_ - pof2, data, count);
+      return;
+    }
+    DType *tmp = Temp<DType>(count);
+    if (rank_ + pof2 < size_) {
+      Exchange<DType>(-1, nullptr, 0, rank_ + pof2, tmp, count);
+      reduce(data, tmp, count);
+    }
+    // the range of values this rank sums, and the ranges it summed at the previous steps
+    size_t begin = 0, end = count;
+    std::vector<std::pair<size_t, size_t> > ranges;
+    for (int mask = pof2 / 2; mask > 0; mask /= 2) {
+      const int peer = rank_ ^ mask;
+      const size_t mid = begin + (end - begin) / 2;
+      ranges.emplace_back(begin, end);
+      if (rank_ & mask) {
+        Exchange(peer, data + begin, mid - begin, peer, tmp, end - mid);
+        begin = mid;
+      } else {
+        Exchange(peer, data + mid, end - mid, peer, tmp, mid - begin);
+        end = mid;
+      }
+      reduce(data + begin, tmp, end - begin);
+    }
+    for (int mask = 1; mask < pof2; mask *= 2) {
+      const int peer = rank_ ^ mask;
+      const auto range = ranges.back();
+      ranges.pop_back();
+      if (rank_ & mask) {
+        Exchange(peer, data + begin, end - begin, peer, data + range.first, begin - range.first);
+      } else {
+        Exchange(peer, data + begin, end - begin, peer, data + end, range.second - end);
+      }
+      begin = range.first;
+      end = range.second;
+    }
+    if (rank_ + pof2 < size_) Exchange(rank_ + pof2, data, count);
+  }
+
+  /*! \brief a buffer of count values, reused by all the operations */
+  template<typename DType>
+  DType *Temp(size_t count) {
+    if (temp_.size() < count * sizeof(DType)) temp_.resize(count * sizeof(DType));
+    return reinterpret_cast<DType*>(temp_.data());
+  }
+
+  /*!
+   * \brief send count values to send_peer while receiving count values from recv_peer,
+   *  either peer being -1 for none
+   */
+  template<typename DType>
+  void Exchange(int send_peer, const DType *send, size_t send_count,
+                int recv_peer = -1, DType *recv = nullptr, size_t recv_count = 0) {
+    ExchangeBytes(send_peer, reinterpret_cast<const char*>(send), send_count * sizeof(DType),
+                  recv_peer, reinterpret_cast<char*>(recv), recv_count * sizeof(DType));
+  }
+
+  void ExchangeBytes(int send_peer, const char *send, size_t send_size,
+                     int recv_peer, char *recv, size_t recv_size) {
+    CollectiveChannel *out = send_size == 0 ? nullptr : channels_[send_peer].get();
+    CollectiveChannel *in = recv_size == 0 ? nullptr : channels_[recv_peer].get();
+    size_t sent = 0, received = 0;
+    uint64_t idle = 0;
+    while (sent < send_size || received < recv_size) {
+      size_t moved = 0;
+      if (sent < send_size) {
+        const size_t n = out->TrySend(send + sent, send_size - sent);
+        sent += n;
+        moved += n;
+      }
+      if (received < recv_size) {
+        const size_t n = in->TryRecv(recv + received, recv_size - received);
+        received += n;
+        moved += n;
+      }
+      if (moved != 0) {
+        idle = 0;
+        continue;
+      }
+      ++idle;
+      CollectiveChannel *pending_out = sent < send_size ? out : nullptr;
+      CollectiveChannel *pending_in = received < recv_size ? in : nullptr;
+      if ((pending_out != nullptr && pending_out->is_shm()) ||
+          (pending_in != nullptr && pending_in->is_shm())) {
+        // shared memory is polled, backing off once the peer looks busy for a while
+        if (idle % 4096 == 0) {
+          if (pending_out != nullptr && pending_out->is_shm()) pending_out->CheckAlive();
+          if (pending_in != nullptr && pending_in->is_shm()) pending_in->CheckAlive();
+        }
+        if (idle < 65536) {
+          std::this_thread::yield();
+        } else {
+          std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        continue;
+      }
+      pollfd pfds[2];
+      nfds_t n = 0;
+      if (pending_out != nullptr) pfds[n++] = {pending_out->fd(), POLLOUT, 0};
+      if (pending_in != nullptr) pfds[n++] = {pending_in->fd(), POLLIN, 0};
+      CHECK(poll(pfds, n, -1) >= 0 || errno == EINTR)
+          << "Failed to wait for the other ranks: " << strerror(errno);
+    }
+  }
+
+  /*! \brief the address and host name of a process, as rank 0 tells the others */
+  struct Peer {
+    uint32_t addr{0};
+    uint16_t port{0};
+    std::string host;
+  };
+
+  void Connect(const std::string& root_uri, int root_port, bool use_shm, size_t shm_size) {
+    sockaddr_in root = Resolve(root_uri, root_port);
+    char hostname[256] = {0};
+    CHECK_EQ(gethostname(hostname, sizeof(hostname) - 1), 0)
+        << "Failed to get the host name: " << strerror(errno);
+    std::vector<Peer> peers(size_);
+    channels_.resize(size_);
+    int listener = Listen(&root);
+    uint64_t nonce = 0;
+    if (rank_ == 0) {
+      nonce = std::random_device()();
+      nonce = (nonce << 32) ^ std::random_device()();
+      peers[0].host = hostname;
+      // ranks are given in the order the processes connect
+      for (int r = 1; r < size_; ++r) {
+        sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        const int fd = accept(listener, reinterpret_cast<sockaddr*>(&addr), &len);
+        CHECK_GE(fd, 0) << "Failed to accept a connection: " << strerror(errno);
+        SetNoDelay(fd);
+        CHECK_EQ(RecvValue<int32_t>(fd), size_)
+            << "The processes do not agree on their number";
+        peers[r].addr = addr.sin_addr.s_addr;
+        peers[r].port = RecvValue<uint16_t>(fd);
+        peers[r].host = RecvString(fd);
+        channels_[r].reset(new CollectiveChannel(r, fd));
+      }
+      for (int r = 1; r < size_; ++r) {
+        const int fd = channels_[r]->fd();
+        SendValue<int32_t>(fd, r);
+        SendValue<int32_t>(fd, use_shm);
+        SendValue<uint64_t>(fd, nonce);
+        for (const Peer& peer : peers) {
+          SendValue<uint32_t>(fd, peer.addr);
+          SendValue<uint16_t>(fd, peer.port);
+          SendString(fd, peer.host);
+        }
+      }
+    } else {
+      sockaddr_in addr;
+      socklen_t len = sizeof(addr);
+      CHECK_EQ(getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+      const int fd = ConnectTo(root);
+      SendValue<int32_t>(fd, size_);
+      SendValue<uint16_t>(fd, ntohs(addr.sin_port));
+      SendString(fd, hostname);
+      rank_ = RecvValue<int32_t>(fd);
+      use_shm = RecvValue<int32_t>(fd);
+      nonce = RecvValue<uint64_t>(fd);
+      for (Peer& peer : peers) {
+        peer.addr = RecvValue<uint32_t>(fd);
+        peer.port = RecvValue<uint16_t>(fd);
+        peer.host = RecvString(fd);
+      }
+      channels_[0].reset(new CollectiveChannel(0, fd));
+      // connect to the lower ranks, and accept the connections of the higher ones
+      for (int r = 1; r < rank_; ++r) {
+        sockaddr_in peer_addr = {};
+        peer_addr.sin_family = AF_INET;
+        peer_addr.sin_addr.s_addr = peers[r].addr;
+        peer_addr.sin_port = htons(peers[r].port);
+        const int peer_fd = ConnectTo(peer_addr);
+        SendValue<int32_t>(peer_fd, rank_);
+        channels_[r].reset(new CollectiveChannel(r, peer_fd));
+      }
+      for (int r = rank_ + 1; r < size_; ++r) {
+        const int peer_fd = accept(listener, nullptr, nullptr);
+        CHECK_GE(peer_fd, 0) << "Failed to accept a connection: " << strerror(errno);
+        SetNoDelay(peer_fd);
+        const int peer = RecvValue<int32_t>(peer_fd);
+        CHECK(peer > rank_ && peer < size_ && !channels_[peer]) << "Unexpected rank " << peer;
+        channels_[peer].reset(new CollectiveChannel(peer, peer_fd));
+      }
+    }
+    close(listener);
+    if (use_shm) {
+      std::vector<int> local;
+      for (int r = 0; r < size_; ++r) {
+        if (r != rank_ && peers[r].host == peers[rank_].host) local.push_back(r);
+      }
+      MapShm(local, nonce, shm_size);
+    }
+    for (auto& channel : channels_) {
+      if (!channel) continue;
+      const int flags = fcntl(channel->fd(), F_GETFL, 0);
+      CHECK_EQ(fcntl(channel->fd(), F_SETFL, flags | O_NONBLOCK), 0);
+    }
+  }
+
+  /*!
+   * \brief map the ring buffers in shared memory with the processes of the same host.
+   *  Each process creates the rings it reads, and removes their names once the writers
+   *  mapped them, so that nothing is left behind when the processes exit.
+   *
+   *  The host names only tell which processes may share memory: a writer checks that the
+   *  ring it opens holds the nonce of rank 0, and a pair of processes keeps its socket when
+   *  either of them fails to create or open its rings.
+   */
+  void MapShm(const std::vector<int>& local, uint64_t nonce, size_t shm_size) {
+    const size_t bytes = sizeof(ShmRingHeader) + shm_size;
+    auto name = [nonce](int from, int to) {
+      std::ostringstream os;
+      os << "/mxnet-allreduce-" << std::hex << nonce << std::dec << "-" << from << "-" << to;
+      return os.str();
+    };
+    std::vector<void*> recv(size_, nullptr), send(size_, nullptr);
+    for (int r : local) {
+      recv[r] = CreateRing(name(r, rank_), bytes, nonce);
+      SendValue<char>(channels_[r]->fd(), recv[r] != nullptr);
+    }
+    for (int r : local) {
+      if (RecvValue<char>(channels_[r]->fd())) {
+        send[r] = OpenRing(name(rank_, r), bytes, nonce);
+      }
+      SendValue<char>(channels_[r]->fd(), send[r] != nullptr);
+    }
+    for (int r : local) {
+      // both processes of the pair get the same two answers
+      const bool mapped = RecvValue<char>(channels_[r]->fd()) && send[r] != nullptr;
+      if (recv[r] != nullptr) shm_unlink(name(r, rank_).c_str());
+      if (mapped) {
+        channels_[r]->UseShm(send[r], recv[r], shm_size);
+        continue;
+      }
+      LOG(WARNING) << "Rank " << rank_ << " exchanges with rank " << r << " over TCP, since "
+                   << "they could not share memory";
+      if (recv[r] != nullptr) munmap(recv[r], bytes);
+      if (send[r] != nullptr) munmap(send[r], bytes);
+    }
+  }
+
+  /*! \brief create and map a ring to read from, \return nullptr if that failed */
+  static void *CreateRing(const std::string& path, size_t bytes, uint64_t nonce) {
+    const int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      LOG(WARNING) << "Failed to create the shared memory " << path << ": " << strerror(errno);
+      return nullptr;
+    }
+    const int err = posix_fallocate(fd, 0, bytes);
+    void *ring = err != 0 ? MAP_FAILED :
+        mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ring == MAP_FAILED) {
+      LOG(WARNING) << "Failed to allocate " << bytes << " bytes of shared memory: "
+                   << strerror(err != 0 ? err : errno) << ". Set "
+                   << "MXNET_KVSTORE_ALLREDUCE_SHM_SIZE lower, or MXNET_KVSTORE_ALLREDUCE_SHM "
+                   << "to 0";
+      shm_unlink(path.c_str());
+      return nullptr;
+    }
+    new (ring) ShmRingHeader();
+    static_cast<ShmRingHeader*>(ring)->nonce = nonce;
+    return ring;
+  }
+
+  /*! \brief map a ring to write to, \return nullptr if it is not the ring of this group */
+  static void *OpenRing(const std::string& path, size_t bytes, uint64_t nonce) {
+    const int fd = shm_open(path.c_str(), O_RDWR, 0600);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    void *ring = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= bytes) {
+      ring = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (ring == MAP_FAILED) return nullptr;
+    if (static_cast<ShmRingHeader*>(ring)->nonce != nonce) {
+      munmap(ring, bytes);
+      return nullptr;
+    }
+    return ring;
+  }
+
+  /*!
+   * \brief listen at root and become rank 0, or at any port when another process
+   *  already listens there
+   * \return the listening socket
+   */
+  int Listen(sockaddr_in *root) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK_GE(fd, 0) << "Failed to create a socket: " << strerror(errno);
+    const int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    // the port is checked again by listen, so only one of the processes starting at the
+    // same time is rank 0
+    if (bind(fd, reinterpret_cast<sockaddr*>(root), sizeof(*root)) == 0 &&
+        listen(fd, SOMAXCONN) == 0) {
+      rank_ = 0;
+      return fd;
+    }
+    CHECK(errno == EADDRINUSE || errno == EADDRNOTAVAIL)
+        << "Failed to listen at the root address: " << strerror(errno);
+    close(fd);
+    rank_ = -1;
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK_GE(fd, 0) << "Failed to create a socket: " << strerror(errno);
+    sockaddr_in any = {};
+    any.sin_family = AF_INET;
+    any.sin_addr.s_addr = htonl(INADDR_ANY);
+    CHECK_EQ(bind(fd, reinterpret_cast<sockaddr*>(&any), sizeof(any)), 0)
+        << "Failed to bind a socket: " << strerror(errno);
+    CHECK_EQ(listen(fd, SOMAXCONN), 0) << "Failed to listen: " << strerror(errno);
+    return fd;
+  }
+
+  /*! \brief connect to addr, retrying while the process there is not listening yet */
+  static int ConnectTo(const sockaddr_in& addr) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(600);
+    while (true) {
+      const int fd = socket(AF_INET, SOCK_STREAM, 0);
+      CHECK_GE(fd, 0) << "Failed to create a socket: " << strerror(errno);
+      if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) {
+        SetNoDelay(fd);
+        return fd;
+      }
+      const int err = errno;
+      close(fd);
+      CHECK(std::chrono::steady_clock::now() < deadline)
+          << "Failed to connect to " << inet_ntoa(addr.sin_addr) << ":"
+          << ntohs(addr.sin_port) << ": " << strerror(err);
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  }
+
+  static sockaddr_in Resolve(const std::string& uri, int port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *res = nullptr;
+    const int err = getaddrinfo(uri.c_str(), nullptr, &hints, &res);
+    CHECK(err == 0 && res != nullptr) << "Failed to resolve " << uri << ": "
+                                      << gai_strerror(err);
+    sockaddr_in addr = *reinterpret_cast<sockaddr_in*>(res->ai_addr);
+    freeaddrinfo(res);
+    addr.sin_port = htons(port);
+    return addr;
+  }
+
+  static void SetNoDelay(int fd) {
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+
+  static void SendAll(int fd, const void *data, size_t size) {
+    const char *p = static_cast<const char*>(data);
+    while (size != 0) {
+      const ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR) continue;
+      CHECK_GT(n, 0) << "Failed to send: " << strerror(errno);
+      p += n;
+      size -= n;
+    }
+  }
+
+  static void RecvAll(int fd, void *data, size_t size) {
+    char *p = static_cast<char*>(data);
+    while (size != 0) {
+      const ssize_t n = recv(fd, p, size, 0);
+      if (n < 0 && errno == EINTR) continue;
+      CHECK_GT(n, 0) << "Failed to receive: "
+                     << (n == 0 ? "connection closed" : strerror(errno));
+      p += n;
+      size -= n;
+    }
+  }
+
+  template<typename T>
+  static void SendValue(int fd, T value) {
+    SendAll(fd, &value, sizeof(value));
+  }
+
+  template<typename T>
+  static T RecvValue(int fd) {
+    T value;
+    RecvAll(fd, &value, sizeof(value));
+    return value;
+  }
+
+  static void SendString(int fd, const std::string& s) {
+    SendValue<uint32_t>(fd, s.size());
+    SendAll(fd, s.data(), s.size());
+  }
+
+  static std::string RecvString(int fd) {
+    std::string s(RecvValue<uint32_t>(fd), '\0');
+    RecvAll(fd, &s[0], s.size());
+    return s;
+  }
+
+  int rank_{0};
+  const int size_;
+  const size_t ring_bound_;
+  /*! \brief the connections to the other ranks, by rank */
+  std::vector<std::unique_ptr<CollectiveChannel> > channels_;
+  /*! \brief values received before they are summed */
+  std::vector<char> temp_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // _WIN32
+#endif  // MXNET_KVSTORE_COLLECTIVE_H_
@@ -190,16 +190,14 @@ class CommCPU : public Comm {
         reduce[i] = buf.copy_buf[i];
         const_vars[i] = reduce[i].var();
       }
-      Resource rsc = ResourceManager::Get()->Request(buf_merged.ctx(),
-          ResourceRequest(ResourceRequest::kTempSpace));
       Engine::Get()->PushAsync(
-        [reduce, buf_merged, rsc, this](RunContext rctx, Engine::CallbackOnComplete on_complete) {
+        [reduce, buf_merged, this](RunContext rctx, Engine::CallbackOnComplete on_complete) {
           NDArray out = buf_merged;
           is_serial_push_?
             ReduceSumCPUExSerial(reduce, &out)
-            : mxnet::ndarray::ElementwiseSum(rctx.get_stream<cpu>(), rsc, reduce, &out);
+            : ReduceSumCPUExParallel(reduce, &out);
           on_complete();
-        }, Context::CPU(), const_vars, {buf_merged.var(), rsc.var},
+        }, Context::CPU(), const_vars, {buf_merged.var()},
         FnProperty::kCPUPrioritized, priority, "KVStoreReduce");
     }
 
@@ -267,6 +265,46 @@ class CommCPU : public Comm {
     }
   }
 
+  /**
+   * \brief add the size values from offset of dptr[1], dptr[2], ... to those of dptr[0]
+   */
+  template<typename DType>
+  inline static void ReduceSumCPU(
+      const std::vector<DType*> &dptr, size_t offset, index_t size) {
+    using namespace mshadow;  // NOLINT(*)
+    Tensor<cpu, 1, DType> in_0(dptr[0] + offset, Shape1(size));
+    for (size_t i = 1; i < dptr.size(); i+=4) {
+      switch (dptr.size() - i) {
+        case 1: {
+          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
+          in_0 += in_1;
+          break;
+        }
+        case 2: {
+          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
+          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
+          in_0 += in_1 + in_2;
+          break;
+        }
+        case 3: {
+          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
+          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
+          Tensor<cpu, 1, DType> in_3(dptr[i+2] + offset, Shape1(size));
+          in_0 += in_1 + in_2 + in_3;
+          break;
+        }
+        default: {
+          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
+          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
+          Tensor<cpu, 1, DType> in_3(dptr[i+2] + offset, Shape1(size));
+          Tensor<cpu, 1, DType> in_4(dptr[i+3] + offset, Shape1(size));
+          in_0 += in_1 + in_2 + in_3 + in_4;
+          break;
+        }
+      }
+    }
+  }
+
  private:
   // reduce sum into val[0]
   inline void ReduceSumCPU(const std::vector<NDArray> &in_data) {
@@ -354,43 +392,130 @@ class CommCPU : public Comm {
     });
   }
 
-  template<typename DType>
-  inline static void ReduceSumCPU(
-      const std::vector<DType*> &dptr, size_t offset, index_t size) {
-    using namespace mshadow;  // NOLINT(*)
-    Tensor<cpu, 1, DType> in_0(dptr[0] + offset, Shape1(size));
-    for (size_t i = 1; i < dptr.size(); i+=4) {
-      switch (dptr.size() - i) {
-        case 1: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          in_0 += in_1;
-          break;
-        }
-        case 2: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
-          in_0 += in_1 + in_2;
-          break;
-        }
-        case 3: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_3(dptr[i+2] + offset, Shape1(size));
-          in_0 += in_1 + in_2 + in_3;
-          break;
+  /*!
+   * \brief merge the sorted row indices in [begin[i], end[i]) of every input i, and sum
+   *  up the values of every row in the order of the inputs, like ReduceSumCPUExSerial
+   * \param out_idx the unique row indices, not written if nullptr
+   * \param out_val the sums of the rows, not written if nullptr
+   * \return the number of unique rows
+   */
+  template<typename DType, typename IType>
+  inline static size_t MergeRowSparse(const std::vector<const IType*> &in_idx,
+                                      const std::vector<const DType*> &in_val,
+                                      std::vector<size_t> begin,
+                                      const std::vector<size_t> &end,
+                                      size_t row_length, IType *out_idx, DType *out_val) {
+    const size_t num_in = in_idx.size();
+    size_t nnr = 0;
+    while (true) {
+      // the smallest row left, the inputs are few enough for a linear scan
+      bool found = false;
+      IType row = 0;
+      for (size_t i = 0; i < num_in; ++i) {
+        if (begin[i] < end[i] && (!found || in_idx[i][begin[i]] < row)) {
+          row = in_idx[i][begin[i]];
+          found = true;
         }
-        default: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_3(dptr[i+2] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_4(dptr[i+3] + offset, Shape1(size));
-          in_0 += in_1 + in_2 + in_3 + in_4;
-          break;
+      }
+      if (!found) return nnr;
+      DType *dst = out_val == nullptr ? nullptr : out_val + nnr * row_length;
+      bool zeros = true;
+      for (size_t i = 0; i < num_in; ++i) {
+        if (begin[i] == end[i] || in_idx[i][begin[i]] != row) continue;
+        if (dst != nullptr) {
+          const DType *src = in_val[i] + begin[i] * row_length;
+          if (zeros) {
+            std::copy(src, src + row_length, dst);
+          } else {
+            for (size_t j = 0; j < row_length; ++j) dst[j] += src[j];
+          }
         }
+        zeros = false;
+        ++begin[i];
       }
+      if (out_idx != nullptr) out_idx[nnr] = row;
+      ++nnr;
     }
   }
 
+  // parallel implementation of reduce sum for row sparse NDArray. The sorted row
+  // indices of the inputs are split into ranges of about as many rows, and every range
+  // is merged on a thread, once to count its unique rows and once to sum them up.
+  inline void ReduceSumCPUExParallel(const std::vector<NDArray> &in, NDArray *out) {
+    using namespace rowsparse;
+    using namespace mshadow;
+    auto stype = out->storage_type();
+    CHECK_EQ(stype, kRowSparseStorage) << "Unexpected storage type " << stype;
+    MSHADOW_TYPE_SWITCH(out->dtype(), DType, {
+      MSHADOW_IDX_TYPE_SWITCH(out->aux_type(kIdx), IType, {
+        // the row indices and values of the inputs with rows
+        std::vector<const IType*> in_idx;
+        std::vector<const DType*> in_val;
+        std::vector<size_t> num_rows;
+        size_t total_num_rows = 0;
+        for (const auto& nd : in) {
+          if (!nd.storage_initialized() || nd.aux_shape(kIdx).Size() == 0) continue;
+          CHECK_EQ(nd.aux_type(kIdx), out->aux_type(kIdx));
+          in_idx.push_back(nd.aux_data(kIdx).dptr<IType>());
+          in_val.push_back(nd.data().dptr<DType>());
+          num_rows.push_back(nd.aux_shape(kIdx).Size());
+          total_num_rows += num_rows.back();
+        }
+        const size_t num_in = in_idx.size();
+        const size_t row_length = out->shape().ProdShape(1, out->shape().ndim());
+        const int nthread = total_num_rows * row_length < bigarray_bound_ ?
+                            1 : nthread_reduction_;
+        // bounds of the ranges, from the rows of the inputs every step rows of them all
+        std::vector<IType> bounds;
+        if (nthread > 1 && total_num_rows > 0) {
+          const size_t num_ranges = static_cast<size_t>(nthread) * 4;
+          const size_t step = std::max<size_t>(total_num_rows / (num_ranges * 8), 1);
+          std::vector<IType> samples;
+          for (size_t i = 0; i < num_in; ++i) {
+            for (size_t j = step / 2; j < num_rows[i]; j += step) {
+              samples.push_back(in_idx[i][j]);
+            }
+          }
+          std::sort(samples.begin(), samples.end());
+          for (size_t r = 1; r < num_ranges; ++r) {
+            bounds.push_back(samples[r * samples.size() / num_ranges]);
+          }
+          bounds.resize(std::unique(bounds.begin(), bounds.end()) - bounds.begin());
+        }
+        // the first row of every input in every range, the rows below the range bound
+        const size_t num_ranges = bounds.size() + 1;
+        std::vector<std::vector<size_t> > range_begin(num_ranges + 1,
+                                                      std::vector<size_t>(num_in, 0));
+        for (size_t i = 0; i < num_in; ++i) {
+          for (size_t r = 1; r < num_ranges; ++r) {
+            range_begin[r][i] = std::lower_bound(in_idx[i], in_idx[i] + num_rows[i],
+                                                 bounds[r - 1]) - in_idx[i];
+          }
+          range_begin[num_ranges][i] = num_rows[i];
+        }
+        std::vector<size_t> range_offset(num_ranges + 1, 0);
+        #pragma omp parallel for schedule(dynamic) num_threads(nthread)
+        for (int r = 0; r < static_cast<int>(num_ranges); ++r) {
+          range_offset[r + 1] = MergeRowSparse<DType, IType>(
+              in_idx, in_val, range_begin[r], range_begin[r + 1], row_length, nullptr, nullptr);
+        }
+        for (size_t r = 0; r < num_ranges; ++r) {
+          range_offset[r + 1] += range_offset[r];
+        }
+        const size_t nnr = range_offset[num_ranges];
+        out->CheckAndAlloc({Shape1(nnr)});
+        IType *out_idx = out->aux_data(kIdx).dptr<IType>();
+        DType *out_val = out->data().dptr<DType>();
+        #pragma omp parallel for schedule(dynamic) num_threads(nthread)
+        for (int r = 0; r < static_cast<int>(num_ranges); ++r) {
+          MergeRowSparse<DType, IType>(in_idx, in_val, range_begin[r], range_begin[r + 1],
+                                       row_length, out_idx + range_offset[r],
+                                       out_val + range_offset[r] * row_length);
+        }
+      });
+    });
+  }
+
   template<typename DType>
   inline void ReduceSumCPUImpl(std::vector<DType*> dptr, size_t total) {
     const size_t step = std::min(bigarray_bound_, static_cast<size_t>(4 << 10));
@@ -36,6 +36,13 @@ void Quantize2BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet:
                       const float threshold);
 void Dequantize2BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
                         const float threshold);
+void Quantize1BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs);
+void Dequantize1BitImpl(mshadow::Stream<mshadow::gpu> *s,
+                        const std::vector<mxnet::TBlob> &inputs);
+void QuantizeTopKImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                      const int block_size, const bool random, const uint64_t seed);
+void DequantizeTopKImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                        const int block_size);
 
 struct quantize_2bit {
   MSHADOW_XINLINE static void Map(int out_block_id,
@@ -138,6 +145,154 @@ void Dequantize2BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet
           threshold);               // positive threshold
 }
 
+// 1bit compression sends the sign of each value, and the mean magnitude of the values
+// in its block of k1BitBlockSize values, as one float followed by the bits of the signs
+const int k1BitBlockSize = 1024;
+const int k1BitBlockWords = 1 + k1BitBlockSize / 32;
+
+struct quantize_1bit {
+  MSHADOW_XINLINE static void Map(int out_block_id,
+                                  int original_size,
+                                  float *out,
+                                  float *grad,
+                                  float *residual) {
+    float *compr_block = out + out_block_id * k1BitBlockWords;
+    uint8_t *bits = reinterpret_cast<uint8_t *>(compr_block + 1);
+    const int start = out_block_id * k1BitBlockSize;
+    const int end = (start + k1BitBlockSize <= original_size) ?
+                    start + k1BitBlockSize : original_size;
+    // the gradient is sent with what was not sent of the previous ones
+    float abs_sum = 0;
+    for (int i = start; i < end; i++) {
+      residual[i] += grad[i];
+      abs_sum += fabsf(residual[i]);
+    }
+    const float scale = abs_sum / (end - start);
+    compr_block[0] = scale;
+    for (int i = 0; i < k1BitBlockSize / 8; i++) {
+      bits[i] = 0;
+    }
+    for (int i = start; i < end; i++) {
+      if (residual[i] >= 0) {
+        bits[(i - start) >> 3] |= static_cast<uint8_t>(1 << ((i - start) & 7));
+        residual[i] -= scale;
+      } else {
+        residual[i] += scale;
+      }
+    }
+  }
+};
+
+template<typename xpu>
+void Quantize1BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs) {
+  const int original_size = inputs[0].Size();
+  mxnet::op::mxnet_op::Kernel<quantize_1bit, xpu>
+    ::Launch(s,
+            (original_size + k1BitBlockSize - 1) / k1BitBlockSize,  // number of blocks
+            original_size,
+            inputs[2].dptr<float>(),  // compressed array
+            inputs[0].dptr<float>(),  // original array
+            inputs[1].dptr<float>());  // residual array
+}
+
+struct dequantize_1bit {
+  MSHADOW_XINLINE static void Map(int i,
+                                  float *out,
+                                  float *in) {
+    const float *compr_block = in + (i / k1BitBlockSize) * k1BitBlockWords;
+    const uint8_t *bits = reinterpret_cast<const uint8_t *>(compr_block + 1);
+    const int j = i % k1BitBlockSize;
+    out[i] = ((bits[j >> 3] >> (j & 7)) & 1) ? compr_block[0] : -compr_block[0];
+  }
+};
+
+template<typename xpu>
+void Dequantize1BitKernelLaunch(mshadow::Stream<xpu> *s,
+                                const std::vector<mxnet::TBlob> &inputs) {
+  mxnet::op::mxnet_op::Kernel<dequantize_1bit, xpu>
+  ::Launch(s,
+          inputs[1].Size(),         // original size
+          inputs[1].dptr<float>(),  // out array
+          inputs[0].dptr<float>());  // compressed array
+}
+
+/*! \brief a well mixed hash of x, to draw random positions without state */
+MSHADOW_XINLINE uint64_t MixBits(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// topk and randk compression send one value of each block of block_size values, the
+// largest in magnitude or a random one, as its position in the block and its value
+// the position is a float, exact for blocks of at most kMaxTopKBlockSize values
+const int kMaxTopKBlockSize = 1 << 24;
+
+struct quantize_topk {
+  MSHADOW_XINLINE static void Map(int out_block_id,
+                                  int original_size,
+                                  int block_size,
+                                  float *out,
+                                  float *grad,
+                                  float *residual,
+                                  bool random,
+                                  uint64_t seed) {
+    const int start = out_block_id * block_size;
+    const int end = (start + block_size <= original_size) ? start + block_size : original_size;
+    // the gradient is sent with what was not sent of the previous ones
+    int pick = start;
+    for (int i = start; i < end; i++) {
+      residual[i] += grad[i];
+      if (fabsf(residual[i]) > fabsf(residual[pick])) pick = i;
+    }
+    if (random) {
+      pick = start + static_cast<int>(MixBits(seed * 0x9e3779b97f4a7c15ULL + out_block_id)
+                                      % static_cast<uint64_t>(end - start));
+    }
+    out[2 * out_block_id] = static_cast<float>(pick - start);
+    out[2 * out_block_id + 1] = residual[pick];
+    residual[pick] = 0;
+  }
+};
+
+template<typename xpu>
+void QuantizeTopKKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                              const int block_size, const bool random, const uint64_t seed) {
+  const int original_size = inputs[0].Size();
+  mxnet::op::mxnet_op::Kernel<quantize_topk, xpu>
+    ::Launch(s,
+            (original_size + block_size - 1) / block_size,  // number of blocks
+            original_size,
+            block_size,
+            inputs[2].dptr<float>(),  // compressed array
+            inputs[0].dptr<float>(),  // original array
+            inputs[1].dptr<float>(),  // residual array
+            random,
+            seed);
+}
+
+struct dequantize_topk {
+  MSHADOW_XINLINE static void Map(int i,
+                                  int block_size,
+                                  float *out,
+                                  float *in) {
+    const int block = i / block_size;
+    const int pick = static_cast<int>(in[2 * block]);
+    out[i] = (i - block * block_size == pick) ? in[2 * block + 1] : 0;
+  }
+};
+
+template<typename xpu>
+void DequantizeTopKKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                                const int block_size) {
+  mxnet::op::mxnet_op::Kernel<dequantize_topk, xpu>
+  ::Launch(s,
+          inputs[1].Size(),         // original size
+          block_size,
+          inputs[1].dptr<float>(),  // out array
+          inputs[0].dptr<float>());  // compressed array
+}
+
 inline void Quantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
                              const std::vector<mxnet::TBlob> &inputs,
                              const float threshold) {
@@ -149,6 +304,28 @@ inline void Dequantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
                                const float threshold) {
   Dequantize2BitKernelLaunch(s, inputs, threshold);
 }
+
+inline void Quantize1BitImpl(mshadow::Stream<mshadow::cpu> *s,
+                             const std::vector<mxnet::TBlob> &inputs) {
+  Quantize1BitKernelLaunch(s, inputs);
+}
+
+inline void Dequantize1BitImpl(mshadow::Stream<mshadow::cpu> *s,
+                               const std::vector<mxnet::TBlob> &inputs) {
+  Dequantize1BitKernelLaunch(s, inputs);
+}
+
+inline void QuantizeTopKImpl(mshadow::Stream<mshadow::cpu> *s,
+                             const std::vector<mxnet::TBlob> &inputs,
+                             const int block_size, const bool random, const uint64_t seed) {
+  QuantizeTopKKernelLaunch(s, inputs, block_size, random, seed);
+}
+
+inline void DequantizeTopKImpl(mshadow::Stream<mshadow::cpu> *s,
+                               const std::vector<mxnet::TBlob> &inputs,
+                               const int block_size) {
+  DequantizeTopKKernelLaunch(s, inputs, block_size);
+}
 }  // namespace kvstore
 }  // namespace mxnet
 
@@ -23,6 +23,8 @@
  * \author Rahul Huilgol
  */
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include "kvstore_local.h"
 #include "gradient_compression.h"
@@ -33,6 +35,49 @@ namespace kvstore {
 
 DMLC_REGISTER_PARAMETER(GradientCompressionParam);
 
+namespace {
+
+template<typename xpu>
+void QuantizeImpl(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                  const CompressionType type, const float threshold, const int block_size,
+                  const uint64_t seed) {
+  switch (type) {
+    case CompressionType::kTwoBit:
+      Quantize2BitImpl(s, inputs, threshold);
+      break;
+    case CompressionType::kOneBit:
+      Quantize1BitImpl(s, inputs);
+      break;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      QuantizeTopKImpl(s, inputs, block_size, type == CompressionType::kRandomK, seed);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported quantization of type " << static_cast<int>(type);
+  }
+}
+
+template<typename xpu>
+void DequantizeImpl(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                    const CompressionType type, const float threshold, const int block_size) {
+  switch (type) {
+    case CompressionType::kTwoBit:
+      Dequantize2BitImpl(s, inputs, threshold);
+      break;
+    case CompressionType::kOneBit:
+      Dequantize1BitImpl(s, inputs);
+      break;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      DequantizeTopKImpl(s, inputs, block_size);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported dequantization of type " << static_cast<int>(type);
+  }
+}
+
+}  // namespace
+
 GradientCompression::GradientCompression() {
   type_ = CompressionType::kNone;
 }
@@ -44,6 +89,11 @@ void GradientCompression::SetParams(const std::vector<std::pair<std::string, std
   CHECK_GT(params.threshold, 0) << "threshold must be greater than 0";
   if (params.type == "2bit") {
     SetTwoBitCompression(params.threshold);
+  } else if (params.type == "1bit") {
+    SetOneBitCompression();
+  } else if (params.type == "topk" || params.type == "randk") {
+    CHECK(params.ratio > 0 && params.ratio <= 1) << "ratio must be in (0, 1]";
+    SetTopKCompression(params.ratio, params.type == "randk");
   } else {
     LOG(FATAL) << "Unknown type for gradient compression " << params.type;
   }
@@ -62,11 +112,24 @@ void GradientCompression::SetTwoBitCompression(const float threshold) {
   threshold_ = threshold;
 }
 
+void GradientCompression::SetOneBitCompression() {
+  type_ = CompressionType::kOneBit;
+}
+
+void GradientCompression::SetTopKCompression(const float ratio, const bool random) {
+  CHECK_GE(ratio, 1.0f / kMaxTopKBlockSize)
+    << "ratio must be at least 1/" << kMaxTopKBlockSize << " for topk and randk compression";
+  type_ = random ? CompressionType::kRandomK : CompressionType::kTopK;
+  block_size_ = std::max(1, static_cast<int>(std::round(1 / ratio)));
+}
+
 std::string GradientCompression::EncodeParams() {
   using namespace std;  // to reduce length of next line
   string rval = get_type_str();
   if (type_ == CompressionType::kTwoBit) {
     rval += "," + to_string(threshold_);
+  } else if (type_ == CompressionType::kTopK || type_ == CompressionType::kRandomK) {
+    rval += ",," + to_string(block_size_);
   }
   return rval;
 }
@@ -80,22 +143,36 @@ void GradientCompression::DecodeParams(const std::string &s) {
       threshold_ = stof(elems[1]);
     }
   }
+  if (elems.size() > 2) {
+    block_size_ = stoi(elems[2]);
+  }
 }
 
-int GradientCompression::GetCompressionFactor() {
-  if (type_ == CompressionType::kTwoBit) {
-    return 16;
-  } else {
-    LOG(FATAL) << "Unsupported compression type: " << get_type_str();
-    return 0;
+int64_t GradientCompression::GetBlockSize() {
+  switch (type_) {
+    case CompressionType::kTwoBit:
+      return 16;
+    case CompressionType::kOneBit:
+      return k1BitBlockSize;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      return block_size_;
+    default:
+      LOG(FATAL) << "Unsupported compression type: " << get_type_str();
+      return 0;
   }
 }
 
 int64_t GradientCompression::GetCompressedSize(const int64_t original_size) {
-  const int bits = GetCompressionFactor();
-  return ((original_size % bits == 0) ?
-          original_size / bits :
-          original_size / bits + 1);
+  const int64_t block_size = GetBlockSize();
+  // the number of floats each block is compressed into
+  int64_t block_words = 1;
+  if (type_ == CompressionType::kOneBit) {
+    block_words = k1BitBlockWords;
+  } else if (type_ == CompressionType::kTopK || type_ == CompressionType::kRandomK) {
+    block_words = 2;
+  }
+  return (original_size + block_size - 1) / block_size * block_words;
 }
 
 void GradientCompression::Quantize(const mxnet::NDArray &from, mxnet::NDArray *to,
@@ -105,20 +182,26 @@ void GradientCompression::Quantize(const mxnet::NDArray &from, mxnet::NDArray *t
   CHECK(shape_is_known(residual->shape())) << "residual operand has undefined shape";
   const int a = from.ctx().dev_mask();
   const int b = to->ctx().dev_mask();
+  const CompressionType type = type_;
   const float threshold = threshold_;
-  if (type_ == CompressionType::kTwoBit) {
+  const int block_size = block_size_;
+  const uint64_t seed = num_quantized_++;
+  if (type != CompressionType::kNone) {
     if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
-      mxnet::Engine::Get()->PushSync([from, to, residual, threshold](mxnet::RunContext ctx) {
+      mxnet::Engine::Get()->PushSync([from, to, residual, type, threshold, block_size, seed](
+          mxnet::RunContext ctx) {
         std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
-        Quantize2BitImpl(ctx.get_stream<mshadow::cpu>(), inputs, threshold);
+        QuantizeImpl(ctx.get_stream<mshadow::cpu>(), inputs, type, threshold, block_size, seed);
       }, from.ctx(), {from.var()}, {to->var(), residual->var()},
       mxnet::FnProperty::kNormal, priority, "QuantizeCPU");
     } else {
 #if MXNET_USE_CUDA
       if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
-        mxnet::Engine::Get()->PushSync([from, to, residual, threshold](mxnet::RunContext ctx) {
+        mxnet::Engine::Get()->PushSync([from, to, residual, type, threshold, block_size, seed](
+            mxnet::RunContext ctx) {
           std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
-          Quantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
+          QuantizeImpl(ctx.get_stream<mshadow::gpu>(), inputs, type, threshold, block_size,
+                       seed);
           // Wait GPU kernel to complete
           ctx.get_stream<mshadow::gpu>()->Wait();
         }, from.ctx(), {from.var()}, {to->var(), residual->var()},
@@ -141,20 +224,24 @@ void GradientCompression::Dequantize(const mxnet::NDArray &from, mxnet::NDArray
   CHECK(shape_is_known(to->shape())) << "destination operand has undefined shape";
   const int a = from.ctx().dev_mask();
   const int b = to->ctx().dev_mask();
+  const CompressionType type = type_;
   const float threshold = threshold_;
-  if (type_ == CompressionType::kTwoBit) {
+  const int block_size = block_size_;
+  if (type != CompressionType::kNone) {
     if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
-      mxnet::Engine::Get()->PushSync([from, to, threshold](mxnet::RunContext ctx) {
+      mxnet::Engine::Get()->PushSync([from, to, type, threshold, block_size](
+          mxnet::RunContext ctx) {
         std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
-        Dequantize2BitImpl(ctx.get_stream<mshadow::cpu>(), inputs, threshold);
+        DequantizeImpl(ctx.get_stream<mshadow::cpu>(), inputs, type, threshold, block_size);
       }, from.ctx(), {from.var()}, {to->var()},
       mxnet::FnProperty::kNormal, priority, "DequantizeCPU");
     } else {
 #if MXNET_USE_CUDA
       if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
-        mxnet::Engine::Get()->PushSync([from, to, threshold](mxnet::RunContext ctx) {
+        mxnet::Engine::Get()->PushSync([from, to, type, threshold, block_size](
+            mxnet::RunContext ctx) {
           std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
-          Dequantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
+          DequantizeImpl(ctx.get_stream<mshadow::gpu>(), inputs, type, threshold, block_size);
           // Wait GPU kernel to complete
           ctx.get_stream<mshadow::gpu>()->Wait();
         }, from.ctx(), {from.var()}, {to->var()},
@@ -36,5 +36,23 @@ void Dequantize2BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& input
                         const float threshold) {
   Dequantize2BitKernelLaunch(s, inputs, threshold);
 }
+
+void Quantize1BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs) {
+  Quantize1BitKernelLaunch(s, inputs);
+}
+
+void Dequantize1BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs) {
+  Dequantize1BitKernelLaunch(s, inputs);
+}
+
+void QuantizeTopKImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                      const int block_size, const bool random, const uint64_t seed) {
+  QuantizeTopKKernelLaunch(s, inputs, block_size, random, seed);
+}
+
+void DequantizeTopKImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                        const int block_size) {
+  DequantizeTopKKernelLaunch(s, inputs, block_size);
+}
 }  // namespace kvstore
 }  // namespace mxnet
@@ -35,17 +35,20 @@ namespace mxnet {
 namespace kvstore {
 
 enum class CompressionType {
-  kNone, kTwoBit
+  kNone, kTwoBit, kOneBit, kTopK, kRandomK
 };
 
 struct GradientCompressionParam : public dmlc::Parameter<GradientCompressionParam> {
   std::string type;
   float threshold;
+  float ratio;
   DMLC_DECLARE_PARAMETER(GradientCompressionParam) {
     DMLC_DECLARE_FIELD(type)
-      .describe("Type of gradient compression to use, like `2bit` for example");
+      .describe("Type of gradient compression to use: `2bit`, `1bit`, `topk` or `randk`");
     DMLC_DECLARE_FIELD(threshold).set_default(0.5)
       .describe("Threshold to use for 2bit gradient compression");
+    DMLC_DECLARE_FIELD(ratio).set_default(0.01)
+      .describe("Fraction of the gradient values sent by topk and randk compression");
   }
 };
 
@@ -78,6 +81,21 @@ class GradientCompression {
    */
   void SetTwoBitCompression(const float threshold);
 
+  /*!
+   * \brief sets 1bit gradient compression, which sends the signs of the values and the
+   * mean of their magnitudes in each block of values
+   */
+  void SetOneBitCompression();
+
+  /*!
+   * \brief sets topk or randk gradient compression, which sends the largest value in
+   * magnitude, or a random value, of each block of values
+   * \param ratio fraction of the values sent, the inverse of the size of the blocks, which
+   *  is at most kMaxTopKBlockSize
+   * \param random whether to send random values rather than the largest ones
+   */
+  void SetTopKCompression(const float ratio, const bool random);
+
   /*!
    * \brief encodes parameters of gc into a string
    */
@@ -89,10 +107,11 @@ class GradientCompression {
   void DecodeParams(const std::string &s);
 
   /*!
-   * \brief returns compression factor, which is the factor by which size of gradient
-   * reduces when using a particular type of compression
+   * \brief returns the number of gradient values compressed into each block of a fixed
+   * number of floats. Any whole number of blocks is compressed, and can be sent,
+   * independently of the other blocks
    */
-  int GetCompressionFactor();
+  int64_t GetBlockSize();
 
   /*!
    * \brief returns the size of compressed gradients given an original sized gradient array
@@ -132,6 +151,16 @@ class GradientCompression {
    * all negative gradients will be thresholded to -1*`threshold_`
    */
   float threshold_ = 0;
+
+  /*!
+   * \brief denotes the number of values out of which topk and randk compression send one
+   */
+  int block_size_ = 0;
+
+  /*!
+   * \brief number of quantizations issued, to draw other random values in each one
+   */
+  uint64_t num_quantized_ = 0;
 };
 }  // namespace kvstore
 }  // namespace mxnet
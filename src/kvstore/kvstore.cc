@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <dmlc/logging.h>
 #include "./kvstore_local.h"
+#include "./kvstore_dist_allreduce.h"
 
 #if MXNET_USE_DIST_KVSTORE
 #include "./kvstore_dist.h"
@@ -49,7 +50,14 @@ KVStore* KVStore::Create(const char *type_name) {
     use_device_comm = true;
   }
 
-  if (has("dist")) {
+  if (has("allreduce")) {
+#ifndef _WIN32
+    kv = new kvstore::KVStoreDistAllreduce(use_device_comm);
+#else
+    LOG(FATAL) << tname << " is not supported on Windows";
+    return nullptr;
+#endif  // _WIN32
+  } else if (has("dist")) {
 #if MXNET_USE_DIST_KVSTORE
     kv = new kvstore::KVStoreDist(use_device_comm);
     if (!has("_async") && kv->IsWorkerNode() && kv->get_rank() == 0) {
@@ -27,6 +27,12 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
 #include <utility>
 #include "./kvstore_local.h"
 #include "mxnet/engine.h"
@@ -57,6 +63,11 @@ class KVStoreDist : public KVStoreLocal {
     }
     bigarray_bound_ = dmlc::GetEnv("MXNET_KVSTORE_BIGARRAY_BOUND", 1000 * 1000);
     log_verbose_ = dmlc::GetEnv("MXNET_KVSTORE_DIST_ROW_SPARSE_VERBOSE", false);
+#ifndef _WIN32
+    if (IsWorkerNode() && dmlc::GetEnv("MXNET_KVSTORE_SHM_TRANSPORT", false)) {
+      ProbeSharedMemServers();
+    }
+#endif  // _WIN32
   }
 
   virtual ~KVStoreDist() {
@@ -109,6 +120,10 @@ class KVStoreDist : public KVStoreLocal {
   void SendCommandToServers(int cmd_id,
                             const std::string& cmd_body) override {
     CHECK_NOTNULL(ps_worker_);
+    if (cmd_id == static_cast<int>(CommandType::kController)) {
+      // the servers update every key with the optimizer settings of its parameter
+      StopFusion();
+    }
     ps_worker_->Wait(ps_worker_->Request(cmd_id, cmd_body, ps::kServerGroup));
   }
 
@@ -167,6 +182,18 @@ class KVStoreDist : public KVStoreLocal {
     PSKV pull;
   };
 
+  /**
+   * \brief the parts of a key on the servers of this host, pushed and pulled through
+   * the buffer of the key in shared memory, and the parts on the other servers
+   */
+  struct SharedMemPSKV {
+    PSKV local;
+    PSKV remote;
+    // byte offsets of the parts in the buffer
+    std::vector<size_t> local_offsets;
+    std::vector<size_t> remote_offsets;
+  };
+
   /**
    * \brief cache all key partitions
    *
@@ -179,6 +206,7 @@ class KVStoreDist : public KVStoreLocal {
    */
   std::unordered_map<int, PSKV> ps_kv_;
   std::unordered_map<int, ComprPSKV> compr_ps_kv_;
+  std::unordered_map<int, SharedMemPSKV> shm_ps_kv_;
 
   /**
    * \brief serialize access to ps_kv_ or push_ps_kv_/pull_ps_kv_ while encoding keys
@@ -212,6 +240,20 @@ class KVStoreDist : public KVStoreLocal {
     Push_(keys, values, priority, true);
   }
 
+  void InitBucket(const FusionBucket& bucket, const NDArray& value) override {
+    InitImpl({bucket.key}, {value});
+  }
+
+  void PushBucket(const FusionBucket& bucket) override {
+    // the servers sum up, or update, the bucket as one key
+    PushImpl(std::vector<int>(bucket.push_bufs.size(), bucket.key), bucket.push_bufs,
+             bucket.priority);
+  }
+
+  bool PullBuckets() const override {
+    return true;
+  }
+
   void PullImpl(const std::vector<int>& keys,
                 const std::vector<NDArray*>& values,
                 int priority, bool ignore_sparse) override {
@@ -228,40 +270,17 @@ class KVStoreDist : public KVStoreLocal {
       const auto storage_type = grouped_vals[i][0]->storage_type();
       CHECK_EQ(storage_type, kDefaultStorage)
                << "Expected stype of value to be kDefaultStorage";
-      if (recv_buf.is_none()) {
-        // it may happen for the first time a no-rank-0 worker pull the weight.
-        recv_buf = NDArray(grouped_vals[i][0]->shape(), pinned_ctx_,
-                           true, grouped_vals[i][0]->dtype());
+      const mxnet::TShape& shape = grouped_vals[i][0]->shape();
+      const int dtype = grouped_vals[i][0]->dtype();
+      if (UseSharedMem(key, shape.Size(), dtype)) {
+        PullSharedMem(key, SharedMemCommBuf(key, shape, dtype), priority);
+      } else {
+        if (recv_buf.is_none()) {
+          // it may happen for the first time a no-rank-0 worker pull the weight.
+          recv_buf = NDArray(shape, pinned_ctx_, true, dtype);
+        }
+        PullDefault(key, recv_buf, priority);
       }
-      auto pull_from_servers = [this, key, recv_buf](
-          RunContext rctx, Engine::CallbackOnComplete cb) {
-        // convert to ps keys
-        size_t size = recv_buf.shape().Size();
-        const int dtype = recv_buf.dtype();
-        const int num_bytes = mshadow::mshadow_sizeof(dtype);
-        PSKV& pskv = (gradient_compression_->get_type() == CompressionType::kNone) ?
-                      EncodeDefaultKey(key, size, num_bytes) :
-                      EncodeCompressedKey(key, size, false, num_bytes);
-        char* data = static_cast<char*> (recv_buf.data().dptr_);
-        // false means not to delete data when SArray is deleted
-        auto vals = new ps::SArray<char>(data, size * num_bytes, false);
-        // issue pull
-        RequestType mode = (gradient_compression_->get_type() != CompressionType::kNone) ?
-                  RequestType::kCompressedPushPull : RequestType::kDefaultPushPull;
-        const int cmd = GetCommandType(mode, dtype);
-        CHECK_NOTNULL(ps_worker_)->ZPull(
-          pskv.keys, vals, &pskv.lens, cmd, [vals, cb](){ delete vals; cb(); });
-      };
-
-      CHECK_NOTNULL(Engine::Get())->PushAsync(
-          pull_from_servers,
-          pinned_ctx_,
-          {},
-          {recv_buf.var()},
-          FnProperty::kNormal,
-          priority,
-          "KVStoreDistDefaultStoragePull");
-
       comm_->Broadcast(key, recv_buf, grouped_vals[i], priority);
     }
   }
@@ -322,8 +341,15 @@ class KVStoreDist : public KVStoreLocal {
       NDArray merged = do_merge ? comm_->Reduce(key, vals, priority) : vals[0];
 
       const auto storage_type = merged.storage_type();
+      const int dtype = merged.dtype();
+      const int num_bytes = mshadow::mshadow_sizeof(dtype);
       auto &comm_buf = comm_buf_[key];
-      if (merged.ctx().dev_mask() == cpu::kDevMask) {
+      const bool shm = storage_type == kDefaultStorage &&
+                       UseSharedMem(key, merged.shape().Size(), dtype);
+      if (shm) {
+        // the servers on this host read the values from the buffer in shared memory
+        CopyFromTo(merged, &SharedMemCommBuf(key, merged.shape(), dtype));
+      } else if (merged.ctx().dev_mask() == cpu::kDevMask) {
         // Start of a push doesn't guarantee that the previous pushes are completed.
         // This shouldn't affect training of networks though because training involves
         // a sequence of push, pull, then push. This imposes ordering that the
@@ -339,10 +365,10 @@ class KVStoreDist : public KVStoreLocal {
         }
         CopyFromTo(merged, &comm_buf);
       }
-      const int dtype = merged.dtype();
-      const int num_bytes = mshadow::mshadow_sizeof(dtype);
       // push to servers
-      if (storage_type == kDefaultStorage) {
+      if (shm) {
+        PushSharedMem(key, comm_buf, priority);
+      } else if (storage_type == kDefaultStorage) {
         if (gradient_compression_->get_type() == CompressionType::kNone) {
           PSKV& pskv = EncodeDefaultKey(key, comm_buf.shape().Size(), num_bytes);
           PushDefault(key, comm_buf, pskv, priority);
@@ -432,6 +458,122 @@ class KVStoreDist : public KVStoreLocal {
         "KVStoreDistDefaultPush");
   }
 
+  void PullDefault(int key, const NDArray& recv_buf, int priority) {
+    auto pull_from_servers = [this, key, recv_buf](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      // convert to ps keys
+      size_t size = recv_buf.shape().Size();
+      const int dtype = recv_buf.dtype();
+      const int num_bytes = mshadow::mshadow_sizeof(dtype);
+      PSKV& pskv = (gradient_compression_->get_type() == CompressionType::kNone) ?
+                    EncodeDefaultKey(key, size, num_bytes) :
+                    EncodeCompressedKey(key, size, false, num_bytes);
+      char* data = static_cast<char*> (recv_buf.data().dptr_);
+      // false means not to delete data when SArray is deleted
+      auto vals = new ps::SArray<char>(data, size * num_bytes, false);
+      // issue pull
+      RequestType mode = (gradient_compression_->get_type() != CompressionType::kNone) ?
+                RequestType::kCompressedPushPull : RequestType::kDefaultPushPull;
+      const int cmd = GetCommandType(mode, dtype);
+      CHECK_NOTNULL(ps_worker_)->ZPull(
+        pskv.keys, vals, &pskv.lens, cmd, [vals, cb](){ delete vals; cb(); });
+    };
+
+    CHECK_NOTNULL(Engine::Get())->PushAsync(
+        pull_from_servers,
+        pinned_ctx_,
+        {},
+        {recv_buf.var()},
+        FnProperty::kNormal,
+        priority,
+        "KVStoreDistDefaultStoragePull");
+  }
+
+  /**
+   * \brief push the parts of a key on the servers of this host as requests without values,
+   * which the servers read from the buffer in shared memory, and the others as usual
+   */
+  void PushSharedMem(int key, const NDArray& send_buf, int priority) {
+    auto push_to_servers =
+        [this, key, send_buf](RunContext rctx, Engine::CallbackOnComplete cb) {
+          const int dtype = send_buf.dtype();
+          const int num_bytes = mshadow::mshadow_sizeof(dtype);
+          const SharedMemPSKV& pskv = EncodeSharedMemKey(key, send_buf.shape().Size(),
+                                                          num_bytes);
+          char* data = static_cast<char *>(send_buf.data().dptr_);
+          auto done = SharedMemCallback(pskv, cb);
+          CHECK_NOTNULL(ps_worker_)->ZPush(
+              pskv.local.keys, ps::SArray<char>(), {},
+              GetCommandType(RequestType::kSharedMemPushPull, dtype), done);
+          for (size_t i = 0; i < pskv.remote.keys.size(); ++i) {
+            // do push. false means no delete
+            ps::SArray<char> vals(data + pskv.remote_offsets[i], pskv.remote.lens[i], false);
+            ps_worker_->ZPush(
+                pskv.remote.keys.segment(i, i + 1), vals, pskv.remote.lens.segment(i, i + 1),
+                GetCommandType(RequestType::kDefaultPushPull, dtype), done);
+          }
+        };
+    Engine::Get()->PushAsync(
+        push_to_servers,
+        pinned_ctx_,
+        {send_buf.var()},
+        {},
+        FnProperty::kNormal,
+        priority,
+        "KVStoreDistSharedMemPush");
+  }
+
+  /**
+   * \brief pull the parts of a key on the servers of this host, which they write into
+   * the buffer in shared memory, and the others as usual
+   */
+  void PullSharedMem(int key, const NDArray& recv_buf, int priority) {
+    auto pull_from_servers = [this, key, recv_buf](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      const int dtype = recv_buf.dtype();
+      const int num_bytes = mshadow::mshadow_sizeof(dtype);
+      const SharedMemPSKV& pskv = EncodeSharedMemKey(key, recv_buf.shape().Size(),
+                                                      num_bytes);
+      char* data = static_cast<char*> (recv_buf.data().dptr_);
+      auto done = SharedMemCallback(pskv, cb);
+      auto local_vals = new ps::SArray<char>();
+      CHECK_NOTNULL(ps_worker_)->ZPull(
+          pskv.local.keys, local_vals, nullptr,
+          GetCommandType(RequestType::kSharedMemPushPull, dtype),
+          [local_vals, done]() { delete local_vals; done(); });
+      for (size_t i = 0; i < pskv.remote.keys.size(); ++i) {
+        // false means not to delete data when SArray is deleted
+        auto vals = new ps::SArray<char>(data + pskv.remote_offsets[i],
+                                         pskv.remote.lens[i], false);
+        ps_worker_->ZPull(
+            pskv.remote.keys.segment(i, i + 1), vals, nullptr,
+            GetCommandType(RequestType::kDefaultPushPull, dtype),
+            [vals, done]() { delete vals; done(); });
+      }
+    };
+    CHECK_NOTNULL(Engine::Get())->PushAsync(
+        pull_from_servers,
+        pinned_ctx_,
+        {},
+        {recv_buf.var()},
+        FnProperty::kNormal,
+        priority,
+        "KVStoreDistSharedMemPull");
+  }
+
+  /**
+   * \brief a callback of the requests for the parts of a key, which completes the
+   * operation once called for all of them
+   */
+  std::function<void()> SharedMemCallback(const SharedMemPSKV& pskv,
+                                          Engine::CallbackOnComplete cb) {
+    const int num_requests = 1 + pskv.remote.keys.size();
+    auto pending = std::make_shared<std::atomic<int>>(num_requests);
+    return [pending, cb]() {
+      if (--(*pending) == 0) cb();
+    };
+  }
+
   // push row sparse gradient
   void PushRowSparse(int key, const NDArray &send_buf, int priority) {
     using namespace rowsparse;
@@ -626,21 +768,23 @@ class KVStoreDist : public KVStoreLocal {
         push_pskv.size = compr_size;
         pull_pskv.size = original_size;
       } else {
-        // partition it to all servers
+        // partition it to all servers, in whole blocks of compressed values
         push_pskv.size = 0;
         pull_pskv.size = 0;
+        const size_t block_size = gradient_compression_->GetBlockSize();
+        const size_t num_blocks = (original_num_elem + block_size - 1) / block_size;
 
         for (int i = 0; i < num_servers; ++i) {
           size_t part_compr, part_orig;
           if (i == num_servers-1) {
-            part_compr = compr_num_elem - push_pskv.size;
             part_orig = original_num_elem - pull_pskv.size;
           } else {
-            part_compr =
-              static_cast<size_t> (round(static_cast<double>(compr_num_elem)/num_servers*(i+1))) -
-              static_cast<size_t> (round(static_cast<double>(compr_num_elem)/num_servers*(i)));
-            part_orig = part_compr * gradient_compression_->GetCompressionFactor();
+            const size_t part_blocks =
+              static_cast<size_t> (round(static_cast<double>(num_blocks)/num_servers*(i+1))) -
+              static_cast<size_t> (round(static_cast<double>(num_blocks)/num_servers*(i)));
+            part_orig = part_blocks * block_size;
           }
+          part_compr = gradient_compression_->GetCompressedSize(part_orig);
 
           // meta info
           ps::Key ps_key_dummy = krs[i].begin() + part_orig;
@@ -670,6 +814,100 @@ class KVStoreDist : public KVStoreLocal {
     return pskv;
   }
 
+  /**
+   * \brief split the parts of the pskv of a key between the servers of this host
+   * and the others
+   * \param key
+   * \param num_arr_elems number of elements in the value for key
+   * \param num_bytes size of each element in number of bytes
+   * \return SharedMemPSKV used for both push and pull
+   */
+  inline SharedMemPSKV& EncodeSharedMemKey(const int key, const size_t num_arr_elems,
+                                           const int num_bytes) {
+    const PSKV& pskv = EncodeDefaultKey(key, num_arr_elems, num_bytes);
+    // held until the entry is filled, since other threads may look the key up meanwhile
+    std::lock_guard<std::mutex> lock(mu_);
+    SharedMemPSKV& shm_pskv = shm_ps_kv_[key];
+    if (shm_pskv.local.keys.empty() && shm_pskv.remote.keys.empty()) {
+      auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
+      shm_pskv.local.size = 0;
+      shm_pskv.remote.size = 0;
+      size_t offset = 0;
+      for (size_t i = 0; i < pskv.keys.size(); ++i) {
+        size_t server = 0;
+        while (server < krs.size() && pskv.keys[i] >= krs[server].end()) ++server;
+        CHECK_LT(server, krs.size());
+        const bool local = shm_servers_[server];
+        PSKV& part = local ? shm_pskv.local : shm_pskv.remote;
+        part.keys.push_back(pskv.keys[i]);
+        part.lens.push_back(pskv.lens[i]);
+        part.size += pskv.lens[i];
+        (local ? shm_pskv.local_offsets : shm_pskv.remote_offsets).push_back(offset);
+        offset += pskv.lens[i];
+      }
+    }
+    return shm_pskv;
+  }
+
+  /**
+   * \brief whether a dense key is pushed and pulled through shared memory, which it is
+   * when some of its parts are on the servers of this host
+   */
+  bool UseSharedMem(const int key, const size_t num_arr_elems, const int dtype) {
+    return !shm_servers_.empty() &&
+           gradient_compression_->get_type() == CompressionType::kNone &&
+           !EncodeSharedMemKey(key, num_arr_elems,
+                               mshadow::mshadow_sizeof(dtype)).local.keys.empty();
+  }
+
+  /**
+   * \brief the buffer of a key in shared memory, which is mapped by the servers of this
+   * host once allocated
+   */
+  NDArray& SharedMemCommBuf(const int key, const mxnet::TShape& shape, const int dtype) {
+    NDArray& buf = comm_buf_[key];
+    if (!buf.is_none()) return buf;
+    buf = NDArray(shape, Context::CPUShared(0), false, dtype);
+    const SharedMemPSKV& pskv = EncodeSharedMemKey(key, shape.Size(),
+                                                   mshadow::mshadow_sizeof(dtype));
+    const Storage::Handle handle = buf.storage_handle();
+    std::ostringstream body;
+    body << shm_nonce_ << ' ' << handle.shared_pid << ' ' << handle.shared_id << ' '
+         << handle.size;
+    for (size_t i = 0; i < pskv.local.keys.size(); ++i) {
+      body << ' ' << pskv.local.keys[i] << ' ' << pskv.local_offsets[i] << ' '
+           << pskv.local.lens[i];
+    }
+    SendCommandToServers(static_cast<int>(CommandType::kSharedMemBuffer), body.str());
+    return buf;
+  }
+
+  /**
+   * \brief find the servers on this host: they mark a segment of shared memory holding
+   * a random nonce, which the servers on other hosts cannot open
+   */
+  void ProbeSharedMemServers() {
+    const int num_servers = ps::NumServers();
+    NDArray probe(mxnet::TShape{static_cast<int64_t>(sizeof(shm_nonce_) + num_servers)},
+                  Context::CPUShared(0), false, mshadow::kUint8);
+    char* data = static_cast<char*>(probe.data().dptr_);
+    std::random_device rd;
+    shm_nonce_ = (static_cast<uint64_t>(rd()) << 32) | rd();
+    std::memcpy(data, &shm_nonce_, sizeof(shm_nonce_));
+    std::memset(data + sizeof(shm_nonce_), 0, num_servers);
+    const Storage::Handle handle = probe.storage_handle();
+    std::ostringstream body;
+    body << shm_nonce_ << ' ' << handle.shared_pid << ' ' << handle.shared_id << ' '
+         << handle.size;
+    SendCommandToServers(static_cast<int>(CommandType::kSharedMemProbe), body.str());
+    bool any = false;
+    for (int i = 0; i < num_servers; ++i) {
+      shm_servers_.push_back(data[sizeof(shm_nonce_) + i] != 0);
+      any = any || shm_servers_.back();
+    }
+    if (!any) shm_servers_.clear();
+  }
+
   // Note: this encoding method for row sparse keys doesn't allow cross-layer batching
   inline PSKV& EncodeRowSparseKey(const int key, const int64_t num_elem, const int64_t num_rows,
                                   const int64_t *offsets, const size_t unit_len,
@@ -760,6 +998,15 @@ class KVStoreDist : public KVStoreLocal {
    * during gradient compression
    */
   std::unordered_map<int, NDArray> residual_;
+  /**
+   * \brief whether each server runs on this host, empty when none does or
+   * MXNET_KVSTORE_SHM_TRANSPORT is not set
+   */
+  std::vector<bool> shm_servers_;
+  /**
+   * \brief the nonce the servers on this host know this worker by
+   */
+  uint64_t shm_nonce_ = 0;
   bool log_verbose_;
 };
 
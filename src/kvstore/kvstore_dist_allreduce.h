@@ -0,0 +1,171 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file kvstore_dist_allreduce.h
+ * \brief distributed kvstore summing the pushed values with allreduce between the
+ *  workers, without servers
+ */
+#ifndef MXNET_KVSTORE_KVSTORE_DIST_ALLREDUCE_H_
+#define MXNET_KVSTORE_KVSTORE_DIST_ALLREDUCE_H_
+
+#ifndef _WIN32
+#include <mxnet/engine.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "./collective.h"
+#include "./comm.h"
+#include "./kvstore_local.h"
+
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief Distributed kvstore where every worker keeps all the values. The values pushed
+ *  are summed over the devices of a worker as by KVStoreLocal, then over the workers by
+ *  allreduce, and each worker updates its own copy with the same sum.
+ *
+ *  The workers meet at DMLC_PS_ROOT_URI:DMLC_PS_ROOT_PORT, DMLC_NUM_WORKER of them, with
+ *  no scheduler or server. They have to init, push and pull the same keys in the same
+ *  order, as the collective operations run in that order.
+ */
+class KVStoreDistAllreduce : public KVStoreLocal {
+ public:
+  explicit KVStoreDistAllreduce(bool use_device_comm) : KVStoreLocal(use_device_comm) {
+    const int size = dmlc::GetEnv("DMLC_NUM_WORKER", 1);
+    const std::string root_uri = dmlc::GetEnv("DMLC_PS_ROOT_URI", std::string());
+    const int root_port = dmlc::GetEnv("DMLC_PS_ROOT_PORT", 0);
+    CHECK(size == 1 || (!root_uri.empty() && root_port > 0))
+        << "Set DMLC_PS_ROOT_URI and DMLC_PS_ROOT_PORT to the address the workers meet at";
+    collective_ = std::make_shared<Collective>(
+        root_uri, root_port, size,
+        dmlc::GetEnv("MXNET_KVSTORE_ALLREDUCE_SHM", true),
+        dmlc::GetEnv("MXNET_KVSTORE_ALLREDUCE_SHM_SIZE", static_cast<size_t>(1 << 20)),
+        dmlc::GetEnv("MXNET_KVSTORE_ALLREDUCE_RING_BOUND", static_cast<size_t>(1 << 20)));
+    collective_var_ = Engine::Get()->NewVariable();
+  }
+
+  virtual ~KVStoreDistAllreduce() {
+    Engine::Get()->WaitForAll();
+    Engine::Get()->DeleteVariable([](RunContext rctx) {}, pinned_ctx_, collective_var_);
+  }
+
+  void SetGradientCompression(const std::vector<std::pair<std::string, std::string> >
+                              & kwargs) override {
+    LOG(FATAL) << "Gradient compression is not supported by the dist_allreduce kvstore";
+  }
+
+  void Barrier() override {
+    auto collective = collective_;
+    Engine::Get()->PushSync([collective](RunContext rctx) {
+        collective->Barrier();
+      }, pinned_ctx_, {}, {collective_var_}, FnProperty::kNormal, 0,
+      "KVStoreDistAllreduceBarrier");
+    Engine::Get()->WaitForVar(collective_var_);
+  }
+
+  int get_group_size() const override { return collective_->size(); }
+
+  int get_rank() const override { return collective_->rank(); }
+
+ private:
+  void InitImpl(const std::vector<int>& keys,
+                const std::vector<NDArray>& values) override {
+    for (size_t i = 0; i < keys.size(); ++i) {
+      CHECK(local_.find(keys[i]) == local_.end())
+          << "duplicate init of key " << keys[i];
+      CHECK_EQ(values[i].storage_type(), kDefaultStorage)
+          << "The dist_allreduce kvstore supports dense arrays only";
+      NDArray& local = local_[keys[i]];
+      local = values[i].Copy(pinned_ctx_);
+      comm_->Init(keys[i], kDefaultStorage, values[i].shape(), values[i].dtype());
+      // every worker starts from the values of rank 0
+      Broadcast(local, 0);
+    }
+  }
+
+  const NDArray& Merge(int key, const std::vector<NDArray>& values, int priority) override {
+    for (const NDArray& value : values) {
+      CHECK_EQ(value.storage_type(), kDefaultStorage)
+          << "The dist_allreduce kvstore supports dense arrays only";
+    }
+    const NDArray& merged = comm_->Reduce(key, values, priority);
+    // sum in place when merged is a buffer of the store in main memory, and in a copy when
+    // it is on a gpu or is the pushed array itself
+    bool in_place = merged.ctx().dev_mask() == cpu::kDevMask;
+    for (const NDArray& value : values) {
+      in_place = in_place && value.var() != merged.var();
+    }
+    NDArray& buf = allreduce_buf_[key];
+    if (in_place) {
+      buf = merged;
+    } else {
+      if (buf.is_none()) buf = NDArray(merged.shape(), pinned_ctx_, false, merged.dtype());
+      CopyFromTo(merged, &buf, priority);
+    }
+    Allreduce(buf, priority);
+    return buf;
+  }
+
+  /*!
+   * \brief sum data over the workers. The collective operations all mutate
+   *  collective_var_, so that they run in the order they are pushed on every worker.
+   */
+  void Allreduce(const NDArray& data, int priority) {
+    auto collective = collective_;
+    Engine::Get()->PushAsync(
+      [collective, data](RunContext rctx, Engine::CallbackOnComplete on_complete) {
+        MSHADOW_TYPE_SWITCH(data.dtype(), DType, {
+          auto sum = [](DType *dst, const DType *src, size_t size) {
+            CommCPU::ReduceSumCPU<DType>({dst, const_cast<DType*>(src)}, 0,
+                                         static_cast<index_t>(size));
+          };
+          collective->Allreduce(data.data().dptr<DType>(), data.shape().Size(), sum);
+        });
+        on_complete();
+      }, pinned_ctx_, {}, {data.var(), collective_var_},
+      FnProperty::kNormal, priority, "KVStoreDistAllreduce");
+  }
+
+  /*! \brief copy data of the worker root to the other workers */
+  void Broadcast(const NDArray& data, int root) {
+    auto collective = collective_;
+    Engine::Get()->PushSync([collective, data, root](RunContext rctx) {
+        const size_t size = data.shape().Size() * mshadow::mshadow_sizeof(data.dtype());
+        collective->Broadcast(static_cast<char*>(data.data().dptr_), size, root);
+      }, pinned_ctx_, {}, {data.var(), collective_var_}, FnProperty::kNormal, 0,
+      "KVStoreDistAllreduceBroadcast");
+  }
+
+  /*! \brief the connections to the other workers */
+  std::shared_ptr<Collective> collective_;
+  /*! \brief the variable of the collective operations, which run one at a time */
+  Engine::VarHandle collective_var_;
+  /*! \brief the arrays summed over the workers, by key */
+  std::unordered_map<int, NDArray> allreduce_buf_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // _WIN32
+#endif  // MXNET_KVSTORE_KVSTORE_DIST_ALLREDUCE_H_
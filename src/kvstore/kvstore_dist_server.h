@@ -34,10 +34,14 @@
 #include <memory>
 #include <functional>
 #include <future>
+#include <map>
+#include <sstream>
+#include <utility>
 #include <vector>
 #include "../profiler/profiler.h"
 #include "../operator/tensor/elemwise_binary_op-inl.h"
 #include "../operator/tensor/init_op.h"
+#include "./shared_mem.h"
 
 namespace mxnet {
 namespace kvstore {
@@ -45,11 +49,11 @@ namespace kvstore {
 // maintain same order in frontend.
 enum class CommandType {
   kController, kSetMultiPrecision, kStopServer, kSyncMode,
-  kSetGradientCompression, kSetProfilerParams
+  kSetGradientCompression, kSetProfilerParams, kSharedMemProbe, kSharedMemBuffer
 };
 
 enum class RequestType {
-  kDefaultPushPull, kRowSparsePushPull, kCompressedPushPull
+  kDefaultPushPull, kRowSparsePushPull, kCompressedPushPull, kSharedMemPushPull
 };
 
 struct DataHandleType {
@@ -214,6 +218,12 @@ class KVStoreDistServer {
                                                   (recved.body.back() - '0'),
                                       recved.body);
         break;
+      case CommandType::kSharedMemProbe:
+        ProbeSharedMem(recved);
+        break;
+      case CommandType::kSharedMemBuffer:
+        RegisterSharedMemBuffer(recved);
+        break;
       case CommandType::kSetMultiPrecision:
         // uses value 1 for message id from frontend
         if (!multi_precision_) {
@@ -336,6 +346,9 @@ class KVStoreDistServer {
       case RequestType::kDefaultPushPull:
         DataHandleDefault(type, req_meta, req_data, server);
         break;
+      case RequestType::kSharedMemPushPull:
+        DataHandleSharedMem(type, req_meta, req_data, server);
+        break;
     }
   }
 
@@ -360,6 +373,10 @@ class KVStoreDistServer {
         CopyFromTo(update_buf->merged, &stored);
       }
 
+      if (has_multi_precision_copy(type)) CopyFromTo(stored, store_[key]);
+      stored.WaitToRead();
+      // respond once the values pushed are read, as they can be in the shared memory of
+      // the workers, which reuse it after the response
       if (log_verbose_)  {
         LOG(INFO) << "sent response to " << update_buf->request.size() << " workers";
       }
@@ -367,8 +384,6 @@ class KVStoreDistServer {
         server->Response(req);
       }
       update_buf->request.clear();
-      if (has_multi_precision_copy(type)) CopyFromTo(stored, store_[key]);
-      stored.WaitToRead();
     } else {
       update_buf->merged.WaitToRead();
     }
@@ -680,7 +695,8 @@ class KVStoreDistServer {
     int key = DecodeKey(req_data.keys[0]);
     auto& stored = has_multi_precision_copy(type) ? store_realt_[key] : store_[key];
     // there used several WaitToRead, this is because \a recved's memory
-    // could be deallocated when this function returns. so we need to make sure
+    // could be deallocated when this function returns, or reused by the worker
+    // once it has the response. so we need to make sure
     // the operators with \a NDArray are actually finished
     if (req_meta.push) {
       size_t ds[] = {(size_t) req_data.lens[0] / mshadow::mshadow_sizeof(type.dtype)};
@@ -695,7 +711,6 @@ class KVStoreDistServer {
         stored = NDArray(dshape, Context(), false,
                          has_multi_precision_copy(type) ? mshadow::kFloat32 : type.dtype);
         CopyFromTo(recved, &stored, 0);
-        server->Response(req_meta);
         if (has_multi_precision_copy(type)) {
           auto& stored_dtype = store_[key];
           stored_dtype = NDArray(dshape, Context(), false, type.dtype);
@@ -703,6 +718,7 @@ class KVStoreDistServer {
           stored_dtype.WaitToRead();
         }
         stored.WaitToRead();
+        server->Response(req_meta);
       } else {
         auto &updates = update_buf_[key];
         if (sync_mode_ && updates.merged.is_none()) {
@@ -739,6 +755,93 @@ class KVStoreDistServer {
     }
   }
 
+  /*!
+   * \brief check that a worker runs on this host: it sends the nonce it wrote in a
+   *  segment of shared memory, which the server marks when it finds the nonce there
+   */
+  void ProbeSharedMem(const ps::SimpleData& recved) {
+    std::istringstream body(recved.body);
+    uint64_t nonce;
+    int shared_pid, shared_id;
+    size_t size;
+    body >> nonce >> shared_pid >> shared_id >> size;
+    CHECK(body) << "Improper shared memory probe passed from worker";
+    CHECK_GE(size, sizeof(nonce) + ps::NumServers());
+    SharedMemSegment probe;
+    if (!probe.Open(shared_pid, shared_id, size)) return;
+    uint64_t found;
+    std::memcpy(&found, probe.data(), sizeof(found));
+    if (found != nonce) return;
+    probe.data()[sizeof(nonce) + ps::MyRank()] = 1;
+    shm_nonces_[nonce] = recved.sender;
+  }
+
+  /*!
+   * \brief map the buffer in shared memory of a key of a worker on this host, which the
+   *  worker then pushes from, and pulls into, with requests of type kSharedMemPushPull
+   */
+  void RegisterSharedMemBuffer(const ps::SimpleData& recved) {
+    std::istringstream body(recved.body);
+    uint64_t nonce;
+    int shared_pid, shared_id;
+    size_t size;
+    body >> nonce >> shared_pid >> shared_id >> size;
+    CHECK(body) << "Improper shared memory buffer passed from worker";
+    auto it = shm_nonces_.find(nonce);
+    // the workers on other hosts send their buffers to every server too
+    if (it == shm_nonces_.end() || it->second != recved.sender) return;
+    // the parts of the buffer for the keys of this server
+    const auto kr = ps::Postoffice::Get()->GetServerKeyRanges()[ps::MyRank()];
+    std::vector<std::pair<int, std::pair<size_t, size_t> > > parts;
+    ps::Key ps_key;
+    size_t offset, len;
+    while (body >> ps_key >> offset >> len) {
+      if (ps_key < kr.begin() || ps_key >= kr.end()) continue;
+      CHECK_LE(offset + len, size);
+      parts.push_back({DecodeKey(ps_key), {offset, len}});
+    }
+    if (parts.empty()) return;
+    auto segment = std::make_shared<SharedMemSegment>();
+    CHECK(segment->Open(shared_pid, shared_id, size))
+      << "Failed to map the shared memory of worker " << recved.sender;
+    for (const auto& part : parts) {
+      SharedMemBuffer& buf = shm_bufs_[{recved.sender, part.first}];
+      buf.segment = segment;
+      buf.data = segment->data() + part.second.first;
+      buf.size = part.second.second;
+    }
+  }
+
+  void DataHandleSharedMem(const DataHandleType type, const ps::KVMeta& req_meta,
+                           const ps::KVPairs<char> &req_data,
+                           ps::KVServer<char>* server) {
+    CHECK_EQ(req_data.keys.size(), (size_t)1);
+    int key = DecodeKey(req_data.keys[0]);
+    auto it = shm_bufs_.find({req_meta.sender, key});
+    CHECK(it != shm_bufs_.end()) << "no buffer in shared memory for key " << key;
+    const SharedMemBuffer& buf = it->second;
+    if (req_meta.push) {
+      // false means not to delete data when SArray is deleted
+      ps::KVPairs<char> data;
+      data.keys = req_data.keys;
+      data.vals = ps::SArray<char>(buf.data, buf.size, false);
+      data.lens = {static_cast<int>(buf.size)};
+      DataHandleDefault(type, req_meta, data, server);
+    } else {
+      const NDArray& stored = store_[key];
+      CHECK(!stored.is_none()) << "init " << key << " first";
+      // as server returns when store_realt is ready in this case
+      if (has_multi_precision_copy(type)) stored.WaitToRead();
+      CHECK_EQ(stored.shape().Size() * mshadow::mshadow_sizeof(stored.dtype()), buf.size);
+      std::memcpy(buf.data, stored.data().dptr_, buf.size);
+      // the values are in the buffer of the worker already
+      ps::KVPairs<char> response;
+      response.keys = req_data.keys;
+      response.lens = {0};
+      server->Response(req_meta, response);
+    }
+  }
+
   int DecodeKey(ps::Key key) {
     auto kr = ps::Postoffice::Get()->GetServerKeyRanges()[ps::MyRank()];
     return key - kr.begin();
@@ -771,6 +874,25 @@ class KVStoreDistServer {
    */
   std::unordered_map<int, NDArray> decomp_buf_;
 
+  /*!
+   * \brief an array of a worker on this host, mapped from its shared memory
+   */
+  struct SharedMemBuffer {
+    std::shared_ptr<SharedMemSegment> segment;
+    char* data;
+    size_t size;
+  };
+
+  /**
+   * \brief the node ids of the workers on this host, by the nonces they probed with
+   */
+  std::unordered_map<uint64_t, int> shm_nonces_;
+
+  /**
+   * \brief the buffers of the workers on this host, by node id of the worker and key
+   */
+  std::map<std::pair<int, int>, SharedMemBuffer> shm_bufs_;
+
   Executor exec_;
   ps::KVServer<char>* ps_server_;
 
@@ -63,6 +63,40 @@ enum KeyType {
   kIntKey
 };
 
+/*! \brief the key of the first bucket of fused keys, above the keys of the users */
+const int kFusedKeyBase = 1 << 30;
+
+/**
+ * \brief small dense keys pushed, reduced and pulled as one flat array
+ */
+struct FusionBucket {
+  /*! \brief the key of the flat array, and its type */
+  int key = -1;
+  int dtype = -1;
+  /*! \brief the fused keys, their shapes, and their offsets in the flat array */
+  std::vector<int> keys;
+  std::vector<mxnet::TShape> shapes;
+  std::vector<size_t> offsets;
+  /*! \brief the size of the flat array */
+  size_t size = 0;
+  /*! \brief the pushed values, as one flat array per device */
+  std::vector<NDArray> push_bufs;
+  /*! \brief which keys are pushed since the bucket was last sent, and how many */
+  std::vector<bool> pushed;
+  size_t num_pushed = 0;
+  /*! \brief the highest priority of the pushes since the bucket was last sent */
+  int priority = 0;
+  /*! \brief the pulled value, and which keys were copied out of it since it was pulled */
+  NDArray pull_buf;
+  std::vector<bool> served;
+  bool pulled = false;
+
+  /*! \brief the array of the i-th key in a flat array of the bucket */
+  NDArray View(const NDArray& flat, size_t i) const {
+    return flat.Slice(offsets[i], offsets[i] + shapes[i].Size()).Reshape(shapes[i]);
+  }
+};
+
 /**
  * \brief store data in local machine
  */
@@ -84,6 +118,7 @@ class KVStoreLocal : public KVStore {
     }
     pinned_ctx_ = comm_->pinned_ctx();
     gradient_compression_ = std::make_shared<GradientCompression>();
+    fusion_bound_ = dmlc::GetEnv("MXNET_KVSTORE_FUSION_BOUND", 0);
   }
 
   virtual ~KVStoreLocal() {
@@ -95,6 +130,7 @@ class KVStoreLocal : public KVStore {
             const std::vector<NDArray>& values) override {
     SetKeyType(kIntKey);
     InitImpl(keys, values);
+    AddFusionKeys(keys, values);
   }
 
   void Init(const std::vector<std::string>& str_keys,
@@ -112,13 +148,14 @@ class KVStoreLocal : public KVStore {
       keys[i] = key;
     }
     InitImpl(keys, values);
+    AddFusionKeys(keys, values);
   }
 
   void Push(const std::vector<int>& keys,
             const std::vector<NDArray>& values,
             int priority) override {
     SetKeyType(kIntKey);
-    PushImpl(keys, values, priority);
+    PushFused(keys, values, priority);
   }
 
   void Pull(const std::vector<int>& keys,
@@ -126,7 +163,7 @@ class KVStoreLocal : public KVStore {
             int priority,
             bool ignore_sparse) override {
     SetKeyType(kIntKey);
-    PullImpl(keys, values, priority, ignore_sparse);
+    PullFused(keys, values, priority, ignore_sparse);
   }
 
   void PullRowSparse(const std::vector<int>& keys,
@@ -142,7 +179,7 @@ class KVStoreLocal : public KVStore {
     SetKeyType(kStringKey);
     std::vector<int> keys(str_keys.size());
     LookupKeys(str_keys, &keys);
-    PushImpl(keys, values, priority);
+    PushFused(keys, values, priority);
   }
 
   void Pull(const std::vector<std::string>& str_keys,
@@ -152,7 +189,7 @@ class KVStoreLocal : public KVStore {
     SetKeyType(kStringKey);
     std::vector<int> keys(str_keys.size());
     LookupKeys(str_keys, &keys);
-    PullImpl(keys, values, priority, ignore_sparse);
+    PullFused(keys, values, priority, ignore_sparse);
   }
 
   void PullRowSparse(const std::vector<std::string>& str_keys,
@@ -189,33 +226,47 @@ class KVStoreLocal : public KVStore {
     GroupKVPairsPush(keys, values, &uniq_keys, &grouped_vals, false);
     for (size_t i = 0; i < uniq_keys.size(); ++i) {
       int key = uniq_keys[i];
-      const NDArray& merged = comm_->Reduce(key, grouped_vals[i], priority);
-      NDArray& local = local_[key];
-      if (updater_ != nullptr) {
-        CHECK(!local.is_none()) << "key " << key << " has not been inited";
-        // if merged is on gpu, we may need copy weight from cpu to gpu
-        if (merged.ctx().dev_mask() != cpu::kDevMask &&
-            local.ctx().dev_mask() == cpu::kDevMask) {
-          local = local.Copy(merged.ctx());
-        }
-        // call the updater with string keys
-        // if string keys are used and str_updater_ is available
-        // otherwise fallback to updater_ which uses int key interface
-        if (key_type_ == kStringKey && str_updater_ != nullptr) {
-          // TODO(haibin) CHECK(str_updater_ != nullptr) if use_str_key
-          // after all language bindings picks up string interface changes
-          const std::string &str_key = reverse_str_key_dict_[key];
-          // TODO(haibin) avoid reverse key lookup if use_str_key
-          str_updater_(str_key, merged,  &local);
-        } else {
-          updater_(key, merged,  &local);
-        }
+      const NDArray& merged = Merge(key, grouped_vals[i], priority);
+      Update(key, merged);
+    }
+  }
+
+  /*!
+   * \brief sum the values pushed for key from the devices
+   */
+  virtual const NDArray& Merge(int key, const std::vector<NDArray>& values, int priority) {
+    return comm_->Reduce(key, values, priority);
+  }
+
+  /*!
+   * \brief update the local value of key with its merged value
+   */
+  void Update(int key, const NDArray& merged) {
+    NDArray& local = local_[key];
+    if (updater_ != nullptr) {
+      CHECK(!local.is_none()) << "key " << key << " has not been inited";
+      // if merged is on gpu, we may need copy weight from cpu to gpu
+      if (merged.ctx().dev_mask() != cpu::kDevMask &&
+          local.ctx().dev_mask() == cpu::kDevMask) {
+        local = local.Copy(merged.ctx());
+      }
+      // call the updater with string keys
+      // if string keys are used and str_updater_ is available
+      // otherwise fallback to updater_ which uses int key interface
+      if (key_type_ == kStringKey && str_updater_ != nullptr) {
+        // TODO(haibin) CHECK(str_updater_ != nullptr) if use_str_key
+        // after all language bindings picks up string interface changes
+        const std::string &str_key = reverse_str_key_dict_[key];
+        // TODO(haibin) avoid reverse key lookup if use_str_key
+        str_updater_(str_key, merged,  &local);
       } else {
-        if (merged.storage_type() != local.storage_type()) {
-          local = merged.Copy(local.ctx());
-        } else {
-          local = merged;
-        }
+        updater_(key, merged,  &local);
+      }
+    } else {
+      if (merged.storage_type() != local.storage_type()) {
+        local = merged.Copy(local.ctx());
+      } else {
+        local = merged;
       }
     }
   }
@@ -258,6 +309,235 @@ class KVStoreLocal : public KVStore {
     }
   }
 
+  /*!
+   * \brief set up the reduction of a new bucket of fused keys
+   * \param value the flat array of the initial values of its keys
+   */
+  virtual void InitBucket(const FusionBucket& bucket, const NDArray& value) {
+    comm_->Init(bucket.key, kDefaultStorage, value.shape(), value.dtype());
+  }
+
+  /*!
+   * \brief reduce a bucket whose keys are all pushed, and update each of its keys
+   */
+  virtual void PushBucket(const FusionBucket& bucket) {
+    const NDArray& merged = Merge(bucket.key, bucket.push_bufs, bucket.priority);
+    for (size_t i = 0; i < bucket.keys.size(); ++i) {
+      Update(bucket.keys[i], bucket.View(merged, i));
+    }
+  }
+
+  /*!
+   * \brief whether fused keys are pulled through their buckets. The local values are
+   *  kept key by key, so they are pulled one by one here.
+   */
+  virtual bool PullBuckets() const {
+    return false;
+  }
+
+  /*!
+   * \brief remember the small dense keys to fuse into buckets at the next push
+   */
+  void AddFusionKeys(const std::vector<int>& keys, const std::vector<NDArray>& values) {
+    if (fusion_bound_ == 0) return;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const NDArray& value = values[i];
+      const size_t bytes = value.shape().Size() * mshadow::mshadow_sizeof(value.dtype());
+      if (value.storage_type() != kDefaultStorage || bytes >= fusion_bound_) continue;
+      CHECK_LT(keys[i], kFusedKeyBase) << "key " << keys[i] << " is too large to be fused";
+      fusion_pending_.emplace_back(keys[i], value.Copy(pinned_ctx_));
+    }
+  }
+
+  /*!
+   * \brief pack the keys added since the last push into buckets of at most
+   *  fusion_bound_ bytes. The gradients of the keys inited last are computed first by
+   *  the backward pass, so keys are packed from the last one, and a bucket holds keys
+   *  whose gradients are ready at about the same time.
+   */
+  void FuseKeys() {
+    if (fusion_pending_.empty()) return;
+    std::vector<FusionBucket> packed;
+    std::vector<std::vector<NDArray>> init_values;
+    std::unordered_map<int, size_t> open_bucket;
+    for (auto it = fusion_pending_.rbegin(); it != fusion_pending_.rend(); ++it) {
+      const NDArray& value = it->second;
+      const size_t num_bytes = mshadow::mshadow_sizeof(value.dtype());
+      const size_t size = value.shape().Size();
+      auto open = open_bucket.find(value.dtype());
+      if (open == open_bucket.end() ||
+          (packed[open->second].size + size) * num_bytes > fusion_bound_) {
+        open_bucket[value.dtype()] = packed.size();
+        packed.emplace_back();
+        packed.back().dtype = value.dtype();
+        init_values.emplace_back();
+      }
+      const size_t b = open_bucket[value.dtype()];
+      FusionBucket& bucket = packed[b];
+      bucket.keys.push_back(it->first);
+      bucket.shapes.push_back(value.shape());
+      bucket.offsets.push_back(bucket.size);
+      bucket.size += size;
+      init_values[b].push_back(value);
+    }
+    fusion_pending_.clear();
+    for (size_t b = 0; b < packed.size(); ++b) {
+      // a key alone is better pushed as it is
+      if (packed[b].keys.size() < 2) continue;
+      FusionBucket bucket = std::move(packed[b]);
+      bucket.key = kFusedKeyBase + static_cast<int>(buckets_.size());
+      bucket.pushed.assign(bucket.keys.size(), false);
+      bucket.served.assign(bucket.keys.size(), false);
+      NDArray value(mxnet::TShape{static_cast<int64_t>(bucket.size)}, pinned_ctx_,
+                    false, bucket.dtype);
+      for (size_t i = 0; i < bucket.keys.size(); ++i) {
+        NDArray view = bucket.View(value, i);
+        CopyFromTo(init_values[b][i], &view);
+        fused_keys_[bucket.keys[i]] = std::make_pair(buckets_.size(), i);
+      }
+      InitBucket(bucket, value);
+      buckets_.push_back(std::move(bucket));
+    }
+  }
+
+  /*!
+   * \brief stop fusing the keys of a bucket, pushing the pushed ones alone. Called when a
+   *  key is pulled, or pushed again, before the bucket is complete, as when keys are
+   *  pushed and pulled one after another, or only some of them are pushed in a step.
+   *  This holds for buckets already sent too: each key keeps its own local value, updated
+   *  from the bucket, and the servers, which have no updater while keys are fused, keep
+   *  the last value pushed of each key.
+   */
+  void Unfuse(size_t b) {
+    FusionBucket& bucket = buckets_[b];
+    std::vector<int> keys;
+    std::vector<NDArray> values;
+    for (size_t i = 0; i < bucket.keys.size(); ++i) {
+      fused_keys_.erase(bucket.keys[i]);
+      if (!bucket.pushed[i]) continue;
+      for (const NDArray& buf : bucket.push_bufs) {
+        keys.push_back(bucket.keys[i]);
+        values.push_back(bucket.View(buf, i));
+      }
+    }
+    if (!keys.empty()) PushImpl(keys, values, bucket.priority);
+    bucket.keys.clear();
+    bucket.push_bufs.clear();
+  }
+
+  /*!
+   * \brief push fused keys into the flat arrays of their buckets, sending the buckets
+   *  whose keys are all pushed, and the other keys as they are
+   */
+  void PushFused(const std::vector<int>& keys, const std::vector<NDArray>& values,
+                 int priority) {
+    if (fusion_bound_ == 0) {
+      PushImpl(keys, values, priority);
+      return;
+    }
+    FuseKeys();
+    std::vector<int> uniq_keys;
+    std::vector<std::vector<NDArray> > grouped_vals;
+    GroupKVPairsPush(keys, values, &uniq_keys, &grouped_vals, false);
+    std::vector<int> other_keys;
+    std::vector<NDArray> other_values;
+    std::vector<size_t> complete;
+    for (size_t i = 0; i < uniq_keys.size(); ++i) {
+      const int key = uniq_keys[i];
+      const auto& vals = grouped_vals[i];
+      auto it = fused_keys_.find(key);
+      if (it != fused_keys_.end() && buckets_[it->second.first].pushed[it->second.second]) {
+        Unfuse(it->second.first);
+        it = fused_keys_.end();
+      }
+      if (it == fused_keys_.end()) {
+        other_keys.insert(other_keys.end(), vals.size(), key);
+        other_values.insert(other_values.end(), vals.begin(), vals.end());
+        continue;
+      }
+      FusionBucket& bucket = buckets_[it->second.first];
+      const size_t k = it->second.second;
+      if (bucket.num_pushed == 0) {
+        bucket.push_bufs.resize(vals.size());
+        for (size_t j = 0; j < vals.size(); ++j) {
+          if (bucket.push_bufs[j].is_none() || bucket.push_bufs[j].ctx() != vals[j].ctx()) {
+            bucket.push_bufs[j] = NDArray(mxnet::TShape{static_cast<int64_t>(bucket.size)},
+                                          vals[j].ctx(), false, bucket.dtype);
+          }
+        }
+        bucket.priority = priority;
+      }
+      CHECK_EQ(vals.size(), bucket.push_bufs.size())
+          << "key " << key << " is pushed from " << vals.size() << " devices, but the keys "
+          << "fused with it from " << bucket.push_bufs.size();
+      for (size_t j = 0; j < vals.size(); ++j) {
+        CHECK(vals[j].ctx() == bucket.push_bufs[j].ctx())
+            << "key " << key << " is pushed from other devices than the keys fused with it";
+        NDArray view = bucket.View(bucket.push_bufs[j], k);
+        CopyFromTo(vals[j], &view, priority);
+      }
+      bucket.pushed[k] = true;
+      bucket.priority = std::max(bucket.priority, priority);
+      if (++bucket.num_pushed == bucket.keys.size()) complete.push_back(it->second.first);
+    }
+    if (!other_keys.empty()) PushImpl(other_keys, other_values, priority);
+    for (size_t b : complete) {
+      FusionBucket& bucket = buckets_[b];
+      PushBucket(bucket);
+      bucket.pushed.assign(bucket.keys.size(), false);
+      bucket.num_pushed = 0;
+      bucket.pulled = false;
+    }
+  }
+
+  /*!
+   * \brief pull fused keys through their buckets, each bucket pulled once for all the
+   *  keys copied out of it, and the other keys as they are
+   */
+  void PullFused(const std::vector<int>& keys, const std::vector<NDArray*>& values,
+                 int priority, bool ignore_sparse) {
+    if (fused_keys_.empty()) {
+      PullImpl(keys, values, priority, ignore_sparse);
+      return;
+    }
+    std::vector<int> other_keys;
+    std::vector<NDArray*> other_values;
+    std::vector<std::pair<size_t, size_t> > fused;
+    std::vector<NDArray*> fused_values;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      auto it = fused_keys_.find(keys[i]);
+      if (it != fused_keys_.end() && buckets_[it->second.first].pushed[it->second.second]) {
+        Unfuse(it->second.first);
+        it = fused_keys_.end();
+      }
+      if (it == fused_keys_.end() || !PullBuckets()) {
+        other_keys.push_back(keys[i]);
+        other_values.push_back(values[i]);
+      } else {
+        fused.push_back(it->second);
+        fused_values.push_back(values[i]);
+      }
+    }
+    if (!other_keys.empty()) PullImpl(other_keys, other_values, priority, ignore_sparse);
+    // pull again the buckets not pulled since sent, or with keys already copied out
+    for (const auto& f : fused) {
+      FusionBucket& bucket = buckets_[f.first];
+      if (bucket.pulled && !bucket.served[f.second]) continue;
+      if (bucket.pull_buf.is_none()) {
+        bucket.pull_buf = NDArray(mxnet::TShape{static_cast<int64_t>(bucket.size)},
+                                  pinned_ctx_, false, bucket.dtype);
+      }
+      PullImpl({bucket.key}, {&bucket.pull_buf}, priority, ignore_sparse);
+      bucket.pulled = true;
+      bucket.served.assign(bucket.keys.size(), false);
+    }
+    for (size_t i = 0; i < fused.size(); ++i) {
+      FusionBucket& bucket = buckets_[fused[i].first];
+      CopyFromTo(bucket.View(bucket.pull_buf, fused[i].second), fused_values[i], priority);
+    }
+    for (const auto& f : fused) buckets_[f.first].served[f.second] = true;
+  }
+
  protected:
   KVStoreLocal() : KVStore() {}
   /**
@@ -269,6 +549,16 @@ class KVStoreLocal : public KVStore {
     CHECK_EQ(key_type_, key_type) << "Mixed key types are not allowed";
   }
 
+  /**
+   * \brief stop fusing keys, as when each key has to be updated with its own parameters
+   */
+  void StopFusion() {
+    CHECK(buckets_.empty()) << "Keys are already fused, this has to be done before the "
+                            << "first push when MXNET_KVSTORE_FUSION_BOUND is set";
+    fusion_bound_ = 0;
+    fusion_pending_.clear();
+  }
+
   /**
    * \brief group values on keys for push
    */
@@ -454,6 +744,14 @@ class KVStoreLocal : public KVStore {
   std::unordered_set<int> warnings_printed_;
   /// whether int or string is used for keys
   KeyType key_type_ = kUndefinedKey;
+  /// keys of fewer bytes are fused into buckets of as many bytes, 0 to not fuse keys
+  size_t fusion_bound_ = 0;
+  /// keys to fuse at the next push, with their initial values
+  std::vector<std::pair<int, NDArray> > fusion_pending_;
+  /// the buckets of fused keys, by key minus kFusedKeyBase
+  std::vector<FusionBucket> buckets_;
+  /// the bucket, and the position in it, of the fused keys
+  std::unordered_map<int, std::pair<size_t, size_t> > fused_keys_;
 };
 }  // namespace kvstore
 }  // namespace mxnet
@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file shared_mem.h
+ * \brief map the shared memory of an array of another process, allocated in the
+ *  kCPUShared context of that process
+ */
+#ifndef MXNET_KVSTORE_SHARED_MEM_H_
+#define MXNET_KVSTORE_SHARED_MEM_H_
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+#include <dmlc/logging.h>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+namespace mxnet {
+namespace kvstore {
+
+/*!
+ * \brief a segment of CPUSharedStorageManager mapped in this process, from the shared_pid
+ *  and shared_id of its handle in the process which allocated it.
+ *
+ *  On Linux the manager unlinks the segment once created and keeps its descriptor as the
+ *  shared_id, so the segment is opened through /proc/<shared_pid>/fd/<shared_id>, which
+ *  works between the processes of a user on the same host. Elsewhere it is opened by name.
+ */
+class SharedMemSegment {
+ public:
+  SharedMemSegment() = default;
+
+  ~SharedMemSegment() {
+#ifndef _WIN32
+    if (base_ != nullptr) munmap(base_, kHeaderSize + size_);
+#endif  // _WIN32
+  }
+
+  /*!
+   * \brief map the segment
+   * \param shared_pid the process which allocated it
+   * \param shared_id its id in that process
+   * \param size the size of the array in bytes, as in its storage handle
+   * \return false when it is not a segment of that process on this host
+   */
+  bool Open(int shared_pid, int shared_id, size_t size) {
+    CHECK(base_ == nullptr) << "shared memory segment already open";
+#ifdef _WIN32
+    return false;
+#else
+    std::ostringstream name;
+#ifdef __linux__
+    name << "/proc/" << shared_pid << "/fd/" << shared_id;
+    // only descriptors of segments of the manager are opened, as /dev/shm/mx_<pid>_<id>
+    char target[256];
+    const ssize_t len = readlink(name.str().c_str(), target, sizeof(target) - 1);
+    if (len < 0) return false;
+    target[len] = '\0';
+    if (std::strncmp(target, "/dev/shm/mx_", std::strlen("/dev/shm/mx_")) != 0) return false;
+    const int fd = open(name.str().c_str(), O_RDWR | O_NOCTTY);
+#else
+    name << "/mx_" << std::hex << shared_pid << "_" << std::hex << shared_id;
+    const int fd = shm_open(name.str().c_str(), O_RDWR, 0666);
+#endif  // __linux__
+    if (fd == -1) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        static_cast<size_t>(st.st_size) < kHeaderSize + size) {
+      close(fd);
+      return false;
+    }
+    void* ptr = mmap(nullptr, kHeaderSize + size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) return false;
+    base_ = static_cast<char*>(ptr);
+    size_ = size;
+    return true;
+#endif  // _WIN32
+  }
+
+  /*! \brief the memory of the array */
+  char* data() const { return base_ + kHeaderSize; }
+
+  /*! \brief the size of the array in bytes */
+  size_t size() const { return size_; }
+
+ private:
+  /*! \brief the reference count CPUSharedStorageManager puts before the array */
+  static constexpr size_t kHeaderSize = 16;
+
+  char* base_ = nullptr;
+  size_t size_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedMemSegment);
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_SHARED_MEM_H_
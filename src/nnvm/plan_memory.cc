@@ -28,7 +28,11 @@
 #include <nnvm/op_attr_types.h>
 #include <nnvm/top/tensor.h>
 #include <mxnet/base.h>
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include "graph_algorithm.h"
 #include "../operator/operator_common.h"
 
@@ -325,6 +329,121 @@ size_t AllocMemory(const Graph& ret, const IndexedGraph& idx,
   return num_not_allocated;
 }
 
+/*
+ * Place the storage blocks of each device into one arena. A block lives from
+ * the first node writing it to the last node reading it, graph outputs live
+ * until the end of the range. Largest blocks are placed first, each one into the
+ * smallest gap left between the placed blocks whose lifetimes overlap its own,
+ * or after all of them when no gap fits. Returns the total arena bytes.
+ */
+size_t PlanArenaOffsets(const Graph& ret, const IndexedGraph& idx,
+                        const std::pair<uint32_t, uint32_t>& node_range,
+                        const StorageVector& storage,
+                        std::vector<size_t>* storage_offset_ptr) {
+  static auto& fignore_inputs = Op::GetAttr<FIgnoreInputs>("FIgnoreInputs");
+  // offsets are aligned so that every block starts on a cache line
+  const size_t kAlignment = 64;
+  const mxnet::ShapeVector& shape_vec = ret.GetAttr<mxnet::ShapeVector>("shape");
+  const DTypeVector& dtype_vec = ret.GetAttr<DTypeVector>("dtype");
+  const DeviceVector* device_vec = nullptr;
+  if (ret.attrs.count("device") != 0) {
+    device_vec = &(ret.GetAttr<DeviceVector>("device"));
+  }
+
+  struct Block {
+    size_t bytes{0};
+    uint32_t first{std::numeric_limits<uint32_t>::max()};
+    uint32_t last{0};
+    int dev_id{0};
+  };
+  int num_blocks = 0;
+  for (int sid : storage) num_blocks = std::max(num_blocks, sid + 1);
+  std::vector<Block> blocks(num_blocks);
+  auto touch = [&](int sid, uint32_t nid) {
+    blocks[sid].first = std::min(blocks[sid].first, nid);
+    blocks[sid].last = std::max(blocks[sid].last, nid);
+  };
+  for (uint32_t nid = node_range.first; nid < node_range.second; ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable()) continue;
+    for (uint32_t index = 0; index < inode.source->num_outputs(); ++index) {
+      uint32_t eid = idx.entry_id(nid, index);
+      int sid = storage[eid];
+      if (sid < 0) continue;
+      size_t bytes = ndim_is_known(shape_vec[eid]) ?
+          shape_vec[eid].Size() * mshadow::mshadow_sizeof(dtype_vec[eid]) : 0;
+      blocks[sid].bytes = std::max(blocks[sid].bytes, bytes);
+      blocks[sid].dev_id = (device_vec != nullptr) ? device_vec->at(nid) : 0;
+      touch(sid, nid);
+    }
+    std::vector<uint32_t> ignore_inputs;
+    if (fignore_inputs.count(inode.source->op()) != 0) {
+      ignore_inputs = fignore_inputs[inode.source->op()](inode.source->attrs);
+      std::sort(ignore_inputs.begin(), ignore_inputs.end());
+    }
+    for (size_t i = 0; i < inode.inputs.size(); ++i) {
+      if (std::binary_search(ignore_inputs.begin(), ignore_inputs.end(), i)) continue;
+      const auto& e = inode.inputs[i];
+      int sid = storage[idx.entry_id(e)];
+      if (sid < 0) continue;
+      // written before the planned range
+      if (e.node_id < node_range.first) touch(sid, node_range.first);
+      touch(sid, nid);
+    }
+  }
+  // outputs are still read after the last node
+  for (const auto& e : idx.outputs()) {
+    int sid = storage[idx.entry_id(e)];
+    if (sid >= 0) touch(sid, node_range.second);
+  }
+
+  std::vector<int> order(num_blocks);
+  for (int sid = 0; sid < num_blocks; ++sid) order[sid] = sid;
+  std::sort(order.begin(), order.end(), [&blocks](int lhs, int rhs) {
+    if (blocks[lhs].bytes != blocks[rhs].bytes) return blocks[lhs].bytes > blocks[rhs].bytes;
+    return blocks[lhs].first < blocks[rhs].first;
+  });
+  auto& storage_offset = *storage_offset_ptr;
+  storage_offset.assign(num_blocks, 0);
+  std::unordered_map<int, size_t> arena_bytes;
+  std::vector<int> placed;
+  std::vector<std::pair<size_t, size_t> > busy;
+  auto aligned = [kAlignment](size_t bytes) {
+    return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+  };
+  for (int sid : order) {
+    const Block& b = blocks[sid];
+    const size_t size = aligned(b.bytes);
+    busy.clear();
+    for (int other : placed) {
+      const Block& o = blocks[other];
+      if (o.dev_id != b.dev_id || o.last < b.first || b.last < o.first) continue;
+      busy.emplace_back(storage_offset[other], storage_offset[other] + aligned(o.bytes));
+    }
+    std::sort(busy.begin(), busy.end());
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t end = 0;
+    for (const auto& range : busy) {
+      if (range.first > end) {
+        size_t gap = range.first - end;
+        if (gap >= size && gap < best_gap) {
+          best_offset = end;
+          best_gap = gap;
+        }
+      }
+      end = std::max(end, range.second);
+    }
+    if (best_offset == std::numeric_limits<size_t>::max()) best_offset = end;
+    storage_offset[sid] = best_offset;
+    arena_bytes[b.dev_id] = std::max(arena_bytes[b.dev_id], best_offset + size);
+    placed.push_back(sid);
+  }
+  size_t total = 0;
+  for (const auto& kv : arena_bytes) total += kv.second;
+  return total;
+}
+
 
 // function to plan memory
 Graph PlanMemory(Graph ret) {
@@ -369,6 +488,30 @@ Graph PlanMemory(Graph ret) {
     storage.resize(idx.num_node_entries(), -1);
   }
 
+  // The best-fit offset planner gives every buffer its own storage id, then
+  // packs the ids into one arena per device at the offsets "storage_offset".
+  std::string planner = "match_range";
+  if (ret.attrs.count("mem_planner") != 0) {
+    planner = ret.MoveCopyAttr<std::string>("mem_planner");
+  }
+  if (planner == "best_fit_offset") {
+    std::vector<int> storage_inplace_index(idx.num_node_entries(), -1);
+    GraphAllocator allocator(&idx, 0);
+    size_t storage_num_not_allocated =
+      AllocMemory(ret, idx, node_range, &storage, &storage_inplace_index,
+                  ref_count, &allocator);
+    std::vector<size_t> storage_offset;
+    size_t storage_allocated_bytes =
+      PlanArenaOffsets(ret, idx, node_range, storage, &storage_offset);
+    ret.attrs["storage_id"] = std::make_shared<any>(std::move(storage));
+    ret.attrs["storage_inplace_index"] = std::make_shared<any>(std::move(storage_inplace_index));
+    ret.attrs["storage_offset"] = std::make_shared<any>(std::move(storage_offset));
+    ret.attrs["storage_allocated_bytes"] = std::make_shared<any>(storage_allocated_bytes);
+    ret.attrs["storage_num_not_allocated"] = std::make_shared<any>(storage_num_not_allocated);
+    return ret;
+  }
+  CHECK_EQ(planner, "match_range") << "unknown memory planner " << planner;
+
   // Search the best NNVM_EXEC_MATCH_RANGE parameter. This is turned off by default
   size_t min_allocated_bytes = -1;
   size_t max_match_range = dmlc::GetEnv("NNVM_EXEC_MATCH_RANGE", 16);
@@ -0,0 +1,436 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file elemwise_fusion-inl.h
+ * \brief Fused CPU execution of chains of elementwise operators.
+ *
+ * A subgraph made of unary, binary, scalar and broadcast elementwise operators
+ * is compiled into a small register program. The fused operator walks the output
+ * in cache-sized blocks and evaluates the whole program per block, so the
+ * intermediate results never leave L1 and the inputs are read exactly once.
+ */
+#ifndef MXNET_OPERATOR_SUBGRAPH_ELEMWISE_FUSION_ELEMWISE_FUSION_INL_H_
+#define MXNET_OPERATOR_SUBGRAPH_ELEMWISE_FUSION_ELEMWISE_FUSION_INL_H_
+
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../../mshadow_op.h"
+#include "../../operator_common.h"
+#include "../../../engine/openmp.h"
+#include "../../nn/activation-inl.h"
+
+namespace mxnet {
+namespace op {
+namespace elemwise_fusion {
+
+/*! \brief instructions understood by the fused elementwise kernel */
+enum FusedOpCode {
+  // unary
+  kRelu, kSigmoid, kTanh, kSoftReLU, kExp, kLog, kSqrt, kSquare, kAbs, kNegative,
+  // binary, the right hand side may be a scalar
+  kAdd, kSub, kMul, kDiv, kRSub, kRDiv, kPower, kMaximum, kMinimum
+};
+
+/*! \brief number of elements of the innermost dimension evaluated per block */
+const index_t kBlockSize = 256;
+/*! \brief minimum number of blocks handed to one OpenMP thread */
+const index_t kMinBlocksPerThread = 16;
+
+inline bool IsUnaryOpCode(int code) {
+  return code <= kNegative;
+}
+
+/*!
+ * \brief Returns the instruction implementing the operator of node, or -1 if the
+ *        node cannot be fused. is_scalar is set for the *_scalar operators.
+ */
+inline int FusibleOpCode(const nnvm::Node& node, bool* is_scalar) {
+  static const std::unordered_map<std::string, int> unary_ops = {
+    {"relu", kRelu}, {"sigmoid", kSigmoid}, {"tanh", kTanh}, {"exp", kExp},
+    {"log", kLog}, {"sqrt", kSqrt}, {"square", kSquare}, {"abs", kAbs},
+    {"negative", kNegative}
+  };
+  static const std::unordered_map<std::string, int> binary_ops = {
+    {"elemwise_add", kAdd}, {"elemwise_sub", kSub}, {"elemwise_mul", kMul},
+    {"elemwise_div", kDiv}, {"_maximum", kMaximum}, {"_minimum", kMinimum},
+    {"broadcast_add", kAdd}, {"broadcast_sub", kSub}, {"broadcast_mul", kMul},
+    {"broadcast_div", kDiv}, {"broadcast_maximum", kMaximum},
+    {"broadcast_minimum", kMinimum}, {"broadcast_power", kPower}
+  };
+  static const std::unordered_map<std::string, int> scalar_ops = {
+    {"_plus_scalar", kAdd}, {"_minus_scalar", kSub}, {"_rminus_scalar", kRSub},
+    {"_mul_scalar", kMul}, {"_div_scalar", kDiv}, {"_rdiv_scalar", kRDiv},
+    {"_power_scalar", kPower}, {"_maximum_scalar", kMaximum},
+    {"_minimum_scalar", kMinimum}
+  };
+  *is_scalar = false;
+  if (node.is_variable() || node.num_outputs() != 1) return -1;
+  const std::string& name = node.op()->name;
+  if (name == "Activation") {
+    switch (nnvm::get<ActivationParam>(node.attrs.parsed).act_type) {
+      case activation::kReLU: return kRelu;
+      case activation::kSigmoid: return kSigmoid;
+      case activation::kTanh: return kTanh;
+      case activation::kSoftReLU: return kSoftReLU;
+      default: return -1;
+    }
+  }
+  auto it = unary_ops.find(name);
+  if (it != unary_ops.end()) return it->second;
+  it = binary_ops.find(name);
+  if (it != binary_ops.end()) return it->second;
+  it = scalar_ops.find(name);
+  if (it != scalar_ops.end()) {
+    *is_scalar = true;
+    return it->second;
+  }
+  return -1;
+}
+
+/*! \brief one step of a fused program: out = opcode(lhs, rhs or scalar) */
+struct FusedInstruction {
+  int opcode;
+  uint32_t lhs;
+  /*! \brief register of the right hand side, or -1 for scalar operators */
+  int rhs;
+  double scalar;
+  uint32_t out;
+};
+
+/*!
+ * \brief Register program equivalent to a subgraph of elementwise operators.
+ *        Registers are the node entries of the subgraph; the subgraph inputs
+ *        map to input_regs in the order of the fused node inputs.
+ */
+struct FusedElemwiseProgram {
+  uint32_t num_regs;
+  std::vector<uint32_t> input_regs;
+  std::vector<uint32_t> output_regs;
+  std::vector<FusedInstruction> instrs;
+};
+
+inline FusedElemwiseProgram CompileFusedElemwise(const nnvm::Symbol& sym) {
+  nnvm::Graph g;
+  g.outputs = sym.outputs;
+  const auto& idx = g.indexed_graph();
+  FusedElemwiseProgram prog;
+  prog.num_regs = idx.num_node_entries();
+  for (const uint32_t nid : idx.input_nodes()) {
+    prog.input_regs.push_back(idx.entry_id(nid, 0));
+  }
+  for (const auto& e : idx.outputs()) {
+    prog.output_regs.push_back(idx.entry_id(e));
+  }
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable()) continue;
+    bool is_scalar = false;
+    FusedInstruction instr;
+    instr.opcode = FusibleOpCode(*inode.source, &is_scalar);
+    CHECK_GE(instr.opcode, 0) << "Operator " << inode.source->op()->name
+                              << " cannot be fused into _sg_elemwise_fusion";
+    instr.lhs = idx.entry_id(inode.inputs[0]);
+    instr.rhs = -1;
+    instr.scalar = 0;
+    if (is_scalar) {
+      instr.scalar = nnvm::get<double>(inode.source->attrs.parsed);
+    } else if (!IsUnaryOpCode(instr.opcode)) {
+      CHECK_EQ(inode.inputs.size(), 2U);
+      instr.rhs = static_cast<int>(idx.entry_id(inode.inputs[1]));
+    }
+    instr.out = idx.entry_id(nid, 0);
+    prog.instrs.push_back(instr);
+  }
+  return prog;
+}
+
+/*! \brief a block of a register: either block-length data or a single broadcast value */
+template<typename DType>
+struct FusedOperand {
+  const DType* ptr;
+  bool vec;
+};
+
+template<typename OP, typename DType>
+inline bool FusedApplyUnary(const FusedOperand<DType>& a, DType* out, const index_t n) {
+  if (!a.vec) {
+    out[0] = OP::Map(a.ptr[0]);
+    return false;
+  }
+  for (index_t j = 0; j < n; ++j) out[j] = OP::Map(a.ptr[j]);
+  return true;
+}
+
+template<typename OP, typename DType>
+inline bool FusedApplyBinary(const FusedOperand<DType>& a, const FusedOperand<DType>& b,
+                             DType* out, const index_t n) {
+  if (a.vec && b.vec) {
+    for (index_t j = 0; j < n; ++j) out[j] = OP::Map(a.ptr[j], b.ptr[j]);
+  } else if (a.vec) {
+    const DType bv = b.ptr[0];
+    for (index_t j = 0; j < n; ++j) out[j] = OP::Map(a.ptr[j], bv);
+  } else if (b.vec) {
+    const DType av = a.ptr[0];
+    for (index_t j = 0; j < n; ++j) out[j] = OP::Map(av, b.ptr[j]);
+  } else {
+    out[0] = OP::Map(a.ptr[0], b.ptr[0]);
+    return false;
+  }
+  return true;
+}
+
+/*! \brief evaluates one instruction over a block, returns whether the result varies */
+template<typename DType>
+inline bool FusedExecute(const int opcode, const FusedOperand<DType>& a,
+                         const FusedOperand<DType>& b, DType* out, const index_t n) {
+  switch (opcode) {
+    case kRelu: return FusedApplyUnary<mshadow_op::relu>(a, out, n);
+    case kSigmoid: return FusedApplyUnary<mshadow_op::sigmoid>(a, out, n);
+    case kTanh: return FusedApplyUnary<mshadow_op::tanh>(a, out, n);
+    case kSoftReLU: return FusedApplyUnary<mshadow_op::softrelu>(a, out, n);
+    case kExp: return FusedApplyUnary<mshadow_op::exp>(a, out, n);
+    case kLog: return FusedApplyUnary<mshadow_op::log>(a, out, n);
+    case kSqrt: return FusedApplyUnary<mshadow_op::square_root>(a, out, n);
+    case kSquare: return FusedApplyUnary<mshadow_op::square>(a, out, n);
+    case kAbs: return FusedApplyUnary<mshadow_op::abs>(a, out, n);
+    case kNegative: return FusedApplyUnary<mshadow_op::negation>(a, out, n);
+    case kAdd: return FusedApplyBinary<mshadow_op::plus>(a, b, out, n);
+    case kSub: return FusedApplyBinary<mshadow_op::minus>(a, b, out, n);
+    case kMul: return FusedApplyBinary<mshadow_op::mul>(a, b, out, n);
+    case kDiv: return FusedApplyBinary<mshadow_op::div>(a, b, out, n);
+    case kRSub: return FusedApplyBinary<mshadow_op::rminus>(a, b, out, n);
+    case kRDiv: return FusedApplyBinary<mshadow_op::rdiv>(a, b, out, n);
+    case kPower: return FusedApplyBinary<mshadow_op::power>(a, b, out, n);
+    case kMaximum: return FusedApplyBinary<mshadow_op::maximum>(a, b, out, n);
+    case kMinimum: return FusedApplyBinary<mshadow_op::minimum>(a, b, out, n);
+    default:
+      LOG(FATAL) << "Unknown fused elementwise instruction " << opcode;
+  }
+  return false;
+}
+
+/*!
+ * \brief Iteration space of one pass: the coalesced output shape plus, for every
+ *        fused input, its element strides in that space (0 along broadcast axes).
+ */
+struct FusedIterSpace {
+  std::vector<index_t> shape;
+  std::vector<std::vector<index_t> > strides;
+  std::vector<bool> used;
+
+  FusedIterSpace(const mxnet::TShape& oshape, const std::vector<TBlob>& inputs,
+                 const std::vector<bool>& used_inputs) : used(used_inputs) {
+    const int ndim = oshape.ndim();
+    std::vector<std::vector<index_t> > full(inputs.size(), std::vector<index_t>(ndim, 0));
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (!used[i]) continue;
+      const mxnet::TShape& ishape = inputs[i].shape_;
+      CHECK_LE(ishape.ndim(), ndim) << "Input " << i << " of _sg_elemwise_fusion with shape "
+                                    << ishape << " cannot broadcast to " << oshape;
+      index_t stride = 1;
+      for (int d = ndim - 1, k = ishape.ndim() - 1; k >= 0; --d, --k) {
+        CHECK(ishape[k] == oshape[d] || ishape[k] == 1)
+          << "Input " << i << " of _sg_elemwise_fusion with shape " << ishape
+          << " cannot broadcast to " << oshape;
+        full[i][d] = ishape[k] == oshape[d] ? stride : 0;
+        stride *= ishape[k];
+      }
+    }
+    strides.resize(inputs.size());
+    for (int d = 0; d < ndim; ++d) {
+      if (oshape[d] == 1) continue;
+      bool merge = !shape.empty();
+      for (size_t i = 0; merge && i < inputs.size(); ++i) {
+        if (used[i] && strides[i].back() != full[i][d] * oshape[d]) merge = false;
+      }
+      if (merge) {
+        shape.back() *= oshape[d];
+        for (size_t i = 0; i < inputs.size(); ++i) {
+          if (used[i]) strides[i].back() = full[i][d];
+        }
+      } else {
+        shape.push_back(oshape[d]);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+          if (used[i]) strides[i].push_back(full[i][d]);
+        }
+      }
+    }
+    if (shape.empty()) {
+      shape.push_back(1);
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        if (used[i]) strides[i].push_back(0);
+      }
+    }
+  }
+
+  index_t inner() const { return shape.back(); }
+  index_t outer() const {
+    index_t ret = 1;
+    for (size_t d = 0; d + 1 < shape.size(); ++d) ret *= shape[d];
+    return ret;
+  }
+  /*! \brief element offset of input i at outer position o and inner position s */
+  index_t Offset(const size_t i, index_t o, const index_t s) const {
+    const std::vector<index_t>& st = strides[i];
+    index_t off = s * st.back();
+    for (int d = static_cast<int>(shape.size()) - 2; d >= 0 && o != 0; --d) {
+      off += (o % shape[d]) * st[d];
+      o /= shape[d];
+    }
+    return off;
+  }
+};
+
+/*! \brief Stateful fused operator executing a FusedElemwiseProgram on CPU */
+class FusedElemwiseOp {
+ public:
+  explicit FusedElemwiseOp(const nnvm::NodeAttrs& attrs)
+    : prog_(CompileFusedElemwise(*attrs.subgraphs[0])) {}
+
+  void Forward(const OpContext& ctx,
+               const std::vector<TBlob>& inputs,
+               const std::vector<OpReqType>& req,
+               const std::vector<TBlob>& outputs) {
+    CHECK_EQ(inputs.size(), prog_.input_regs.size());
+    CHECK_EQ(outputs.size(), prog_.output_regs.size());
+    // outputs of equal shape are produced by the same pass over memory
+    std::vector<bool> done(outputs.size(), false);
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      if (done[i]) continue;
+      std::vector<size_t> group;
+      for (size_t j = i; j < outputs.size(); ++j) {
+        if (!done[j] && outputs[j].shape_ == outputs[i].shape_) {
+          group.push_back(j);
+          done[j] = true;
+        }
+      }
+      // integer types only reach here from graphs partitioned before their types were
+      // known, such as by get_backend_symbol, and are evaluated like the original operators
+      MSHADOW_TYPE_SWITCH(outputs[i].type_flag_, DType, {
+        RunPass<DType>(ctx, inputs, req, outputs, group);
+      });
+    }
+  }
+
+ private:
+  template<typename DType>
+  void RunPass(const OpContext& ctx,
+               const std::vector<TBlob>& inputs,
+               const std::vector<OpReqType>& req,
+               const std::vector<TBlob>& outputs,
+               const std::vector<size_t>& group) {
+    // instructions and inputs reachable from the outputs of this pass
+    std::vector<bool> live(prog_.num_regs, false);
+    std::vector<OpReqType> out_req;
+    std::vector<DType*> out_ptr;
+    std::vector<uint32_t> out_reg;
+    for (const size_t j : group) {
+      if (req[j] == kNullOp) continue;
+      CHECK_EQ(outputs[j].type_flag_, outputs[group[0]].type_flag_);
+      live[prog_.output_regs[j]] = true;
+      out_req.push_back(req[j]);
+      out_ptr.push_back(outputs[j].dptr<DType>());
+      out_reg.push_back(prog_.output_regs[j]);
+    }
+    if (out_reg.empty() || outputs[group[0]].Size() == 0) return;
+    std::vector<const FusedInstruction*> instrs;
+    for (auto it = prog_.instrs.rbegin(); it != prog_.instrs.rend(); ++it) {
+      if (!live[it->out]) continue;
+      live[it->lhs] = true;
+      if (it->rhs >= 0) live[it->rhs] = true;
+      instrs.push_back(&*it);
+    }
+    std::reverse(instrs.begin(), instrs.end());
+    std::vector<bool> used(inputs.size(), false);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      used[i] = live[prog_.input_regs[i]];
+      if (used[i]) CHECK_EQ(inputs[i].type_flag_, outputs[group[0]].type_flag_);
+    }
+    std::vector<DType> scalars(instrs.size());
+    for (size_t k = 0; k < instrs.size(); ++k) scalars[k] = DType(instrs[k]->scalar);
+
+    const FusedIterSpace space(outputs[group[0]].shape_, inputs, used);
+    const index_t inner = space.inner();
+    const index_t blocks_per_row = (inner + kBlockSize - 1) / kBlockSize;
+    const index_t num_blocks = space.outer() * blocks_per_row;
+    // give every thread at least kMinBlocksPerThread blocks of work
+    const int nthreads = static_cast<int>(std::max<index_t>(1, std::min<index_t>(
+        engine::OpenMP::Get()->GetRecommendedOMPThreadCount(),
+        num_blocks / kMinBlocksPerThread)));
+    const size_t scratch_per_thread = static_cast<size_t>(prog_.num_regs) * kBlockSize;
+    DType* scratch = ctx.requested[0].get_space_typed<cpu, 1, DType>(
+        mshadow::Shape1(scratch_per_thread * nthreads), ctx.get_stream<cpu>()).dptr_;
+
+    #pragma omp parallel for num_threads(nthreads)
+    for (int tid = 0; tid < nthreads; ++tid) {
+      const int64_t blocks = num_blocks;
+      const index_t begin = static_cast<index_t>(blocks * tid / nthreads);
+      const index_t end = static_cast<index_t>(blocks * (tid + 1) / nthreads);
+      DType* buf = scratch + scratch_per_thread * tid;
+      std::vector<FusedOperand<DType> > regs(prog_.num_regs);
+      for (index_t blk = begin; blk < end; ++blk) {
+        const index_t o = blk / blocks_per_row;
+        const index_t s = (blk % blocks_per_row) * kBlockSize;
+        const index_t n = std::min(kBlockSize, inner - s);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+          if (!used[i]) continue;
+          FusedOperand<DType>& r = regs[prog_.input_regs[i]];
+          r.ptr = inputs[i].dptr<DType>() + space.Offset(i, o, s);
+          r.vec = space.strides[i].back() != 0;
+        }
+        for (size_t k = 0; k < instrs.size(); ++k) {
+          const FusedInstruction& instr = *instrs[k];
+          const FusedOperand<DType> rhs = instr.rhs >= 0 ? regs[instr.rhs]
+                                                         : FusedOperand<DType>{&scalars[k], false};
+          DType* dst = buf + static_cast<size_t>(instr.out) * kBlockSize;
+          regs[instr.out].vec = FusedExecute(instr.opcode, regs[instr.lhs], rhs, dst, n);
+          regs[instr.out].ptr = dst;
+        }
+        for (size_t j = 0; j < out_reg.size(); ++j) {
+          const FusedOperand<DType>& r = regs[out_reg[j]];
+          DType* dst = out_ptr[j] + o * inner + s;
+          if (out_req[j] == kAddTo) {
+            if (r.vec) {
+              for (index_t e = 0; e < n; ++e) dst[e] += r.ptr[e];
+            } else {
+              for (index_t e = 0; e < n; ++e) dst[e] += r.ptr[0];
+            }
+          } else if (r.vec) {
+            std::copy(r.ptr, r.ptr + n, dst);
+          } else {
+            std::fill(dst, dst + n, r.ptr[0]);
+          }
+        }
+      }
+    }
+  }
+
+  FusedElemwiseProgram prog_;
+};
+
+}  // namespace elemwise_fusion
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_SUBGRAPH_ELEMWISE_FUSION_ELEMWISE_FUSION_INL_H_
@@ -0,0 +1,147 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file elemwise_fusion.cc
+ * \brief _sg_elemwise_fusion operator executing a fused chain of elementwise operators
+ */
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "./elemwise_fusion-inl.h"
+#include "../common.h"
+#include "../../../executor/exec_pass.h"
+#include "../../../executor/graph_executor.h"
+
+namespace mxnet {
+namespace op {
+namespace elemwise_fusion {
+
+static bool FusedElemwiseStorageType(const nnvm::NodeAttrs& attrs,
+                                     const int dev_mask,
+                                     DispatchMode* dispatch_mode,
+                                     std::vector<int>* in_attrs,
+                                     std::vector<int>* out_attrs) {
+  bool dispatched = false;
+  if (common::ContainsOnlyStorage(*in_attrs, kDefaultStorage)) {
+    dispatched = storage_type_assign(out_attrs, kDefaultStorage,
+                                     dispatch_mode, DispatchMode::kFCompute);
+  }
+  if (!dispatched) {
+    dispatched = dispatch_fallback(out_attrs, dispatch_mode);
+  }
+  return dispatched;
+}
+
+static OpStatePtr CreateFusedElemwiseState(const nnvm::NodeAttrs& attrs,
+                                           Context ctx,
+                                           const mxnet::ShapeVector& in_shapes,
+                                           const std::vector<int>& in_types) {
+  return OpStatePtr::Create<FusedElemwiseOp>(attrs);
+}
+
+static void FusedElemwiseForward(const OpStatePtr& state_ptr,
+                                 const OpContext& ctx,
+                                 const std::vector<TBlob>& inputs,
+                                 const std::vector<OpReqType>& req,
+                                 const std::vector<TBlob>& outputs) {
+  FusedElemwiseOp& op = state_ptr.get_state<FusedElemwiseOp>();
+  op.Forward(ctx, inputs, req, outputs);
+}
+
+/*!
+ * \brief The gradient of a fused node is the gradient of the subgraph it replaced.
+ *        The subgraph is copied, differentiated with respect to its inputs and spliced
+ *        onto the inputs of the fused node, so the backward pass recomputes the
+ *        unfused forward chain it needs.
+ */
+static std::vector<nnvm::NodeEntry> FusedElemwiseGradient(
+    const nnvm::NodePtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+  static const std::vector<const Op*> zero_ops{Op::Get("zeros_like"), Op::Get("_zeros")};
+  nnvm::Symbol sym = n->attrs.subgraphs[0]->Copy();
+  nnvm::Graph g;
+  g.outputs = sym.outputs;
+  const auto& idx = g.indexed_graph();
+  std::vector<nnvm::NodeEntry> xs;
+  std::unordered_map<const nnvm::Node*, nnvm::NodeEntry> var_map;
+  CHECK_EQ(idx.input_nodes().size(), n->inputs.size());
+  for (size_t i = 0; i < idx.input_nodes().size(); ++i) {
+    nnvm::NodePtr var = idx[idx.input_nodes()[i]].weak_ref.lock();
+    var_map[var.get()] = n->inputs[i];
+    xs.emplace_back(var);
+  }
+  nnvm::Graph grad_g = nnvm::pass::MXGradient(
+      g, g.outputs, xs, ograds, exec::AggregateGradient, nullptr, nullptr,
+      zero_ops, "_copy");
+
+  // rewire the subgraph variables to the inputs of the fused node, without
+  // descending into the surrounding graph behind the output gradients
+  std::unordered_set<const nnvm::Node*> visited;
+  for (const auto& e : ograds) visited.insert(e.node.get());
+  std::vector<nnvm::Node*> stack;
+  std::vector<nnvm::NodeEntry> ret = grad_g.outputs;
+  for (auto& e : ret) {
+    auto it = var_map.find(e.node.get());
+    if (it != var_map.end()) {
+      e = it->second;
+    } else if (visited.insert(e.node.get()).second) {
+      stack.push_back(e.node.get());
+    }
+  }
+  while (!stack.empty()) {
+    nnvm::Node* node = stack.back();
+    stack.pop_back();
+    for (auto& e : node->inputs) {
+      auto it = var_map.find(e.node.get());
+      if (it != var_map.end()) {
+        e = it->second;
+      } else if (visited.insert(e.node.get()).second) {
+        stack.push_back(e.node.get());
+      }
+    }
+    for (auto& dep : node->control_deps) {
+      if (visited.insert(dep.get()).second) stack.push_back(dep.get());
+    }
+  }
+  return ret;
+}
+
+}  // namespace elemwise_fusion
+
+NNVM_REGISTER_OP(_sg_elemwise_fusion)
+.describe(R"code(Fused chain of elementwise operators, executed in a single pass
+over memory on CPU. Created by the ELEMWISE_FUSION subgraph backend.)code" ADD_FILELINE)
+.set_num_inputs(DefaultSubgraphOpNumInputs)
+.set_num_outputs(DefaultSubgraphOpNumOutputs)
+.set_attr<nnvm::FListInputNames>("FListInputNames", DefaultSubgraphOpListInputs)
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", DefaultSubgraphOpListOutputs)
+.set_attr<mxnet::FInferShape>("FInferShape", DefaultSubgraphOpShape)
+.set_attr<nnvm::FInferType>("FInferType", DefaultSubgraphOpType)
+.set_attr<FInferStorageType>("FInferStorageType", elemwise_fusion::FusedElemwiseStorageType)
+.set_attr<FCreateOpState>("FCreateOpState", elemwise_fusion::CreateFusedElemwiseState)
+.set_attr<FStatefulCompute>("FStatefulCompute<cpu>", elemwise_fusion::FusedElemwiseForward)
+.set_attr<nnvm::FGradient>("FGradient", elemwise_fusion::FusedElemwiseGradient)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+});
+
+}  // namespace op
+}  // namespace mxnet
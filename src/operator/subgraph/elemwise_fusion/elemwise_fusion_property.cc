@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file elemwise_fusion_property.cc
+ * \brief Subgraph property grouping chains of elementwise operators into _sg_elemwise_fusion
+ */
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "./elemwise_fusion-inl.h"
+#include "../common.h"
+#include "../subgraph_property.h"
+
+namespace mxnet {
+namespace op {
+
+/*
+ * This selects connected elementwise operators that the fused kernel can
+ * execute. When the graph carries device placement and types, nodes placed
+ * off CPU, or with outputs of other than floating point types, are left out
+ * since _sg_elemwise_fusion only has a CPU implementation and only speeds up
+ * real types. Graphs without types are partitioned regardless, and the fused
+ * kernel evaluates the integer chains among them like the original operators.
+ */
+class ElemwiseFusionSelector : public SubgraphSelector {
+ public:
+  explicit ElemwiseFusionSelector(std::unordered_set<const nnvm::Node*> excluded_nodes)
+    : excluded_nodes_(std::move(excluded_nodes)) {}
+
+  bool Select(const nnvm::Node &seed_node) override {
+    return Fusible(seed_node);
+  }
+
+  bool SelectInput(const nnvm::Node &cur_node, const nnvm::Node &input_node) override {
+    return Fusible(input_node);
+  }
+
+  bool SelectOutput(const nnvm::Node &cur_node, const nnvm::Node &output_node) override {
+    return Fusible(output_node);
+  }
+
+  std::vector<nnvm::Node*> Filter(const std::vector<nnvm::Node*>& candidates) override {
+    // a single operator gains nothing from fusion
+    if (candidates.size() < 2) return std::vector<nnvm::Node*>();
+    return candidates;
+  }
+
+ private:
+  bool Fusible(const nnvm::Node &node) const {
+    bool is_scalar = false;
+    return !node.is_variable() && !excluded_nodes_.count(&node) &&
+           elemwise_fusion::FusibleOpCode(node, &is_scalar) >= 0;
+  }
+
+  std::unordered_set<const nnvm::Node*> excluded_nodes_;
+};
+
+/*
+ * This subgraph property replaces every chain of elementwise operators by a
+ * single _sg_elemwise_fusion node which evaluates the chain in one pass over
+ * memory. The original chain is kept as the subgraph of the fused node, so
+ * the partitioned graph can be serialized and differentiated.
+ */
+class ElemwiseFusionProperty : public SubgraphProperty {
+ public:
+  ElemwiseFusionProperty() {
+    SetAttr<std::string>("property_name", "CPU elementwise fusion");
+  }
+
+  static SubgraphPropertyPtr Create() {
+    return std::make_shared<ElemwiseFusionProperty>();
+  }
+
+  nnvm::NodePtr CreateSubgraphNode(const nnvm::Symbol &sym,
+                                   const int subgraph_id = 0) const override {
+    nnvm::NodePtr n = nnvm::Node::Create();
+    n->attrs.op = Op::Get("_sg_elemwise_fusion");
+    n->attrs.name = "_sg_elemwise_fusion" + std::to_string(subgraph_id);
+    n->attrs.subgraphs.push_back(std::make_shared<nnvm::Symbol>(sym));
+    return n;
+  }
+
+  SubgraphSelectorPtr CreateSubgraphSelector() const override {
+    // the property is shared by all the graphs partitioned, so the nodes
+    // excluded are found in the graph being partitioned every time
+    std::unordered_set<const nnvm::Node*> excluded_nodes;
+    if (HasAttr("graph")) {
+      const nnvm::Graph& g = GetAttr<nnvm::Graph>("graph");
+      const auto& idx = g.indexed_graph();
+      if (g.HasAttr("context")) {
+        const auto& vctx = g.GetAttr<std::vector<Context> >("context");
+        for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+          if (vctx[nid].dev_mask() != Context::kCPU) excluded_nodes.insert(idx[nid].source);
+        }
+      }
+      if (g.HasAttr("dtype")) {
+        const auto& vtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+        for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+          const nnvm::Node* node = idx[nid].source;
+          for (uint32_t i = 0; i < node->num_outputs(); ++i) {
+            const int dtype = vtype[idx.entry_id(nid, i)];
+            if (dtype != mshadow::kFloat32 && dtype != mshadow::kFloat64 &&
+                dtype != mshadow::kFloat16) {
+              excluded_nodes.insert(node);
+            }
+          }
+        }
+      }
+    }
+    return std::make_shared<ElemwiseFusionSelector>(std::move(excluded_nodes));
+  }
+};
+
+MXNET_REGISTER_SUBGRAPH_PROPERTY(ELEMWISE_FUSION, ElemwiseFusionProperty);
+
+}  // namespace op
+}  // namespace mxnet
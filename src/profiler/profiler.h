@@ -1204,6 +1204,35 @@ struct ProfileOperator : public ProfileEvent {
       ProfileEvent::stop();
     }
   }
+  /*!
+   * \brief Set how the operator waited on its dependencies before starting
+   * \param push_time Time when the operator was pushed to the engine
+   * \param ready_time Time when all dependencies of the operator were satisfied
+   * \param ready_var The var whose completion made the operator ready, nullptr if it was
+   *        ready when pushed
+   * \param ready_opr_name Name of the operator that completed ready_var
+   */
+  void set_dependency_info(uint64_t push_time, uint64_t ready_time,
+                           const void *ready_var, const char *ready_opr_name) {
+    dep_info_.push_time_ = push_time;
+    dep_info_.ready_time_ = ready_time;
+    dep_info_.ready_var_ = ready_var;
+    dep_info_.ready_opr_name_.set(ready_opr_name ? ready_opr_name : "");
+  }
+
+  /*!
+   * \brief Dependency wait information of an operator
+   */
+  struct DependencyInfo {
+    /*! \brief time when the operator was pushed, 0 if unknown */
+    uint64_t push_time_ = 0;
+    /*! \brief time when all dependencies of the operator were satisfied */
+    uint64_t ready_time_ = 0;
+    /*! \brief the var which was last to unblock the operator */
+    const void *ready_var_ = nullptr;
+    /*! \brief name of the operator that completed ready_var_ */
+    profile_stat_string ready_opr_name_;
+  };
 
   /*!
    * \brief Operation execution statistics
@@ -1219,10 +1248,14 @@ struct ProfileOperator : public ProfileEvent {
      */
     inline OprExecStat(const char *name, mxnet::Context::DeviceType dev_type, uint32_t dev_id,
                        uint64_t start_time, uint64_t stop_time,
-                       const Attributes *attributes)
+                       const Attributes *attributes,
+                       const DependencyInfo *dep_info = nullptr)
       : DurationStat(ProfileStat::kDurationBegin, ProfileStat::kDurationEnd)
         , dev_type_(dev_type)
         , dev_id_(dev_id) {
+      if (dep_info) {
+        dep_info_ = *dep_info;
+      }
       name_.set(name);
       if (attributes) {
         name_.append(attributes->to_string().c_str());
@@ -1235,10 +1268,34 @@ struct ProfileOperator : public ProfileEvent {
       items_[kStart].timestamp_ = start_time;
       items_[kStop].timestamp_ = stop_time;
     }
+    /*!
+     * \brief Emit how long the operator waited for its dependencies, and in the ready
+     *        queue, in the args of the begin event
+     * \param os Output stream to write data to
+     * \param idx Sub-even index (index into items_) to write
+     */
+    void EmitExtra(std::ostream *os, size_t idx) override {
+      DurationStat::EmitExtra(os, idx);
+      if (idx != kStart || !dep_info_.push_time_) {
+        return;
+      }
+      const uint64_t start_time = items_[kStart].timestamp_;
+      *os << "        \"args\": {\n"
+          << "            \"push_ts\": " << dep_info_.push_time_ << ",\n"
+          << "            \"ready_ts\": " << dep_info_.ready_time_ << ",\n"
+          << "            \"dependency_wait_us\": "
+          << dep_info_.ready_time_ - dep_info_.push_time_ << ",\n"
+          << "            \"queue_wait_us\": " << start_time - dep_info_.ready_time_ << ",\n"
+          << "            \"unblocked_by_var\": \"" << dep_info_.ready_var_ << "\",\n"
+          << "            \"unblocked_by_op\": \"" << dep_info_.ready_opr_name_.c_str() << "\"\n"
+          << "        },\n";
+    }
     /*! \brief device type: CPU: 1, GPU: 2, CPUPinned: 3 */
     mxnet::Context::DeviceType dev_type_;
     /*! \brief device id */
     uint32_t dev_id_;
+    /*! \brief dependency wait information */
+    DependencyInfo dep_info_;
   };
 
  private:
@@ -1249,7 +1306,7 @@ struct ProfileOperator : public ProfileEvent {
     Profiler::Get()->AddNewProfileStat<OprExecStat>(
       [this](OprExecStat *stat) {}, name_.c_str(), dev_type_, dev_id_,
       start_time_, ProfileStat::NowInMicrosec(),
-      attributes_.get());
+      attributes_.get(), &dep_info_);
   }
   /*!
    * \brief Check if this operator is no longer profiled
@@ -1277,6 +1334,8 @@ struct ProfileOperator : public ProfileEvent {
   static ProfileDomain domain_;
   /*! \brief Optional operator attributes */
   std::unique_ptr<Attributes> attributes_;
+  /*! \brief Dependency wait information */
+  DependencyInfo dep_info_;
   /*! \brief Whether to profile or not */
   const bool profiling_;
 };
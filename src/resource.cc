@@ -171,6 +171,27 @@ class ResourceManagerImpl : public ResourceManager {
     return ret;
   }
 
+  Resource RequestPrivateSpace(Context ctx) override {
+    Resource ret;
+    ret.req = ResourceRequest(ResourceRequest::kTempSpace);
+    ret.var = Engine::Get()->NewVariable();
+    ret.id = -1;
+    SpaceAllocator *space = new SpaceAllocator();
+    space->ctx = ctx;
+    ret.ptr_ = space;
+    return ret;
+  }
+
+  void FreePrivateSpace(const Resource &res) override {
+    CHECK_EQ(res.req.type, ResourceRequest::kTempSpace);
+    SpaceAllocator *space = static_cast<SpaceAllocator*>(res.ptr_);
+    Engine::Get()->DeleteVariable(
+        [space](RunContext rctx) {
+          MSHADOW_CATCH_ERROR(space->ReleaseAll());
+          delete space;
+        }, space->ctx, res.var);
+  }
+
   void SeedRandom(uint32_t seed) override {
     global_seed_ = seed;
     cpu_rand_->SeedWithDeviceID(global_seed_);
@@ -29,6 +29,7 @@
 #include <cstdlib>
 #include <new>
 #include "mxnet/base.h"
+#include "../common/numa.h"
 
 namespace mxnet {
 namespace storage {
@@ -67,6 +68,19 @@ inline void CPUDeviceStorage::Alloc(Storage::Handle* handle) {
   const size_t size = handle->size;
   if (size == 0) return;
 
+#if !_MSC_VER
+  // In NUMA mode, bind allocations spanning at least one page to the node of the
+  // context. Smaller ones rely on first-touch by the pinned worker threads.
+  const size_t page_size = common::numa::PageSize();
+  if (size >= page_size && common::numa::Enabled()) {
+    int ret = posix_memalign(&handle->dptr, page_size, size);
+    if (ret != 0) LOG(FATAL) << "Failed to allocate CPU Memory";
+    common::numa::BindMemoryToNode(handle->dptr, size,
+                                   common::numa::NodeOfDevice(handle->ctx.dev_id));
+    return;
+  }
+#endif
+
 #if _MSC_VER
   handle->dptr = _aligned_malloc(size, alignment_);
   if (handle->dptr == nullptr) LOG(FATAL) << "Failed to allocate CPU Memory";
@@ -33,10 +33,13 @@
 #include <mxnet/storage.h>
 #include <unordered_map>
 #include <algorithm>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <mutex>
 #include <new>
 #include "./storage_manager.h"
+#include "./cpu_device_storage.h"
 #include "../common/cuda_utils.h"
 #include "../common/utils.h"
 
@@ -367,6 +370,257 @@ void GPUPooledRoundedStorageManager::ReleaseAll() {
 
 #endif  // MXNET_USE_CUDA
 
+/*!
+ * \brief Storage manager with a size-class memory pool on cpu.
+ *
+ * Requested sizes are rounded to size classes in the same way as
+ * GPUPooledRoundedStorageManager: nearest pow2 up to 2^cutoff, then nearest multiple
+ * of 2^cutoff. Freed chunks are first kept in a small per-thread cache, so that the
+ * common alloc/free churn of short-lived intermediates on the same worker thread
+ * does not touch any shared lock. Chunks that do not fit in the thread cache go to a
+ * shared pool guarded by a mutex. The total number of bytes retained by the pool
+ * (thread caches included) is capped by MXNET_CPU_MEM_POOL_MAX_CACHED_MB; chunks
+ * freed beyond the cap are returned to the system immediately.
+ */
+class CPUPooledStorageManager final : public StorageManager {
+ public:
+  /*!
+   * \brief Default constructor.
+   */
+  CPUPooledStorageManager() : id_(NextId()) {
+    page_size_ = dmlc::GetEnv("MXNET_CPU_MEM_POOL_PAGE_SIZE", 4096);
+    cut_off_ = dmlc::GetEnv("MXNET_CPU_MEM_POOL_ROUND_LINEAR_CUTOFF", 24);
+    max_cached_bytes_ =
+        static_cast<size_t>(dmlc::GetEnv("MXNET_CPU_MEM_POOL_MAX_CACHED_MB", 4096)) << 20;
+    thread_cache_bytes_ =
+        static_cast<size_t>(dmlc::GetEnv("MXNET_CPU_MEM_POOL_THREAD_CACHE_MB", 16)) << 20;
+    if (page_size_ < 32) {
+      LOG(FATAL) << "MXNET_CPU_MEM_POOL_PAGE_SIZE cannot be set to a value smaller than 32. " \
+                 << "Got: " << page_size_ << ".";
+    }
+    if (page_size_ != 1ul << common::ilog2ul(page_size_ - 1)) {
+      LOG(FATAL) << "MXNET_CPU_MEM_POOL_PAGE_SIZE must be a power of 2. Got: " << page_size_ << ".";
+    }
+    page_size_ = common::ilog2ul(page_size_ - 1);
+    if (cut_off_ < 20 || cut_off_ > LOG2_MAX_MEM) {
+      LOG(FATAL) << "MXNET_CPU_MEM_POOL_ROUND_LINEAR_CUTOFF cannot be set to a value " \
+                 << "smaller than 20 or greater than " << LOG2_MAX_MEM << ". Got: " \
+                 << cut_off_ << ".";
+    }
+    if (cut_off_ < page_size_) {
+      LOG(FATAL) << "MXNET_CPU_MEM_POOL_ROUND_LINEAR_CUTOFF cannot be set to a value " \
+                 << "smaller than log2 of MXNET_CPU_MEM_POOL_PAGE_SIZE. Got: " \
+                 << cut_off_ << " vs " << page_size_ << ".";
+    }
+    num_buckets_ = (1ul << (LOG2_MAX_MEM - cut_off_)) + cut_off_;
+    memory_pool_ = std::vector<std::vector<void*>>(num_buckets_);
+  }
+  /*!
+   * \brief Default destructor.
+   */
+  ~CPUPooledStorageManager() {
+    ReleaseAll();
+  }
+
+  void Alloc(Storage::Handle* handle) override;
+  void Free(Storage::Handle handle) override;
+
+  void DirectFree(Storage::Handle handle) override {
+    if (handle.dptr == nullptr) return;
+    CPUDeviceStorage::Free(handle);
+  }
+
+  void ReleaseAll() override;
+
+ private:
+  /*!
+   * \brief Chunks cached by one thread. The mutex is only contended when
+   *  ReleaseAll drains the cache from another thread.
+   */
+  struct ThreadCache {
+    std::mutex mutex;
+    size_t bytes = 0;
+    std::vector<std::vector<void*>> pool;
+  };
+
+  inline int div_pow2_round_up(size_t s, int divisor_log2) {
+    size_t result = s >> divisor_log2;
+    return static_cast<int>(result + (s > (result << divisor_log2) ? 1 : 0));
+  }
+  inline int get_bucket(size_t s) {
+    int log_size = common::ilog2ul(s - 1);
+    if (log_size > static_cast<int>(cut_off_))
+      return div_pow2_round_up(s, cut_off_) - 1 + cut_off_;
+    else
+      return std::max(log_size, static_cast<int>(page_size_));
+  }
+  inline size_t get_size(int bucket) {
+    if (bucket <= static_cast<int>(cut_off_))
+      return 1ul << bucket;
+    else
+      return (bucket - cut_off_ + 1) * (1ul << cut_off_);
+  }
+  // whether a request of this size is served from the pool at all
+  inline bool Poolable(size_t size) {
+    return size <= (1ul << LOG2_MAX_MEM) && size <= max_cached_bytes_;
+  }
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+  }
+  // get the cache of the calling thread, creating and registering it on first use
+  ThreadCache* GetThreadCache();
+  // move all chunks of a thread cache into the shared pool, must hold mutex_
+  void DrainThreadCacheNoLock(ThreadCache* cache);
+
+ private:
+  // log2 of maximum pooled chunk size. 16GB
+  const size_t LOG2_MAX_MEM = 34;
+  // unique id of this manager, used to key the thread local caches
+  const uint64_t id_;
+  // log2 of page size
+  size_t page_size_;
+  // log2 of memory size before switching to exponential mode to linear mode
+  size_t cut_off_;
+  // number of size classes
+  size_t num_buckets_;
+  // maximum number of bytes kept by the pool, including thread caches
+  size_t max_cached_bytes_;
+  // maximum number of bytes kept by one thread cache
+  size_t thread_cache_bytes_;
+  // number of bytes currently kept by the pool, including thread caches
+  std::atomic<size_t> cached_bytes_{0};
+  // mutex guarding memory_pool_ and thread_caches_
+  std::mutex mutex_;
+  // shared memory pool
+  std::vector<std::vector<void*>> memory_pool_;
+  // all thread caches created for this manager
+  std::vector<std::shared_ptr<ThreadCache>> thread_caches_;
+  DISALLOW_COPY_AND_ASSIGN(CPUPooledStorageManager);
+};  // class CPUPooledStorageManager
+
+CPUPooledStorageManager::ThreadCache* CPUPooledStorageManager::GetThreadCache() {
+  // keyed by manager id rather than address, so that a stale entry of a destroyed
+  // manager is never picked up by a new one allocated at the same address.
+  static thread_local std::unordered_map<uint64_t, std::shared_ptr<ThreadCache>> caches;
+  auto it = caches.find(id_);
+  if (it != caches.end()) return it->second.get();
+  auto cache = std::make_shared<ThreadCache>();
+  cache->pool.resize(num_buckets_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // reclaim the caches of threads that have exited, which are only referenced here
+    auto dead = std::remove_if(thread_caches_.begin(), thread_caches_.end(),
+                               [this](const std::shared_ptr<ThreadCache>& c) {
+                                 if (c.use_count() != 1) return false;
+                                 DrainThreadCacheNoLock(c.get());
+                                 return true;
+                               });
+    thread_caches_.erase(dead, thread_caches_.end());
+    thread_caches_.push_back(cache);
+  }
+  caches[id_] = cache;
+  return cache.get();
+}
+
+void CPUPooledStorageManager::DrainThreadCacheNoLock(ThreadCache* cache) {
+  std::lock_guard<std::mutex> lock(cache->mutex);
+  for (size_t i = 0; i < cache->pool.size(); ++i) {
+    auto&& src = cache->pool[i];
+    auto&& dst = memory_pool_[i];
+    dst.insert(dst.end(), src.begin(), src.end());
+    src.clear();
+  }
+  cache->bytes = 0;
+}
+
+void CPUPooledStorageManager::Alloc(Storage::Handle* handle) {
+  // Set dptr to nullptr when handle size is 0.
+  if (handle->size == 0) {
+    handle->dptr = nullptr;
+    return;
+  }
+  if (!Poolable(handle->size)) {
+    CPUDeviceStorage::Alloc(handle);
+    return;
+  }
+
+  int bucket = get_bucket(handle->size);
+  size_t size = get_size(bucket);
+  if (size <= thread_cache_bytes_) {
+    ThreadCache* cache = GetThreadCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    auto&& reuse_pool = cache->pool[bucket];
+    if (reuse_pool.size() != 0) {
+      handle->dptr = reuse_pool.back();
+      reuse_pool.pop_back();
+      cache->bytes -= size;
+      cached_bytes_ -= size;
+      return;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto&& reuse_pool = memory_pool_[bucket];
+    if (reuse_pool.size() != 0) {
+      handle->dptr = reuse_pool.back();
+      reuse_pool.pop_back();
+      cached_bytes_ -= size;
+      return;
+    }
+  }
+  // allocate the rounded size so that the chunk can serve any request of its class
+  Storage::Handle chunk;
+  chunk.size = size;
+  chunk.ctx = handle->ctx;
+  CPUDeviceStorage::Alloc(&chunk);
+  handle->dptr = chunk.dptr;
+}
+
+void CPUPooledStorageManager::Free(Storage::Handle handle) {
+  if (handle.dptr == nullptr) return;
+  if (!Poolable(handle.size)) {
+    CPUDeviceStorage::Free(handle);
+    return;
+  }
+
+  int bucket = get_bucket(handle.size);
+  size_t size = get_size(bucket);
+  if (cached_bytes_.fetch_add(size) + size > max_cached_bytes_) {
+    cached_bytes_ -= size;
+    CPUDeviceStorage::Free(handle);
+    return;
+  }
+  if (size <= thread_cache_bytes_) {
+    ThreadCache* cache = GetThreadCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (cache->bytes + size <= thread_cache_bytes_) {
+      cache->pool[bucket].push_back(handle.dptr);
+      cache->bytes += size;
+      return;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  memory_pool_[bucket].push_back(handle.dptr);
+}
+
+void CPUPooledStorageManager::ReleaseAll() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto&& cache : thread_caches_) {
+    DrainThreadCacheNoLock(cache.get());
+  }
+  for (size_t i = 0; i < memory_pool_.size(); ++i) {
+    for (auto&& j : memory_pool_[i]) {
+      Storage::Handle handle;
+      handle.dptr = j;
+      handle.size = get_size(i);
+      CPUDeviceStorage::Free(handle);
+      cached_bytes_ -= handle.size;
+    }
+    memory_pool_[i].clear();
+  }
+}
+
 }  // namespace storage
 }  // namespace mxnet
 
@@ -67,7 +67,16 @@ void StorageImpl::Alloc(Storage::Handle* handle) {
         storage::StorageManager *ptr = nullptr;
         switch (handle->ctx.dev_type) {
           case Context::kCPU: {
-            ptr = new storage::NaiveStorageManager<storage::CPUDeviceStorage>();
+            const char *type = getenv("MXNET_CPU_MEM_POOL_TYPE");
+            std::string strategy = (type == nullptr) ? "Unpooled" : type;
+
+            if (strategy == "Pooled") {
+              ptr = new storage::CPUPooledStorageManager();
+            } else if (strategy == "Unpooled") {
+              ptr = new storage::NaiveStorageManager<storage::CPUDeviceStorage>();
+            } else {
+              LOG(FATAL) << "Unknown CPU memory pool strategy specified: " << strategy << ".";
+            }
             break;
           }
           case Context::kCPUShared: {
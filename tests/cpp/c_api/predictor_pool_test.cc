@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file predictor_pool_test.cc
+ * \brief Predictors of a pool sharing parameters and running on their own threads
+ */
+#include <gtest/gtest.h>
+#include <dmlc/memory_io.h>
+#include <mxnet/c_predict_api.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/pass_functions.h>
+#include <nnvm/symbolic.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/test_util.h"
+
+namespace {
+
+const int kBatch = 2;
+const int kHidden = 16;
+
+/*! \brief two FullyConnected layers, serialized the way the predict API reads them */
+void CreateModel(std::string* symbol_json, std::string* param_bytes) {
+  nnvm::Symbol sym = nnvm::Symbol::CreateVariable("data");
+  std::vector<mxnet::NDArray> params;
+  std::vector<std::string> names;
+  for (int i = 0; i < 2; ++i) {
+    const std::string name = "fc" + std::to_string(i);
+    nnvm::Symbol fc = nnvm::Symbol::CreateFunctor(
+        nnvm::Op::Get("FullyConnected"), {{"num_hidden", std::to_string(kHidden)}});
+    std::vector<const nnvm::Symbol*> args{&sym};
+    fc.Compose(args, {}, name);
+    sym = fc;
+    params.emplace_back(mxnet::TShape({kHidden, kHidden}), mxnet::Context::CPU());
+    mxnet::SampleUniform(-0.5f, 0.5f, &params.back());
+    names.push_back("arg:" + name + "_weight");
+    params.emplace_back(mxnet::TShape({kHidden}), mxnet::Context::CPU());
+    mxnet::SampleUniform(-0.5f, 0.5f, &params.back());
+    names.push_back("arg:" + name + "_bias");
+  }
+  nnvm::Graph g;
+  g.outputs = sym.outputs;
+  *symbol_json = nnvm::pass::SaveJSON(g);
+  dmlc::MemoryStringStream strm(param_bytes);
+  mxnet::NDArray::Save(&strm, params, names);
+}
+
+/*! \brief run one forward pass of the predictor on the given input */
+std::vector<float> Predict(PredictorHandle pred, const std::vector<float>& input) {
+  EXPECT_EQ(MXPredSetInput(pred, "data", input.data(), input.size()), 0);
+  EXPECT_EQ(MXPredForward(pred), 0);
+  std::vector<float> output(kBatch * kHidden);
+  EXPECT_EQ(MXPredGetOutput(pred, 0, output.data(), output.size()), 0);
+  return output;
+}
+
+}  // namespace
+
+TEST(PREDICTOR_POOL, ConcurrentInlinePredictors) {
+  std::string symbol_json, param_bytes;
+  CreateModel(&symbol_json, &param_bytes);
+  const char* input_keys[] = {"data"};
+  const mx_uint input_shape_indptr[] = {0, 2};
+  const mx_uint input_shape_data[] = {kBatch, kHidden};
+
+  PredictorHandle reference = nullptr;
+  ASSERT_EQ(MXPredCreate(symbol_json.c_str(), param_bytes.data(),
+                         static_cast<int>(param_bytes.size()), 1, 0, 1, input_keys,
+                         input_shape_indptr, input_shape_data, &reference), 0);
+  const int num_predictors = 4;
+  std::vector<std::vector<float> > inputs, expected;
+  for (int i = 0; i < num_predictors; ++i) {
+    inputs.emplace_back(kBatch * kHidden);
+    for (size_t j = 0; j < inputs[i].size(); ++j) {
+      inputs[i][j] = static_cast<float>((i + 1) * (j % 7)) / 10.0f;
+    }
+    expected.push_back(Predict(reference, inputs[i]));
+  }
+  ASSERT_EQ(MXPredFree(reference), 0);
+
+  for (int inline_exec = 0; inline_exec < 2; ++inline_exec) {
+    std::vector<PredictorHandle> pool(num_predictors, nullptr);
+    ASSERT_EQ(MXPredCreatePool(symbol_json.c_str(), param_bytes.data(),
+                               static_cast<int>(param_bytes.size()), 1, 0, 1, input_keys,
+                               input_shape_indptr, input_shape_data, num_predictors,
+                               inline_exec, pool.data()), 0);
+    std::vector<std::vector<float> > outputs(num_predictors);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_predictors; ++i) {
+      threads.emplace_back([&, i]() {
+        for (int iter = 0; iter < 20; ++iter) {
+          outputs[i] = Predict(pool[i], inputs[i]);
+        }
+      });
+    }
+    for (auto& t : threads) t.join();
+    for (int i = 0; i < num_predictors; ++i) {
+      for (size_t j = 0; j < expected[i].size(); ++j) {
+        EXPECT_NEAR(outputs[i][j], expected[i][j], 1e-5);
+      }
+      ASSERT_EQ(MXPredFree(pool[i]), 0);
+    }
+  }
+}
@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file threaded_engine_perf.cc
+ * \brief Operator dispatch throughput of the threaded engines
+ */
+#include <gtest/gtest.h>
+#include <dmlc/logging.h>
+#include <dmlc/timer.h>
+#include <mxnet/engine.h>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/engine/engine_impl.h"
+#include "../include/test_util.h"
+
+/*!
+ * \brief Push num_ops tiny operators, each writing one of num_var variables, and
+ *  return the achieved throughput in operators per second.
+ *  With many variables most operators are independent, so the throughput is bound
+ *  by the cost of dispatching operators to the worker threads.
+ */
+static double DispatchThroughput(mxnet::Engine* engine, int num_ops, int num_var) {
+  using namespace mxnet;
+  std::vector<Engine::VarHandle> vars;
+  for (int i = 0; i < num_var; ++i) {
+    vars.push_back(engine->NewVariable());
+  }
+  std::atomic<int> counter(0);
+  double t = dmlc::GetTime();
+  for (int i = 0; i < num_ops; ++i) {
+    engine->PushSync([&counter](RunContext ctx) { ++counter; },
+                     Context::CPU(), {}, {vars[i % num_var]});
+  }
+  engine->WaitForAll();
+  t = dmlc::GetTime() - t;
+  EXPECT_EQ(counter.load(), num_ops);
+  for (auto var : vars) {
+    engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  }
+  engine->WaitForAll();
+  return num_ops / t;
+}
+
+TEST(ENGINE_PERF, DispatchThroughput) {
+  const int num_ops = mxnet::test::performance_run ? 1000000 : 50000;
+  const int num_var = 1024;
+  const char* old_nthreads = getenv("MXNET_CPU_WORKER_NTHREADS");
+  const std::string saved = old_nthreads ? old_nthreads : "";
+  for (const char* nthreads : {"1", "4"}) {
+    setenv("MXNET_CPU_WORKER_NTHREADS", nthreads, 1);
+    std::unique_ptr<mxnet::Engine> queue_engine(mxnet::engine::CreateThreadedEnginePerDevice());
+    std::unique_ptr<mxnet::Engine> stealing_engine(
+      mxnet::engine::CreateThreadedEnginePerDeviceWorkStealing());
+    const double queue_rate = DispatchThroughput(queue_engine.get(), num_ops, num_var);
+    const double stealing_rate = DispatchThroughput(stealing_engine.get(), num_ops, num_var);
+    LOG(INFO) << "MXNET_CPU_WORKER_NTHREADS=" << nthreads;
+    LOG(INFO) << "ThreadedEnginePerDevice\t\t\t" << queue_rate << " ops/sec";
+    LOG(INFO) << "ThreadedEnginePerDeviceWorkStealing\t" << stealing_rate << " ops/sec";
+  }
+  if (old_nthreads) {
+    setenv("MXNET_CPU_WORKER_NTHREADS", saved.c_str(), 1);
+  } else {
+    unsetenv("MXNET_CPU_WORKER_NTHREADS");
+  }
+}
+
+/*!
+ * \brief Throughput of operators that all read one shared variable and write one of
+ *  a few others, which stresses the dependency tracking of each ThreadedVar.
+ */
+TEST(ENGINE_PERF, VarContentionThroughput) {
+  using namespace mxnet;
+  const int num_ops = test::performance_run ? 1000000 : 50000;
+  const int num_var = 4;
+  std::unique_ptr<Engine> engine(engine::CreateThreadedEnginePerDevice());
+  Engine::VarHandle shared = engine->NewVariable();
+  std::vector<Engine::VarHandle> vars;
+  for (int i = 0; i < num_var; ++i) {
+    vars.push_back(engine->NewVariable());
+  }
+  std::atomic<int> counter(0);
+  double t = dmlc::GetTime();
+  for (int i = 0; i < num_ops; ++i) {
+    engine->PushSync([&counter](RunContext ctx) { ++counter; },
+                     Context::CPU(), {shared}, {vars[i % num_var]});
+  }
+  engine->WaitForAll();
+  t = dmlc::GetTime() - t;
+  EXPECT_EQ(counter.load(), num_ops);
+  LOG(INFO) << "ThreadedEnginePerDevice\t" << num_ops / t << " ops/sec";
+  for (auto var : vars) {
+    engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  }
+  engine->DeleteVariable([](RunContext) {}, Context::CPU(), shared);
+  engine->WaitForAll();
+}
@@ -124,12 +124,14 @@ double EvaluateWorkloads(const std::vector<Workload>& workloads,
 }
 
 TEST(Engine, start_stop) {
-  const int num_engine = 3;
+  const int num_engine = 4;
   std::vector<mxnet::Engine*> engine(num_engine);
   engine[0] = mxnet::engine::CreateNaiveEngine();
   engine[1] = mxnet::engine::CreateThreadedEnginePooled();
   engine[2] = mxnet::engine::CreateThreadedEnginePerDevice();
-  std::string type_names[3] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice"};
+  engine[3] = mxnet::engine::CreateThreadedEnginePerDeviceWorkStealing();
+  std::string type_names[4] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice",
+                               "ThreadedEnginePerDeviceWorkStealing"};
 
   for (int i = 0; i < num_engine; ++i) {
     LOG(INFO) << "Stopping: " << type_names[i];
@@ -143,7 +145,7 @@ TEST(Engine, start_stop) {
 TEST(Engine, RandSumExpr) {
   std::vector<Workload> workloads;
   int num_repeat = 5;
-  const int num_engine = 4;
+  const int num_engine = 5;
 
   std::vector<double> t(num_engine, 0.0);
   std::vector<mxnet::Engine*> engine(num_engine);
@@ -152,6 +154,7 @@ TEST(Engine, RandSumExpr) {
   engine[1] = mxnet::engine::CreateNaiveEngine();
   engine[2] = mxnet::engine::CreateThreadedEnginePooled();
   engine[3] = mxnet::engine::CreateThreadedEnginePerDevice();
+  engine[4] = mxnet::engine::CreateThreadedEnginePerDeviceWorkStealing();
 
   for (int repeat = 0; repeat < num_repeat; ++repeat) {
     srand(time(NULL) + repeat);
@@ -174,6 +177,7 @@ TEST(Engine, RandSumExpr) {
   LOG(INFO) << "NaiveEngine\t\t"  << t[1] << " sec";
   LOG(INFO) << "ThreadedEnginePooled\t" << t[2] << " sec";
   LOG(INFO) << "ThreadedEnginePerDevice\t" << t[3] << " sec";
+  LOG(INFO) << "ThreadedEnginePerDeviceWorkStealing\t" << t[4] << " sec";
 }
 
 void Foo(mxnet::RunContext, int i) { printf("The fox says %d\n", i); }
@@ -459,6 +463,83 @@ TEST(Engine, VarVersion) {
   }
 }
 
+/**
+ * Access state of a variable, used to check that the engine never runs a write
+ * concurrently with any other access of the same variable.
+ */
+struct VarAccess {
+  std::atomic<int> readers{0};
+  std::atomic<int> writers{0};
+  std::atomic<int> num_writes{0};
+};
+
+TEST(Engine, VarDependencyStress) {
+  const int num_engines = 3;
+  std::vector<mxnet::Engine*> engines(num_engines);
+  engines[0] = mxnet::engine::CreateThreadedEnginePooled();
+  engines[1] = mxnet::engine::CreateThreadedEnginePerDevice();
+  engines[2] = mxnet::engine::CreateThreadedEnginePerDeviceWorkStealing();
+  std::string type_names[3] = {"ThreadedEnginePooled", "ThreadedEnginePerDevice",
+                               "ThreadedEnginePerDeviceWorkStealing"};
+  // few variables and several pushers, to maximize contention on each var
+  const int num_var = 8;
+  const int num_pushers = 4;
+  const int num_ops = mxnet::test::performance_run ? 100000 : 10000;
+  for (int k = 0; k < num_engines; ++k) {
+    auto engine = engines[k];
+    std::vector<mxnet::Engine::VarHandle> vars;
+    std::vector<VarAccess> access(num_var);
+    for (int i = 0; i < num_var; ++i) {
+      vars.push_back(engine->NewVariable());
+    }
+    std::atomic<int> violations(0);
+    std::vector<int> expected_writes(num_var * num_pushers, 0);
+    std::vector<std::thread> pushers;
+    double t = dmlc::GetTime();
+    for (int p = 0; p < num_pushers; ++p) {
+      pushers.emplace_back([&, p]() {
+        unsigned seed = p + 1;
+        for (int i = 0; i < num_ops; ++i) {
+          const int write = rand_r(&seed) % num_var;
+          std::vector<int> reads;
+          for (int j = 0; j < num_var; ++j) {
+            if (j != write && rand_r(&seed) % 4 == 0) reads.push_back(j);
+          }
+          ++expected_writes[p * num_var + write];
+          std::vector<mxnet::Engine::VarHandle> const_vars;
+          for (int j : reads) const_vars.push_back(vars[j]);
+          engine->PushSync([&access, &violations, reads, write](mxnet::RunContext) {
+              for (int j : reads) {
+                ++access[j].readers;
+                if (access[j].writers.load() != 0) ++violations;
+              }
+              if (access[write].writers.exchange(1) != 0 ||
+                  access[write].readers.load() != 0) {
+                ++violations;
+              }
+              ++access[write].num_writes;
+              access[write].writers.store(0);
+              for (int j : reads) --access[j].readers;
+            }, mxnet::Context::CPU(), const_vars, {vars[write]});
+        }
+      });
+    }
+    for (auto& pusher : pushers) pusher.join();
+    engine->WaitForAll();
+    t = dmlc::GetTime() - t;
+    EXPECT_EQ(violations.load(), 0);
+    for (int i = 0; i < num_var; ++i) {
+      int writes = 0;
+      for (int p = 0; p < num_pushers; ++p) writes += expected_writes[p * num_var + i];
+      EXPECT_EQ(access[i].num_writes.load(), writes);
+      EXPECT_EQ(vars[i]->version(), static_cast<size_t>(writes));
+      engine->DeleteVariable([](mxnet::RunContext) {}, mxnet::Context::CPU(), vars[i]);
+    }
+    engine->WaitForAll();
+    LOG(INFO) << type_names[k] << "\t" << num_pushers * num_ops / t << " ops/sec";
+  }
+}
+
 #ifdef _OPENMP
 
 struct TestSaveAndRestoreOMPState {
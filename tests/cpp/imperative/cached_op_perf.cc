@@ -0,0 +1,153 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file cached_op_perf.cc
+ * \brief Per-call overhead of static_shape and frozen CachedOp inference
+ */
+#include <gtest/gtest.h>
+#include <dmlc/logging.h>
+#include <dmlc/timer.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/symbolic.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/imperative/cached_op.h"
+#include "../include/test_util.h"
+
+using CachedOpFlags = std::vector<std::pair<std::string, std::string> >;
+
+/*!
+ * \brief A stack of FullyConnected and relu layers. The layers are tiny, so the
+ *  time of a forward call is dominated by the cost of dispatching it.
+ */
+static nnvm::Symbol SmallMLP(int depth, int hidden) {
+  nnvm::Symbol sym = nnvm::Symbol::CreateVariable("data");
+  for (int i = 0; i < depth; ++i) {
+    const std::string name = "fc" + std::to_string(i);
+    nnvm::Symbol fc = nnvm::Symbol::CreateFunctor(
+        nnvm::Op::Get("FullyConnected"), {{"num_hidden", std::to_string(hidden)}});
+    std::vector<const nnvm::Symbol*> fc_args{&sym};
+    fc.Compose(fc_args, {}, name);
+    nnvm::Symbol act = nnvm::Symbol::CreateFunctor(nnvm::Op::Get("relu"), {});
+    std::vector<const nnvm::Symbol*> act_args{&fc};
+    act.Compose(act_args, {}, name + "_relu");
+    sym = act;
+  }
+  return sym;
+}
+
+/*!
+ * \brief Run num_calls inference forward passes, each with a fresh output handle
+ *  like the C API passes, and return the average microseconds per call.
+ */
+static double ForwardLatency(const nnvm::Symbol& sym, const CachedOpFlags& flags,
+                             std::vector<mxnet::NDArray>* args, int num_calls,
+                             mxnet::NDArray* output) {
+  using namespace mxnet;
+  auto op = std::make_shared<CachedOp>(sym, flags);
+  std::vector<NDArray*> inputs;
+  for (auto& arg : *args) inputs.push_back(&arg);
+  std::vector<NDArray*> outputs{output};
+  // the first call plans the memory and, when frozen, records the pass
+  *output = NDArray();
+  op->Forward(op, inputs, outputs);
+  output->WaitToRead();
+  double t = dmlc::GetTime();
+  for (int i = 0; i < num_calls; ++i) {
+    *output = NDArray();
+    op->Forward(op, inputs, outputs);
+  }
+  output->WaitToRead();
+  t = dmlc::GetTime() - t;
+  return t * 1e6 / num_calls;
+}
+
+TEST(CACHED_OP_PERF, FrozenForwardOverhead) {
+  using namespace mxnet;
+  const int depth = 8;
+  const int hidden = 16;
+  const int num_calls = test::performance_run ? 100000 : 1000;
+  nnvm::Symbol sym = SmallMLP(depth, hidden);
+
+  std::vector<NDArray> args;
+  std::string param_indices;
+  const auto names = sym.ListInputNames(nnvm::Symbol::kAll);
+  for (size_t i = 0; i < names.size(); ++i) {
+    mxnet::TShape shape;
+    if (i == 0) {
+      shape = mxnet::TShape({1, hidden});
+    } else if (names[i].find("_weight") != std::string::npos) {
+      shape = mxnet::TShape({hidden, hidden});
+      param_indices += (param_indices.empty() ? "" : ",") + std::to_string(i);
+    } else {
+      shape = mxnet::TShape({hidden});
+      param_indices += (param_indices.empty() ? "" : ",") + std::to_string(i);
+    }
+    args.emplace_back(shape, Context::CPU());
+    SampleUniform(-0.5f, 0.5f, &args.back());
+  }
+  CachedOpFlags static_flags{{"static_alloc", "true"}, {"static_shape", "true"},
+                             {"data_indices", "[0]"}, {"param_indices", "[" + param_indices + "]"}};
+  CachedOpFlags frozen_flags(static_flags);
+  frozen_flags.emplace_back("frozen", "true");
+
+  NDArray static_out, frozen_out;
+  const double static_us = ForwardLatency(sym, static_flags, &args, num_calls, &static_out);
+  const double frozen_us = ForwardLatency(sym, frozen_flags, &args, num_calls, &frozen_out);
+  LOG(INFO) << "static_shape\t" << static_us << " us/call";
+  LOG(INFO) << "frozen\t\t" << frozen_us << " us/call";
+
+  ASSERT_EQ(static_out.shape(), frozen_out.shape());
+  const float* expected = static_out.data().dptr<float>();
+  const float* actual = frozen_out.data().dptr<float>();
+  for (size_t i = 0; i < static_out.shape().Size(); ++i) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-5);
+  }
+}
+
+TEST(CACHED_OP_PERF, FrozenForwardReusesOutputs) {
+  using namespace mxnet;
+  nnvm::Symbol sym = SmallMLP(2, 8);
+  std::vector<NDArray> args;
+  for (const auto& name : sym.ListInputNames(nnvm::Symbol::kAll)) {
+    if (name == "data") {
+      args.emplace_back(mxnet::TShape({4, 8}), Context::CPU());
+    } else if (name.find("_weight") != std::string::npos) {
+      args.emplace_back(mxnet::TShape({8, 8}), Context::CPU());
+    } else {
+      args.emplace_back(mxnet::TShape({8}), Context::CPU());
+    }
+    args.back() = 0.5f;
+  }
+  auto op = std::make_shared<CachedOp>(
+      sym, CachedOpFlags{{"static_alloc", "true"}, {"static_shape", "true"}, {"frozen", "true"}});
+  std::vector<NDArray*> inputs;
+  for (auto& arg : args) inputs.push_back(&arg);
+  NDArray first, second;
+  op->Forward(op, inputs, {&first});
+  op->Forward(op, inputs, {&second});
+  // the replay hands out the recorded output instead of allocating a new one
+  EXPECT_TRUE(first.IsSame(second));
+  second.WaitToRead();
+}
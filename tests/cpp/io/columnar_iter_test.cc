@@ -0,0 +1,168 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file columnar_iter_test.cc
+ * \brief Columnar files written block by block and read back through ColumnarIter
+ */
+#include <gtest/gtest.h>
+#include <dmlc/io.h>
+#include <mxnet/io.h>
+#include <mxnet/ndarray.h>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/io/columnar_format.h"
+
+using mxnet::io::ColumnarReader;
+using mxnet::io::ColumnarWriter;
+
+namespace {
+
+const int kNumRows = 10;
+const int kNumColumns = 3;
+const int kRowsPerBlock = 4;
+
+float DenseValue(int row, int column) {
+  return row * 10.0f + column;
+}
+
+/*! \brief row r has the columns c with (r + c) % 3 == 0, valued like the dense rows */
+void WriteFile(const std::string& path, bool sparse) {
+  std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(path.c_str(), "w"));
+  ColumnarWriter writer(fo.get(), sparse ? mxnet::io::kColumnarCSR : mxnet::io::kColumnarDense,
+                        kNumColumns, 1, kRowsPerBlock);
+  for (int r = 0; r < kNumRows; ++r) {
+    const float label = -r;
+    std::vector<float> value;
+    std::vector<int64_t> index;
+    for (int c = 0; c < kNumColumns; ++c) {
+      if (!sparse || (r + c) % 3 == 0) {
+        value.push_back(DenseValue(r, c));
+        index.push_back(c);
+      }
+    }
+    if (sparse) {
+      writer.WriteSparseRow(&label, index.data(), value.data(), index.size());
+    } else {
+      writer.WriteDenseRow(&label, value.data());
+    }
+  }
+  writer.Finish();
+}
+
+/*! \brief the rows of every batch read in an epoch, densified, with padding dropped */
+std::vector<std::pair<unsigned, std::vector<float> > > ReadEpoch(
+    const std::vector<std::pair<std::string, std::string> >& kwargs) {
+  using namespace mxnet;
+  std::unique_ptr<IIterator<DataBatch> > iter(
+      dmlc::Registry<DataIteratorReg>::Find("ColumnarIter")->body());
+  iter->Init(kwargs);
+  iter->BeforeFirst();
+  std::vector<std::pair<unsigned, std::vector<float> > > rows;
+  while (iter->Next()) {
+    const DataBatch& batch = iter->Value();
+    const NDArray& data = batch.data[0];
+    const float *label = batch.data[1].data().dptr<float>();
+    const size_t batch_size = batch.index.size();
+    for (size_t i = 0; i + batch.num_batch_padd < batch_size; ++i) {
+      std::vector<float> row(kNumColumns, 0.0f);
+      if (data.storage_type() == kCSRStorage) {
+        const int64_t *indptr = data.aux_data(csr::kIndPtr).dptr<int64_t>();
+        const int64_t *idx = data.aux_data(csr::kIdx).dptr<int64_t>();
+        const float *value = data.data().dptr<float>();
+        for (int64_t j = indptr[i]; j < indptr[i + 1]; ++j) row[idx[j]] = value[j];
+      } else {
+        std::copy_n(data.data().dptr<float>() + i * kNumColumns, kNumColumns, row.begin());
+      }
+      EXPECT_EQ(label[i], -static_cast<float>(batch.index[i]));
+      rows.emplace_back(batch.index[i], row);
+    }
+  }
+  return rows;
+}
+
+void CheckRow(unsigned r, const std::vector<float>& row, bool sparse) {
+  for (int c = 0; c < kNumColumns; ++c) {
+    const bool stored = !sparse || (r + c) % 3 == 0;
+    EXPECT_EQ(row[c], stored ? DenseValue(r, c) : 0.0f) << "row " << r << " column " << c;
+  }
+}
+
+}  // namespace
+
+TEST(COLUMNAR_ITER, ReaderSeesTheWrittenBlocks) {
+  const std::string path = "columnar_reader_test.col";
+  WriteFile(path, false);
+  {
+    ColumnarReader reader(path);
+    ASSERT_EQ(reader.NumRows(), static_cast<uint64_t>(kNumRows));
+    ASSERT_EQ(reader.NumBlocks(), 3U);
+    EXPECT_FALSE(reader.IsSparse());
+    EXPECT_EQ(reader.Block(2).num_rows, 2U);
+    for (size_t b = 0; b < reader.NumBlocks(); ++b) {
+      EXPECT_EQ(reader.Block(b).offset % mxnet::io::kColumnarAlign, 0U);
+      for (size_t r = 0; r < reader.Block(b).num_rows; ++r) {
+        const int row = b * kRowsPerBlock + r;
+        EXPECT_EQ(reader.Label(b, 0)[r], -row);
+        for (int c = 0; c < kNumColumns; ++c) {
+          EXPECT_EQ(reader.Column(b, c)[r], DenseValue(row, c));
+        }
+      }
+    }
+  }
+  std::remove(path.c_str());
+}
+
+TEST(COLUMNAR_ITER, DenseAndSparseBatches) {
+  for (bool sparse : {false, true}) {
+    const std::string path = "columnar_iter_test.col";
+    WriteFile(path, sparse);
+    const auto rows = ReadEpoch({{"data_columnar", path}, {"batch_size", "4"}});
+    ASSERT_EQ(rows.size(), static_cast<size_t>(kNumRows));
+    for (int r = 0; r < kNumRows; ++r) {
+      EXPECT_EQ(rows[r].first, static_cast<unsigned>(r));
+      CheckRow(rows[r].first, rows[r].second, sparse);
+    }
+    std::remove(path.c_str());
+  }
+}
+
+TEST(COLUMNAR_ITER, ShuffledPart) {
+  const std::string path = "columnar_part_test.col";
+  WriteFile(path, true);
+  // the second of two parts holds blocks 1 and 2, rows 4 to 9
+  const auto rows = ReadEpoch({{"data_columnar", path}, {"batch_size", "4"},
+                               {"num_parts", "2"}, {"part_index", "1"},
+                               {"shuffle", "true"}, {"seed", "5"}});
+  std::set<unsigned> seen;
+  for (const auto& row : rows) {
+    CheckRow(row.first, row.second, true);
+    seen.insert(row.first);
+  }
+  EXPECT_EQ(rows.size(), 6U);
+  EXPECT_EQ(seen, std::set<unsigned>({4, 5, 6, 7, 8, 9}));
+  std::remove(path.c_str());
+}
@@ -0,0 +1,155 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file image_normalize_kernel_test.cc
+ * \brief Fused image normalization against a per pixel reference, and its speed
+ */
+#include <gtest/gtest.h>
+#include <dmlc/logging.h>
+#include <dmlc/timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../src/io/image_normalize_kernel.h"
+#include "../include/test_util.h"
+
+using mxnet::io::NormalizeImage;
+using mxnet::io::NormalizeKernelParam;
+
+namespace {
+
+NormalizeKernelParam MakeParam(int n_channels, bool mirror, const float *mean_img,
+                               size_t mean_stride) {
+  NormalizeKernelParam param;
+  const int swap_indices[4] = {n_channels == 1 ? 0 : 2, 1, 0, 3};
+  for (int k = 0; k < 4; ++k) {
+    param.source_channel[k] = swap_indices[k];
+    param.mean[k] = 100.3f + k;
+    param.mult[k] = 1.0f / (50.0f + k);
+    param.bias[k] = 0.25f * k;
+  }
+  param.mean_img = mean_img;
+  param.mean_stride = mean_stride;
+  param.mirror = mirror;
+  return param;
+}
+
+/*! \brief the per pixel loop NormalizeImage replaces */
+template<typename DType>
+DType Reference(const uint8_t *src, size_t src_step, int n_channels, int rows, int cols,
+                const NormalizeKernelParam &param, int k, int i, int j) {
+  const int source_j = param.mirror ? cols - j - 1 : j;
+  const uint8_t x = src[i * src_step + source_j * n_channels + param.source_channel[k]];
+  const float mean = param.mean_img != nullptr ?
+      param.mean_img[(k * rows + i) * param.mean_stride + source_j] : param.mean[k];
+  if (std::is_same<DType, uint8_t>::value) return x;
+  if (std::is_same<DType, int8_t>::value) {
+    const int v = x - static_cast<int>(std::round(mean));
+    return static_cast<DType>(std::min(127, std::max(-128, v)));
+  }
+  return static_cast<DType>((x - mean) * param.mult[k] + param.bias[k]);
+}
+
+template<int n_channels, typename DType>
+void CheckNormalize(int rows, int cols, bool mirror, bool with_mean_img) {
+  std::mt19937 rnd(rows * 1000 + cols);
+  // a view into a wider image, as left by a center crop
+  const size_t src_step = cols * n_channels + 5;
+  std::vector<uint8_t> src(rows * src_step);
+  for (auto& x : src) x = rnd();
+  const size_t mean_stride = cols + 3;
+  std::vector<float> mean_img(n_channels * rows * mean_stride);
+  for (auto& m : mean_img) m = rnd() % 2560 / 10.0f;
+  const NormalizeKernelParam param =
+      MakeParam(n_channels, mirror, with_mean_img ? mean_img.data() : nullptr, mean_stride);
+  std::vector<DType> dst(n_channels * rows * cols);
+  NormalizeImage<n_channels>(src.data(), src_step, rows, cols, param, dst.data());
+  for (int k = 0; k < n_channels; ++k) {
+    for (int i = 0; i < rows; ++i) {
+      for (int j = 0; j < cols; ++j) {
+        const DType expected =
+            Reference<DType>(src.data(), src_step, n_channels, rows, cols, param, k, i, j);
+        ASSERT_NEAR(dst[(k * rows + i) * cols + j], expected, 1e-5)
+            << n_channels << " channels " << rows << "x" << cols << " mirror " << mirror
+            << " mean image " << with_mean_img << " at " << k << "," << i << "," << j;
+      }
+    }
+  }
+}
+
+template<typename DType>
+void CheckAllShapes() {
+  // widths around the 8 and 16 pixel vectors and their scalar tails
+  for (int cols : {1, 7, 8, 9, 15, 16, 17, 31, 33, 224}) {
+    for (bool mirror : {false, true}) {
+      for (bool with_mean_img : {false, true}) {
+        CheckNormalize<1, DType>(3, cols, mirror, with_mean_img);
+        CheckNormalize<3, DType>(3, cols, mirror, with_mean_img);
+        CheckNormalize<4, DType>(3, cols, mirror, with_mean_img);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(IMAGE_NORMALIZE_KERNEL, Float) {
+  CheckAllShapes<float>();
+}
+
+TEST(IMAGE_NORMALIZE_KERNEL, UInt8) {
+  CheckAllShapes<uint8_t>();
+}
+
+TEST(IMAGE_NORMALIZE_KERNEL, Int8) {
+  CheckAllShapes<int8_t>();
+}
+
+TEST(IMAGE_NORMALIZE_KERNEL_PERF, Float224) {
+  const int rows = 224, cols = 224, n_channels = 3;
+  const int iterations = mxnet::test::performance_run ? 10000 : 100;
+  std::vector<uint8_t> src(rows * cols * n_channels, 77);
+  std::vector<float> dst(n_channels * rows * cols), expected(dst.size());
+  const NormalizeKernelParam param = MakeParam(n_channels, true, nullptr, 0);
+  double fused = dmlc::GetTime();
+  for (int it = 0; it < iterations; ++it) {
+    NormalizeImage<n_channels>(src.data(), cols * n_channels, rows, cols, param, dst.data());
+  }
+  fused = dmlc::GetTime() - fused;
+  double reference = dmlc::GetTime();
+  for (int it = 0; it < iterations; ++it) {
+    for (int k = 0; k < n_channels; ++k) {
+      for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+          expected[(k * rows + i) * cols + j] = Reference<float>(
+              src.data(), cols * n_channels, n_channels, rows, cols, param, k, i, j);
+        }
+      }
+    }
+  }
+  reference = dmlc::GetTime() - reference;
+  for (size_t i = 0; i < dst.size(); ++i) ASSERT_NEAR(dst[i], expected[i], 1e-5);
+  LOG(INFO) << "224x224x3 to float\tfused " << iterations / fused << " images/s"
+            << "\tper pixel " << iterations / reference << " images/s";
+}
@@ -0,0 +1,174 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file text_parser_perf.cc
+ * \brief Number parsing and multi-threaded throughput of the CSV and LibSVM parsers
+ */
+#include <gtest/gtest.h>
+#include <dmlc/logging.h>
+#include <dmlc/timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../src/io/text_parser.h"
+#include "../include/test_util.h"
+
+using mxnet::io::CSVTextParser;
+using mxnet::io::LibSVMTextParser;
+
+namespace {
+
+const int kNumColumns = 32;
+
+/*! \brief write random rows of about num_bytes in total, as CSV or as LibSVM */
+void WriteRows(const std::string& path, size_t num_bytes, bool libsvm) {
+  FILE *fo = std::fopen(path.c_str(), "w");
+  ASSERT_NE(fo, nullptr);
+  std::mt19937 rnd(17);
+  std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+  size_t written = 0;
+  while (written < num_bytes) {
+    if (libsvm) written += std::fprintf(fo, "%d", static_cast<int>(rnd() % 2));
+    for (int i = 0; i < kNumColumns; ++i) {
+      if (libsvm) {
+        if (rnd() % 4 == 0) written += std::fprintf(fo, " %d:%.6g", i, dist(rnd));
+      } else {
+        written += std::fprintf(fo, i == 0 ? "%.6g" : ",%.6g", dist(rnd));
+      }
+    }
+    written += std::fprintf(fo, "\n");
+  }
+  std::fclose(fo);
+}
+
+/*! \brief parse the whole file, returning the number of rows and the sum of the values */
+template<typename Parser>
+std::pair<size_t, double> ParseAll(Parser *parser, double *mb_per_sec) {
+  size_t num_rows = 0;
+  double sum = 0;
+  double t = dmlc::GetTime();
+  parser->BeforeFirst();
+  while (parser->Next()) {
+    const auto& block = parser->Value();
+    num_rows += block.Size();
+    for (auto v : block.value) sum += v;
+  }
+  t = dmlc::GetTime() - t;
+  *mb_per_sec = parser->BytesRead() / t / (1 << 20);
+  return {num_rows, sum};
+}
+
+/*! \brief compare the results and speed of one thread and of all cores */
+template<typename Parser, typename... Args>
+void CheckThroughput(const char *name, const std::string& path, Args... args) {
+  const int num_cores = std::max(1U, std::thread::hardware_concurrency());
+  Parser serial(path, args..., 1);
+  Parser parallel(path, args..., num_cores);
+  double serial_mbs, parallel_mbs;
+  const auto expected = ParseAll(&serial, &serial_mbs);
+  const auto actual = ParseAll(&parallel, &parallel_mbs);
+  EXPECT_GT(expected.first, 0U);
+  EXPECT_EQ(expected.first, actual.first);
+  EXPECT_NEAR(expected.second, actual.second, 1e-6 * std::abs(expected.second) + 1e-3);
+  LOG(INFO) << name << "\t1 thread\t" << serial_mbs << " MB/s";
+  LOG(INFO) << name << "\t" << num_cores << " threads\t" << parallel_mbs << " MB/s";
+}
+
+}  // namespace
+
+TEST(TEXT_PARSER, ParseNumberMatchesStrtof) {
+  const char *cases[] = {
+    "0", "-0", "1", "+7.", "-.5", "3.14159265", "1e10", "1.5E-7", "12345678.87654321",
+    "0.000000000000000000000123", "123456789012345678901234", "1e400", "nan", "-inf", "",
+    "0x1p3", "-0X1.8p-1", "0x10", "0x", "0xg"
+  };
+  for (const char *c : cases) {
+    float v;
+    const char *end = mxnet::io::ParseNumber(c, c + std::strlen(c), &v);
+    char *expected_end;
+    const float expected = std::strtof(c, &expected_end);
+    EXPECT_EQ(end, expected_end) << c;
+    if (!std::isnan(expected)) EXPECT_EQ(v, expected) << c;
+  }
+  std::mt19937 rnd(3);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  const char *formats[] = {"%.9g", "%.3f", "%e", "%.17g"};
+  char buf[64];
+  for (int i = 0; i < 100000; ++i) {
+    std::snprintf(buf, sizeof(buf), formats[i % 4], dist(rnd) * std::pow(10.0, i % 21 - 10));
+    float v;
+    mxnet::io::ParseNumber(buf, buf + std::strlen(buf), &v);
+    ASSERT_EQ(v, std::strtof(buf, nullptr)) << buf;
+  }
+  int64_t n;
+  const char big[] = "-9223372036854775807";
+  mxnet::io::ParseNumber(big, big + sizeof(big) - 1, &n);
+  EXPECT_EQ(n, -9223372036854775807LL);
+}
+
+TEST(TEXT_PARSER, ParseRealLeadingZerosMatchesStrtod) {
+  // the zeros before the first nonzero digit take no room in the mantissa
+  const char *cases[] = {
+    "0.000000012345678901234", "0.0000000000000000123456789012345678", "00000000123456789012345678",
+    "-0.00000000000000001234567890123456789e5", "0.00000000000000000000000001"
+  };
+  for (const char *c : cases) {
+    double v;
+    const char *end = mxnet::io::ParseReal(c, c + std::strlen(c), &v);
+    char *expected_end;
+    const double expected = std::strtod(c, &expected_end);
+    EXPECT_EQ(end, expected_end) << c;
+    EXPECT_NEAR(v, expected, 1e-15 * std::abs(expected)) << c;
+  }
+  std::mt19937 rnd(5);
+  std::uniform_int_distribution<uint64_t> digits(1, 9999999999999999999ULL);
+  char buf[64];
+  for (int i = 0; i < 10000; ++i) {
+    std::snprintf(buf, sizeof(buf), "0.%0*d%llu", i % 24, 0,
+                  static_cast<unsigned long long>(digits(rnd)));  // NOLINT(runtime/int)
+    double v;
+    mxnet::io::ParseReal(buf, buf + std::strlen(buf), &v);
+    const double expected = std::strtod(buf, nullptr);
+    ASSERT_NEAR(v, expected, 1e-15 * expected) << buf;
+  }
+}
+
+TEST(TEXT_PARSER_PERF, CSVThroughput) {
+  const std::string path = "text_parser_perf.csv";
+  WriteRows(path, mxnet::test::performance_run ? (2UL << 30) : (8UL << 20), false);
+  CheckThroughput<CSVTextParser<float> >("csv", path, mxnet::TShape({kNumColumns}));
+  std::remove(path.c_str());
+}
+
+TEST(TEXT_PARSER_PERF, LibSVMThroughput) {
+  const std::string path = "text_parser_perf.libsvm";
+  WriteRows(path, mxnet::test::performance_run ? (2UL << 30) : (8UL << 20), true);
+  CheckThroughput<LibSVMTextParser>("libsvm", path, 0U, 1U);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,141 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file collective_test.cc
+ * \brief allreduce, broadcast and barrier between local processes, over sockets and
+ *  shared memory
+ */
+#ifndef _WIN32
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "../src/kvstore/collective.h"
+
+using mxnet::kvstore::Collective;
+
+namespace {
+
+/*! \brief a port nobody listens at */
+int FreePort() {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  socklen_t len = sizeof(addr);
+  getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+  close(fd);
+  return ntohs(addr.sin_port);
+}
+
+/*! \brief the operations one rank runs, \return whether all the results are right */
+bool RunRank(int size, bool use_shm, size_t shm_size, size_t ring_bound, int port) {
+  Collective collective("127.0.0.1", port, size, use_shm, shm_size, ring_bound);
+  const int rank = collective.rank();
+  if (rank < 0 || rank >= size) return false;
+  auto sum = [](float *dst, const float *src, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] += src[i];
+  };
+  for (size_t count : {0, 1, 3, 7, 1000, 100003}) {
+    std::vector<float> data(count);
+    for (size_t i = 0; i < count; ++i) data[i] = rank * 1000 + i % 1000;
+    collective.Allreduce(data.data(), count, sum);
+    for (size_t i = 0; i < count; ++i) {
+      const float expected = 1000.0f * size * (size - 1) / 2 + size * (i % 1000);
+      if (data[i] != expected) return false;
+    }
+  }
+  for (int root : {0, size - 1}) {
+    std::vector<char> data(50000, static_cast<char>(rank));
+    collective.Broadcast(data.data(), data.size(), root);
+    for (char c : data) {
+      if (c != root) return false;
+    }
+  }
+  collective.Barrier();
+  return true;
+}
+
+/*!
+ * \brief run size ranks in as many processes, checking they all succeed. The rings in
+ *  shared memory are small by default, so that arrays wrap around them many times.
+ */
+void CheckRanks(int size, bool use_shm, size_t ring_bound, size_t shm_size = 4096) {
+  const int port = FreePort();
+  std::vector<pid_t> pids;
+  for (int i = 0; i < size; ++i) {
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      bool ok = false;
+      try {
+        ok = RunRank(size, use_shm, shm_size, ring_bound, port);
+      } catch (const std::exception& e) {
+        ok = false;
+      }
+      _exit(ok ? 0 : 1);
+    }
+    pids.push_back(pid);
+  }
+  for (pid_t pid : pids) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        << size << " ranks, shm " << use_shm << ", ring bound " << ring_bound;
+  }
+}
+
+}  // namespace
+
+TEST(COLLECTIVE, Ring) {
+  for (int size : {2, 3, 4, 5}) {
+    CheckRanks(size, false, 0);
+    CheckRanks(size, true, 0);
+  }
+}
+
+TEST(COLLECTIVE, RecursiveHalving) {
+  for (int size : {2, 3, 4, 5}) {
+    CheckRanks(size, false, std::numeric_limits<size_t>::max());
+    CheckRanks(size, true, std::numeric_limits<size_t>::max());
+  }
+}
+
+TEST(COLLECTIVE, ShmFallback) {
+  // rings too large to allocate, so that the ranks keep their sockets
+  const size_t shm_size = std::numeric_limits<size_t>::max() / 2;
+  CheckRanks(3, true, 0, shm_size);
+  CheckRanks(3, true, std::numeric_limits<size_t>::max(), shm_size);
+}
+
+TEST(COLLECTIVE, SingleRank) {
+  Collective collective("127.0.0.1", 0, 1, true, 4096, 0);
+  std::vector<float> data = {1, 2, 3};
+  collective.Allreduce(data.data(), data.size(), [](float *, const float *, size_t) {});
+  collective.Barrier();
+  EXPECT_EQ(collective.rank(), 0);
+  EXPECT_EQ(data[2], 3);
+}
+#endif  // _WIN32
@@ -0,0 +1,155 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file gradient_compression_test.cc
+ * \brief Quantization and dequantization of the 1bit, topk and randk gradient compressions
+ */
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/kvstore/gradient_compression.h"
+#include "../src/kvstore/gradient_compression-inl.h"
+
+using mxnet::kvstore::GradientCompression;
+
+namespace {
+
+/*! \brief quantize grad with the residual, then dequantize it, with the CPU kernels */
+void Compress(const std::string& type, int block_size, uint64_t seed,
+              std::vector<float> *grad, std::vector<float> *residual,
+              std::vector<float> *compressed, std::vector<float> *dequantized) {
+  mshadow::Stream<mshadow::cpu> *s = nullptr;
+  const mxnet::TShape shape{static_cast<int64_t>(grad->size())};
+  const mxnet::TShape compressed_shape{static_cast<int64_t>(compressed->size())};
+  std::vector<mxnet::TBlob> inputs = {mxnet::TBlob(grad->data(), shape, mshadow::cpu::kDevMask),
+      mxnet::TBlob(residual->data(), shape, mshadow::cpu::kDevMask),
+      mxnet::TBlob(compressed->data(), compressed_shape, mshadow::cpu::kDevMask)};
+  std::vector<mxnet::TBlob> outputs = {inputs[2],
+      mxnet::TBlob(dequantized->data(), shape, mshadow::cpu::kDevMask)};
+  if (type == "1bit") {
+    mxnet::kvstore::Quantize1BitImpl(s, inputs);
+    mxnet::kvstore::Dequantize1BitImpl(s, outputs);
+  } else {
+    mxnet::kvstore::QuantizeTopKImpl(s, inputs, block_size, type == "randk", seed);
+    mxnet::kvstore::DequantizeTopKImpl(s, outputs, block_size);
+  }
+}
+
+GradientCompression MakeCompression(const std::string& type) {
+  GradientCompression gc;
+  gc.SetParams({{"type", type}, {"ratio", "0.02"}});
+  return gc;
+}
+
+/*!
+ * \brief check that no part of the gradients is lost: what is sent over the steps plus
+ *  the residual left is their sum
+ */
+void CheckErrorFeedback(const std::string& type, int64_t size) {
+  GradientCompression gc = MakeCompression(type);
+  const int block_size = gc.GetBlockSize();
+  std::mt19937 rnd(static_cast<unsigned>(size));
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<float> grad(size), residual(size, 0), compressed(gc.GetCompressedSize(size));
+  std::vector<float> dequantized(size), sent(size, 0), total(size, 0);
+  for (int step = 0; step < 5; ++step) {
+    for (int64_t i = 0; i < size; ++i) {
+      grad[i] = dist(rnd);
+      total[i] += grad[i];
+    }
+    Compress(type, block_size, step, &grad, &residual, &compressed, &dequantized);
+    for (int64_t i = 0; i < size; ++i) sent[i] += dequantized[i];
+  }
+  for (int64_t i = 0; i < size; ++i) {
+    ASSERT_NEAR(sent[i] + residual[i], total[i], 1e-4) << type << " size " << size << " at " << i;
+  }
+}
+
+}  // namespace
+
+TEST(GRADIENT_COMPRESSION, ErrorFeedback) {
+  // sizes with and without a partial last block
+  for (const std::string type : {"1bit", "topk", "randk"}) {
+    for (int64_t size : {1, 49, 50, 1024, 3000}) {
+      CheckErrorFeedback(type, size);
+    }
+  }
+}
+
+TEST(GRADIENT_COMPRESSION, OneBit) {
+  std::vector<float> grad(1500), residual(1500, 0), dequantized(1500);
+  for (size_t i = 0; i < grad.size(); ++i) grad[i] = (i % 3 == 0) ? -2.0f : 0.5f + i % 2;
+  std::vector<float> compressed(MakeCompression("1bit").GetCompressedSize(grad.size()));
+  EXPECT_EQ(compressed.size(), static_cast<size_t>(2 * mxnet::kvstore::k1BitBlockWords));
+  Compress("1bit", 0, 0, &grad, &residual, &compressed, &dequantized);
+  for (int block = 0; block < 2; ++block) {
+    const size_t start = block * mxnet::kvstore::k1BitBlockSize;
+    const size_t end = std::min(grad.size(), start + mxnet::kvstore::k1BitBlockSize);
+    float mean = 0;
+    for (size_t i = start; i < end; ++i) mean += std::fabs(grad[i]);
+    mean /= end - start;
+    for (size_t i = start; i < end; ++i) {
+      ASSERT_FLOAT_EQ(dequantized[i], grad[i] > 0 ? mean : -mean) << i;
+    }
+  }
+}
+
+TEST(GRADIENT_COMPRESSION, TopK) {
+  GradientCompression gc = MakeCompression("topk");
+  ASSERT_EQ(gc.GetBlockSize(), 50);
+  std::vector<float> grad(120, 0.1f), residual(120, 0), dequantized(120);
+  grad[7] = -3;
+  grad[60] = 2;
+  std::vector<float> compressed(gc.GetCompressedSize(grad.size()));
+  ASSERT_EQ(compressed.size(), 6U);
+  Compress("topk", 50, 0, &grad, &residual, &compressed, &dequantized);
+  for (size_t i = 0; i < grad.size(); ++i) {
+    // the last block, of 20 values, sends its first as they are all equal
+    const float expected = (i == 7 || i == 60 || i == 100) ? grad[i] : 0;
+    ASSERT_EQ(dequantized[i], expected) << i;
+    ASSERT_EQ(residual[i], grad[i] - expected) << i;
+  }
+}
+
+TEST(GRADIENT_COMPRESSION, Params) {
+  for (const std::string type : {"2bit", "1bit", "topk", "randk"}) {
+    GradientCompression gc = MakeCompression(type);
+    GradientCompression decoded;
+    decoded.DecodeParams(gc.EncodeParams());
+    EXPECT_EQ(decoded.get_type(), gc.get_type()) << type;
+    EXPECT_EQ(decoded.GetBlockSize(), gc.GetBlockSize()) << type;
+    // whole blocks are compressed independently, as sent to different servers
+    const int64_t block_size = gc.GetBlockSize();
+    EXPECT_EQ(gc.GetCompressedSize(7 * block_size),
+              gc.GetCompressedSize(3 * block_size) + gc.GetCompressedSize(4 * block_size));
+  }
+  EXPECT_EQ(MakeCompression("2bit").GetCompressedSize(33), 3);
+  // a ratio of 2^-24, as positions in larger blocks would not be exact as floats
+  GradientCompression gc;
+  gc.SetParams({{"type", "topk"}, {"ratio", "5.9604644775390625e-8"}});
+  EXPECT_EQ(gc.GetBlockSize(), mxnet::kvstore::kMaxTopKBlockSize);
+  EXPECT_THROW(gc.SetParams({{"type", "topk"}, {"ratio", "1e-9"}}), dmlc::Error);
+}
@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file shared_mem_test.cc
+ * \brief mapping arrays of the kCPUShared context from their storage handles, as the
+ *  servers of the dist kvstores do for the workers on their host
+ */
+#ifndef _WIN32
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <mxnet/storage.h>
+
+#include "../src/kvstore/shared_mem.h"
+
+using mxnet::kvstore::SharedMemSegment;
+
+TEST(SHARED_MEM, MapFromHandle) {
+  constexpr size_t kSize = 100000;
+  auto&& storage = mxnet::Storage::Get();
+  auto handle = storage->Alloc(kSize, mxnet::Context::CPUShared(0));
+  char* data = static_cast<char*>(handle.dptr);
+  for (size_t i = 0; i < kSize; ++i) data[i] = static_cast<char>(i % 101);
+  // another process writes through its own mapping
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    SharedMemSegment segment;
+    bool ok = segment.Open(handle.shared_pid, handle.shared_id, kSize) &&
+              segment.size() == kSize;
+    for (size_t i = 0; ok && i < kSize; ++i) {
+      ok = segment.data()[i] == static_cast<char>(i % 101);
+      segment.data()[i] = static_cast<char>(i % 7);
+    }
+    _exit(ok ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  for (size_t i = 0; i < kSize; ++i) {
+    ASSERT_EQ(data[i], static_cast<char>(i % 7)) << i;
+  }
+  storage->Free(handle);
+}
+
+TEST(SHARED_MEM, NotASegment) {
+  constexpr size_t kSize = 1000;
+  auto&& storage = mxnet::Storage::Get();
+  auto handle = storage->Alloc(kSize, mxnet::Context::CPUShared(0));
+  // bigger than the segment
+  SharedMemSegment too_big;
+  EXPECT_FALSE(too_big.Open(handle.shared_pid, handle.shared_id, 100 * kSize));
+  // a descriptor of the process which is not a segment
+  SharedMemSegment not_shared;
+  EXPECT_FALSE(not_shared.Open(getpid(), STDOUT_FILENO, kSize));
+  storage->Free(handle);
+}
+#endif  // _WIN32
@@ -47,6 +47,39 @@ TEST(Storage, Basic_CPU) {
   storage->Free(handle);
 }
 
+TEST(Storage, Pooled_CPU) {
+  putenv("MXNET_CPU_MEM_POOL_TYPE=Pooled");
+  // use a fresh device id so that the pool is not shared with other tests
+  auto&& storage = mxnet::Storage::Get();
+  mxnet::Context context_cpu = mxnet::Context::CPU(1);
+  auto&& handle = storage->Alloc(32, context_cpu);
+  auto&& handle2 = storage->Alloc(2097153, context_cpu);
+  EXPECT_EQ(handle.ctx, context_cpu);
+  EXPECT_EQ(handle.size, 32);
+  EXPECT_EQ(handle2.size, 2097153);
+  auto ptr = handle.dptr;
+  auto ptr2 = handle2.dptr;
+  storage->Free(handle);
+  storage->Free(handle2);
+
+  // same size class, served from the pool
+  handle = storage->Alloc(4095, context_cpu);
+  EXPECT_EQ(handle.size, 4095);
+  EXPECT_EQ(handle.dptr, ptr);
+  storage->Free(handle);
+
+  handle2 = storage->Alloc(4194304, context_cpu);
+  EXPECT_EQ(handle2.size, 4194304);
+  EXPECT_EQ(handle2.dptr, ptr2);
+  storage->Free(handle2);
+
+  storage->ReleaseAll(context_cpu);
+  handle = storage->Alloc(0, context_cpu);
+  EXPECT_EQ(handle.dptr, nullptr);
+  storage->Free(handle);
+  unsetenv("MXNET_CPU_MEM_POOL_TYPE");
+}
+
 #if MXNET_USE_CUDA
 TEST(Storage_GPU, Basic_GPU) {
   if (mxnet::test::unitTestsWithCuda) {
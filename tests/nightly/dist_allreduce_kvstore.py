@@ -0,0 +1,139 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+"""Runs as many workers of the dist_allreduce kvstore as asked, on this machine.
+
+    python dist_allreduce_kvstore.py -n 4
+"""
+import sys
+sys.path.insert(0, "../../python/")
+import argparse
+import os
+import socket
+import subprocess
+import mxnet as mx
+import numpy as np
+
+shape = (2, 3)
+big_shape = (1200, 1200)
+keys = ['3', '5', '7']
+big_keys = ['99']
+fp16_keys = ['4', '6']
+fp64_keys = ['8']
+nrepeat = 3
+
+
+def check_diff(A, x, rank=None):
+    assert (np.sum(np.abs((A - x).asnumpy())) == 0), (rank, A.asnumpy(), x)
+
+
+def test_sync_push_pull():
+    kv = mx.kv.create('dist_allreduce')
+    rank = kv.rank
+    nworker = kv.num_workers
+    # the values of rank 0 are the initial ones
+    kv.init(keys, [mx.nd.ones(shape) * (rank + 1)] * len(keys))
+    kv.init(big_keys, [mx.nd.ones(big_shape) * (rank + 1)] * len(big_keys))
+    kv.init(fp16_keys, [mx.nd.ones(shape, dtype='float16') * (rank + 1)] * len(fp16_keys))
+    kv.init(fp64_keys, [mx.nd.ones(big_shape, dtype='float64') * (rank + 1)] * len(fp64_keys))
+    for k, s, t in [(keys[0], shape, 'float32'), (big_keys[0], big_shape, 'float32'),
+                    (fp16_keys[0], shape, 'float16'), (fp64_keys[0], big_shape, 'float64')]:
+        val = mx.nd.zeros(s, dtype=t)
+        kv.pull(k, out=val)
+        check_diff(val, 1, rank)
+
+    # without an updater, the values pulled are the sums of the pushed ones
+    for i in range(nrepeat):
+        for k, s, t in [(k, shape, 'float32') for k in keys] + \
+                       [(k, big_shape, 'float32') for k in big_keys] + \
+                       [(k, shape, 'float16') for k in fp16_keys] + \
+                       [(k, big_shape, 'float64') for k in fp64_keys]:
+            # two devices per worker
+            kv.push(k, [mx.nd.ones(s, dtype=t) * (rank + 1)] * 2)
+            val = mx.nd.zeros(s, dtype=t)
+            kv.pull(k, out=val)
+            check_diff(val, nworker * (nworker + 1), rank)
+
+    # with an updater, every worker applies the same update to its copy
+    kv.set_optimizer(mx.optimizer.create('test', rescale_grad=1.0))
+    kv.push(keys[1], mx.nd.ones(shape) * (rank + 1))
+    val = mx.nd.zeros(shape)
+    kv.pull(keys[1], out=val)
+    check_diff(val, nworker * (nworker + 1) + nworker * (nworker + 1) / 2, rank)
+    kv._barrier()
+    print('worker ' + str(rank) + ' of ' + str(nworker) + ' is done')
+
+
+def test_gluon_trainer():
+    kv = mx.kv.create('dist_allreduce')
+    rank = kv.rank
+    nworker = kv.num_workers
+    params = mx.gluon.ParameterDict()
+    # two small parameters, fused into a bucket when MXNET_KVSTORE_FUSION_BOUND is set
+    x = params.get('x', shape=(10, 1), lr_mult=1.0)
+    z = params.get('z', shape=(3, 4), lr_mult=1.0)
+    params.initialize(ctx=[mx.cpu(0), mx.cpu(1)], init=mx.init.Constant(rank))
+    trainer = mx.gluon.Trainer(params, 'sgd', {'learning_rate': 0.1}, kvstore=kv)
+    for i in range(nrepeat):
+        with mx.autograd.record():
+            for w in x.list_data() + z.list_data():
+                y = w + 1
+                y.backward()
+        trainer.step(1)
+    # the weights start from those of rank 0, and the gradients of all the devices of all
+    # the workers are summed
+    expected = -0.1 * 2 * nworker * nrepeat
+    for w in x.list_data() + z.list_data():
+        assert np.allclose(w.asnumpy(), expected), (rank, w.asnumpy(), expected)
+
+
+def launch(num_workers, args):
+    """start the workers, and check that they all succeed"""
+    s = socket.socket()
+    s.bind(('127.0.0.1', 0))
+    port = s.getsockname()[1]
+    s.close()
+    env = dict(os.environ, DMLC_NUM_WORKER=str(num_workers),
+               DMLC_PS_ROOT_URI='127.0.0.1', DMLC_PS_ROOT_PORT=str(port))
+    procs = [subprocess.Popen([sys.executable, __file__] + args, env=env)
+             for _ in range(num_workers)]
+    codes = [p.wait() for p in procs]
+    assert all(code == 0 for code in codes), codes
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='test the dist_allreduce kvstore')
+    parser.add_argument('-n', '--num-workers', type=int, default=4)
+    parser.add_argument('--type', type=str, default='all')
+    opt = parser.parse_args()
+    if 'DMLC_NUM_WORKER' not in os.environ:
+        for shm in ['1', '0']:
+            for ring_bound in ['1048576', '0']:
+                os.environ['MXNET_KVSTORE_ALLREDUCE_SHM'] = shm
+                os.environ['MXNET_KVSTORE_ALLREDUCE_RING_BOUND'] = ring_bound
+                launch(opt.num_workers, ['--type', opt.type])
+        # small keys fused into buckets
+        os.environ['MXNET_KVSTORE_FUSION_BOUND'] = '4096'
+        launch(opt.num_workers, ['--type', opt.type])
+    else:
+        if opt.type in ('all', 'kvstore'):
+            test_sync_push_pull()
+        if opt.type in ('all', 'gluon'):
+            test_gluon_trainer()
@@ -165,6 +165,39 @@ def test_reshape():
     assert np.all(new_exe.arg_arrays[1].asnumpy() == 1)
 
 
+@with_seed()
+def test_best_fit_offset_planner():
+    data = mx.sym.var('data')
+    fc1 = mx.sym.FullyConnected(data, num_hidden=256, name='fc1')
+    act = mx.sym.relu(fc1, name='relu')
+    fc2 = mx.sym.FullyConnected(act, num_hidden=256, name='fc2')
+    fc3 = mx.sym.FullyConnected(act, num_hidden=128, name='fc3')
+    concat = mx.sym.concat(fc2, fc3, dim=1, name='concat')
+    out = mx.sym.FullyConnected(concat, num_hidden=10, name='fc4')
+    data_shape = (32, 64)
+
+    default_exe = out.simple_bind(mx.cpu(), data=data_shape)
+    for arr in default_exe.arg_arrays:
+        arr[:] = mx.nd.random.uniform(-1, 1, arr.shape)
+    head_grad = mx.nd.random.uniform(-1, 1, (32, 10))
+    default_plan = out.plan_memory(ctx=mx.cpu(), data=data_shape)
+    with mx.test_utils.EnvManager('MXNET_EXEC_MEM_PLANNER', 'best_fit_offset'):
+        arena_exe = out.simple_bind(mx.cpu(), data=data_shape)
+        arena_plan = out.plan_memory(ctx=mx.cpu(), data=data_shape)
+    for src, dst in zip(default_exe.arg_arrays, arena_exe.arg_arrays):
+        src.copyto(dst)
+    assert arena_plan['planned_bytes'] <= default_plan['planned_bytes']
+
+    for is_train in [False, True]:
+        default_exe.forward(is_train=is_train)
+        arena_exe.forward(is_train=is_train)
+        assert_almost_equal(default_exe.outputs[0].asnumpy(), arena_exe.outputs[0].asnumpy())
+    default_exe.backward([head_grad])
+    arena_exe.backward([head_grad])
+    for default_grad, arena_grad in zip(default_exe.grad_arrays, arena_exe.grad_arrays):
+        assert_almost_equal(default_grad.asnumpy(), arena_grad.asnumpy())
+
+
 if __name__ == "__main__":
     import nose
     nose.runmodule()
@@ -1458,6 +1458,31 @@ def test_hybrid_static_memory_switching():
     check_hybrid_static_memory_switching()
     check_hybrid_static_memory_switching(static_alloc=True)
     check_hybrid_static_memory_switching(static_alloc=True, static_shape=True)
+    check_hybrid_static_memory_switching(static_alloc=True, static_shape=True, frozen=True)
+
+@with_seed()
+def test_hybrid_frozen_replay():
+    net = nn.HybridSequential()
+    with net.name_scope():
+        net.add(nn.Dense(32, activation='relu'))
+        net.add(nn.Dense(16, activation='tanh'))
+        net.add(nn.Dense(8))
+    net.initialize()
+    net.hybridize()
+    x1 = mx.nd.random.uniform(shape=(4, 10))
+    x2 = mx.nd.random.uniform(shape=(4, 10))
+    x3 = mx.nd.random.uniform(shape=(2, 10))
+    y1, y2, y3 = [net(x).asnumpy() for x in [x1, x2, x3]]
+
+    net.hybridize(static_alloc=True, static_shape=True, frozen=True)
+    out1 = net(x1)
+    assert_almost_equal(out1.asnumpy(), y1, rtol=1e-5, atol=1e-6)
+    out2 = net(x2)
+    assert_almost_equal(out2.asnumpy(), y2, rtol=1e-5, atol=1e-6)
+    # the replay writes into the arrays returned by the previous call
+    assert_almost_equal(out1.asnumpy(), y2, rtol=1e-5, atol=1e-6)
+    # a new input shape records the pass again
+    assert_almost_equal(net(x3).asnumpy(), y3, rtol=1e-5, atol=1e-6)
 
 @with_seed()
 def test_hook():
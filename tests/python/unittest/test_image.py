@@ -161,6 +161,36 @@ class TestImage(unittest.TestCase):
             cv_image = cv2.imread(img)
             assert_almost_equal(image.asnumpy(), cv_image)
 
+    def test_imdecode_batch(self):
+        try:
+            import cv2
+        except ImportError:
+            raise unittest.SkipTest("Unable to import cv2.")
+        bufs = []
+        for img in TestImage.IMAGES:
+            with open(img, 'rb') as fp:
+                bufs.append(fp.read())
+        cv_images = [cv2.imread(img) for img in TestImage.IMAGES]
+        data, sizes = mx.image.imdecode_batch(bufs, to_rgb=False)
+        max_h = max(im.shape[0] for im in cv_images)
+        max_w = max(im.shape[1] for im in cv_images)
+        assert data.shape == (len(bufs), max_h, max_w, 3)
+        for i, cv_image in enumerate(cv_images):
+            h, w = sizes[i].asnumpy()
+            assert (h, w) == cv_image.shape[:2]
+            image = data[i].asnumpy()
+            # libjpeg-turbo and OpenCV may round the inverse DCT differently
+            assert_almost_equal(image[:h, :w], cv_image, atol=4)
+            assert not image[h:].any() and not image[:, w:].any()
+        data, sizes = mx.image.imdecode_batch(bufs, size=(32, 24), interp=1)
+        assert data.shape == (len(bufs), 24, 32, 3)
+        assert (sizes.asnumpy() == [24, 32]).all()
+        for i, cv_image in enumerate(cv_images):
+            cv_resized = cv2.resize(cv_image, (32, 24), interpolation=1)
+            assert_almost_equal(data[i].asnumpy(), cv_resized[:, :, (2, 1, 0)], atol=4)
+        gray, _ = mx.image.imdecode_batch(bufs[:1], flag=0)
+        assert gray.shape == (1,) + cv_images[0].shape[:2] + (1,)
+
     @raises(mx.base.MXNetError)
     def test_imdecode_empty_buffer(self):
         mx.image.imdecode(b'', to_rgb=0)
@@ -443,6 +443,115 @@ def test_CSVIter():
     for dtype in ['int32', 'int64', 'float32']:
         check_CSVIter_synthetic(dtype=dtype)
 
+def test_CSVIter_preprocess_threads():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_threads.t')
+    num_rows = 4000
+    # large enough for every thread to get a share of the lines
+    with open(data_path, 'w') as fout:
+        for i in range(num_rows):
+            fout.write(','.join(['%d.%d' % (i, j) for j in range(16)]) + '\n')
+
+    expected = np.array([[float('%d.%d' % (i, j)) for j in range(16)]
+                         for i in range(num_rows)], dtype=np.float32)
+    for preprocess_threads in [1, 4]:
+        data_iter = mx.io.CSVIter(data_csv=data_path, data_shape=(16,), batch_size=500,
+                                  preprocess_threads=preprocess_threads)
+        rows = np.concatenate([batch.data[0].asnumpy() for batch in data_iter])
+        assert_almost_equal(rows, expected)
+    os.remove(data_path)
+
+def test_CSVIter_batch_memory():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_rows.t')
+    num_rows = 60
+    with open(data_path, 'w') as fout:
+        for i in range(num_rows):
+            fout.write(','.join([str(i)] * 4) + '\n')
+
+    # more batches than the prefetcher holds, so most are written into recycled batches
+    for batch_memory in ['cpu', 'pinned', 'shared']:
+        data_iter = mx.io.CSVIter(data_csv=data_path, data_shape=(4,), batch_size=3,
+                                  prefetch_buffer=1, prefetch_queue_size=1,
+                                  batch_memory=batch_memory)
+        for epoch in range(2):
+            data_iter.reset()
+            rows = []
+            for batch in data_iter:
+                rows.extend(batch.data[0].asnumpy()[:, 0].tolist())
+            assert rows == list(range(num_rows))
+    os.remove(data_path)
+
+def _read_batches(data_iter, num_batches, with_data=False):
+    """the labels, and the data if asked, of the next batches, going on with the next epoch
+    at the end of one"""
+    labels = []
+    while len(labels) < num_batches:
+        try:
+            batch = data_iter.next()
+        except StopIteration:
+            data_iter.reset()
+            continue
+        label = batch.label[0].asnumpy().tolist()
+        if with_data:
+            data = batch.data[0]
+            if data.stype != 'default':
+                data = data.tostype('default')
+            labels.append((label, data.asnumpy().tolist()))
+        else:
+            labels.append(label)
+    return labels
+
+def test_CSVIter_save_load_state():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_state.t')
+    label_path = os.path.join(cwd, 'label_state.t')
+    num_rows = 25
+    with open(data_path, 'w') as fout:
+        for i in range(num_rows):
+            fout.write(','.join([str(i)] * 4) + '\n')
+    with open(label_path, 'w') as fout:
+        for i in range(num_rows):
+            fout.write('%d\n' % i)
+
+    def make_iter():
+        return mx.io.CSVIter(data_csv=data_path, data_shape=(4,), label_csv=label_path,
+                             batch_size=10, preprocess_threads=2)
+
+    # save at the start, in the middle of an epoch and after the batch wrapping around
+    for num_read in [0, 2, 3, 5]:
+        data_iter = make_iter()
+        _read_batches(data_iter, num_read)
+        state = data_iter.save_state()
+        expected = _read_batches(data_iter, 6)
+        resumed = make_iter()
+        resumed.load_state(state)
+        assert _read_batches(resumed, 6) == expected
+    os.remove(data_path)
+    os.remove(label_path)
+
+def test_LibSVMIter_save_load_state():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_state.libsvm')
+    num_rows = 25
+    with open(data_path, 'w') as fout:
+        for i in range(num_rows):
+            fout.write('%d %d:%d %d:0.5\n' % (i, i % 5, i, 5 + i % 3))
+
+    def make_iter():
+        return mx.io.LibSVMIter(data_libsvm=data_path, data_shape=(8,), batch_size=10)
+
+    # save at the start, in the middle of an epoch and after the batch wrapping around
+    for num_read in [0, 1, 2, 3, 5]:
+        data_iter = make_iter()
+        _read_batches(data_iter, num_read)
+        state = data_iter.save_state()
+        expected = _read_batches(data_iter, 6, with_data=True)
+        resumed = make_iter()
+        resumed.load_state(state)
+        assert _read_batches(resumed, 6, with_data=True) == expected
+    os.remove(data_path)
+
 def test_ImageRecordIter_seed_augmentation():
     get_cifar10()
     seed_aug = 3
@@ -568,6 +677,162 @@ def test_ImageRecordIter_seed_augmentation():
     
     assert_dataiter_items_equals(dataiter1, dataiter2)
 
+def test_ImageRecordIter_jpeg_scaled_decode():
+    try:
+        import cv2
+    except ImportError:
+        raise unittest.SkipTest("jpeg_scaled_decode test requires OpenCV python bindings")
+    import tempfile
+    tmpdir = tempfile.mkdtemp()
+    rec_path = os.path.join(tmpdir, 'large.rec')
+    # smooth images, 8 times larger than the network input
+    writer = mx.recordio.MXRecordIO(rec_path, 'w')
+    ys, xs = np.mgrid[0:256, 0:320]
+    for i in range(4):
+        img = np.stack([xs * 255 // 320, ys * 255 // 256, (xs + ys + 40 * i) % 256], axis=2)
+        header = mx.recordio.IRHeader(0, float(i), i, 0)
+        writer.write(mx.recordio.pack_img(header, img.astype(np.uint8), quality=95))
+    writer.close()
+
+    def read_all(scaled):
+        it = mx.io.ImageRecordIter(path_imgrec=rec_path, data_shape=(3, 32, 32),
+                                   resize=32, batch_size=4, shuffle=False,
+                                   preprocess_threads=1, jpeg_scaled_decode=scaled)
+        return it.next().data[0].asnumpy()
+
+    full = read_all(False)
+    scaled = read_all(True)
+    os.remove(rec_path)
+    os.rmdir(tmpdir)
+    assert full.shape == scaled.shape
+    # only the resampling differs between a scaled and a full decode
+    assert np.mean(np.abs(full - scaled)) < 4
+
+def test_ImageRecordIter_mmap_recordio():
+    try:
+        import cv2
+    except ImportError:
+        raise unittest.SkipTest("mmap_recordio test requires OpenCV python bindings")
+    import tempfile
+    tmpdir = tempfile.mkdtemp()
+    rec_path = os.path.join(tmpdir, 'small.rec')
+    idx_path = os.path.join(tmpdir, 'small.idx')
+    num_records = 12
+    writer = mx.recordio.MXIndexedRecordIO(idx_path, rec_path, 'w')
+    for i in range(num_records):
+        img = np.random.randint(0, 256, size=(8, 8, 3), dtype=np.uint8)
+        header = mx.recordio.IRHeader(0, float(i), i, 0)
+        writer.write_idx(i, mx.recordio.pack_img(header, img, img_fmt='.png'))
+    writer.close()
+
+    def read_labels(batch_size=4, **kwargs):
+        it = mx.io.ImageRecordIter(path_imgrec=rec_path, path_imgidx=idx_path,
+                                   data_shape=(3, 8, 8), batch_size=batch_size,
+                                   preprocess_threads=2, **kwargs)
+        labels = []
+        for batch in it:
+            labels.extend(batch.label[0].asnumpy().tolist())
+        return labels
+
+    assert read_labels(mmap_recordio=True, shuffle=False) == \
+        read_labels(mmap_recordio=False, shuffle=False)
+    shuffled = read_labels(mmap_recordio=True, shuffle=True, seed=3)
+    # a global shuffle visits every record once per epoch
+    assert sorted(shuffled) == list(range(num_records))
+    assert shuffled != list(range(num_records))
+    part = read_labels(batch_size=3, mmap_recordio=True, shuffle=False,
+                       num_parts=2, part_index=1)
+    assert part == list(range(num_records // 2, num_records))
+    # the batches are allocated in the memory asked for
+    for batch_memory, device_type in [('cpu', 'cpu'), ('pinned', 'cpu_pinned'),
+                                      ('shared', 'cpu_shared')]:
+        it = mx.io.ImageRecordIter(path_imgrec=rec_path, data_shape=(3, 8, 8), batch_size=4,
+                                   device_id=-1, batch_memory=batch_memory)
+        for batch in it:
+            assert batch.data[0].context.device_type == device_type
+            assert batch.label[0].context.device_type == device_type
+
+    def make_iter():
+        return mx.io.ImageRecordIter(path_imgrec=rec_path, path_imgidx=idx_path,
+                                     data_shape=(3, 8, 8), batch_size=5, preprocess_threads=2,
+                                     mmap_recordio=True, shuffle=True, seed=5)
+
+    # a loaded state continues with the same records, through the shuffles of later epochs
+    for num_read in [0, 3, 4]:
+        data_iter = make_iter()
+        _read_batches(data_iter, num_read)
+        state = data_iter.save_state()
+        expected = _read_batches(data_iter, 6)
+        resumed = make_iter()
+        resumed.load_state(state)
+        assert _read_batches(resumed, 6) == expected
+
+    def make_aug_iter():
+        # one thread, since threads take images in any order, and no seed_aug, so that the
+        # random states of the augmentation are resumed
+        return mx.io.ImageRecordIter(path_imgrec=rec_path, path_imgidx=idx_path,
+                                     data_shape=(3, 8, 8), batch_size=5, preprocess_threads=1,
+                                     mmap_recordio=True, shuffle=True, seed=5,
+                                     rand_mirror=True, max_random_contrast=0.3,
+                                     max_random_illumination=20)
+
+    # the images of a loaded state are augmented the same, including the ones parsed with
+    # the previous batch and decoded again
+    for num_read in [0, 1, 2, 3, 4]:
+        data_iter = make_aug_iter()
+        _read_batches(data_iter, num_read)
+        state = data_iter.save_state()
+        expected = _read_batches(data_iter, 6, with_data=True)
+        resumed = make_aug_iter()
+        resumed.load_state(state)
+        assert _read_batches(resumed, 6, with_data=True) == expected
+    for path in (rec_path, idx_path):
+        os.remove(path)
+    os.rmdir(tmpdir)
+
+def test_ImageRecordIter_decoded_cache():
+    try:
+        import cv2
+    except ImportError:
+        raise unittest.SkipTest("decoded_cache test requires OpenCV python bindings")
+    import tempfile
+    tmpdir = tempfile.mkdtemp()
+    rec_path = os.path.join(tmpdir, 'cache.rec')
+    num_records = 10
+    writer = mx.recordio.MXRecordIO(rec_path, 'w')
+    for i in range(num_records):
+        img = np.random.randint(0, 256, size=(16, 20, 3), dtype=np.uint8)
+        header = mx.recordio.IRHeader(0, float(i), i, 0)
+        writer.write(mx.recordio.pack_img(header, img, img_fmt='.png'))
+    writer.close()
+
+    def read_epochs(**kwargs):
+        it = mx.io.ImageRecordIter(path_imgrec=rec_path, data_shape=(3, 12, 12),
+                                   batch_size=5, rand_crop=True, rand_mirror=True,
+                                   seed_aug=7, preprocess_threads=2, **kwargs)
+        epochs = []
+        for _ in range(3):
+            it.reset()
+            epochs.append(np.concatenate([batch.data[0].asnumpy() for batch in it]))
+        return epochs
+
+    expected = read_epochs()
+    spill_path = os.path.join(tmpdir, 'cache.bin')
+    # later epochs augment the cached images, held in memory or in the spill file
+    for size, spill in [(1, ''), (0, spill_path)]:
+        for actual, want in zip(read_epochs(decoded_cache_size=size,
+                                            decoded_cache_file=spill), expected):
+            assert_almost_equal(actual, want)
+    assert not os.path.exists(spill_path)
+    # images cached scaled down to the resize come out as if resized by the augmenter
+    for inter_method in [0, 1, 2, 3, 9, 10]:
+        expected = read_epochs(resize=13, inter_method=inter_method)
+        for actual, want in zip(read_epochs(resize=13, inter_method=inter_method,
+                                            decoded_cache_size=1), expected):
+            assert_almost_equal(actual, want)
+    os.remove(rec_path)
+    os.rmdir(tmpdir)
+
 if __name__ == "__main__":
     test_NDArrayIter()
     if h5py:
@@ -577,5 +842,11 @@ if __name__ == "__main__":
     test_LibSVMIter()
     test_NDArrayIter_csr()
     test_CSVIter()
+    test_CSVIter_batch_memory()
+    test_CSVIter_save_load_state()
+    test_LibSVMIter_save_load_state()
     test_ImageRecordIter_seed_augmentation()
     test_image_iter_exception()
+    test_ImageRecordIter_jpeg_scaled_decode()
+    test_ImageRecordIter_mmap_recordio()
+    test_ImageRecordIter_decoded_cache()
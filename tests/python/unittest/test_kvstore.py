@@ -16,6 +16,7 @@
 # under the License.
 
 # pylint: skip-file
+import os
 import mxnet as mx
 import numpy as np
 import unittest
@@ -223,6 +224,98 @@ def test_sparse_aggregator():
     check_sparse_aggregator(False)
     check_sparse_aggregator(True)
 
+@with_seed()
+def test_sparse_aggregator_big():
+    """aggregate big sparse ndarrays on multiple cpus, in parallel and serially"""
+    big_shape = (200000, 8)
+    num_devs = 4
+    devs = [mx.Context('cpu', i) for i in range(num_devs)]
+    vals = [rand_ndarray(big_shape, 'row_sparse', density=0.5).copyto(devs[i])
+            for i in range(num_devs)]
+    # an empty array takes no part in the merge
+    vals.append(mx.nd.sparse.zeros('row_sparse', big_shape, ctx=mx.Context('cpu', num_devs)))
+    expected_sum = np.zeros(big_shape)
+    for v in vals:
+        expected_sum += v.asnumpy()
+
+    def reduce(serial):
+        os.environ['MXNET_KVSTORE_SERIAL_PUSH'] = '1' if serial else '0'
+        try:
+            kv = mx.kv.create()
+        finally:
+            del os.environ['MXNET_KVSTORE_SERIAL_PUSH']
+        kv.init('a', mx.nd.sparse.zeros('row_sparse', big_shape))
+        kv.push('a', vals)
+        out = mx.nd.sparse.zeros('row_sparse', big_shape)
+        kv.pull('a', out=out, ignore_sparse=False)
+        return out
+
+    parallel = reduce(False)
+    assert_almost_equal(parallel.asnumpy(), expected_sum)
+    # the rows are summed up in the same order on both paths
+    serial = reduce(True)
+    assert_almost_equal(serial.indices.asnumpy(), parallel.indices.asnumpy())
+    assert_almost_equal(serial.data.asnumpy(), parallel.data.asnumpy(), rtol=0, atol=0)
+
+def fusion_kv(bound):
+    """create a kvstore fusing keys of fewer than bound bytes"""
+    os.environ['MXNET_KVSTORE_FUSION_BOUND'] = str(bound)
+    try:
+        return mx.kv.create()
+    finally:
+        del os.environ['MXNET_KVSTORE_FUSION_BOUND']
+
+@with_seed()
+def test_fused_keys():
+    """push and pull small keys fused into buckets"""
+    num_devs = 4
+    devs = [mx.Context('cpu', i) for i in range(num_devs)]
+    # the big key, of 1600 bytes, is not fused
+    shapes = [(4, 4), (3,), (2, 5), (20, 20), (1,), (7,), (4, 4), (2, 2, 2), (6,)]
+
+    def check_fused_keys(use_updater, interleave):
+        kv = fusion_kv(128)
+        for k, s in enumerate(shapes):
+            kv.init(k, mx.nd.ones(s))
+        if use_updater:
+            kv._set_updater(updater)
+        expected = [np.ones(s) for s in shapes]
+        for _ in range(3):
+            vals = [[mx.nd.random.uniform(shape=s, ctx=d) for d in devs] for s in shapes]
+            outs = [[mx.nd.zeros(s, ctx=d) for d in devs] for s in shapes]
+            for k, vv in enumerate(vals):
+                total = sum(v.asnumpy() for v in vv)
+                expected[k] = expected[k] + total if use_updater else total
+            if interleave:
+                for k in range(len(shapes)):
+                    kv.push(k, vals[k])
+                    kv.pull(k, out=outs[k])
+            else:
+                for k in reversed(range(len(shapes))):
+                    kv.push(k, vals[k])
+                kv.pull(list(range(len(shapes))), out=outs)
+            for e, out in zip(expected, outs):
+                for o in out:
+                    assert_almost_equal(o.asnumpy(), e)
+        # after full steps, some keys pushed, one of them twice, and pulled before the
+        # keys fused with them, as with conditional branches, are no longer fused
+        partial = [0, 4, 0, 2, 5]
+        for k in partial:
+            vv = [mx.nd.random.uniform(shape=shapes[k], ctx=d) for d in devs]
+            total = sum(v.asnumpy() for v in vv)
+            expected[k] = expected[k] + total if use_updater else total
+            kv.push(k, vv)
+        for k in set(partial):
+            out = [mx.nd.zeros(shapes[k], ctx=d) for d in devs]
+            kv.pull(k, out=out)
+            for o in out:
+                assert_almost_equal(o.asnumpy(), expected[k])
+
+    for use_updater in [False, True]:
+        # keys pushed and pulled one after another are no longer fused
+        for interleave in [False, True]:
+            check_fused_keys(use_updater, interleave)
+
 def updater(key, recv, local):
     """use updater: += with int keys"""
     assert(isinstance(key, int))
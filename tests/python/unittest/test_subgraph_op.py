@@ -17,11 +17,14 @@
 
 import os
 import ctypes
+import json
+import unittest
 import mxnet as mx
 from mxnet.base import SymbolHandle, check_call, _LIB, mx_uint, c_str_array, c_str
 from mxnet.symbol import Symbol
 import numpy as np
 from mxnet.test_utils import assert_almost_equal
+from nose.tools import assert_raises
 
 
 def _test_subgraph_exe(subgraph_backend):
@@ -238,6 +241,113 @@ def test_subgraph_exe():
 def test_subgraph_v2_exe():
     _test_subgraph_exe('default_v2')
 
+def test_elemwise_fusion():
+    data = mx.sym.var('data')
+    bias = mx.sym.var('bias')
+    out = mx.sym.broadcast_add(data, bias)
+    out = mx.sym.Activation(out, act_type='sigmoid') * data
+    out = mx.sym.relu(2 - out) / 3 + mx.sym.exp(bias)
+    out = mx.sym.sqrt(mx.sym.square(out) + 1)
+    out = mx.sym.Group([out, mx.sym.tanh(data)])
+    shapes = {'data': (4, 5, 300), 'bias': (1, 5, 1)}
+
+    fused = out.get_backend_symbol('ELEMWISE_FUSION')
+    op_names = [n['op'] for n in json.loads(fused.tojson())['nodes']]
+    assert '_sg_elemwise_fusion' in op_names
+    assert 'sqrt' not in op_names
+
+    args = {k: mx.nd.random.uniform(-1, 1, shape=v) for k, v in shapes.items()}
+    def run(sym):
+        grads = {k: mx.nd.zeros(v) for k, v in shapes.items()}
+        exe = sym.bind(mx.cpu(), args=args, args_grad=grads)
+        outputs = exe.forward(is_train=True)
+        exe.backward([mx.nd.ones_like(o) for o in outputs])
+        return [o.asnumpy() for o in outputs], {k: v.asnumpy() for k, v in grads.items()}
+
+    ref_outs, ref_grads = run(out)
+    outs, grads = run(mx.sym.load_json(fused.tojson()))
+    for ref, o in zip(ref_outs, outs):
+        assert_almost_equal(ref, o, rtol=1e-5, atol=1e-6)
+    for k in shapes:
+        assert_almost_equal(ref_grads[k], grads[k], rtol=1e-5, atol=1e-6)
+
+    class Net(mx.gluon.HybridBlock):
+        def hybrid_forward(self, F, x, b):
+            return F.relu(F.broadcast_mul(x, b) - 0.5) * 2
+
+    net = Net()
+    ref = net(args['data'], args['bias'])
+    net.hybridize(backend='ELEMWISE_FUSION')
+    x = args['data'].copy()
+    x.attach_grad()
+    with mx.autograd.record():
+        y = net(x, args['bias'])
+    y.backward()
+    assert_almost_equal(ref.asnumpy(), y.asnumpy())
+    assert_almost_equal(x.grad.asnumpy(),
+                        ((ref.asnumpy() > 0) * 2 * args['bias'].asnumpy()) * np.ones(shapes['data']))
+
+def test_elemwise_fusion_int_types():
+    # integer chains, such as index arithmetic, are left to the original operators
+    idx = mx.sym.var('idx')
+    data = mx.sym.var('data')
+    out = mx.sym.Group([(idx + 1) * 2 - idx, mx.sym.relu(data * 2) + 1])
+    os.environ['MXNET_SUBGRAPH_BACKEND'] = 'ELEMWISE_FUSION'
+    try:
+        exe = out.simple_bind(mx.cpu(), grad_req='null', idx=(3, 4), data=(3, 4),
+                              type_dict={'idx': np.int32, 'data': np.float32})
+    finally:
+        del os.environ['MXNET_SUBGRAPH_BACKEND']
+    optimized = SymbolHandle()
+    check_call(_LIB.MXExecutorGetOptimizedSymbol(exe.handle, ctypes.byref(optimized)))
+    nodes = json.loads(Symbol(optimized).tojson())['nodes']
+    fused = [n for n in nodes if n['op'] == '_sg_elemwise_fusion']
+    assert len(fused) == 1
+    assert '_plus_scalar' in [n['op'] for n in nodes]
+    exe.arg_dict['idx'][:] = np.arange(12).reshape((3, 4))
+    exe.arg_dict['data'][:] = np.arange(12).reshape((3, 4)) - 6
+    outputs = exe.forward()
+    assert outputs[0].dtype == np.int32
+    assert_almost_equal(outputs[0].asnumpy(), np.arange(12).reshape((3, 4)) + 2)
+    assert_almost_equal(outputs[1].asnumpy(),
+                        np.maximum(np.arange(12).reshape((3, 4)) - 6, 0) * 2 + 1)
+
+def test_elemwise_fusion_int_types_backend():
+    # get_backend_symbol partitions without types, so integer chains get fused and must run
+    idx = mx.sym.var('idx')
+    out = mx.sym.relu((idx + 1) * 2 - idx) / 2
+    fused = out.get_backend_symbol('ELEMWISE_FUSION')
+    assert '_sg_elemwise_fusion' in [n['op'] for n in json.loads(fused.tojson())['nodes']]
+    for dtype in [np.int32, np.int64, np.uint8]:
+        args = {'idx': mx.nd.array(np.arange(12).reshape((3, 4)), dtype=dtype)}
+        ref = out.bind(mx.cpu(), args=args).forward()[0]
+        outputs = fused.bind(mx.cpu(), args=args).forward()
+        assert outputs[0].dtype == dtype
+        assert_almost_equal(outputs[0].asnumpy(), ref.asnumpy())
+        assert_almost_equal(outputs[0].asnumpy(), (np.arange(12).reshape((3, 4)) + 2) // 2)
+
+    class Net(mx.gluon.HybridBlock):
+        def hybrid_forward(self, F, x):
+            return F.relu(x * 2 - 3) + 1
+
+    net = Net()
+    net.hybridize(backend='ELEMWISE_FUSION')
+    x = mx.nd.array(np.arange(6).reshape((2, 3)), dtype=np.int32)
+    y = net(x)
+    assert y.dtype == np.int32
+    assert_almost_equal(y.asnumpy(), np.maximum(np.arange(6).reshape((2, 3)) * 2 - 3, 0) + 1)
+
+@unittest.skipIf(mx.context.num_gpus() == 0, "requires a GPU")
+def test_elemwise_fusion_gpu_context():
+    # the fused operator only runs on CPU
+    class Net(mx.gluon.HybridBlock):
+        def hybrid_forward(self, F, x):
+            return F.relu(x * 2) + 1
+
+    net = Net()
+    net.hybridize(backend='ELEMWISE_FUSION')
+    assert_raises(ValueError, net, mx.nd.ones((2, 3), ctx=mx.gpu(0)))
+
 if __name__ == '__main__':
     import nose
     nose.runmodule()
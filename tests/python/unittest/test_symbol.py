@@ -373,6 +373,29 @@ def test_children_same_name():
     for c in b.get_children():
         pass
 
+def test_plan_memory():
+    data = mx.sym.var('data')
+    fc = mx.sym.FullyConnected(data, num_hidden=128, name='fc')
+    out = mx.sym.relu(fc, name='relu')
+    arg_bytes = (64 * 256 + 128 * 256 + 128) * 4
+
+    plan = out.plan_memory(ctx=mx.cpu(), data=(64, 256))
+    assert plan['input_bytes'] == arg_bytes
+    assert plan['external_bytes'] == 0
+    # relu writes into the output of fc, which needs a single pool block
+    assert plan['planned_bytes'] == 64 * 128 * 4
+    assert plan['peak_live_bytes'] == plan['planned_bytes']
+    assert len(plan['storage']) == 1
+    inplace = [(plan['nodes'][p['node_id']], p['input']) for p in plan['inplace']]
+    assert inplace == [('relu', 0)]
+    first, last = plan['storage'][0]['lifetimes'][0]
+    assert plan['nodes'][first] == 'fc' and plan['nodes'][last] == 'relu'
+
+    train_plan = out.plan_memory(ctx=mx.cpu(), for_training=True, data=(64, 256))
+    assert train_plan['external_bytes'] == arg_bytes
+    assert train_plan['planned_bytes'] >= plan['planned_bytes']
+    assert train_plan['peak_live_bytes'] <= train_plan['planned_bytes']
+
 if __name__ == '__main__':
     import nose
     nose.runmodule()
@@ -25,16 +25,23 @@
  *  The 64bit zero pad was reserved for future purposes
  *
  *  Image List Format: unique-image-index label[s] path-to-image
+ *
+ *  Images are read, resized and encoded by nthread threads, and written in the order of
+ *  the list, round robin into num_shards files, each with an index of "key offset" lines.
  * \sa dmlc/recordio.h
  */
+#include <algorithm>
 #include <cctype>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 #include <iomanip>
 #include <sstream>
 #include <dmlc/base.h>
+#include <dmlc/common.h>
 #include <dmlc/io.h>
+#include <dmlc/omp.h>
 #include <dmlc/timer.h>
 #include <dmlc/logging.h>
 #include <dmlc/recordio.h>
@@ -62,6 +69,152 @@ int GetInterMethod(int inter_method, int old_width, int old_height, int new_widt
         return inter_method;
     }
 }
+/*! \brief how the images of the list are packed */
+struct PackParam {
+  std::string root;
+  int label_width;
+  int pack_label;
+  int new_size;
+  int center_crop;
+  int color_mode;
+  int unchanged;
+  int inter_method;
+  std::string encoding;
+  std::vector<int> encode_params;
+};
+
+/*!
+ * \brief pack the image of a line of the list into a record, called concurrently
+ * \param sline the line of the list
+ * \param key set to the index of the image
+ * \param blob set to the record
+ * \return false if the line holds no image
+ */
+bool PackImage(const std::string& sline, const PackParam& param, std::mt19937& prnd,
+               uint64_t *key, std::string *blob) {
+  const static size_t kBufferSize = 1 << 20UL;
+  using dmlc::BeginPtr;
+  mxnet::io::ImageRecordIO rec;
+  std::istringstream is(sline);
+  if (!(is >> rec.header.image_id[0] >> rec.header.label)) return false;
+  *key = rec.header.image_id[0];
+  std::vector<float> label_buf(param.label_width, 0.f);
+  label_buf[0] = rec.header.label;
+  for (int k = 1; k < param.label_width; ++k) {
+    CHECK(is >> label_buf[k])
+        << "Invalid ImageList, did you provide the correct label_width?";
+  }
+  if (param.pack_label) rec.header.flag = param.label_width;
+  rec.SaveHeader(blob);
+  if (param.pack_label) {
+    size_t bsize = blob->size();
+    blob->resize(bsize + label_buf.size()*sizeof(float));
+    memcpy(BeginPtr(*blob) + bsize,
+           BeginPtr(label_buf), label_buf.size()*sizeof(float));
+  }
+  std::string fname;
+  CHECK(std::getline(is, fname));
+  // eliminate invalid chars in the end
+  while (fname.length() != 0 &&
+         (isspace(*fname.rbegin()) || !isprint(*fname.rbegin()))) {
+    fname.resize(fname.length() - 1);
+  }
+  // eliminate invalid chars in beginning.
+  const char *p = fname.c_str();
+  while (isspace(*p)) ++p;
+  std::string path = param.root + p;
+  // use "r" is equal to rb in dmlc::Stream
+  std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(path.c_str(), "r"));
+  std::vector<unsigned char> decode_buf;
+  size_t imsize = 0;
+  while (true) {
+    decode_buf.resize(imsize + kBufferSize);
+    size_t nread = fi->Read(BeginPtr(decode_buf) + imsize, kBufferSize);
+    imsize += nread;
+    decode_buf.resize(imsize);
+    if (nread != kBufferSize) break;
+  }
+  fi.reset();
+
+  if (param.unchanged != 1) {
+    cv::Mat img = cv::imdecode(decode_buf, param.color_mode);
+    CHECK(img.data != NULL) << "OpenCV decode fail:" << path;
+    cv::Mat res = img;
+    const int new_size = param.new_size;
+    const int inter_method = param.inter_method;
+    if (new_size > 0) {
+      if (param.center_crop) {
+        if (img.rows > img.cols) {
+          int margin = (img.rows - img.cols)/2;
+          img = img(cv::Range(margin, margin+img.cols), cv::Range(0, img.cols));
+        } else {
+          int margin = (img.cols - img.rows)/2;
+          img = img(cv::Range(0, img.rows), cv::Range(margin, margin + img.rows));
+        }
+      }
+      int interpolation_method = 1;
+      if (img.rows > img.cols) {
+          if (img.cols != new_size) {
+              interpolation_method = GetInterMethod(inter_method, img.cols, img.rows, new_size, img.rows * new_size / img.cols, prnd);
+              cv::resize(img, res, cv::Size(new_size, img.rows * new_size / img.cols), 0, 0, interpolation_method);
+          } else {
+              res = img.clone();
+          }
+      } else {
+          if (img.rows != new_size) {
+              interpolation_method = GetInterMethod(inter_method, img.cols, img.rows, new_size * img.cols / img.rows, new_size, prnd);
+              cv::resize(img, res, cv::Size(new_size * img.cols / img.rows, new_size), 0, 0, interpolation_method);
+          } else {
+              res = img.clone();
+          }
+      }
+    }
+    std::vector<unsigned char> encode_buf;
+    CHECK(cv::imencode(param.encoding, res, encode_buf, param.encode_params));
+
+    // write buffer
+    size_t bsize = blob->size();
+    blob->resize(bsize + encode_buf.size());
+    memcpy(BeginPtr(*blob) + bsize,
+           BeginPtr(encode_buf), encode_buf.size());
+  } else {
+    size_t bsize = blob->size();
+    blob->resize(bsize + decode_buf.size());
+    memcpy(BeginPtr(*blob) + bsize,
+           BeginPtr(decode_buf), decode_buf.size());
+  }
+  return true;
+}
+
+/*! \brief a .rec output file, with its index when one is written */
+struct RecordShard {
+  std::unique_ptr<dmlc::Stream> fo;
+  std::unique_ptr<dmlc::RecordIOWriter> writer;
+  std::unique_ptr<dmlc::Stream> fidx;
+
+  RecordShard(const std::string& rec_path, const std::string& idx_path) {
+    LOG(INFO) << "Write to output: " << rec_path;
+    fo.reset(dmlc::Stream::Create(rec_path.c_str(), "w"));
+    writer.reset(new dmlc::RecordIOWriter(fo.get()));
+    if (!idx_path.empty() && dynamic_cast<dmlc::SeekStream*>(fo.get()) == nullptr) {
+      LOG(INFO) << "Skip the index of " << rec_path << ", whose offsets cannot be told";
+    } else if (!idx_path.empty()) {
+      LOG(INFO) << "Write index to: " << idx_path;
+      fidx.reset(dmlc::Stream::Create(idx_path.c_str(), "w"));
+    }
+  }
+
+  void Write(uint64_t key, const std::string& blob) {
+    if (fidx) {
+      std::ostringstream line;
+      line << key << '\t' << writer->Tell() << '\n';
+      const std::string str = line.str();
+      fidx->Write(str.data(), str.size());
+    }
+    writer->WriteRecord(dmlc::BeginPtr(blob), blob.size());
+  }
+};
+
 int main(int argc, char *argv[]) {
   if (argc < 4) {
     printf("Usage: <image.lst> <image_root_dir> <output.rec> [additional parameters in form key=value]\n"\
@@ -76,20 +229,28 @@ int main(int argc, char *argv[]) {
            "\tquality=QUALITY[default=95] JPEG quality for encoding (1-100, default: 95) or PNG compression for encoding (1-9, default: 3).\n"\
            "\tencoding=ENCODING[default='.jpg'] Encoding type. Can be '.jpg' or '.png'\n"\
            "\tinter_method=INTER_METHOD[default=1] NN(0) BILINEAR(1) CUBIC(2) AREA(3) LANCZOS4(4) AUTO(9) RAND(10).\n"\
-           "\tunchanged=UNCHANGED[default=0] Keep the original image encoding, size and color. If set to 1, it will ignore the others parameters.\n");
+           "\tunchanged=UNCHANGED[default=0] Keep the original image encoding, size and color. If set to 1, it will ignore the others parameters.\n"\
+           "\tnthread=NTHREAD[default=1] number of threads reading, resizing and encoding the images.\n"\
+           "\tnum_shards=NUM_SHARDS[default=1] write the images round robin into NUM_SHARDS files <output>.shardNNN.rec,"\
+           " to be read by as many workers.\n"\
+           "\tindex=INDEX[default=1] whether to write the index of every output into a .idx file next to it.\n");
     return 0;
   }
-  int label_width = 1;
-  int pack_label = 0;
-  int new_size = -1;
+  PackParam param;
+  param.label_width = 1;
+  param.pack_label = 0;
+  param.new_size = -1;
+  param.center_crop = 0;
+  param.color_mode = CV_LOAD_IMAGE_COLOR;
+  param.unchanged = 0;
+  param.inter_method = CV_INTER_LINEAR;
+  param.encoding = ".jpg";
   int nsplit = 1;
   int partid = 0;
-  int center_crop = 0;
   int quality = 95;
-  int color_mode = CV_LOAD_IMAGE_COLOR;
-  int unchanged = 0;
-  int inter_method = CV_INTER_LINEAR;
-  std::string encoding(".jpg");
+  int nthread = 1;
+  int num_shards = 1;
+  int write_index = 1;
   for (int i = 4; i < argc; ++i) {
     char key[128], val[128];
     int effct_len = 0;
@@ -101,50 +262,59 @@ int main(int argc, char *argv[]) {
 #endif
 
     if (effct_len == 2) {
-      if (!strcmp(key, "resize")) new_size = atoi(val);
-      if (!strcmp(key, "label_width")) label_width = atoi(val);
-      if (!strcmp(key, "pack_label")) pack_label = atoi(val);
+      if (!strcmp(key, "resize")) param.new_size = atoi(val);
+      if (!strcmp(key, "label_width")) param.label_width = atoi(val);
+      if (!strcmp(key, "pack_label")) param.pack_label = atoi(val);
       if (!strcmp(key, "nsplit")) nsplit = atoi(val);
       if (!strcmp(key, "part")) partid = atoi(val);
-      if (!strcmp(key, "center_crop")) center_crop = atoi(val);
+      if (!strcmp(key, "center_crop")) param.center_crop = atoi(val);
       if (!strcmp(key, "quality")) quality = atoi(val);
-      if (!strcmp(key, "color")) color_mode = atoi(val);
-      if (!strcmp(key, "encoding")) encoding = std::string(val);
-      if (!strcmp(key, "unchanged")) unchanged = atoi(val);
-      if (!strcmp(key, "inter_method")) inter_method = atoi(val);
+      if (!strcmp(key, "color")) param.color_mode = atoi(val);
+      if (!strcmp(key, "encoding")) param.encoding = std::string(val);
+      if (!strcmp(key, "unchanged")) param.unchanged = atoi(val);
+      if (!strcmp(key, "inter_method")) param.inter_method = atoi(val);
+      if (!strcmp(key, "nthread")) nthread = atoi(val);
+      if (!strcmp(key, "num_shards")) num_shards = atoi(val);
+      if (!strcmp(key, "index")) write_index = atoi(val);
     }
   }
   // Check parameters ranges
-  if (color_mode != -1 && color_mode != 0 && color_mode != 1) {
+  if (param.color_mode != -1 && param.color_mode != 0 && param.color_mode != 1) {
     LOG(FATAL) << "Color mode must be -1, 0 or 1.";
   }
-  if (encoding != std::string(".jpg") && encoding != std::string(".png")) {
+  if (param.encoding != std::string(".jpg") && param.encoding != std::string(".png")) {
     LOG(FATAL) << "Encoding mode must be .jpg or .png.";
   }
-  if (label_width <= 1 && pack_label) {
+  if (param.label_width <= 1 && param.pack_label) {
     LOG(FATAL) << "pack_label can only be used when label_width > 1";
   }
-  if (new_size > 0) {
-    LOG(INFO) << "New Image Size: Short Edge " << new_size;
+  if (nthread < 1) {
+    LOG(FATAL) << "nthread must be at least 1.";
+  }
+  if (num_shards < 1) {
+    LOG(FATAL) << "num_shards must be at least 1.";
+  }
+  if (param.new_size > 0) {
+    LOG(INFO) << "New Image Size: Short Edge " << param.new_size;
   } else {
     LOG(INFO) << "Keep origin image size";
   }
-  if (center_crop) {
+  if (param.center_crop) {
     LOG(INFO) << "Center cropping to square";
   }
-  if (color_mode == 0) {
+  if (param.color_mode == 0) {
     LOG(INFO) << "Use gray images";
   }
-  if (color_mode == -1) {
+  if (param.color_mode == -1) {
     LOG(INFO) << "Keep original color mode";
   }
-  LOG(INFO) << "Encoding is " << encoding;
+  LOG(INFO) << "Encoding is " << param.encoding;
 
-  if (encoding == std::string(".png") && quality > 9) {
+  if (param.encoding == std::string(".png") && quality > 9) {
       quality = 3;
   }
-  if (inter_method != 1) {
-      switch (inter_method) {
+  if (param.inter_method != 1) {
+      switch (param.inter_method) {
         case 0:
             LOG(INFO) << "Use inter_method CV_INTER_NN";
             break;
@@ -169,11 +339,12 @@ int main(int argc, char *argv[]) {
       }
   }
   std::random_device rd;
-  std::mt19937 prnd(rd());
+  std::vector<std::mt19937> prnds;
+  for (int i = 0; i < nthread; ++i) {
+    prnds.emplace_back(rd());
+  }
   using namespace dmlc;
-  const static size_t kBufferSize = 1 << 20UL;
-  std::string root = argv[2];
-  mxnet::io::ImageRecordIO rec;
+  param.root = argv[2];
   size_t imcnt = 0;
   double tstart = dmlc::GetTime();
   dmlc::InputSplit *flist = dmlc::InputSplit::
@@ -184,121 +355,64 @@ int main(int argc, char *argv[]) {
   } else {
     os << argv[3] << ".part" << std::setw(3) << std::setfill('0') << partid;
   }
-  LOG(INFO) << "Write to output: " << os.str();
-  dmlc::Stream *fo = dmlc::Stream::Create(os.str().c_str(), "w");
-  LOG(INFO) << "Output: " << os.str();
-  dmlc::RecordIOWriter writer(fo);
-  std::string fname, path, blob;
-  std::vector<unsigned char> decode_buf;
-  std::vector<unsigned char> encode_buf;
-  std::vector<int> encode_params;
-  if (encoding == std::string(".png")) {
-      encode_params.push_back(CV_IMWRITE_PNG_COMPRESSION);
-      encode_params.push_back(quality);
+  // out.rec is written to out.shard000.rec, ... and indexed by out.idx or out.shard000.idx, ...
+  const std::string output = os.str();
+  const bool rec_ext = output.size() > 4 && output.compare(output.size() - 4, 4, ".rec") == 0;
+  const std::string stem = rec_ext ? output.substr(0, output.size() - 4) : output;
+  std::vector<std::unique_ptr<RecordShard> > shards;
+  for (int k = 0; k < num_shards; ++k) {
+    std::ostringstream name;
+    name << stem;
+    if (num_shards != 1) {
+      name << ".shard" << std::setw(3) << std::setfill('0') << k;
+    }
+    const std::string rec_path = num_shards == 1 ? output : name.str() + (rec_ext ? ".rec" : "");
+    shards.emplace_back(new RecordShard(rec_path, write_index ? name.str() + ".idx" : ""));
+  }
+  if (param.encoding == std::string(".png")) {
+      param.encode_params.push_back(CV_IMWRITE_PNG_COMPRESSION);
+      param.encode_params.push_back(quality);
       LOG(INFO) << "PNG encoding compression: " << quality;
   } else {
-      encode_params.push_back(CV_IMWRITE_JPEG_QUALITY);
-      encode_params.push_back(quality);
+      param.encode_params.push_back(CV_IMWRITE_JPEG_QUALITY);
+      param.encode_params.push_back(quality);
       LOG(INFO) << "JPEG encoding quality: " << quality;
   }
+  LOG(INFO) << "Pack images with " << nthread << " threads";
+  // the lines of a batch are packed in parallel, then written in the order of the list
+  const size_t batch_size = static_cast<size_t>(nthread) * 16;
+  std::vector<std::string> lines;
+  std::vector<std::string> blobs(batch_size);
+  std::vector<uint64_t> keys(batch_size);
+  std::vector<char> packed(batch_size);
+  dmlc::OMPException omp_exc;
   dmlc::InputSplit::Blob line;
-  std::vector<float> label_buf(label_width, 0.f);
+  bool more = true;
 
-  while (flist->NextRecord(&line)) {
-    std::string sline(static_cast<char*>(line.dptr), line.size);
-    std::istringstream is(sline);
-    if (!(is >> rec.header.image_id[0] >> rec.header.label)) continue;
-    label_buf[0] = rec.header.label;
-    for (int k = 1; k < label_width; ++k) {
-      CHECK(is >> label_buf[k])
-          << "Invalid ImageList, did you provide the correct label_width?";
-    }
-    if (pack_label) rec.header.flag = label_width;
-    rec.SaveHeader(&blob);
-    if (pack_label) {
-      size_t bsize = blob.size();
-      blob.resize(bsize + label_buf.size()*sizeof(float));
-      memcpy(BeginPtr(blob) + bsize,
-             BeginPtr(label_buf), label_buf.size()*sizeof(float));
+  while (more) {
+    lines.clear();
+    while (lines.size() < batch_size && (more = flist->NextRecord(&line))) {
+      lines.emplace_back(static_cast<char*>(line.dptr), line.size);
     }
-    CHECK(std::getline(is, fname));
-    // eliminate invalid chars in the end
-    while (fname.length() != 0 &&
-           (isspace(*fname.rbegin()) || !isprint(*fname.rbegin()))) {
-      fname.resize(fname.length() - 1);
+    #pragma omp parallel for num_threads(nthread) schedule(dynamic)
+    for (int i = 0; i < static_cast<int>(lines.size()); ++i) {
+      omp_exc.Run([&] {
+        const int tid = omp_get_thread_num();
+        packed[i] = PackImage(lines[i], param, prnds[tid], &keys[i], &blobs[i]);
+      });
     }
-    // eliminate invalid chars in beginning.
-    const char *p = fname.c_str();
-    while (isspace(*p)) ++p;
-    path = root + p;
-    // use "r" is equal to rb in dmlc::Stream
-    dmlc::Stream *fi = dmlc::Stream::Create(path.c_str(), "r");
-    decode_buf.clear();
-    size_t imsize = 0;
-    while (true) {
-      decode_buf.resize(imsize + kBufferSize);
-      size_t nread = fi->Read(BeginPtr(decode_buf) + imsize, kBufferSize);
-      imsize += nread;
-      decode_buf.resize(imsize);
-      if (nread != kBufferSize) break;
-    }
-    delete fi;
-
-
-    if (unchanged != 1) {
-      cv::Mat img = cv::imdecode(decode_buf, color_mode);
-      CHECK(img.data != NULL) << "OpenCV decode fail:" << path;
-      cv::Mat res = img;
-      if (new_size > 0) {
-        if (center_crop) {
-          if (img.rows > img.cols) {
-            int margin = (img.rows - img.cols)/2;
-            img = img(cv::Range(margin, margin+img.cols), cv::Range(0, img.cols));
-          } else {
-            int margin = (img.cols - img.rows)/2;
-            img = img(cv::Range(0, img.rows), cv::Range(margin, margin + img.rows));
-          }
-        }
-        int interpolation_method = 1;
-        if (img.rows > img.cols) {
-            if (img.cols != new_size) {
-                interpolation_method = GetInterMethod(inter_method, img.cols, img.rows, new_size, img.rows * new_size / img.cols, prnd);
-                cv::resize(img, res, cv::Size(new_size, img.rows * new_size / img.cols), 0, 0, interpolation_method);
-            } else {
-                res = img.clone();
-            }
-        } else {
-            if (img.rows != new_size) {
-                interpolation_method = GetInterMethod(inter_method, img.cols, img.rows, new_size * img.cols / img.rows, new_size, prnd);
-                cv::resize(img, res, cv::Size(new_size * img.cols / img.rows, new_size), 0, 0, interpolation_method);
-            } else {
-                res = img.clone();
-            }
-        }
+    omp_exc.Rethrow();
+    for (size_t i = 0; i < lines.size(); ++i) {
+      if (!packed[i]) continue;
+      shards[imcnt % num_shards]->Write(keys[i], blobs[i]);
+      ++imcnt;
+      if (imcnt % 1000 == 0) {
+        LOG(INFO) << imcnt << " images processed, " << GetTime() - tstart << " sec elapsed";
       }
-      encode_buf.clear();
-      CHECK(cv::imencode(encoding, res, encode_buf, encode_params));
-
-      // write buffer
-      size_t bsize = blob.size();
-      blob.resize(bsize + encode_buf.size());
-      memcpy(BeginPtr(blob) + bsize,
-             BeginPtr(encode_buf), encode_buf.size());
-    } else {
-      size_t bsize = blob.size();
-      blob.resize(bsize + decode_buf.size());
-      memcpy(BeginPtr(blob) + bsize,
-             BeginPtr(decode_buf), decode_buf.size());
-    }
-    writer.WriteRecord(BeginPtr(blob), blob.size());
-    // write header
-    ++imcnt;
-    if (imcnt % 1000 == 0) {
-      LOG(INFO) << imcnt << " images processed, " << GetTime() - tstart << " sec elapsed";
     }
   }
   LOG(INFO) << "Total: " << imcnt << " images processed, " << GetTime() - tstart << " sec elapsed";
-  delete fo;
+  shards.clear();
   delete flist;
   return 0;
 }
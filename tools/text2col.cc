@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file text2col.cc
+ * \brief convert a CSV or LibSVM file into the columnar format read by ColumnarIter
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <dmlc/base.h>
+#include <dmlc/io.h>
+#include <dmlc/timer.h>
+#include <dmlc/logging.h>
+#include "../src/io/columnar_format.h"
+#include "../src/io/text_parser.h"
+
+using namespace mxnet::io;
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    printf("Usage: <input> <output.col> [additional parameters in form key=value]\n"\
+           "Possible additional parameters:\n"\
+           "\tformat=FORMAT[default=csv] Format of the input, csv or libsvm.\n"\
+           "\tnum_columns=NUM_COLUMNS number of data columns, required.\n"\
+           "\tlabel_width=WIDTH[default=1] number of label columns leading every CSV row,"\
+           " a LibSVM row has 1.\n"\
+           "\trows_per_block=ROWS[default=65536] number of rows of a block.\n"\
+           "\tnthread=NTHREAD[default=4] number of threads parsing the input.\n");
+    return 0;
+  }
+  std::string format("csv");
+  long long num_columns = 0;  // NOLINT(*)
+  int label_width = 1;
+  int rows_per_block = 65536;
+  int nthread = 4;
+  for (int i = 3; i < argc; ++i) {
+    char key[128], val[128];
+    int effct_len = 0;
+
+#ifdef _MSC_VER
+    effct_len = sscanf_s(argv[i], "%[^=]=%s", key, sizeof(key), val, sizeof(val));
+#else
+    effct_len = sscanf(argv[i], "%[^=]=%s", key, val);
+#endif
+
+    if (effct_len == 2) {
+      if (!strcmp(key, "format")) format = std::string(val);
+      if (!strcmp(key, "num_columns")) num_columns = atoll(val);
+      if (!strcmp(key, "label_width")) label_width = atoi(val);
+      if (!strcmp(key, "rows_per_block")) rows_per_block = atoi(val);
+      if (!strcmp(key, "nthread")) nthread = atoi(val);
+    }
+  }
+  if (format != "csv" && format != "libsvm") {
+    LOG(FATAL) << "Format must be csv or libsvm.";
+  }
+  if (num_columns <= 0) {
+    LOG(FATAL) << "num_columns must be set to the number of data columns.";
+  }
+  if (label_width < 0 || (format == "libsvm" && label_width != 1)) {
+    LOG(FATAL) << "label_width must be non-negative, and 1 for libsvm.";
+  }
+  if (rows_per_block <= 0) {
+    LOG(FATAL) << "rows_per_block must be positive.";
+  }
+
+  std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(argv[2], "w"));
+  const bool sparse = format == "libsvm";
+  ColumnarWriter writer(fo.get(), sparse ? kColumnarCSR : kColumnarDense, num_columns,
+                        label_width, rows_per_block);
+  double tstart = dmlc::GetTime();
+  size_t bytes_read = 0;
+  if (sparse) {
+    LibSVMTextParser parser(argv[1], 0, 1, nthread);
+    while (parser.Next()) {
+      const SparseTextBlock& block = parser.Value();
+      for (size_t r = 0; r < block.Size(); ++r) {
+        const size_t begin = block.offset[r];
+        writer.WriteSparseRow(&block.label[r],
+                              reinterpret_cast<const int64_t*>(block.index.data()) + begin,
+                              block.value.data() + begin, block.offset[r + 1] - begin);
+      }
+    }
+    bytes_read = parser.BytesRead();
+  } else {
+    CSVTextParser<mxnet::real_t> parser(
+        argv[1], mxnet::TShape({static_cast<mxnet::index_t>(label_width + num_columns)}),
+        nthread);
+    while (parser.Next()) {
+      const DenseTextBlock<mxnet::real_t>& block = parser.Value();
+      for (size_t r = 0; r < block.Size(); ++r) {
+        writer.WriteDenseRow(block.Row(r), block.Row(r) + label_width);
+      }
+    }
+    bytes_read = parser.BytesRead();
+  }
+  writer.Finish();
+  LOG(INFO) << "Total: " << writer.NumRows() << " rows, " << bytes_read << " bytes of text, "
+            << "elapsed time = " << dmlc::GetTime() - tstart << " sec";
+  return 0;
+}